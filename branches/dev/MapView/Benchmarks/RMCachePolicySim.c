@@ -0,0 +1,274 @@
+//
+//  RMCachePolicySim.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Replays tile requests through each RMPrimaryCache policy and reports how
+// many the cache would have answered. Build and run with
+//
+//     cc -O2 -o cache-sim RMCachePolicySim.c ../Map/CacheNT/RMCachePolicy.c ../Map/CacheNT/RMKeyTable.c
+//     ./cache-sim [-m limit,limit,...] [trace ...]
+//
+// A trace is what RMTileFactory writes to Caches/RMCacheTrace.txt when the
+// kit is built with RM_CACHE_TRACE defined, a line for every request and
+// one with the length of every tile that came in:
+//
+//     R <cache key in hex>
+//     L <cache key in hex> <bytes>
+//
+// Each request is a lookup; a miss is added with the tile's length, or the
+// average length if the trace never saw the tile load. Without a trace the
+// requests come from a synthetic user panning about a home area, with a
+// fling or a zoom out now and then that passes over tiles never seen again.
+//
+// One tab separated line per policy and limit:
+//
+//     policy  limit  requests  hit_ratio  byte_hit_ratio
+
+#include "../Map/CacheNT/RMCachePolicy.h"
+#include "../Map/CacheNT/RMKeyTable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+	uint64_t key;
+	size_t length;
+} Request;
+
+static Request *requests;
+static size_t requestCount, requestCapacity;
+
+static void
+AddRequest(uint64_t key, size_t length)
+{
+	if (requestCount == requestCapacity) {
+		requestCapacity = requestCapacity ? 2 * requestCapacity : 4096;
+		if (!(requests = realloc(requests, requestCapacity * sizeof(Request)))) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	requests[requestCount].key = key;
+	requests[requestCount].length = length;
+	requestCount++;
+}
+
+/////////////////////////////////////////////////////////////// TRACES
+
+// lengths are kept in a table as they may be logged after the request
+static RMKeyTable *lengths;
+
+static void
+ReadTrace(const char *path)
+{
+	FILE *fp = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	unsigned long long key;
+	unsigned long bytes;
+	char line[256];
+
+	if (!fp) {
+		perror(path);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "R %llx", &key) == 1 && key)
+			AddRequest(key, 0);
+		else if (sscanf(line, "L %llx %lu", &key, &bytes) == 2 && key && bytes)
+			RMKeyTableSet(lengths, key, (void *)(uintptr_t)bytes);
+	}
+	if (fp != stdin)
+		fclose(fp);
+}
+
+// fills in the lengths, using the average for tiles that never loaded
+static void
+ResolveLengths(void)
+{
+	unsigned long long total = 0, known = 0;
+	size_t i, average;
+	uintptr_t length;
+
+	for (i = 0; i < requestCount; i++)
+		if ((length = (uintptr_t)RMKeyTableGet(lengths, requests[i].key))) {
+			requests[i].length = length;
+			total += length;
+			known++;
+		}
+	average = known ? (size_t)(total / known) : 12000;
+	for (i = 0; i < requestCount; i++)
+		if (!requests[i].length)
+			requests[i].length = average;
+}
+
+/////////////////////////////////////////////////////////////// SYNTHETIC
+
+static uint64_t randomState = 1;
+
+static uint64_t
+Random64(void)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return randomState;
+}
+
+static double
+RandomUnit(void)
+{
+	return (Random64() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// the same packing as RMCacheKeyForTile() for source 1
+static uint64_t
+TileKey(unsigned zoom, unsigned x, unsigned y)
+{
+	return (1ULL << 53) | ((uint64_t)zoom << 48) | ((uint64_t)x << 24) | y;
+}
+
+// 100 bytes of empty sea to 25k of city, fixed for each tile
+static size_t
+TileLength(uint64_t key)
+{
+	uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+	return 100 + (size_t)((h >> 40) % 24900);
+}
+
+// a screen of tiles about x, y
+static void
+RequestScreen(unsigned zoom, unsigned x, unsigned y)
+{
+	unsigned i, j;
+
+	for (j = 0; j < 3; j++)
+		for (i = 0; i < 2; i++) {
+			uint64_t key = TileKey(zoom, x + i, y + j);
+			AddRequest(key, TileLength(key));
+		}
+}
+
+// Sessions of looking about a home area, where the user mostly returns to
+// a few places, broken up by flings across the map and zooms out and back,
+// which bring in tiles that are not asked for again.
+static void
+Synthesize(unsigned sessions)
+{
+	const unsigned zoom = 15, homeX = 16000, homeY = 11000, places = 12;
+	unsigned s, step, k, x, y, far = 0;
+
+	for (s = 0; s < sessions; s++) {
+		for (step = 0; step < 40; step++) {
+			double r = RandomUnit();
+			if (r < 0.85) {
+				// a favourite place, the first ones the most
+				unsigned place = (unsigned)(places * RandomUnit() * RandomUnit());
+				x = homeX + 3 * (place % 4) + (unsigned)(Random64() % 2);
+				y = homeY + 4 * (place / 4) + (unsigned)(Random64() % 2);
+				RequestScreen(zoom, x, y);
+			} else if (r < 0.95) {
+				// a fling: a line of screens out over new ground
+				far += 50;
+				for (k = 0; k < 12; k++)
+					RequestScreen(zoom, homeX + far + 2 * k, homeY + far);
+			} else {
+				// out to the region and back in
+				far += 50;
+				for (k = 1; k <= 4; k++)
+					RequestScreen(zoom - k, ((homeX + far) >> k), ((homeY + far) >> k));
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////// REPLAY
+
+static void
+Evict(uint64_t key, void *value, void *context)
+{
+	(void)key, (void)value, (void)context;
+}
+
+static void
+Replay(RMCachePolicyType type, size_t limit)
+{
+	RMCachePolicy *cache = RMCachePolicyCreate(type, limit, Evict, NULL);
+	unsigned long long hits = 0, bytes = 0, hitBytes = 0;
+	size_t i;
+
+	if (!cache) {
+		perror("RMCachePolicyCreate");
+		exit(1);
+	}
+	for (i = 0; i < requestCount; i++) {
+		bytes += requests[i].length;
+		if (RMCachePolicyGet(cache, requests[i].key)) {
+			hits++;
+			hitBytes += requests[i].length;
+		} else {
+			RMCachePolicyAdd(cache, requests[i].key, requests + i, requests[i].length);
+		}
+	}
+	printf("%s\t%lu\t%lu\t%.4f\t%.4f\n", RMCachePolicyName(type),
+		   (unsigned long)limit, (unsigned long)requestCount,
+		   requestCount ? (double)hits / requestCount : 0,
+		   bytes ? (double)hitBytes / bytes : 0);
+	RMCachePolicyFree(cache);
+}
+
+int
+main(int argc, char **argv)
+{
+	char limits[256] = "500000,1000000,2000000,4000000", *p;
+	int c, type;
+
+	while ((c = getopt(argc, argv, "m:")) != -1)
+		switch (c) {
+			case 'm': snprintf(limits, sizeof(limits), "%s", optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-m limit,limit,...] [trace ...]\n", argv[0]);
+				return 1;
+		}
+
+	lengths = RMKeyTableCreate();
+	if (optind < argc) {
+		for (; optind < argc; optind++)
+			ReadTrace(argv[optind]);
+		ResolveLengths();
+	} else {
+		Synthesize(200);
+	}
+
+	printf("#policy\tlimit\trequests\thit_ratio\tbyte_hit_ratio\n");
+	for (p = strtok(limits, ","); p; p = strtok(NULL, ","))
+		for (type = 0; type < kRMCachePolicyCount; type++)
+			Replay((RMCachePolicyType)type, (size_t)strtoul(p, NULL, 10));
+
+	RMKeyTableFree(lengths);
+	free(requests);
+	return 0;
+}
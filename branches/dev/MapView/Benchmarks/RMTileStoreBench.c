@@ -0,0 +1,334 @@
+//
+//  RMTileStoreBench.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Compares the secondary cache layouts on a desktop machine: RMStorage's
+// directory with one file per tile, named by the 64 bit key hash, against
+// the packed RMTileStore. The file per tile side does what RMStorage does
+// around its archives (an existence check, then open/read/close, and a
+// readdir count at startup) but cannot include the NSKeyedArchiver cost,
+// so it is the better case of the old layout. Build and run with
+//
+//     cc -O2 -o tilestore-bench RMTileStoreBench.c ../Map/CacheNT/RMTileStore.c -lpthread
+//     ./tilestore-bench [-n tiles] [-r reads] [directory]
+//
+// One tab separated line per case, like the Proj4 projbench:
+//
+//     layout  case  seconds  ops/sec
+
+#include "../Map/CacheNT/RMTileStore.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+static double
+Now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void
+Report(const char *layout, const char *name, double seconds, unsigned ops)
+{
+	printf("%s\t%s\t%.3f\t%.0f\n", layout, name, seconds, seconds > 0 ? ops / seconds : 0);
+}
+
+// a reproducible stream of keys and tile sizes, 100 bytes to 25k like
+// the range the cache notes give for real tiles
+static uint64_t randomState = 1;
+
+static uint64_t
+Random64(void)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return randomState;
+}
+
+static size_t
+TileSize(uint64_t key)
+{
+	return 100 + (size_t)((key >> 17) % 24900);
+}
+
+static void
+FileName(char *buf, const char *dir, uint64_t key)
+{
+	sprintf(buf, "%s/%llx", dir, (unsigned long long)key);
+}
+
+static void
+RemoveTree(const char *dir)
+{
+	char path[2048];
+	struct dirent *dp;
+	DIR *dirp = opendir(dir);
+
+	if (!dirp)
+		return;
+	while ((dp = readdir(dirp)))
+		if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
+			snprintf(path, sizeof(path), "%s/%s", dir, dp->d_name);
+			unlink(path);
+		}
+	closedir(dirp);
+	rmdir(dir);
+}
+
+/////////////////////////////////////////////////////////////// FILE PER TILE
+
+typedef struct {
+	char name[24];
+	time_t atime;
+} FileEntry;
+
+static int
+CompareFileEntry(const void *p1, const void *p2)
+{
+	const FileEntry *f1 = p1, *f2 = p2;
+
+	return f1->atime < f2->atime ? -1 : f1->atime > f2->atime;
+}
+
+static void
+BenchFiles(const char *dir, uint64_t *keys, unsigned n, unsigned reads, char *tile)
+{
+	char path[2048];
+	struct stat sb;
+	struct dirent *dp;
+	DIR *dirp;
+	FileEntry *entries;
+	unsigned i, count, hits, prune = n * 15 / 100;
+	double t;
+	int fd;
+
+	mkdir(dir, 0755);
+
+	t = Now();
+	for (i = 0; i < n; i++) {
+		FileName(path, dir, keys[i]);
+		if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+			|| write(fd, tile, TileSize(keys[i])) < 0) {
+			perror(path);
+			exit(1);
+		}
+		close(fd);
+	}
+	Report("files", "write", Now() - t, n);
+
+	t = Now();
+	count = 0;
+	if ((dirp = opendir(dir))) {
+		while ((dp = readdir(dirp)))
+			count++;
+		closedir(dirp);
+	}
+	Report("files", "open", Now() - t, 1);
+
+	randomState = 7;
+	hits = 0;
+	t = Now();
+	for (i = 0; i < reads; i++) {
+		uint64_t key = keys[Random64() % n];
+		FileName(path, dir, key);
+		if (stat(path, &sb) == 0 && (fd = open(path, O_RDONLY)) >= 0) {
+			char *buf = malloc(sb.st_size);
+			if (read(fd, buf, sb.st_size) == sb.st_size)
+				hits++;
+			free(buf);
+			close(fd);
+		}
+	}
+	Report("files", "read_hit", Now() - t, reads);
+	if (hits != reads)
+		fprintf(stderr, "files: %u of %u reads failed\n", reads - hits, reads);
+
+	t = Now();
+	for (i = 0; i < reads; i++) {
+		FileName(path, dir, Random64() | 1ULL << 63);
+		(void)stat(path, &sb);
+	}
+	Report("files", "read_miss", Now() - t, reads);
+
+	// what RMPrune did: stat everything, remove the least recently accessed
+	t = Now();
+	entries = malloc(n * sizeof(FileEntry));
+	count = 0;
+	if (entries && (dirp = opendir(dir))) {
+		while ((dp = readdir(dirp)) && count < n) {
+			snprintf(path, sizeof(path), "%s/%s", dir, dp->d_name);
+			if (dp->d_name[0] != '.' && strlen(dp->d_name) < sizeof(entries[count].name)
+				&& stat(path, &sb) == 0) {
+				strcpy(entries[count].name, dp->d_name);
+				entries[count].atime = sb.st_atime;
+				count++;
+			}
+		}
+		closedir(dirp);
+		qsort(entries, count, sizeof(FileEntry), CompareFileEntry);
+		for (i = 0; i < prune && i < count; i++) {
+			snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+			unlink(path);
+		}
+	}
+	free(entries);
+	Report("files", "prune_15pct", Now() - t, prune);
+
+	RemoveTree(dir);
+}
+
+/////////////////////////////////////////////////////////////// PACKED
+
+static void
+BenchPacked(const char *dir, uint64_t *keys, unsigned n, unsigned reads, char *tile)
+{
+	RMTileStore *store;
+	char path[2048];
+	unsigned i, hits, prune = n * 15 / 100;
+	size_t length;
+	double t;
+
+	mkdir(dir, 0755);
+	if (!(store = RMTileStoreOpen(dir))) {
+		perror(dir);
+		exit(1);
+	}
+
+	t = Now();
+	for (i = 0; i < n; i++)
+		if (RMTileStorePut(store, keys[i], tile, TileSize(keys[i])) != 0) {
+			perror("RMTileStorePut");
+			exit(1);
+		}
+	RMTileStoreSync(store);
+	Report("packed", "write", Now() - t, n);
+	RMTileStoreClose(store);
+
+	t = Now();
+	store = RMTileStoreOpen(dir);
+	Report("packed", "open", Now() - t, 1);
+	if (!store || RMTileStoreCount(store) != n) {
+		fprintf(stderr, "packed: reopened with %u of %u tiles\n", store ? RMTileStoreCount(store) : 0, n);
+		exit(1);
+	}
+	RMTileStoreClose(store);
+
+	// without tiles.idx the index is rebuilt from the data file
+	snprintf(path, sizeof(path), "%s/tiles.idx", dir);
+	unlink(path);
+	t = Now();
+	store = RMTileStoreOpen(dir);
+	Report("packed", "open_rebuild", Now() - t, 1);
+	if (!store || RMTileStoreCount(store) != n) {
+		fprintf(stderr, "packed: rebuilt with %u of %u tiles\n", store ? RMTileStoreCount(store) : 0, n);
+		exit(1);
+	}
+
+	randomState = 7;
+	hits = 0;
+	t = Now();
+	for (i = 0; i < reads; i++) {
+		uint64_t key = keys[Random64() % n];
+		void *data = RMTileStoreCopyData(store, key, &length);
+		if (data && length == TileSize(key))
+			hits++;
+		free(data);
+	}
+	Report("packed", "read_hit", Now() - t, reads);
+	if (hits != reads)
+		fprintf(stderr, "packed: %u of %u reads failed\n", reads - hits, reads);
+
+	t = Now();
+	for (i = 0; i < reads; i++)
+		free(RMTileStoreCopyData(store, Random64() | 1ULL << 63, &length));
+	Report("packed", "read_miss", Now() - t, reads);
+
+	t = Now();
+	if (RMTileStorePrune(store, prune) != prune)
+		fprintf(stderr, "packed: prune short\n");
+	Report("packed", "prune_15pct", Now() - t, prune);
+
+	t = Now();
+	if (RMTileStoreCompact(store) != 0)
+		perror("RMTileStoreCompact");
+	Report("packed", "compact", Now() - t, RMTileStoreCount(store));
+
+	RMTileStoreClose(store);
+	RemoveTree(dir);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned n = 20000, reads = 100000, i;
+	const char *base = "/tmp";
+	char dir[1024];
+	uint64_t *keys;
+	char *tile;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:r:")) != -1)
+		switch (c) {
+			case 'n': n = (unsigned)atoi(optarg); break;
+			case 'r': reads = (unsigned)atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n tiles] [-r reads] [directory]\n", argv[0]);
+				return 1;
+		}
+	if (optind < argc)
+		base = argv[optind];
+	if (!n)
+		n = 1;
+
+	keys = malloc(n * sizeof(uint64_t));
+	tile = malloc(25000);
+	if (!keys || !tile)
+		return 1;
+	for (i = 0; i < n; i++)
+		keys[i] = Random64() & ~(1ULL << 63);
+	for (i = 0; i < 25000; i++)
+		tile[i] = (char)i;
+
+	printf("#layout\tcase\tseconds\tops/sec\n");
+	snprintf(dir, sizeof(dir), "%s/tilestore-bench-files.%d", base, (int)getpid());
+	BenchFiles(dir, keys, n, reads, tile);
+	snprintf(dir, sizeof(dir), "%s/tilestore-bench-packed.%d", base, (int)getpid());
+	BenchPacked(dir, keys, n, reads, tile);
+
+	free(keys);
+	free(tile);
+	return 0;
+}
@@ -0,0 +1,366 @@
+//
+//  RMTileStorePruneBench.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Times a 15% prune of a full cache, 100k tiles by default, both ways the
+// secondary cache has done it: RMPrune's readdir and stat of every file,
+// keeping the oldest access times in a heap, and RMTileStorePrune() off
+// the eviction order the store keeps in its index. A tenth of the tiles
+// are read before the prune, and the run ends with how many of those
+// survived; on a volume mounted noatime, atime cannot tell them apart.
+// Build and run with
+//
+//     cc -O2 -o prune-bench RMTileStorePruneBench.c ../Map/CacheNT/RMTileStore.c -lpthread
+//     ./prune-bench [-n tiles] [-b batch] [directory]
+//
+// One tab separated line per case, like RMTileStoreBench:
+//
+//     layout  case  seconds  ops/sec
+//
+// where prune_batch_max is the longest single batch of RMStorage's
+// incremental prune, the time a fetch can be held up behind it.
+
+#include "../Map/CacheNT/RMTileStore.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+static double
+Now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void
+Report(const char *layout, const char *name, double seconds, unsigned ops)
+{
+	printf("%s\t%s\t%.4f\t%.0f\n", layout, name, seconds, seconds > 0 ? ops / seconds : 0);
+}
+
+static uint64_t randomState = 1;
+
+static uint64_t
+Random64(void)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return randomState;
+}
+
+// small tiles, the prune cost is in the bookkeeping rather than the bytes
+static size_t
+TileSize(uint64_t key)
+{
+	return 100 + (size_t)((key >> 17) % 2000);
+}
+
+static void
+FileName(char *buf, const char *dir, uint64_t key)
+{
+	sprintf(buf, "%s/%llx", dir, (unsigned long long)key);
+}
+
+static void
+RemoveTree(const char *dir)
+{
+	char path[2048];
+	struct dirent *dp;
+	DIR *dirp = opendir(dir);
+
+	if (!dirp)
+		return;
+	while ((dp = readdir(dirp)))
+		if (strcmp(dp->d_name, ".") && strcmp(dp->d_name, "..")) {
+			snprintf(path, sizeof(path), "%s/%s", dir, dp->d_name);
+			unlink(path);
+		}
+	closedir(dirp);
+	rmdir(dir);
+}
+
+// every tenth key is a hot one, read a few times before the prune
+static void
+ReadHot(unsigned n, unsigned reads, void (*read)(unsigned, void *), void *ctx)
+{
+	unsigned i;
+
+	randomState = 7;
+	for (i = 0; i < reads; i++)
+		read((unsigned)(Random64() % (n / 10 + 1)) * 10 % n, ctx);
+}
+
+/////////////////////////////////////////////////////////////// FILE PER TILE
+
+typedef struct {
+	char name[24];
+	double atime;
+} FileEntry;
+
+typedef struct {
+	const char *dir;
+	uint64_t *keys;
+	char *buf;
+} FileContext;
+
+static void
+ReadFile(unsigned i, void *ctx)
+{
+	FileContext *fc = ctx;
+	char path[2048];
+	int fd;
+
+	FileName(path, fc->dir, fc->keys[i]);
+	if ((fd = open(path, O_RDONLY)) >= 0) {
+		if (read(fd, fc->buf, TileSize(fc->keys[i])) < 0)
+			perror(path);
+		close(fd);
+	}
+}
+
+// RMPrune's heap: the number oldest seen so far, the newest of them on top
+static void
+HeapSift(FileEntry *heap, unsigned count, unsigned i)
+{
+	FileEntry t;
+	unsigned c;
+
+	while ((c = 2 * i + 1) < count) {
+		if (c + 1 < count && heap[c + 1].atime > heap[c].atime)
+			c++;
+		if (heap[i].atime >= heap[c].atime)
+			break;
+		t = heap[i]; heap[i] = heap[c]; heap[c] = t;
+		i = c;
+	}
+}
+
+static void
+HeapPush(FileEntry *heap, unsigned count, const FileEntry *fe)
+{
+	unsigned i = count, p;
+
+	heap[i] = *fe;
+	while (i && heap[p = (i - 1) / 2].atime < heap[i].atime) {
+		FileEntry t = heap[i]; heap[i] = heap[p]; heap[p] = t;
+		i = p;
+	}
+}
+
+static void
+BenchFiles(const char *dir, uint64_t *keys, unsigned n, unsigned reads, char *tile)
+{
+	FileContext fc = { dir, keys, tile };
+	char path[2048];
+	struct stat sb;
+	struct dirent *dp;
+	DIR *dirp;
+	FileEntry *heap, fe;
+	unsigned i, count = 0, prune = n * 15 / 100, hot = 0;
+	double t;
+	int fd;
+
+	mkdir(dir, 0755);
+	for (i = 0; i < n; i++) {
+		FileName(path, dir, keys[i]);
+		if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+			|| write(fd, tile, TileSize(keys[i])) < 0) {
+			perror(path);
+			exit(1);
+		}
+		close(fd);
+	}
+	ReadHot(n, reads, ReadFile, &fc);
+
+	t = Now();
+	heap = malloc((prune + 1) * sizeof(FileEntry));
+	if (heap && prune && (dirp = opendir(dir))) {
+		while ((dp = readdir(dirp))) {
+			snprintf(path, sizeof(path), "%s/%s", dir, dp->d_name);
+			if (dp->d_name[0] == '.' || strlen(dp->d_name) >= sizeof(fe.name)
+				|| stat(path, &sb) != 0)
+				continue;
+			strcpy(fe.name, dp->d_name);
+			fe.atime = sb.st_atim.tv_sec + sb.st_atim.tv_nsec * 1e-9;
+			if (count < prune) {
+				HeapPush(heap, count++, &fe);
+			} else if (fe.atime < heap[0].atime) {
+				heap[0] = fe;
+				HeapSift(heap, count, 0);
+			}
+		}
+		closedir(dirp);
+		for (i = 0; i < count; i++) {
+			snprintf(path, sizeof(path), "%s/%s", dir, heap[i].name);
+			unlink(path);
+		}
+	}
+	free(heap);
+	Report("files", "prune_15pct", Now() - t, count);
+
+	for (i = 0; i < n; i += 10) {
+		FileName(path, dir, keys[i]);
+		hot += stat(path, &sb) == 0;
+	}
+	printf("#files\thot_kept\t%u of %u\n", hot, (n + 9) / 10);
+	RemoveTree(dir);
+}
+
+/////////////////////////////////////////////////////////////// PACKED
+
+typedef struct {
+	RMTileStore *store;
+	uint64_t *keys;
+} PackedContext;
+
+static void
+ReadPacked(unsigned i, void *ctx)
+{
+	PackedContext *pc = ctx;
+	size_t length;
+
+	free(RMTileStoreCopyData(pc->store, pc->keys[i], &length));
+}
+
+static RMTileStore *
+FillPacked(const char *dir, uint64_t *keys, unsigned n, unsigned reads, char *tile)
+{
+	PackedContext pc = { NULL, keys };
+	unsigned i;
+
+	RemoveTree(dir);
+	mkdir(dir, 0755);
+	if (!(pc.store = RMTileStoreOpen(dir))) {
+		perror(dir);
+		exit(1);
+	}
+	for (i = 0; i < n; i++)
+		if (RMTileStorePut(pc.store, keys[i], tile, TileSize(keys[i])) != 0) {
+			perror("RMTileStorePut");
+			exit(1);
+		}
+	ReadHot(n, reads, ReadPacked, &pc);
+
+	// the order has to come back from tiles.idx
+	RMTileStoreClose(pc.store);
+	if (!(pc.store = RMTileStoreOpen(dir)) || RMTileStoreCount(pc.store) != n) {
+		fprintf(stderr, "packed: reopen failed\n");
+		exit(1);
+	}
+	return pc.store;
+}
+
+static void
+BenchPacked(const char *dir, uint64_t *keys, unsigned n, unsigned reads, unsigned batch, char *tile)
+{
+	PackedContext pc = { NULL, keys };
+	unsigned i, removed, prune = n * 15 / 100, hot = 0, batches = 0;
+	double t, start, longest = 0;
+
+	pc.store = FillPacked(dir, keys, n, reads, tile);
+	t = Now();
+	removed = RMTileStorePrune(pc.store, prune);
+	Report("packed", "prune_15pct", Now() - t, removed);
+	for (i = 0; i < n; i += 10)
+		hot += RMTileStoreContains(pc.store, keys[i]);
+	printf("#packed\thot_kept\t%u of %u\n", hot, (n + 9) / 10);
+	RMTileStoreClose(pc.store);
+
+	// again the way RMStorage goes about it, a batch at a time with reads
+	// from the run loop in between
+	pc.store = FillPacked(dir, keys, n, reads, tile);
+	randomState = 11;
+	start = Now();
+	for (removed = 0; removed < prune; batches++) {
+		t = Now();
+		removed += RMTileStorePrune(pc.store, prune - removed < batch ? prune - removed : batch);
+		t = Now() - t;
+		if (t > longest)
+			longest = t;
+		ReadPacked((unsigned)(Random64() % n), &pc);
+	}
+	Report("packed", "prune_batched", Now() - start, removed);
+	Report("packed", "prune_batch_max", longest, 1);
+	t = Now();
+	RMTileStoreSync(pc.store);
+	Report("packed", "sync", Now() - t, 1);
+	RMTileStoreClose(pc.store);
+	RemoveTree(dir);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned n = 100000, batch = 32, reads, i;
+	const char *base = "/tmp";
+	char dir[1024];
+	uint64_t *keys;
+	char *tile;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:b:")) != -1)
+		switch (c) {
+			case 'n': n = (unsigned)atoi(optarg); break;
+			case 'b': batch = (unsigned)atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n tiles] [-b batch] [directory]\n", argv[0]);
+				return 1;
+		}
+	if (optind < argc)
+		base = argv[optind];
+	if (n < 10)
+		n = 10;
+	if (!batch)
+		batch = 1;
+	reads = n / 2;
+
+	keys = malloc(n * sizeof(uint64_t));
+	tile = malloc(2100);
+	if (!keys || !tile)
+		return 1;
+	for (i = 0; i < n; i++)
+		keys[i] = Random64() & ~(1ULL << 63);
+	for (i = 0; i < 2100; i++)
+		tile[i] = (char)i;
+
+	printf("#layout\tcase\tseconds\tops/sec\n");
+	snprintf(dir, sizeof(dir), "%s/prune-bench-files.%d", base, (int)getpid());
+	BenchFiles(dir, keys, n, reads, tile);
+	snprintf(dir, sizeof(dir), "%s/prune-bench-packed.%d", base, (int)getpid());
+	BenchPacked(dir, keys, n, reads, batch, tile);
+
+	free(keys);
+	free(tile);
+	return 0;
+}
@@ -13,6 +13,7 @@
 
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
+#import "rm-cache.h"
 
 // 
 // Protocol for objects who want to receive cache updates to implement. 
@@ -48,6 +49,10 @@
 - (NSString *)key;
 - (void)setKey:(NSString *)urlAsString;
 
+// the integer form of the key, which is what the caches actually look
+// objects up by, see RMCacheKey
+- (RMCacheKey)cacheKey;
+
 // counts the length in bytes of the object, this is used by 
 // high level caches mostly in order to maintain high water 
 // marks in the cache in terms of memory use, since no two
@@ -81,6 +86,15 @@ typedef struct {
 } RMCacheTimestamp;
 
 //
+// Something that knows the URL of its tiles, like an RMTileSource. A cache
+// entry for a tile holds on to one of these instead of a URL, and only asks
+// it for the URL if the tile has to be loaded from the network. That is done
+// on the main thread, unless kRMKeySecondaryCacheImmediateRead is turned off,
+// when it is the secondary cache thread.
+@protocol RMCacheURLSource <NSObject>
+- (NSString *)tileURL:(RMTile)tile;
+@end
+
 // The cache entry object represents a single chunk of data that has been fetched
 // from a URL based key (could be disk or network, doesn't really matter,
 // though for now the underlying implementation is only using network as a source).
@@ -96,6 +110,9 @@ typedef struct {
 
 @interface RMCacheEntry : NSObject <NSCoding,RMCacheable> {
 	NSString *key;					// a URL in string form, mapping us to our data 
+	RMCacheKey cacheKey;			// the key the caches use, see RMCacheKey
+	id <RMCacheURLSource> source;		// for a tile entry, builds the key URL
+	RMTile tile;						// when it is first needed
 	NSMutableData *data;				// the data we have or will get 
 	NSString *filename;					// where we are stored in the filesystem,
 										// this ivar is set to nil by the secondary
@@ -121,8 +138,17 @@ typedef struct {
 #  define STAMPWITH(a,b,c)
 #endif
 
+// Makes an entry for the tile with the given key, whose URL is left to
+// source until it is needed.
++ (RMCacheEntry *)entryForTile:(RMTile)tile cacheKey:(RMCacheKey)cacheKey source:(id <RMCacheURLSource>)source;
+
 // properties
+
+// For an entry made by entryForTile:cacheKey:source: this is built the first
+// time it is asked for; that must not happen from two threads at once.
 @property (nonatomic,retain) NSString *key;
+// set from the key if it was not given
+@property (nonatomic,assign) RMCacheKey cacheKey;
 @property (nonatomic,retain) NSData *data;
 @property (nonatomic,retain) NSString *filename;
 @property (nonatomic,assign) id<RMCacheDelegate> delegate;
@@ -15,7 +15,49 @@
 
 @implementation RMCacheEntry
 
-@synthesize filename,data,key,delegate;
+@synthesize filename,data,delegate;
+
++ (RMCacheEntry *)entryForTile:(RMTile)tile cacheKey:(RMCacheKey)cacheKey source:(id <RMCacheURLSource>)source;
+{
+	RMCacheEntry *entry = [[self new] autorelease];
+	entry->tile = tile;
+	entry->cacheKey = cacheKey;
+	entry->source = [source retain];
+	return entry;
+}
+
+@dynamic key;
+
+- (NSString *)key;
+{
+	if (!key && source) {
+		key = [[source tileURL:tile] retain];
+	}
+	return key;
+}
+
+- (void)setKey:(NSString *)newKey;
+{
+	if (key != newKey) {
+		[key release];
+		key = [newKey retain];
+	}
+}
+
+@dynamic cacheKey;
+
+- (RMCacheKey)cacheKey;
+{
+	if (!cacheKey && key) {
+		cacheKey = RMCacheKeyForURL(key);
+	}
+	return cacheKey;
+}
+
+- (void)setCacheKey:(RMCacheKey)newKey;
+{
+	cacheKey = newKey;
+}
 
 #ifdef RM_CACHE_DEBUG
 @dynamic timestamp;
@@ -38,8 +80,9 @@
 - (NSString *)description;
 {
 	NSMutableString *string = 
-	[NSMutableString stringWithFormat:@"++++{ bytes = %u, key = %@ }\n",
+	[NSMutableString stringWithFormat:@"++++{ bytes = %u, key = %qx %@ }\n",
 		[data length],
+	 [self cacheKey],
 	 key];
 #ifdef RM_CACHE_DEBUG
 #define PRINT(tag) \
@@ -74,7 +117,7 @@ static NSString * const kRMCacheEntryData = @"RMData";
 
 - (void)encodeWithCoder:(NSCoder *)coder
 {
-	[coder encodeObject:key forKey:kRMCacheEntryResource];
+	[coder encodeObject:[self key] forKey:kRMCacheEntryResource];
 	[coder encodeObject:data forKey:kRMCacheEntryData];
 	STAMP(self,filesystem.written);
 }
@@ -84,6 +127,7 @@ static NSString * const kRMCacheEntryData = @"RMData";
 	[filename release];
 	[data release];
 	[key release];
+	[source release];
 	[super dealloc];
 }
 
@@ -96,9 +140,9 @@ static NSString * const kRMCacheEntryData = @"RMData";
 {
 #if PARANOIA_IS_THE_ANSWER
   // clean the string out of paranoia
-  NSString *query = [key stringByAddingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+  NSString *query = [[self key] stringByAddingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
 #else
-  NSString *query = key;
+  NSString *query = [self key];
 #endif
   NSURL *url = [NSURL URLWithString:query];
   return url;
@@ -0,0 +1,534 @@
+//
+//  RMCachePolicy.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "RMCachePolicy.h"
+#include "RMKeyTable.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// 2Q: the share of the limit for the FIFO of new values, and the bytes of
+// evicted values the ghost list remembers, as in the paper
+#define k2QInPercent			25
+#define k2QGhostPercent			50
+
+// W-TinyLFU: the window and the protected part of the main LRU. Tiles are
+// large next to the cache, so the window is 10% rather than the paper's 1%,
+// or it would not hold a single tile
+#define kTinyLFUWindowPercent	10
+#define kTinyLFUProtectedPercent	80
+
+// the sketch has a counter per row for each of about limit / this many
+// bytes, and halves its counters after ten times that many requests
+#define kTinyLFUBytesPerCounter	2048
+#define kTinyLFUMinCounters		64
+#define kTinyLFURows			4
+#define kTinyLFUMaxCount		15
+
+// what the lists are used for in each policy
+enum {
+	kListMain,			// LRU: everything, 2Q: Am, TinyLFU: protected
+	kListIn,			// 2Q: A1in, TinyLFU: window
+	kListProbation,		// TinyLFU: probation
+	kListGhost,			// 2Q: A1out, keys only
+	kListCount,
+	kListNone = kListCount
+};
+
+typedef struct RMCachePolicyCell {
+	struct RMCachePolicyCell *left;
+	struct RMCachePolicyCell *right;
+	uint64_t key;
+	void *value;		// NULL for a ghost
+	size_t length;
+	int list;
+} RMCachePolicyCell;
+
+typedef struct {
+	RMCachePolicyCell *start;		// most recent
+	RMCachePolicyCell *end;			// next out
+	size_t length;
+	unsigned count;
+} RMCachePolicyList;
+
+struct RMCachePolicy {
+	RMCachePolicyType type;
+	size_t limit;
+	RMCachePolicyList lists[kListCount];
+	size_t listLimits[kListCount];
+	RMKeyTable *mapping;			// keys to cells, ghosts included
+	RMCachePolicyCell *bin;			// recycled cells
+	RMCachePolicyEvictFunction evict;
+	void *context;
+
+	// TinyLFU count-min sketch, kTinyLFURows rows of sketchMask + 1 counters
+	uint8_t *sketch;
+	unsigned sketchMask;
+	unsigned samples;
+	unsigned sampleLimit;
+};
+
+static const char * const RMCachePolicyNames[kRMCachePolicyCount] = {
+	"LRU", "2Q", "TinyLFU"
+};
+
+/////////////////////////////////////////////////////////////// LISTS
+
+static inline RMCachePolicyCell *
+RMCachePolicyNewCell(RMCachePolicy *cache)
+{
+	RMCachePolicyCell *cell = cache->bin;
+
+	if (cell) {
+		cache->bin = cell->right;
+		memset(cell, 0, sizeof(*cell));
+	} else {
+		cell = calloc(1, sizeof(RMCachePolicyCell));
+	}
+	return cell;
+}
+
+static inline void
+RMCachePolicyPushFront(RMCachePolicy *cache, int index, RMCachePolicyCell *cell)
+{
+	RMCachePolicyList *list = cache->lists + index;
+
+	cell->list = index;
+	cell->left = NULL;
+	cell->right = list->start;
+	if (list->start)
+		list->start->left = cell;
+	else
+		list->end = cell;
+	list->start = cell;
+	list->length += cell->length;
+	list->count++;
+}
+
+static inline void
+RMCachePolicyUnlink(RMCachePolicy *cache, RMCachePolicyCell *cell)
+{
+	RMCachePolicyList *list;
+
+	if (cell->list == kListNone)
+		return;
+	list = cache->lists + cell->list;
+	if (cell->left)
+		cell->left->right = cell->right;
+	else
+		list->start = cell->right;
+	if (cell->right)
+		cell->right->left = cell->left;
+	else
+		list->end = cell->left;
+	list->length -= cell->length;
+	list->count--;
+	cell->list = kListNone;
+}
+
+static inline void
+RMCachePolicyMove(RMCachePolicy *cache, int index, RMCachePolicyCell *cell)
+{
+	if (cell->list != index || cache->lists[index].start != cell) {
+		RMCachePolicyUnlink(cache, cell);
+		RMCachePolicyPushFront(cache, index, cell);
+	}
+}
+
+// forgets the cell altogether, evicting its value
+static void
+RMCachePolicyDrop(RMCachePolicy *cache, RMCachePolicyCell *cell)
+{
+	RMCachePolicyUnlink(cache, cell);
+	RMKeyTableRemove(cache->mapping, cell->key);
+	if (cell->value)
+		cache->evict(cell->key, cell->value, cache->context);
+	cell->right = cache->bin;
+	cache->bin = cell;
+}
+
+// evicts the value of the cell but remembers its key on the ghost list
+static void
+RMCachePolicyBanish(RMCachePolicy *cache, RMCachePolicyCell *cell)
+{
+	RMCachePolicyList *ghosts = cache->lists + kListGhost;
+	void *value = cell->value;
+
+	RMCachePolicyUnlink(cache, cell);
+	cell->value = NULL;
+	RMCachePolicyPushFront(cache, kListGhost, cell);
+	cache->evict(cell->key, value, cache->context);
+	while (ghosts->length > cache->listLimits[kListGhost])
+		RMCachePolicyDrop(cache, ghosts->end);
+}
+
+static inline size_t
+RMCachePolicyResident(const RMCachePolicy *cache)
+{
+	return cache->lists[kListMain].length + cache->lists[kListIn].length
+		+ cache->lists[kListProbation].length;
+}
+
+/////////////////////////////////////////////////////////////// SKETCH
+
+static inline unsigned
+RMCachePolicySketchIndex(const RMCachePolicy *cache, uint64_t key, unsigned row)
+{
+	uint64_t h = (key + row) * 0x9E3779B97F4A7C15ULL;
+
+	h ^= h >> 29;
+	return row * (cache->sketchMask + 1) + ((unsigned)(h >> 32) & cache->sketchMask);
+}
+
+static unsigned
+RMCachePolicyFrequency(const RMCachePolicy *cache, uint64_t key)
+{
+	unsigned row, count, min = kTinyLFUMaxCount;
+
+	for (row = 0; row < kTinyLFURows; row++)
+		if ((count = cache->sketch[RMCachePolicySketchIndex(cache, key, row)]) < min)
+			min = count;
+	return min;
+}
+
+// conservative update: only the counters at the minimum go up, which keeps
+// the others from being inflated by the keys they collide with
+static void
+RMCachePolicyRecord(RMCachePolicy *cache, uint64_t key)
+{
+	unsigned row, min = RMCachePolicyFrequency(cache, key), i;
+
+	if (min < kTinyLFUMaxCount)
+		for (row = 0; row < kTinyLFURows; row++)
+			if (cache->sketch[i = RMCachePolicySketchIndex(cache, key, row)] == min)
+				cache->sketch[i]++;
+
+	// age: halving every counter now and then lets the sketch forget
+	// what was popular a while ago
+	if (++cache->samples >= cache->sampleLimit) {
+		for (i = 0; i < kTinyLFURows * (cache->sketchMask + 1); i++)
+			cache->sketch[i] >>= 1;
+		cache->samples /= 2;
+	}
+}
+
+static int
+RMCachePolicySizeSketch(RMCachePolicy *cache)
+{
+	size_t wanted = cache->limit / kTinyLFUBytesPerCounter;
+	unsigned width = kTinyLFUMinCounters;
+	uint8_t *sketch;
+
+	while (width < wanted && width < (1U << 24))
+		width <<= 1;
+	if (!(sketch = calloc(kTinyLFURows * (size_t)width, 1)))
+		return -1;
+	free(cache->sketch);
+	cache->sketch = sketch;
+	cache->sketchMask = width - 1;
+	cache->samples = 0;
+	cache->sampleLimit = 10 * width;
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////// POLICIES
+
+static void
+RMCachePolicySetLimits(RMCachePolicy *cache)
+{
+	size_t limit = cache->limit, rest;
+
+	memset(cache->listLimits, 0, sizeof(cache->listLimits));
+	switch (cache->type) {
+		case kRMCachePolicy2Q:
+			cache->listLimits[kListIn] = limit / 100 * k2QInPercent;
+			cache->listLimits[kListGhost] = limit / 100 * k2QGhostPercent;
+			break;
+		case kRMCachePolicyTinyLFU:
+			cache->listLimits[kListIn] = limit / 100 * kTinyLFUWindowPercent;
+			rest = limit - cache->listLimits[kListIn];
+			cache->listLimits[kListMain] = rest / 100 * kTinyLFUProtectedPercent;
+			cache->listLimits[kListProbation] = rest;	// with protected
+			break;
+		default:
+			break;
+	}
+}
+
+// TinyLFU: demotes from protected to probation until protected fits
+static void
+RMCachePolicyFitProtected(RMCachePolicy *cache)
+{
+	RMCachePolicyList *protection = cache->lists + kListMain;
+
+	while (protection->length > cache->listLimits[kListMain] && protection->count > 1)
+		RMCachePolicyMove(cache, kListProbation, protection->end);
+}
+
+// TinyLFU: a value out of the window gets into the main LRU only by being
+// requested more often than each value it has to push out
+static void
+RMCachePolicyAdmit(RMCachePolicy *cache, RMCachePolicyCell *candidate)
+{
+	RMCachePolicyList *probation = cache->lists + kListProbation;
+	RMCachePolicyList *protection = cache->lists + kListMain;
+	size_t limit = cache->listLimits[kListProbation];
+	unsigned frequency = RMCachePolicyFrequency(cache, candidate->key);
+	RMCachePolicyCell *victim;
+
+	while (probation->length + protection->length + candidate->length > limit) {
+		victim = probation->end ? probation->end : protection->end;
+		if (!victim || RMCachePolicyFrequency(cache, victim->key) >= frequency) {
+			RMCachePolicyDrop(cache, candidate);
+			return;
+		}
+		RMCachePolicyDrop(cache, victim);
+	}
+	RMCachePolicyPushFront(cache, kListProbation, candidate);
+}
+
+static void
+RMCachePolicyReclaim(RMCachePolicy *cache)
+{
+	RMCachePolicyList *am = cache->lists + kListMain;
+	RMCachePolicyList *in = cache->lists + kListIn;
+	RMCachePolicyList *probation = cache->lists + kListProbation;
+	RMCachePolicyCell *cell;
+
+	switch (cache->type) {
+		case kRMCachePolicyLRU:
+			while (am->length > cache->limit)
+				RMCachePolicyDrop(cache, am->end);
+			break;
+
+		case kRMCachePolicy2Q:
+			while (RMCachePolicyResident(cache) > cache->limit) {
+				if (in->end && (in->length > cache->listLimits[kListIn] || !am->end))
+					RMCachePolicyBanish(cache, in->end);
+				else
+					RMCachePolicyDrop(cache, am->end);
+			}
+			break;
+
+		case kRMCachePolicyTinyLFU:
+			while (in->length > cache->listLimits[kListIn]) {
+				cell = in->end;
+				RMCachePolicyUnlink(cache, cell);
+				RMCachePolicyAdmit(cache, cell);
+			}
+			// only needed when the limit comes down
+			while (probation->length + am->length > cache->listLimits[kListProbation])
+				RMCachePolicyDrop(cache, probation->end ? probation->end : am->end);
+			RMCachePolicyFitProtected(cache);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/////////////////////////////////////////////////////////////// PUBLIC
+
+RMCachePolicy *
+RMCachePolicyCreate(RMCachePolicyType type, size_t limit,
+					RMCachePolicyEvictFunction evict, void *context)
+{
+	RMCachePolicy *cache = calloc(1, sizeof(RMCachePolicy));
+
+	if (!cache)
+		return NULL;
+	cache->type = type < kRMCachePolicyCount ? type : kRMCachePolicyLRU;
+	cache->limit = limit;
+	cache->evict = evict;
+	cache->context = context;
+	if (!(cache->mapping = RMKeyTableCreate())
+		|| (cache->type == kRMCachePolicyTinyLFU && RMCachePolicySizeSketch(cache) != 0)) {
+		RMKeyTableFree(cache->mapping);
+		free(cache);
+		return NULL;
+	}
+	RMCachePolicySetLimits(cache);
+	return cache;
+}
+
+void
+RMCachePolicyFree(RMCachePolicy *cache)
+{
+	RMCachePolicyCell *cell;
+
+	if (!cache)
+		return;
+	RMCachePolicyEmpty(cache);
+	while ((cell = cache->bin)) {
+		cache->bin = cell->right;
+		free(cell);
+	}
+	RMKeyTableFree(cache->mapping);
+	free(cache->sketch);
+	free(cache);
+}
+
+void *
+RMCachePolicyGet(RMCachePolicy *cache, uint64_t key)
+{
+	RMCachePolicyCell *cell = RMKeyTableGet(cache->mapping, key);
+
+	if (cache->type == kRMCachePolicyTinyLFU)
+		RMCachePolicyRecord(cache, key);
+	if (!cell || !cell->value)
+		return NULL;
+
+	switch (cell->list) {
+		case kListMain:
+			RMCachePolicyMove(cache, kListMain, cell);
+			break;
+		case kListIn:
+			// the 2Q FIFO does not reorder on a hit
+			if (cache->type == kRMCachePolicyTinyLFU)
+				RMCachePolicyMove(cache, kListIn, cell);
+			break;
+		case kListProbation:
+			RMCachePolicyMove(cache, kListMain, cell);
+			RMCachePolicyFitProtected(cache);
+			break;
+	}
+	return cell->value;
+}
+
+int
+RMCachePolicyAdd(RMCachePolicy *cache, uint64_t key, void *value, size_t length)
+{
+	RMCachePolicyCell *cell = RMKeyTableGet(cache->mapping, key);
+	void *old;
+	int list;
+
+	if (cell && cell->value) {
+		// a new value for a key we hold stays where the old one was
+		list = cell->list;
+		old = cell->value;
+		RMCachePolicyUnlink(cache, cell);
+		cell->value = value;
+		cell->length = length;
+		RMCachePolicyPushFront(cache, list, cell);
+		cache->evict(key, old, cache->context);
+	} else if (cell) {
+		// 2Q: requested again since it was banished, so it is no scan
+		RMCachePolicyUnlink(cache, cell);
+		cell->value = value;
+		cell->length = length;
+		RMCachePolicyPushFront(cache, kListMain, cell);
+	} else {
+		if (!(cell = RMCachePolicyNewCell(cache))) {
+			cache->evict(key, value, cache->context);
+			return -1;
+		}
+		cell->key = key;
+		cell->value = value;
+		cell->length = length;
+		cell->list = kListNone;
+		if (RMKeyTableSet(cache->mapping, key, cell) != 0) {
+			cell->value = NULL;
+			cell->right = cache->bin;
+			cache->bin = cell;
+			cache->evict(key, value, cache->context);
+			return -1;
+		}
+		RMCachePolicyPushFront(cache, cache->type == kRMCachePolicyLRU ? kListMain : kListIn, cell);
+	}
+	RMCachePolicyReclaim(cache);
+	return 0;
+}
+
+void *
+RMCachePolicyRemove(RMCachePolicy *cache, uint64_t key)
+{
+	RMCachePolicyCell *cell = RMKeyTableGet(cache->mapping, key);
+	void *value;
+
+	if (!cell || !(value = cell->value))
+		return NULL;
+	cell->value = NULL;
+	RMCachePolicyDrop(cache, cell);
+	return value;
+}
+
+void
+RMCachePolicySetLimit(RMCachePolicy *cache, size_t limit)
+{
+	cache->limit = limit;
+	RMCachePolicySetLimits(cache);
+	// if there is no memory for a sketch to suit, the old one will do
+	if (cache->type == kRMCachePolicyTinyLFU)
+		(void)RMCachePolicySizeSketch(cache);
+	RMCachePolicyReclaim(cache);
+	while (cache->lists[kListGhost].length > cache->listLimits[kListGhost])
+		RMCachePolicyDrop(cache, cache->lists[kListGhost].end);
+}
+
+void
+RMCachePolicyEmpty(RMCachePolicy *cache)
+{
+	int i;
+
+	for (i = 0; i < kListCount; i++)
+		while (cache->lists[i].end)
+			RMCachePolicyDrop(cache, cache->lists[i].end);
+	if (cache->sketch) {
+		memset(cache->sketch, 0, kTinyLFURows * (size_t)(cache->sketchMask + 1));
+		cache->samples = 0;
+	}
+}
+
+unsigned
+RMCachePolicyCount(const RMCachePolicy *cache)
+{
+	return cache->lists[kListMain].count + cache->lists[kListIn].count
+		+ cache->lists[kListProbation].count;
+}
+
+size_t
+RMCachePolicyLength(const RMCachePolicy *cache)
+{
+	return RMCachePolicyResident(cache);
+}
+
+const char *
+RMCachePolicyName(RMCachePolicyType type)
+{
+	return type < kRMCachePolicyCount ? RMCachePolicyNames[type] : NULL;
+}
+
+RMCachePolicyType
+RMCachePolicyTypeForName(const char *name)
+{
+	int type;
+
+	for (type = 0; name && type < kRMCachePolicyCount; type++)
+		if (strcasecmp(name, RMCachePolicyNames[type]) == 0)
+			return (RMCachePolicyType)type;
+	return kRMCachePolicyCount;
+}
@@ -0,0 +1,102 @@
+//
+//  RMCachePolicy.h
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _RM_CACHE_POLICY_H_
+#define _RM_CACHE_POLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \file RMCachePolicy.h
+ \brief The replacement policies behind RMPrimaryCache.
+
+ A policy holds values by 64 bit key up to a limit in bytes, each value
+ weighing the length it was added with, and hands the values it lets go of
+ to an evict function. It is plain C so the cache simulator in Benchmarks
+ runs the same code as the map.
+
+ - kRMCachePolicyLRU evicts the least recently used value. One pass over
+   new tiles, a fling across the map or a zoom out, flushes everything.
+ - kRMCachePolicy2Q (Johnson and Shasha) takes new values into a FIFO of a
+   quarter of the limit. Only a value requested again after it has left the
+   FIFO, which a ghost list of keys remembers, gets into the main LRU, so a
+   scan passes through the FIFO alone.
+ - kRMCachePolicyTinyLFU (W-TinyLFU, Einziger, Friedman and Manes) keeps
+   new values in a small LRU window. A value leaving the window only gets
+   into the main segmented LRU if a count-min sketch of recent requests
+   says it is asked for more often than the value it would push out.
+
+ All of them are O(1) per request. A policy is not thread safe.
+ */
+
+typedef enum {
+	kRMCachePolicyLRU,
+	kRMCachePolicy2Q,
+	kRMCachePolicyTinyLFU,
+	kRMCachePolicyCount
+} RMCachePolicyType;
+
+typedef struct RMCachePolicy RMCachePolicy;
+
+typedef void (*RMCachePolicyEvictFunction)(uint64_t key, void *value, void *context);
+
+/// Returns an empty cache holding up to limit bytes, or NULL if out of memory.
+RMCachePolicy *RMCachePolicyCreate(RMCachePolicyType type, size_t limit,
+								   RMCachePolicyEvictFunction evict, void *context);
+
+/// Evicts every value and releases the cache.
+void RMCachePolicyFree(RMCachePolicy *cache);
+
+/// The value for key or NULL. Either way it counts as a request of key.
+void *RMCachePolicyGet(RMCachePolicy *cache, uint64_t key);
+
+/// Adds value under key, evicting any value already there, and then evicts
+/// down to the limit, which may be value itself. value must not be NULL.
+/// Returns 0, or -1 if out of memory, when value is evicted at once.
+int RMCachePolicyAdd(RMCachePolicy *cache, uint64_t key, void *value, size_t length);
+
+/// Takes the value for key out of the cache without evicting it and
+/// returns it, or NULL. The requests of key are not forgotten.
+void *RMCachePolicyRemove(RMCachePolicy *cache, uint64_t key);
+
+/// Changes the limit, evicting down to it.
+void RMCachePolicySetLimit(RMCachePolicy *cache, size_t limit);
+
+/// Evicts every value and forgets every request.
+void RMCachePolicyEmpty(RMCachePolicy *cache);
+
+/// Number of values held and the sum of their lengths.
+unsigned RMCachePolicyCount(const RMCachePolicy *cache);
+size_t RMCachePolicyLength(const RMCachePolicy *cache);
+
+/// "LRU", "2Q" and "TinyLFU", the names the defaults use.
+const char *RMCachePolicyName(RMCachePolicyType type);
+
+/// The type with the name, ignoring case, or kRMCachePolicyCount if none.
+RMCachePolicyType RMCachePolicyTypeForName(const char *name);
+
+#endif
@@ -22,12 +22,27 @@
 // there are other ways around this but it makes no sense given the
 // memory issues we're facing
 
-#ifdef RM_EXPERIMENTAL__
-
-
 #import <UIKit/UIKit.h>
 #import "RMCacheEntry.h"
 
+//
+// A utility function to return the estimated decompressed size of an image.
+// Returns the length in bytes required to store the image.
+// 
+extern size_t
+RMImageGetLength(CGImageRef image);
+
+//
+// Makes an image from PNG or JPEG data and decompresses it there and then,
+// rather than every time it is drawn, which is what the decoded tier of
+// RMPrimaryCache holds. Returns nil if the data is not an image.
+//
+extern UIImage *
+RMImageDecodedFromData(NSData *data);
+
+#ifdef RM_EXPERIMENTAL__
+
+
 //
 // A subclass of UIImage which makes it somewhat interchangeable with
 // RMCacheEntry, at least for measuring size and tracking it in a data 
@@ -48,21 +63,17 @@
 // for the default key to change the default situation.
 
 
-//
-// A utility function to return the estimated decompressed size of an image.
-// Returns the length in bytes required to store the image.
-// 
-extern size_t
-RMImageGetLength(CGImageRef image);
 
 
 @interface RMImage : UIImage <RMCacheable> {
 	NSString *key;  // a key for the cache
+	RMCacheKey cacheKey;	// and its integer form, set with the key
 	NSUInteger length;	 // our estimated length, which is calculated and then cached 
 						 // since we are data-immutable
 }
 
 @property (nonatomic,retain) NSString *key;
+@property (nonatomic,assign) RMCacheKey cacheKey;
 @property (nonatomic,readonly) NSUInteger length;
 
 
@@ -1,4 +1,3 @@
-#ifdef RM_EXPERIMENTAL__
 //
 //  Created by samurai on 3/6/09.
 //  Copyright 2009 quarrelso.me. All rights reserved. This code is hereby 
@@ -24,9 +23,57 @@ RMImageGetLength(CGImageRef image)
 	return length;
 }
 
+// Draws the image into a bitmap context of the layout the screen uses,
+// 32 bit premultiplied BGRA, so Core Animation can use the pixels as they
+// are. If that fails the image is just left compressed.
+UIImage *
+RMImageDecodedFromData(NSData *data)
+{
+	UIImage *compressed = [UIImage imageWithData:data];
+	CGImageRef source = [compressed CGImage];
+	if (!source) {
+		return nil;
+	}
+	size_t width = CGImageGetWidth(source);
+	size_t height = CGImageGetHeight(source);
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef context = 
+		CGBitmapContextCreate(NULL, 
+							  width, 
+							  height, 
+							  8, 
+							  width*4, 
+							  colorSpace, 
+							  kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+	CGColorSpaceRelease(colorSpace);
+	if (!context) {
+		return compressed;
+	}
+	CGContextDrawImage(context,CGRectMake(0,0,width,height),source);
+	CGImageRef decoded = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+	if (!decoded) {
+		return compressed;
+	}
+	UIImage *image = [UIImage imageWithCGImage:decoded];
+	CGImageRelease(decoded);
+	return image;
+}
+
+#ifdef RM_EXPERIMENTAL__
+
 @implementation RMImage
 
-@synthesize key;
+@synthesize key,cacheKey;
+
+- (void)setKey:(NSString *)newKey;
+{
+	if (key != newKey) {
+		[key release];
+		key = [newKey retain];
+		cacheKey = key ? RMCacheKeyForURL(key) : 0;
+	}
+}
 
 - (void)dealloc
 {
@@ -0,0 +1,178 @@
+//
+//  RMKeyTable.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "RMKeyTable.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define kRMKeyTableMinSlots	64
+
+typedef struct {
+	uint64_t key;
+	void *value;
+} RMKeyTableSlot;
+
+struct RMKeyTable {
+	RMKeyTableSlot *slots;
+	unsigned mask;
+	unsigned count;
+};
+
+static inline unsigned
+RMKeyTableHash(uint64_t key)
+{
+	// Fibonacci hashing, the high bits are the well mixed ones
+	return (unsigned)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// the slot holding key, or the empty slot where it would go
+static inline unsigned
+RMKeyTableProbe(const RMKeyTable *table, uint64_t key)
+{
+	unsigned i = RMKeyTableHash(key) & table->mask;
+
+	while (table->slots[i].value && table->slots[i].key != key)
+		i = (i + 1) & table->mask;
+	return i;
+}
+
+static int
+RMKeyTableResize(RMKeyTable *table, unsigned slotCount)
+{
+	RMKeyTableSlot *old = table->slots;
+	unsigned i, oldCount = table->mask + 1;
+
+	if (!(table->slots = calloc(slotCount, sizeof(RMKeyTableSlot)))) {
+		table->slots = old;
+		return -1;
+	}
+	table->mask = slotCount - 1;
+	for (i = 0; i < oldCount; i++)
+		if (old[i].value)
+			table->slots[RMKeyTableProbe(table, old[i].key)] = old[i];
+	free(old);
+	return 0;
+}
+
+RMKeyTable *
+RMKeyTableCreate(void)
+{
+	RMKeyTable *table = calloc(1, sizeof(RMKeyTable));
+
+	if (table && !(table->slots = calloc(kRMKeyTableMinSlots, sizeof(RMKeyTableSlot)))) {
+		free(table);
+		return NULL;
+	}
+	if (table)
+		table->mask = kRMKeyTableMinSlots - 1;
+	return table;
+}
+
+void
+RMKeyTableFree(RMKeyTable *table)
+{
+	if (table) {
+		free(table->slots);
+		free(table);
+	}
+}
+
+void *
+RMKeyTableGet(const RMKeyTable *table, uint64_t key)
+{
+	return table->slots[RMKeyTableProbe(table, key)].value;
+}
+
+int
+RMKeyTableSet(RMKeyTable *table, uint64_t key, void *value)
+{
+	unsigned i = RMKeyTableProbe(table, key);
+
+	if (!table->slots[i].value) {
+		// keep the table at most half full
+		if (2 * (table->count + 1) > table->mask + 1) {
+			if (RMKeyTableResize(table, 2 * (table->mask + 1)) != 0)
+				return -1;
+			i = RMKeyTableProbe(table, key);
+		}
+		table->slots[i].key = key;
+		table->count++;
+	}
+	table->slots[i].value = value;
+	return 0;
+}
+
+void *
+RMKeyTableRemove(RMKeyTable *table, uint64_t key)
+{
+	unsigned mask = table->mask, hole = RMKeyTableProbe(table, key), i = hole, home;
+	void *value = table->slots[hole].value;
+
+	if (!value)
+		return NULL;
+
+	// backward shift: move up any later key of the probe run that would
+	// no longer be found across the hole
+	for (;;) {
+		i = (i + 1) & mask;
+		if (!table->slots[i].value)
+			break;
+		home = RMKeyTableHash(table->slots[i].key) & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			table->slots[hole] = table->slots[i];
+			hole = i;
+		}
+	}
+	table->slots[hole].value = NULL;
+	table->count--;
+	return value;
+}
+
+void
+RMKeyTableRemoveAll(RMKeyTable *table)
+{
+	memset(table->slots, 0, (table->mask + 1) * sizeof(RMKeyTableSlot));
+	table->count = 0;
+}
+
+unsigned
+RMKeyTableCount(const RMKeyTable *table)
+{
+	return table->count;
+}
+
+void
+RMKeyTableApply(const RMKeyTable *table,
+				void (*function)(uint64_t key, void *value, void *context),
+				void *context)
+{
+	unsigned i;
+
+	for (i = 0; i <= table->mask; i++)
+		if (table->slots[i].value)
+			function(table->slots[i].key, table->slots[i].value, context);
+}
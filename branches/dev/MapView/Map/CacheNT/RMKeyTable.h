@@ -0,0 +1,77 @@
+//
+//  RMKeyTable.h
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _RM_KEY_TABLE_H_
+#define _RM_KEY_TABLE_H_
+
+#include <stdint.h>
+
+/*! \file RMKeyTable.h
+ \brief A hash table from 64 bit cache keys to pointers.
+
+ The cache looks tiles up by RMCacheKey on every frame, so instead of
+ boxing keys for a CFDictionary the tables are open addressing arrays of
+ key and value pairs, probed linearly from a Fibonacci hash of the key and
+ kept at most half full. Removal shifts the rest of the probe run back, so
+ there are no tombstones and lookups stay short however much the table
+ churns.
+
+ Values are not retained and must not be NULL, which marks an empty slot.
+ A table is not thread safe.
+ */
+
+typedef struct RMKeyTable RMKeyTable;
+
+/// Returns an empty table, or NULL if out of memory.
+RMKeyTable *RMKeyTableCreate(void);
+
+/// Releases the table, not the values in it.
+void RMKeyTableFree(RMKeyTable *table);
+
+/// The value stored under key, or NULL.
+void *RMKeyTableGet(const RMKeyTable *table, uint64_t key);
+
+/// Stores value under key, replacing any value there. Returns 0, or -1 if
+/// the table could not grow.
+int RMKeyTableSet(RMKeyTable *table, uint64_t key, void *value);
+
+/// Removes key and returns the value that was stored under it, or NULL.
+void *RMKeyTableRemove(RMKeyTable *table, uint64_t key);
+
+/// Removes every key.
+void RMKeyTableRemoveAll(RMKeyTable *table);
+
+/// Number of keys stored.
+unsigned RMKeyTableCount(const RMKeyTable *table);
+
+/// Calls function for every key and value, in no particular order. The
+/// function must not change the table.
+void RMKeyTableApply(const RMKeyTable *table,
+					 void (*function)(uint64_t key, void *value, void *context),
+					 void *context);
+
+#endif
@@ -12,22 +12,27 @@
 
 #import <Foundation/Foundation.h>
 #import "RMCacheEntry.h"
+#import "RMCachePolicy.h"
 
-// This object has its guts implemented in C for high performance. 
+// This object has its guts implemented in C for high performance, in
+// RMCachePolicy.c, which the cache simulator in Benchmarks shares.
 
 // The datastructure employed is a mixed hashtable / linked list. The 
-// hashtable gives O(1) lookup for inclusion testing / search of the 
-// linked list. The linked list gives O(1) delete anywhere in the list 
-// (once found) and O(1) addition to any known part of the list. Keeping
-// track of the head and tail means that new additions can be added
-// at the head O(1) and old items can be popped from the tail at O(1).
-// Overall this gives an O(1) datastructure which is appropriate for
-// maintaining least recently used information regarding a cache. Every
-// time a cached object is referenced, the object is moved to the head
-// of the linked list. Every time a new object is to enter, the oldest
-// is popped off the end.
-
-// The linked list also maintains a recycling bin for its cells, to
+// hashtable, an RMKeyTable on the cache key, gives O(1) lookup for 
+// inclusion testing / search of the linked lists. The linked lists give 
+// O(1) delete anywhere in the list (once found) and O(1) addition to
+// any known part of the list. Every operation is O(1).
+
+// Which object goes when the cache is full is up to the policy, set with
+// kRMKeyPrimaryCachePolicy. "LRU" pops the least recently used object,
+// which is simple but lets a single fling across the map push out every
+// tile around the places the user keeps going back to. "2Q" and "TinyLFU"
+// (the default) make new objects earn their place, by being asked for
+// again or by being asked for more often than what they would replace, so
+// a pass over tiles that are never seen again does not flush the cache.
+// See RMCachePolicy.h.
+
+// The lists also keep a recycling bin for their cells, to
 // avoid being caught up constantly in malloc/free, since the basic
 // mode of operation here is to add and delete, in and out. Reuse
 // brings low overhead and high performance in this regard.
@@ -44,25 +49,57 @@
 // if we keep them as PNG and let the decompression happen as they
 // are dropped into the map view.
 
-// linked list datastructure for the cache
-typedef struct __RMCache RMCache;
+// Except that a tile panned back and forth across the screen would then be
+// decompressed over and over, so the few most recently displayed tiles are
+// kept decoded as well, in a second tier above the PNG one and bounded by
+// kRMKeyPrimaryCacheDecodedMemoryLimit, counting the bytes of their bitmaps
+// with RMImageGetLength() and of the PNG data they keep. A tile is in one
+// tier or the other, the compressed one if it does not decode: decoding it
+// takes it out of the compressed tier, and when the decoded tier lets go of
+// it the PNG data goes back into the compressed tier. A memory warning
+// drops the decoded tier before anything else.
 
 // the primary cache is a cache delegate, taking its RMCacheEntry updates
 // from the RMTileFactory that manipulates it
 @interface RMPrimaryCache : NSObject
 {
 	NSUInteger memoryLimit;
-	RMCache *cache;
+	RMCachePolicyType policy;
+	RMCachePolicy *cache;
+	// the decoded tier, an LRU of RMDecodedTile
+	NSUInteger decodedMemoryLimit;
+	RMCachePolicy *decoded;
+	// set while the decoded tier is being dropped rather than demoted
+	BOOL dropping;
 }
 
 // changing the memory limit will cause the cache to immediately 
 // size itself down to respect the new limit if necessary
 @property (nonatomic,assign) NSUInteger memoryLimit;
+// the same for the decoded tier
+@property (nonatomic,assign) NSUInteger decodedMemoryLimit;
+
+// the replacement policy, from kRMKeyPrimaryCachePolicy at startup
+@property (nonatomic,readonly) RMCachePolicyType policy;
 
 // returns nil, or the cached image for the key
+// looks up an object by the URL it was loaded from
 - (id <RMCacheable>)objectForKey:(NSString *)key;
+// and by its cache key, which is what the cache is keyed on
+- (id <RMCacheable>)objectForCacheKey:(RMCacheKey)key;
 - (void)addObject:(id <RMCacheable>)entry;
 
+// returns nil, or the decoded image for the key, decoding it from the
+// compressed tier if it is not in the decoded one
+- (UIImage *)imageForCacheKey:(RMCacheKey)key;
+// decodes the entry that just came in for display and puts it straight
+// into the decoded tier, returning the image, or nil if it is no image, in
+// which case it goes into the compressed tier as before
+- (UIImage *)addImageForEntry:(RMCacheEntry *)entry;
+
+// drops the decoded tier, or if that is already empty, the compressed one
+- (void)didReceiveMemoryWarning;
+
 // empties the cache
 - (void)empty;
 
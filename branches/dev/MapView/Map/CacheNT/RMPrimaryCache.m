@@ -12,31 +12,24 @@
 
 #import "RMPrimaryCache.h"
 #import "RMTileImage.h"
+#import "RMImage.h"
 
 // default keys and values
 
 NSString * const kRMKeyPrimaryCacheMemoryLimit = @"RMPrimaryCacheSize";
 NSUInteger kRMDefaultPrimaryCacheMemoryLimit = 1000000;
 
+NSString * const kRMKeyPrimaryCachePolicy = @"RMPrimaryCachePolicy";
+NSString * const kRMDefaultPrimaryCachePolicy = @"TinyLFU";
 
+NSString * const kRMKeyPrimaryCacheDecodedMemoryLimit = @"RMPrimaryCacheDecodedSize";
+NSUInteger kRMDefaultPrimaryCacheDecodedMemoryLimit = 3000000;
 
-// a cell in our cache structure, which is a double linked list
-typedef struct __RMCacheCell {
-	struct __RMCacheCell *left;
-	struct __RMCacheCell *right;	
-	id cached;    // object we're caching
-	int32_t length; // the size of the data it holds
-}  RMCacheCell;
-
-// the DLL master structure
-struct __RMCache {
-	RMCacheCell *start;   // head of the list
-	RMCacheCell *end;     // tail of the list
-	unsigned count;       // number of items we hold
-	unsigned length;        // total size of memory the cells cache
-	RMCacheCell *bin;     // a recycling bin to put used cells on
-	CFMutableDictionaryRef mapping;  // maps the key to a cache cell
-} ;
+// a tile in the decoded tier, holding on to its PNG data for the way down
+typedef struct {
+	RMCacheEntry *entry;
+	UIImage *image;
+} RMDecodedTile;
 
 @implementation RMPrimaryCache
 
@@ -48,260 +41,184 @@ struct __RMCache {
 #define i(a,b) [NSNumber numberWithInteger:a], b
 #define d(a,b) [NSNumber numberWithDouble:a], b
 #define f(a,b) [NSNumber numberWithFloat:a], b
+#define s(a,b) a, b
 
-///////////////////////////////////////////////////////////////// CACHE DATASTRUCTURE
-
-// for use in a CFDictionary to compare two cache cells
-static Boolean 
-RMCacheCellEqual(const void *value1,const void *value2)
-{
-	return ((RMCacheCell *)value1)->cached == ((RMCacheCell *)value2)->cached;
-}
-
-// creates a new cache cell, pulling it from the recycle bin if necessary
-static inline RMCacheCell *
-RMCacheNewCell(RMCache *self)
-{
-	RMCacheCell *cell;
-	if (self->bin) {
-		cell = self->bin;
-		memset(cell,'\0',sizeof(*cell));
-		self->bin = self->bin->right;
-	} else {
-		cell = calloc(1,sizeof(RMCacheCell));	
-	}
-	return cell;
-}
-
-// places a cell onto the recycle bin
-static inline void
-RMCacheRecycleCell(RMCache *self, RMCacheCell *cell)
+// the cache holds a retain on everything in it, given up here
+static void
+RMPrimaryCacheEvict(uint64_t key, void *cached, void *context)
 {
-	cell->right = self->bin;
-	self->bin = cell;
+	[(id)cached release];
 }
 
-// removes an arbitrary entry from the cache
+// a decoded tile going out of the decoded tier is demoted, unless the
+// whole tier is being dropped
 static void
-RMCacheRemove(RMCache *self, NSString *key)
+RMPrimaryCacheDemote(uint64_t key, void *value, void *context)
 {
-	RMCacheCell * cell = (void *)CFDictionaryGetValue(self->mapping,key);
-	CFDictionaryRemoveValue(self->mapping,key);
-	
-	RMCacheCell *left = cell->left;
-	RMCacheCell *right = cell->right;
-	if (left) {
-		left->right = right;
+	RMPrimaryCache *self = context;
+	RMDecodedTile *tile = value;
+	if (self->dropping) {
+		[tile->entry release];
 	} else {
-		self->start = right;
+		// hands over the retain on the entry
+		RMCachePolicyAdd(self->cache,key,tile->entry,[tile->entry length]);
 	}
-	if (right){
-		right->left = left;
-	} else {
-		self->end = left;
-	}
-	self->count--;
-	self->length -= cell->length;
-	[cell->cached release];
-	RMCacheRecycleCell(self,cell);
+	[tile->image release];
+	free(tile);
 }
 
-// adds a new cell to the cache and retains the item
-static inline void
-RMCacheAdd(RMCache *self, id cached)
-{
-	NSString *key = [cached key];
-	if (CFDictionaryContainsKey(self->mapping,key)){
-		RMCacheRemove(self,key);
-	}
-	RMCacheCell *cell = RMCacheNewCell(self);
-	cell->cached = [cached retain];
-	cell->length = [cached length];
-	self->length += cell->length;
-	self->count++;
-	if (!self->end) {
-		self->end = cell;
-	} else {
-		// if there is an end then there is a start
-		self->start->left = cell;
-	}
-	cell->right = self->start;
-	self->start = cell;
-	CFDictionaryAddValue(self->mapping,key,cell);
-}
+///////////////////////////////////////////////////////////////////// OBJECT
 
-// removes the last cell in the cache and releases
-// its contents
-static inline BOOL
-RMCachePop(RMCache *self)
-{
-	BOOL value = NO;
-	RMCacheCell *cell = self->end;
-	if (cell){
-		id cached = cell->cached;
-		self->length -= cell->length;
-		self->count--;
-		self->end = cell->left;
-		if (!self->end) {
-			self->start = 0;
-		} else {
-			self->end->right = 0;
-		}
-		RMCacheRecycleCell(self,cell);
-		CFDictionaryRemoveValue(self->mapping,[cached key]);
-		[cached release];
-		value = YES;
-	}
-	return value;
-}
 
-// removes a cell from an arbitrary position and establishes
-// it at the head of the list.
-static inline void
-RMCacheMoveCellToStart(RMCache *self, RMCacheCell *cell)
-{
-	RMCacheCell *left = cell->left;
-	if (left) {
-		// snip it out
-		RMCacheCell *right = cell->right;
-		if (right) {
-			right->left = left;
-		} else {
-			self->end = left;
-		}
-		left->right = right;
-		// stick it on the front
-		self->start->left = cell;
-		cell->right = self->start;
-		cell->left = 0;
-		self->start= cell;
-	}
-}
+@dynamic memoryLimit;
 
-// empties the cache and releases the contents... 
-static inline void
-RMCacheEmpty(RMCache *self)
+- (NSUInteger)memoryLimit;
 {
-	while(RMCachePop(self));
+	return memoryLimit;
 }
 
-// frees the memory associated with the cache
-// structure, and empties the cache, releasing 
-// the contents
-static inline void
-RMCacheFree(RMCache *self)
-{
-	RMCacheEmpty(self);
-	RMCacheCell *cell = self->bin;
-	while (cell) {
-		self->bin = cell->right;
-		free(cell);
-		cell = self->bin;
-	}
-	free(self);
-}
 
-// returns the object in the cache matching the key,
-// or returns nil... if the lookup is successful, the
-// object in the cache is moved to the head to implement
-// LRU sorting... constant time operations.
-static inline id
-RMCacheGetValue(RMCache *self, NSString *key)
+- (void)setMemoryLimit:(NSUInteger)newLimit;
 {
-	RMCacheCell *value = (RMCacheCell *)CFDictionaryGetValue(self->mapping,key);
-	if (value) {
-		RMCacheMoveCellToStart(self,value);
-		return value->cached;
-	} else {
-		return nil;
-	}
+	memoryLimit = newLimit;
+	RMCachePolicySetLimit(cache,memoryLimit);
 }
 
-// creates a new RMCache object
-static inline RMCache *
-RMCacheNew(void)
-{
-	RMCache *self = calloc(1,sizeof(RMCache));	
-	CFDictionaryValueCallBacks cb = {
-		0,NULL,NULL,NULL,RMCacheCellEqual
-	};
-	self->mapping = CFDictionaryCreateMutable(0,0,&kCFTypeDictionaryKeyCallBacks,&cb);
-	return self;
-}
+@dynamic decodedMemoryLimit;
 
-// Partially empties the cache, up until it hits its memory limit, items
-// in the cache are released
-static inline void 
-RMCachePurgeToLimit(RMCache *self, unsigned memoryLimit)
+- (NSUInteger)decodedMemoryLimit;
 {
-	// check sizes
-	while (self->length > memoryLimit){
-		RMCachePop(self);
-	}
+	return decodedMemoryLimit;
 }
 
-///////////////////////////////////////////////////////////////////// OBJECT
-
-
-@dynamic memoryLimit;
-
-- (NSUInteger)memoryLimit;
+- (void)setDecodedMemoryLimit:(NSUInteger)newLimit;
 {
-	return memoryLimit;
+	decodedMemoryLimit = newLimit;
+	RMCachePolicySetLimit(decoded,decodedMemoryLimit);
 }
 
+@synthesize policy;
 
-- (void)setMemoryLimit:(NSUInteger)newLimit;
-{
-	memoryLimit = newLimit;
-	RMCachePurgeToLimit(cache,memoryLimit);
-}
-
-// load up our instance variables that depend on the defaults subsystem
 - (void)_processDefaults
 {
 	NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
 	NSDictionary *vector =  
 	[NSDictionary dictionaryWithObjectsAndKeys:
 	 i(kRMDefaultPrimaryCacheMemoryLimit,kRMKeyPrimaryCacheMemoryLimit),
+	 s(kRMDefaultPrimaryCachePolicy,kRMKeyPrimaryCachePolicy),
+	 i(kRMDefaultPrimaryCacheDecodedMemoryLimit,kRMKeyPrimaryCacheDecodedMemoryLimit),
 	 nil];
 	[defaults registerDefaults:vector];
 	
 	memoryLimit = [defaults integerForKey:kRMKeyPrimaryCacheMemoryLimit];
+	decodedMemoryLimit = [defaults integerForKey:kRMKeyPrimaryCacheDecodedMemoryLimit];
+	NSString *name = [defaults stringForKey:kRMKeyPrimaryCachePolicy];
+	policy = RMCachePolicyTypeForName([name UTF8String]);
+	if (policy == kRMCachePolicyCount) {
+		NSLog(@"unknown %@ %@, using %@",kRMKeyPrimaryCachePolicy,name,kRMDefaultPrimaryCachePolicy);
+		policy = RMCachePolicyTypeForName([kRMDefaultPrimaryCachePolicy UTF8String]);
+	}
 }
 
-// duh
 - init;
 {
 	if ((self = [super init])){
 		[self _processDefaults];
-		cache = RMCacheNew();
+		cache = RMCachePolicyCreate(policy,memoryLimit,RMPrimaryCacheEvict,NULL);
+		// recency is all that matters for what is on screen
+		decoded = RMCachePolicyCreate(kRMCachePolicyLRU,decodedMemoryLimit,RMPrimaryCacheDemote,self);
+		if (!cache || !decoded) {
+			[self release];
+			return nil;
+		}
 	}
 	return self;
 }
 
-// returns nil or the image if it is in the cache...
 
 - (id <RMCacheable>)objectForKey:(NSString *)key;
 {
-	return RMCacheGetValue(cache,key);
+	return RMCachePolicyGet(cache,RMCacheKeyForURL(key));
+}
+
+- (id <RMCacheable>)objectForCacheKey:(RMCacheKey)key;
+{
+	RMDecodedTile *tile = RMCachePolicyGet(decoded,key);
+	return tile ? tile->entry : RMCachePolicyGet(cache,key);
 }
 
 - (void)addObject:(id <RMCacheable>)entry;
 {
-	RMCacheAdd(cache,entry);
-	RMCachePurgeToLimit(cache,self->memoryLimit);
+	// on failure the policy has already evicted, i.e. released, it
+	RMCachePolicyAdd(cache,[entry cacheKey],[entry retain],[entry length]);
 }
 
 
+// takes the entry, retained, and its image into the decoded tier, or
+// into the compressed one if it cannot be decoded
+- (UIImage *)_promoteEntry:(RMCacheEntry *)entry key:(RMCacheKey)key;
+{
+	UIImage *image = RMImageDecodedFromData(entry.data);
+	RMDecodedTile *tile = image ? malloc(sizeof(RMDecodedTile)) : NULL;
+	if (!tile) {
+		// hands over the retain on the entry
+		RMCachePolicyAdd(cache,key,entry,[entry length]);
+		return image;
+	}
+	tile->entry = entry;
+	tile->image = [image retain];
+	// the tile keeps its PNG data too, which counts against the tier; this
+	// may demote something else, or straight away this tile, if it is
+	// bigger than the whole tier
+	RMCachePolicyAdd(decoded,key,tile,RMImageGetLength([image CGImage]) + [entry length]);
+	return image;
+}
+
+- (UIImage *)imageForCacheKey:(RMCacheKey)key;
+{
+	RMDecodedTile *tile = RMCachePolicyGet(decoded,key);
+	if (tile) {
+		return tile->image;
+	}
+	// the compressed tier hands over its retain on the entry
+	RMCacheEntry *entry = RMCachePolicyGet(cache,key) ? RMCachePolicyRemove(cache,key) : nil;
+	return entry ? [self _promoteEntry:entry key:key] : nil;
+}
+
+- (UIImage *)addImageForEntry:(RMCacheEntry *)entry;
+{
+	return [self _promoteEntry:[entry retain] key:entry.cacheKey];
+}
+
+- (void)_dropDecoded;
+{
+	dropping = YES;
+	RMCachePolicyEmpty(decoded);
+	dropping = NO;
+}
+
+- (void)didReceiveMemoryWarning;
+{
+	if (RMCachePolicyCount(decoded)) {
+		[self _dropDecoded];
+	} else {
+		RMCachePolicyEmpty(cache);
+	}
+}
+
 - (void)empty;
 {
-	RMCacheEmpty(cache);
+	[self _dropDecoded];
+	RMCachePolicyEmpty(cache);
 }
 
 - (void)dealloc;
 {
-	RMCacheFree(cache);
+	if (decoded) {
+		[self _dropDecoded];
+		RMCachePolicyFree(decoded);
+	}
+	RMCachePolicyFree(cache);
 	[super dealloc];
 }
 
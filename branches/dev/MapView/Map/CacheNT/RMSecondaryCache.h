@@ -58,4 +58,9 @@
 // loaded item. Otherwise it will return nil and you should expect a callback.
 - (RMCacheEntry *)cacheEntryForKey:(NSString *)key; 
 
+// The same for an entry made by the caller, such as a tile entry from
+// +[RMCacheEntry entryForTile:cacheKey:source:]. If it can be loaded at once
+// the entry is returned with its data filled in.
+- (RMCacheEntry *)fetchCacheEntry:(RMCacheEntry *)entry;
+
 @end
@@ -195,33 +195,35 @@ self.runLoop = CFRunLoopGetCurrent();
 // Call this method when you would like a network key fetched/returned/cached.
 // The work will be done in a secondary thread, but your callback will return in
 // your own thread. The key as NSString should be a properly formatted URL.
-- (RMCacheEntry *)cacheEntryForKey:(NSString *)_key;
+- (RMCacheEntry *)cacheEntryForKey:(NSString *)key;
+{
+	RMCacheEntry *entry = [[RMCacheEntry new] autorelease];
+	// hand over a fresh copy to be sure we don't get any silliness 
+	entry.key = [[key copy] autorelease];
+	return [self fetchCacheEntry:entry];
+}
+
+- (RMCacheEntry *)fetchCacheEntry:(RMCacheEntry *)entry;
 {
 #ifdef RM_CACHE_DEBUG
 	stamp = [NSDate timeIntervalSinceReferenceDate];
 #endif	
-	// hand over a fresh copy to be sure we don't get any silliness 
 	if (immediateRead) {
-		RMCacheEntry * entry = [storage storedCacheEntryForKey:_key];
-		if (entry.data) {
+		if ([storage readCacheEntry:entry]) {
 			return entry;
-		} else {
-			[storage performSelector:@selector(loadCacheEntry:) 
-						onThread:thread
-						  withObject:entry
-					   waitUntilDone:NO];
 		}
+		// it is going to the network, so build a tile entry's URL here
+		// on the main thread rather than have the source asked from ours
+		(void)entry.key;
 	}
-	NSString * key = [_key copy];
 	// be sure we're running
 	[self start];
-	[storage performSelector:@selector(loadCacheEntryForKey:) 
+	// the storage checks again in our thread, in case the entry was
+	// stored or requested since
+	[storage performSelector:@selector(fetchCacheEntry:) 
 				 onThread:thread
-			   withObject:key
+			   withObject:entry
 			waitUntilDone:NO];
-	// the method above has retained key while it is being executed
-	// over the wall so we can dump it
-	[key release];
 
 	// returning nil tells him that his object is not ready and he will
 	// get a callback
@@ -229,5 +231,4 @@ self.runLoop = CFRunLoopGetCurrent();
 }
 
 
-
 @end
@@ -12,6 +12,8 @@
 
 #import <Foundation/Foundation.h>
 #import "RMCacheEntry.h"
+#import "RMTileStore.h"
+#import "RMKeyTable.h"
 
 // This is a storage manager for the secondary cache. Its job is to take 
 // key names which are string representations of URLs and uniquely reduce
@@ -24,25 +26,38 @@
 //    is returned as NSData. If not present, NSMutableData is created for the URL
 //    key and returned.
 //
-// 2. Strings are mapped to files by hashing them down to a filename code. Clashes
-//    are resolved by appending a sequence number to the filename. 
+// 2. Entries are stored under their RMCacheKey in a packed RMTileStore: one
+//    data file and one index for the whole cache, rather than an archive file
+//    per key. Tiles of a source with an id are keyed by the tile itself, and
+//    their URL is not built unless they go to the network; anything else is
+//    keyed by the 64 bit hash of its URL. With 64 bits and a few thousand keys
+//    a clash is not a practical concern, so URLs are not stored with the data.
 //    
 
-// This object takes care of managing a maximum count of files in secondary
+// This object takes care of managing a maximum count of entries in secondary
 // storage, as well as pruning them when they reach a maximum. Pruning is done
-// in batches, where a percentage (by default 15%) of the existing files are
-// removed. Obviously if you set the percentage of pruning very high and the
+// in batches, where a percentage (by default 15%) of the existing entries are
+// removed, least recently used first, a few at a time between other work. Obviously if you set the percentage of pruning very high and the
 // count very low, you could get some pretty bad behavior.
 
 
+// the name of our directory in the caches directory
+extern NSString *kRMStorageCache;
+
 // this is the default maximum number of items stored in cold storage, when
 // this number is hit, the LRU stored object will be removed. 
 @interface RMStorage : NSObject <RMCacheDelegate> {
-	// maps open data objects to keys
-	NSMutableDictionary *requests;
+	// maps cache keys to the entries loading from the network, which
+	// hold their own retain while they do
+	RMKeyTable *requests;
 	// our file workhorse
 	NSFileManager *fileManager;
 	
+	// the packed data and index files in the directory below
+	RMTileStore *store;
+	// writes since the store index was last synced
+	NSUInteger unsynced;
+
 	// number of items we're holding
 	NSUInteger count;
 	
@@ -51,6 +66,9 @@
 	
 	// how many we should nuke when we clean up
 	float pruneFraction;
+	// left to nuke of the current clean up, which goes in batches
+	NSUInteger pruneRemaining;
+	BOOL pruneScheduled;
 	
 	// The directory in which we reside. This is built from the NSCaches directory
 	// and the above filename.
@@ -77,11 +95,17 @@
 // nil to prevent double-writes to the existing key.
 - (void)loadCacheEntryForKey:(NSString *)key;
 
+// The same for an entry made by the caller, usually a tile entry that has
+// its cache key but no URL yet. The entry is the one handed to the delegate.
+- (void)fetchCacheEntry:(RMCacheEntry *)entry;
+
 // this method will attempt to load the object from storage, if the entry was
 // not in storage, the entry will have nil for its data. In which case you can
 // call loadCacheEntry: and you will receive the data via callback when it's
 // ready
 - (RMCacheEntry *)storedCacheEntryForKey:(NSString *)key;
+// fills in the data of the entry from storage, returns NO if it is not there
+- (BOOL)readCacheEntry:(RMCacheEntry *)entry;
 - (void)loadCacheEntry:(RMCacheEntry *)entry;
 
 // Forces the cache to completely empty itself, deleting everything in secondary
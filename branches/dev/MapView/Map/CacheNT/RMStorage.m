@@ -14,6 +14,7 @@
 #import "rm-cache.h"
 #import <UIKit/UIKit.h>
 #import <Foundation/NSPathUtilities.h>
+#import <errno.h>
 
 #define b(a,b) [NSNumber numberWithBool:a], b
 #define i(a,b) [NSNumber numberWithInteger:a], b
@@ -28,6 +29,14 @@ NSString * kRMStorageCache = @"__RMCache";
 NSUInteger kRMDefaultStorageLimit = 2000;
 double kRMDefaultStoragePruneFraction = 0.15;
 
+// the store index is written out after this many new entries; entries written
+// since are still found on the next launch, only recent reads are forgotten
+NSUInteger kRMStorageSyncInterval = 64;
+
+// entries pruned per pass of the run loop, so a prune never holds up the
+// fetches queued behind it for long
+NSUInteger kRMStoragePruneBatch = 32;
+
 @implementation RMStorage
 
 @synthesize delegate;
@@ -117,6 +126,19 @@ double kRMDefaultStoragePruneFraction = 0.15;
 	return path;
 }
 
+// Caches written before the packed store have an archive file per entry in
+// the directory. They will never be read again, so they go on the first launch.
+- (void)_removeArchives;
+{
+	NSError *error;
+	for (NSString *name in [fileManager contentsOfDirectoryAtPath:directory error:NULL]) {
+		if (![name hasPrefix:@"tiles."]
+			&& ![fileManager removeItemAtPath:[directory stringByAppendingPathComponent:name] error:&error]) {
+			NSLog(@"could not remove old cache archive %@: %@",name,[error localizedDescription]);
+		}
+	}
+}
+
 - (void)_load;
 {
 	// now we are down to counting the number of requests in the file... the 
@@ -126,7 +148,23 @@ double kRMDefaultStoragePruneFraction = 0.15;
 	CFIndex len = [directory length]+1;
 	char buf[len];
 	CFStringGetFileSystemRepresentation((CFStringRef)directory,buf,len);
-	count = RMDirCount(buf);
+	// anything besides tiles.dat, tiles.idx and the source ids is from the
+	// old layout
+	unsigned ours = [fileManager fileExistsAtPath:[directory stringByAppendingPathComponent:kRMCacheSourceIDsFile]] ? 3 : 2;
+	if (RMDirCount(buf) > ours) {
+		[self _removeArchives];
+	}
+	store = RMTileStoreOpen(buf);
+	if (!store) {
+		NSLog(@"RMTileStoreOpen(%s) failed: %s",buf,strerror(errno));
+	} else if (RMTileStoreCount(store) && RMCacheSourceIDsAreNew()) {
+		// the tiles may be keyed by ids that are about to go to other sources
+		NSLog(@"cache source ids were lost, emptying the cache");
+		if (RMTileStoreEmpty(store) != 0) {
+			NSLog(@"RMTileStoreEmpty() failed: %s",strerror(errno));
+		}
+	}
+	count = store ? RMTileStoreCount(store) : 0;
 }
 
 - init;
@@ -135,7 +173,7 @@ double kRMDefaultStoragePruneFraction = 0.15;
 		return nil;
 	}
 	[self _processDefaults];
-	requests = [NSMutableDictionary new];
+	requests = RMKeyTableCreate();
 	fileManager = [[NSFileManager defaultManager] retain];
 	directory = [[self _constructCache:kRMStorageCache] retain];
 	[self _load];
@@ -144,7 +182,8 @@ double kRMDefaultStoragePruneFraction = 0.15;
 
 - (void)dealloc;
 {
-	[requests release];
+	RMTileStoreClose(store);
+	RMKeyTableFree(requests);
 	[fileManager release];
 	[directory release];
 	[super dealloc];
@@ -152,74 +191,80 @@ double kRMDefaultStoragePruneFraction = 0.15;
 
 - (void)empty
 {
-	NSError *error;
-    if (![fileManager removeItemAtPath:directory error:&error]) {
-        RMError(error);
-    }
-	[directory release];
-	directory = nil;
-	directory = [[self _constructCache:kRMStorageCache] retain];
+	if (store && RMTileStoreEmpty(store) != 0) {
+		NSLog(@"RMTileStoreEmpty() failed: %s",strerror(errno));
+	}
+	count = 0;
+	unsynced = 0;
+	pruneRemaining = 0;
 }    
 
-// This is where the magic happens... we are first going to make a big
-// attempt to avoid filename clashes by 64 bit hashing. 
-- (RMCacheEntry *)storedCacheEntryForKey:(NSString *)key;
+// The store looks the cache key up in its in-memory index, so a miss never
+// touches the filesystem and a hit is a single read.
+- (BOOL)readCacheEntry:(RMCacheEntry *)entry;
 {
-	RMCacheEntry *entry = nil;
-	uint64_t hash = [key hash64];
-	NSMutableString *datafile = [directory mutableCopy];
+	size_t length;
+	void *bytes = store ? RMTileStoreCopyData(store,entry.cacheKey,&length) : NULL;
 	
-	[datafile appendFormat:@"/%qx",hash];
-	
-	while ([fileManager fileExistsAtPath:datafile]){
-		// we need to verify it against the inverted file, there are
-		// 18,0000,000,000,000,000,000 possibilities in the hash above
-		// so we are not likely to have to probe very often, so we're
-		// not super concerned about a miss and reading extra data, 
-		// this should, SHOULD, *should*, _should_, almost never, ever
-		// happen.
-		entry = [NSKeyedUnarchiver unarchiveObjectWithFile:datafile];
-		if ([entry.key isEqualToString:key]){
-			// we verified this is the correct file
-			return entry;
-		}
-		// if we got here, we hit the lottery, we need to linear probe for the
-		// next one..., append a . to resolve the name clash and go back to the
-		// loop beginning...
-		[datafile appendString:@"."];
+	if (bytes) {
+		entry.data = [NSMutableData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES];
 	}
-		// we broke the loop, which means we have a filename for the key
-		// and it doesn't exist, so we will create it and hook it up, and 
-		// set it going 
-	entry = [[RMCacheEntry new] autorelease];
+	return bytes != NULL;
+}
+
+- (RMCacheEntry *)storedCacheEntryForKey:(NSString *)key;
+{
+	RMCacheEntry *entry = [[RMCacheEntry new] autorelease];
 	entry.key = key;
-	entry.filename = datafile;
+	[self readCacheEntry:entry];
 	return entry;
 }
 
 
 
-- (void)_prune;
+- (void)_sync;
 {
-		// time to prune
-		double pc = pruneFraction * max;
-		NSUInteger pruneCount = pc;
-		count -= pruneCount;
-		// we could fork a thread here, but given concurrency, it might
-		// be better to just delay our other tasks while we prune the cache
-		// we do this in bulk and won't be doing it very often, so it should
-		// likely be ok
-		NSUInteger removed = RMPrune([directory fileSystemRepresentation],pruneCount);
-		if (removed != pruneCount){
-			NSLog(@"RMPrune() returned %u when requested %u",removed,pruneCount);
-		}
-	
+	if (RMTileStoreSync(store) != 0) {
+		NSLog(@"RMTileStoreSync() failed: %s",strerror(errno));
+	}
+	unsynced = 0;
+}
+
+// The store keeps its entries in eviction order, so each batch costs only
+// the entries it removes. Batches go through the run loop of our thread,
+// letting the fetches and writes queued meanwhile in between them.
+- (void)_pruneStep;
+{
+	NSUInteger batch = MIN(pruneRemaining,kRMStoragePruneBatch);
+	NSUInteger removed = store ? RMTileStorePrune(store,batch) : 0;
+
+	pruneScheduled = NO;
+	count = store ? RMTileStoreCount(store) : 0;
+	if (removed != batch) {
+		NSLog(@"RMTileStorePrune() returned %lu when requested %lu",(unsigned long)removed,(unsigned long)batch);
+		pruneRemaining = 0;
+	} else {
+		pruneRemaining -= removed;
+	}
+	if (pruneRemaining) {
+		pruneScheduled = YES;
+		[self performSelector:@selector(_pruneStep) withObject:nil afterDelay:0];
+	} else {
+		// the prune left dead space in the data file, which the sync
+		// reclaims once there is enough of it
+		[self _sync];
+	}
 }
 
 - (void)_attemptPrune;
 {
-	if (count >= max) {
-		[self _prune];
+	if (count >= max && !pruneRemaining) {
+		// time to prune
+		pruneRemaining = MAX((NSUInteger)(pruneFraction * max),1);
+	}
+	if (pruneRemaining && !pruneScheduled) {
+		pruneScheduled = YES;
+		[self performSelector:@selector(_pruneStep) withObject:nil afterDelay:0];
 	}
 }
 
@@ -235,7 +280,9 @@ double kRMDefaultStoragePruneFraction = 0.15;
 {
 	// we will retain this through the network cycle
 	[entry retain];
-	[requests setObject:entry forKey:entry.key];
+	if (RMKeyTableSet(requests,entry.cacheKey,entry) != 0) {
+		NSLog(@"RMStorage could not record the request for %@",entry.key);
+	}
 	entry.delegate = self;
 	// this will signal us back when it has completed the 
 	// network load
@@ -244,17 +291,21 @@ double kRMDefaultStoragePruneFraction = 0.15;
 
 - (void)loadCacheEntryForKey:(NSString *)key;
 {
-	RMCacheEntry *entry = [requests objectForKey:key];
-	if (entry) {
+	RMCacheEntry *entry = [[RMCacheEntry new] autorelease];
+	entry.key = key;
+	[self fetchCacheEntry:entry];
+}
+
+- (void)fetchCacheEntry:(RMCacheEntry *)entry;
+{
+	if (RMKeyTableGet(requests,entry.cacheKey)) {
 		// we already have an open data for this key, this means
 		// we have something on the go for this data object already.
 		return;
 	}
 	// we have no knowledge of the key, so we will load or 
 	// create one
-	entry = [self storedCacheEntryForKey:key];
-
-	if ((entry.data)){
+	if ([self readCacheEntry:entry]){
 		// we have data loaded from the cache, so we can
 		// signal our delegate that the entry loaded
 		[delegate cacheEntryDidLoad:entry];
@@ -270,9 +321,20 @@ double kRMDefaultStoragePruneFraction = 0.15;
 // closed, the matching key in the key table will be discarded.
 - (void)cacheEntryDidLoad:(RMCacheEntry *)entry
 {
-	[NSKeyedArchiver archiveRootObject:entry toFile:entry.filename];
+	NSData *data = entry.data;
+	if (store && [data length]) {
+		if (RMTileStorePut(store,entry.cacheKey,[data bytes],[data length]) != 0) {
+			NSLog(@"RMTileStorePut() failed: %s",strerror(errno));
+		} else {
+			count = RMTileStoreCount(store);
+			if (++unsynced >= kRMStorageSyncInterval) {
+				[self _sync];
+			}
+			[self _attemptPrune];
+		}
+	}
 	entry.filename = nil;
-	[requests removeObjectForKey:entry.key];
+	RMKeyTableRemove(requests,entry.cacheKey);
 	[delegate cacheEntryDidLoad:entry];
 	[entry autorelease];
 }
@@ -281,7 +343,7 @@ double kRMDefaultStoragePruneFraction = 0.15;
 {
 	entry.filename = nil;
 	[delegate cacheEntryDidFail:entry];
-	[requests removeObjectForKey:entry.key];
+	RMKeyTableRemove(requests,entry.cacheKey);
 	[entry autorelease];
 }
 
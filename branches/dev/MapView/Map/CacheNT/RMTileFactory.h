@@ -12,11 +12,12 @@
 
 #import <Foundation/Foundation.h>
 #import "RMSecondaryCache.h"
+#import "RMKeyTable.h"
 
 @protocol RMTileClient <NSObject>
 // you will get one response from the cache and then be automatically removed
-- (void)factoryDidLoad:(UIImage *)image forRequest:(NSString *)requestedResource;
-- (void)factoryDidFail:(NSString *)requestedResource;
+- (void)factoryDidLoad:(UIImage *)image forRequest:(RMCacheKey)requestedResource;
+- (void)factoryDidFail:(RMCacheKey)requestedResource;
 @end
 
 @class RMPrimaryCache;
@@ -24,7 +25,9 @@
 @interface RMTileFactory : NSObject <RMCacheDelegate> {
 	RMPrimaryCache *primaryCache;
 	RMSecondaryCache *secondaryCache;
-	NSMutableDictionary *dispatchTable;
+	// clients waiting on each cache key, retained: one client, or an
+	// NSMutableArray of them
+	RMKeyTable *dispatchTable;
 }
 
 // you request an image from the tile factory, and if it is able to send it
@@ -32,9 +35,14 @@
 // protocol
 + (UIImage *)requestImage:(NSString *)key forClient:(id <RMTileClient>)client;
 
+// The same for a tile with a cache key from RMCacheKeyForTile(). Nothing
+// calls on the source for the tile URL unless the tile is in neither cache.
++ (UIImage *)requestImageForTile:(RMTile)tile cacheKey:(RMCacheKey)cacheKey source:(id <RMCacheURLSource>)source forClient:(id <RMTileClient>)client;
+
 // If you are still waiting for a tile and have no further need for it (i.e. need to
 // deallocate), you call this to cancel the pending update.
 + (void)cancelImage:(NSString *)key forClient:(id <RMTileClient>)delegate;
++ (void)cancelImageForCacheKey:(RMCacheKey)cacheKey forClient:(id <RMTileClient>)delegate;
 
 // Stops all processing of requests, halts the cache and secondary thread. Do this
 // prior to application termination and cleanup. The process is reversible by
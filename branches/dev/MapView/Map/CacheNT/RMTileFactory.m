@@ -28,6 +28,25 @@ static RMTileFactory *factory = nil;
 #define d(a,b) [NSNumber numberWithDouble:a], b
 #define f(a,b) [NSNumber numberWithFloat:a], b
 
+// Built with RM_CACHE_TRACE defined, the factory appends every request and
+// the length of every tile that comes in to Caches/RMCacheTrace.txt, the
+// input of the cache simulator in Benchmarks/RMCachePolicySim.c.
+#ifdef RM_CACHE_TRACE
+static FILE *
+RMTileFactoryTrace(void)
+{
+	static FILE *trace = NULL;
+	if (!trace) {
+		NSString *path = [RMStorage pathForCache:@"RMCacheTrace.txt"];
+		trace = fopen([path fileSystemRepresentation],"a");
+	}
+	return trace;
+}
+#  define TRACE(...) do { FILE *trace = RMTileFactoryTrace(); if (trace) fprintf(trace,__VA_ARGS__); } while (0)
+#else
+#  define TRACE(...)
+#endif
+
 
 - (RMPrimaryCache *)_primaryCache;
 {
@@ -41,10 +60,12 @@ static RMTileFactory *factory = nil;
 	NSString *d = [entry description];
 	NSLog(@"%@",d);
 #endif	
-	NSString *key = entry.key;
-	id object = [dispatchTable objectForKey:key];
+	RMCacheKey key = entry.cacheKey;
+	id object = RMKeyTableRemove(dispatchTable,key);
+	TRACE("L %qx %u\n",key,[entry.data length]);
 	
-	UIImage *image = [[UIImage alloc] initWithData:entry.data];
+	// it is wanted on screen, so it goes straight to the decoded tier
+	UIImage *image = [primaryCache addImageForEntry:entry];
 	if ([object isKindOfClass:[NSMutableArray class]]){
 		for (id client in object){
 			[client factoryDidLoad:image forRequest:key];
@@ -52,69 +73,84 @@ static RMTileFactory *factory = nil;
 	} else {
 		[object factoryDidLoad:image forRequest:key];
 	}
-	[dispatchTable removeObjectForKey:key];
-	[primaryCache addObject:entry];
-	[image release];
+	[object release];
 }
 
 - (void)cacheEntryDidFail:(RMCacheEntry *)entry;
 {
-	NSString *key = entry.key;
-	id object = [dispatchTable objectForKey:key];
+	RMCacheKey key = entry.cacheKey;
+	id object = RMKeyTableRemove(dispatchTable,key);
 	if ([object isKindOfClass:[NSMutableArray class]]){
-		[object makeObjectsPerformSelector:@selector(factoryDidFail:)
-								withObject:key];
+		for (id client in object){
+			[client factoryDidFail:key];
+		}
 	} else {
 		[object factoryDidFail:key];
 	}
-	[dispatchTable removeObjectForKey:key];
+	[object release];
 }
 
 
-- (void)_removeClient:(id <RMTileClient>)client forKey:(NSString *)key;
+- (void)_removeClient:(id <RMTileClient>)client forKey:(RMCacheKey)key;
 {
-	id object = [dispatchTable objectForKey:key];
+	id object = RMKeyTableGet(dispatchTable,key);
 	if (object == client) {
-		[dispatchTable removeObjectForKey:key];
+		RMKeyTableRemove(dispatchTable,key);
+		[object release];
 	} else if ([object isKindOfClass:[NSArray class]]){
 		[object removeObject:client];
 		if (![object count]){
-			[dispatchTable removeObjectForKey:key];
+			RMKeyTableRemove(dispatchTable,key);
+			[object release];
 		}
 	} 
 }
 
 
-- (void)_addClient:(id <RMTileClient>)client forKey:(NSString *)key;
+- (void)_addClient:(id <RMTileClient>)client forKey:(RMCacheKey)key;
 {
-	id object = [dispatchTable objectForKey:key];
+	id object = RMKeyTableGet(dispatchTable,key);
 	if (object) {
 		if (object == client){
-			NSLog(@"%@ requested by same client %@",key,[(id)client description]);
+			NSLog(@"%qx requested by same client %@",key,[(id)client description]);
 		} else if ([object isKindOfClass:[NSMutableArray class]]){
 		// this probably won't happen but might as well do it right...
 		// if someone is already waiting for this URL, we turn the
 		// dispatch table entry into an array and store them all
 			[object addObject:client];
 		} else {
-			NSMutableArray *array = [NSMutableArray arrayWithObjects:object,client,nil];
-			[dispatchTable setObject:array forKey:key];
+			NSMutableArray *array = [[NSMutableArray alloc] initWithObjects:object,client,nil];
+			RMKeyTableSet(dispatchTable,key,array);
+			[object release];
 		}
-	} else {
-		[dispatchTable setObject:client forKey:key];
+	} else if (RMKeyTableSet(dispatchTable,key,client) == 0) {
+		[client retain];
 	}
 }
 
-- (UIImage *)_imageForKey:(NSString *)key client:(id <RMTileClient>)client
+// the primary cache is checked by key alone, the entry is only made if
+// the image has to come from further away
+- (UIImage *)_cachedImageForKey:(RMCacheKey)key
 {
+	return [primaryCache imageForCacheKey:key];
+}
+
+- (UIImage *)_imageForEntry:(RMCacheEntry *)entry client:(id <RMTileClient>)client
+{
+	RMCacheKey key = entry.cacheKey;
 	RMCacheEntry * response = nil;
-	if (!(response = (id)[primaryCache objectForKey:key])){
-		if (!(response = [secondaryCache cacheEntryForKey:key])){
-			[self _addClient:client forKey:key];
-			return nil;
-		}
+	// if the key is already on its way, there is no need to ask again
+	if (RMKeyTableGet(dispatchTable,key) || !(response = [secondaryCache fetchCacheEntry:entry])){
+		[self _addClient:client forKey:key];
+		return nil;
 	}
-	return [[[UIImage alloc] initWithData:response.data] autorelease];
+	return [primaryCache addImageForEntry:response];
+}
+
+static void
+RMTileFactoryReleaseClients(uint64_t key, void *object, void *context)
+{
+	[(id)object release];
 }
 
 - init;
@@ -122,16 +158,29 @@ static RMTileFactory *factory = nil;
 	if ((self = [super init])){
 		primaryCache = [RMPrimaryCache new];
 		secondaryCache = [RMSecondaryCache new];
-		dispatchTable = [NSMutableDictionary new];
+		dispatchTable = RMKeyTableCreate();
 		[secondaryCache setDelegate:self];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(didReceiveMemoryWarning)
+													 name:UIApplicationDidReceiveMemoryWarningNotification
+												   object:nil];
 	}
 	return self;
 }
 
+// the decoded tiles are the cheapest memory to give back, they are all
+// still in PNG form in secondary storage
+- (void)didReceiveMemoryWarning
+{
+	[primaryCache didReceiveMemoryWarning];
+}
+
 - (void)dealloc
 {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
 	[secondaryCache release];
-	[dispatchTable release];
+	RMKeyTableApply(dispatchTable,RMTileFactoryReleaseClients,NULL);
+	RMKeyTableFree(dispatchTable);
 	[primaryCache release];
 	[super dealloc];
 }
@@ -146,7 +195,12 @@ static RMTileFactory *factory = nil;
 
 + (void)cancelImage:(NSString *)key forClient:(id <RMTileClient>)client;
 {
-	[factory _removeClient:client forKey:key];
+	[factory _removeClient:client forKey:RMCacheKeyForURL(key)];
+}
+
++ (void)cancelImageForCacheKey:(RMCacheKey)cacheKey forClient:(id <RMTileClient>)client;
+{
+	[factory _removeClient:client forKey:cacheKey];
 }
 
 + (void)shutdown;
@@ -160,7 +214,28 @@ static RMTileFactory *factory = nil;
 	if (!factory) {
 		factory = [[self alloc] init];
 	}
-	return [factory _imageForKey:key client:client];
+	TRACE("R %qx\n",RMCacheKeyForURL(key));
+	UIImage *image = [factory _cachedImageForKey:RMCacheKeyForURL(key)];
+	if (!image) {
+		RMCacheEntry *entry = [[RMCacheEntry new] autorelease];
+		entry.key = key;
+		image = [factory _imageForEntry:entry client:client];
+	}
+	return image;
+}
+
++ (UIImage *)requestImageForTile:(RMTile)tile cacheKey:(RMCacheKey)cacheKey source:(id <RMCacheURLSource>)source forClient:(id <RMTileClient>)client;
+{
+	if (!factory) {
+		factory = [[self alloc] init];
+	}
+	TRACE("R %qx\n",cacheKey);
+	UIImage *image = [factory _cachedImageForKey:cacheKey];
+	if (!image) {
+		RMCacheEntry *entry = [RMCacheEntry entryForTile:tile cacheKey:cacheKey source:source];
+		image = [factory _imageForEntry:entry client:client];
+	}
+	return image;
 }
 
 
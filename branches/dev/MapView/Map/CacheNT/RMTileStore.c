@@ -0,0 +1,810 @@
+//
+//  RMTileStore.c
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "RMTileStore.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define kRMTileStoreDataMagic	0x52544D44	// "RMTD"
+#define kRMTileStoreIndexMagic	0x52544D49	// "RMTI"
+#define kRMTileStoreRecordMagic	0x52544D52	// "RMTR"
+#define kRMTileStoreVersion		1
+#define kRMTileStoreIndexVersion	2	// 1 kept access times, not an order
+
+// the protected segment holds at most this share of the tiles
+#define kRMTileStoreProtectedPercent	80
+
+#define kRMTileStoreNil			UINT32_MAX
+#define kRMTileStoreProtectedBit	0x80000000u	// segment bit of an entry's access
+#define kRMTileStoreClockMask	0x7FFFFFFFu
+
+// dead bytes in the data file below this are not worth a compaction
+#define kRMTileStoreMinCompactBytes	(256 * 1024)
+
+// starts tiles.dat; the index is only trusted if it has the same generation
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t generation;
+} RMTileStoreDataHeader;
+
+// precedes every tile in tiles.dat
+typedef struct {
+	uint32_t magic;
+	uint32_t length;
+	uint64_t key;
+} RMTileStoreRecord;
+
+// starts tiles.idx, followed by count entries
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t generation;
+	uint64_t dataEnd;		// bytes of tiles.dat the entries account for
+	uint32_t count;
+	uint32_t reserved;
+} RMTileStoreIndexHeader;
+
+typedef struct {
+	uint64_t key;
+	uint64_t offset;		// of the record in tiles.dat
+	uint32_t length;		// of the tile, without the record
+	uint32_t access;		// segment bit | logical clock of the last access
+} RMTileStoreEntry;
+
+enum { kRMTileStoreProbation, kRMTileStoreProtected, kRMTileStoreSegments };
+
+typedef struct {
+	uint32_t prev, next;	// entry indexes, kRMTileStoreNil at the ends
+} RMTileStoreLink;
+
+struct RMTileStore {
+	pthread_mutex_t lock;
+	char *dataPath;
+	char *indexPath;
+	int fd;
+	uint64_t generation;
+	uint64_t dataEnd;		// where the next record goes
+	uint64_t liveBytes;		// records of the entries, the rest is dead
+	int dirty;				// entries differ from tiles.idx
+
+	// entries are kept packed, slots is an open addressing table of
+	// entry index + 1 by key, 0 marking an empty slot
+	RMTileStoreEntry *entries;
+	unsigned count;
+	unsigned capacity;
+	uint32_t *slots;
+	unsigned slotMask;
+
+	// the eviction order, a segmented LRU threaded through the entries:
+	// a new tile starts on probation and moves to the protected segment
+	// when it is read, which pushes its coldest tiles back to probation
+	// once it is over kRMTileStoreProtectedPercent. Pruning takes the
+	// coldest probation tiles first, so a pass over the map that reads
+	// each tile once cannot flush the tiles that are read again and again.
+	// tiles.idx keeps the entries in this order, coldest first
+	RMTileStoreLink *links;	// parallel to entries
+	uint32_t head[kRMTileStoreSegments];	// coldest
+	uint32_t tail[kRMTileStoreSegments];	// hottest
+	unsigned segmentCount[kRMTileStoreSegments];
+	uint32_t clock;			// counts accesses, wrapping at 31 bits
+};
+
+#define RecordSize(length) (sizeof(RMTileStoreRecord) + (uint64_t)(length))
+
+/////////////////////////////////////////////////////////////// HASH TABLE
+
+static inline unsigned
+RMTileStoreHash(uint64_t key)
+{
+	// Fibonacci hashing, the high bits are the well mixed ones
+	return (unsigned)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// the slot holding key, or the empty slot where it would go
+static unsigned
+RMTileStoreProbe(RMTileStore *store, uint64_t key)
+{
+	unsigned i = RMTileStoreHash(key) & store->slotMask;
+	uint32_t s;
+
+	while ((s = store->slots[i]) && store->entries[s - 1].key != key)
+		i = (i + 1) & store->slotMask;
+	return i;
+}
+
+static int
+RMTileStoreResize(RMTileStore *store, unsigned slotCount)
+{
+	uint32_t *slots = calloc(slotCount, sizeof(uint32_t));
+	unsigned i;
+
+	if (!slots)
+		return -1;
+	free(store->slots);
+	store->slots = slots;
+	store->slotMask = slotCount - 1;
+	for (i = 0; i < store->count; i++)
+		slots[RMTileStoreProbe(store, store->entries[i].key)] = i + 1;
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////// EVICTION ORDER
+
+static inline int
+RMTileStoreSegment(const RMTileStoreEntry *entry)
+{
+	return (entry->access & kRMTileStoreProtectedBit) ? kRMTileStoreProtected : kRMTileStoreProbation;
+}
+
+static void
+RMTileStoreUnlink(RMTileStore *store, uint32_t index)
+{
+	RMTileStoreLink *link = store->links + index;
+	int segment = RMTileStoreSegment(store->entries + index);
+
+	if (link->prev != kRMTileStoreNil)
+		store->links[link->prev].next = link->next;
+	else
+		store->head[segment] = link->next;
+	if (link->next != kRMTileStoreNil)
+		store->links[link->next].prev = link->prev;
+	else
+		store->tail[segment] = link->prev;
+	store->segmentCount[segment]--;
+}
+
+// makes index the hottest entry of segment, with the given clock
+static void
+RMTileStoreLinkTail(RMTileStore *store, uint32_t index, int segment, uint32_t clock)
+{
+	RMTileStoreLink *link = store->links + index;
+
+	store->entries[index].access = (clock & kRMTileStoreClockMask)
+		| (segment == kRMTileStoreProtected ? kRMTileStoreProtectedBit : 0);
+	link->prev = store->tail[segment];
+	link->next = kRMTileStoreNil;
+	if (link->prev != kRMTileStoreNil)
+		store->links[link->prev].next = index;
+	else
+		store->head[segment] = index;
+	store->tail[segment] = index;
+	store->segmentCount[segment]++;
+}
+
+// a read: the entry becomes the hottest protected one
+static void
+RMTileStoreTouch(RMTileStore *store, uint32_t index)
+{
+	uint32_t coldest;
+
+	RMTileStoreUnlink(store, index);
+	RMTileStoreLinkTail(store, index, kRMTileStoreProtected, ++store->clock);
+	while (store->segmentCount[kRMTileStoreProtected] > 1
+		&& store->segmentCount[kRMTileStoreProtected] > (uint64_t)store->count * kRMTileStoreProtectedPercent / 100) {
+		coldest = store->head[kRMTileStoreProtected];
+		RMTileStoreUnlink(store, coldest);
+		RMTileStoreLinkTail(store, coldest, kRMTileStoreProbation, store->entries[coldest].access);
+	}
+	store->dirty = 1;
+}
+
+/////////////////////////////////////////////////////////////// ENTRIES
+
+// adds or replaces the entry for key; a new entry goes at the hot end of
+// the segment access names, a replaced one keeps its place
+static int
+RMTileStoreSetEntry(RMTileStore *store, uint64_t key, uint64_t offset, uint32_t length, uint32_t access)
+{
+	RMTileStoreEntry *entry;
+	unsigned slot;
+
+	// keep the table at most half full
+	if (2 * (store->count + 1) > store->slotMask + 1
+		&& RMTileStoreResize(store, 2 * (store->slotMask + 1)) != 0)
+		return -1;
+
+	slot = RMTileStoreProbe(store, key);
+	if (store->slots[slot]) {
+		entry = store->entries + store->slots[slot] - 1;
+		store->liveBytes -= RecordSize(entry->length);
+	} else {
+		if (store->count == store->capacity) {
+			unsigned capacity = store->capacity ? 2 * store->capacity : 256;
+			RMTileStoreLink *links;
+			entry = realloc(store->entries, capacity * sizeof(RMTileStoreEntry));
+			if (!entry)
+				return -1;
+			store->entries = entry;
+			if (!(links = realloc(store->links, capacity * sizeof(RMTileStoreLink))))
+				return -1;
+			store->links = links;
+			store->capacity = capacity;
+		}
+		entry = store->entries + store->count++;
+		store->slots[slot] = store->count;
+		entry->key = key;
+		RMTileStoreLinkTail(store, store->count - 1,
+			(access & kRMTileStoreProtectedBit) ? kRMTileStoreProtected : kRMTileStoreProbation, access);
+	}
+	entry->offset = offset;
+	entry->length = length;
+	store->liveBytes += RecordSize(length);
+	store->dirty = 1;
+	return 0;
+}
+
+// removes the entry in slot, filling the hole in both the table and entries
+static void
+RMTileStoreDeleteSlot(RMTileStore *store, unsigned slot)
+{
+	unsigned mask = store->slotMask, hole = slot, i = slot, home;
+	unsigned index = store->slots[slot] - 1;
+
+	store->liveBytes -= RecordSize(store->entries[index].length);
+	RMTileStoreUnlink(store, index);
+
+	// backward shift: move up any later entry of the probe run that
+	// would no longer be found across the hole
+	for (;;) {
+		i = (i + 1) & mask;
+		if (!store->slots[i])
+			break;
+		home = RMTileStoreHash(store->entries[store->slots[i] - 1].key) & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			store->slots[hole] = store->slots[i];
+			hole = i;
+		}
+	}
+	store->slots[hole] = 0;
+
+	// and the last entry takes the place of the removed one, in the
+	// eviction order too
+	if (index != --store->count) {
+		RMTileStoreLink *link = store->links + index;
+		int segment = RMTileStoreSegment(store->entries + store->count);
+
+		store->entries[index] = store->entries[store->count];
+		store->slots[RMTileStoreProbe(store, store->entries[index].key)] = index + 1;
+		*link = store->links[store->count];
+		if (link->prev != kRMTileStoreNil)
+			store->links[link->prev].next = index;
+		else
+			store->head[segment] = index;
+		if (link->next != kRMTileStoreNil)
+			store->links[link->next].prev = index;
+		else
+			store->tail[segment] = index;
+	}
+	store->dirty = 1;
+}
+
+static void
+RMTileStoreClear(RMTileStore *store)
+{
+	int segment;
+
+	memset(store->slots, 0, (store->slotMask + 1) * sizeof(uint32_t));
+	store->count = 0;
+	store->liveBytes = 0;
+	store->dirty = 1;
+	for (segment = 0; segment < kRMTileStoreSegments; segment++) {
+		store->head[segment] = store->tail[segment] = kRMTileStoreNil;
+		store->segmentCount[segment] = 0;
+	}
+}
+
+/////////////////////////////////////////////////////////////// FILES
+
+static uint64_t
+RMTileStoreNewGeneration(uint64_t old)
+{
+	struct timeval tv;
+	uint64_t generation;
+
+	gettimeofday(&tv, NULL);
+	generation = ((uint64_t)tv.tv_sec << 20) ^ (uint64_t)tv.tv_usec;
+	return generation == old ? generation + 1 : generation;
+}
+
+static int
+RMTileStoreWriteAll(int fd, const void *buf, size_t length, uint64_t offset)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (length) {
+		n = pwrite(fd, p, length, (off_t)offset);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		offset += n;
+		length -= n;
+	}
+	return 0;
+}
+
+static int
+RMTileStoreReadAll(int fd, void *buf, size_t length, uint64_t offset)
+{
+	char *p = buf;
+	ssize_t n;
+
+	while (length) {
+		n = pread(fd, p, length, (off_t)offset);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0) {
+			errno = EIO;
+			return -1;
+		}
+		p += n;
+		offset += n;
+		length -= n;
+	}
+	return 0;
+}
+
+// starts fd over as an empty data file of a new generation
+static int
+RMTileStoreResetData(RMTileStore *store, int fd)
+{
+	RMTileStoreDataHeader header = {
+		kRMTileStoreDataMagic, kRMTileStoreVersion, 0
+	};
+
+	header.generation = RMTileStoreNewGeneration(store->generation);
+	if (ftruncate(fd, 0) != 0
+		|| RMTileStoreWriteAll(fd, &header, sizeof(header), 0) != 0)
+		return -1;
+	store->generation = header.generation;
+	store->dataEnd = sizeof(header);
+	return 0;
+}
+
+// writes the entries, coldest first, to a temporary file and renames it
+// over tiles.idx
+static int
+RMTileStoreWriteIndex(RMTileStore *store)
+{
+	RMTileStoreIndexHeader header = {
+		kRMTileStoreIndexMagic, kRMTileStoreIndexVersion,
+		store->generation, store->dataEnd, store->count, 0
+	};
+	size_t length = strlen(store->indexPath);
+	char temp[length + 5];
+	FILE *fp;
+	uint32_t i;
+	int ok, segment;
+
+	memcpy(temp, store->indexPath, length);
+	memcpy(temp + length, ".tmp", 5);
+	if (!(fp = fopen(temp, "wb")))
+		return -1;
+	ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	for (segment = 0; ok && segment < kRMTileStoreSegments; segment++)
+		for (i = store->head[segment]; ok && i != kRMTileStoreNil; i = store->links[i].next)
+			ok = fwrite(store->entries + i, sizeof(RMTileStoreEntry), 1, fp) == 1;
+	if (fclose(fp) != 0 || !ok || rename(temp, store->indexPath) != 0) {
+		unlink(temp);
+		return -1;
+	}
+	store->dirty = 0;
+	return 0;
+}
+
+// reads tiles.idx, returns 0 if it is missing or does not match tiles.dat
+static int
+RMTileStoreReadIndex(RMTileStore *store, uint64_t dataSize)
+{
+	RMTileStoreIndexHeader header;
+	RMTileStoreEntry entry;
+	FILE *fp = fopen(store->indexPath, "rb");
+	uint32_t i;
+
+	if (!fp)
+		return 0;
+	if (fread(&header, sizeof(header), 1, fp) != 1
+		|| header.magic != kRMTileStoreIndexMagic
+		|| header.version != kRMTileStoreIndexVersion
+		|| header.generation != store->generation
+		|| header.dataEnd > dataSize
+		|| header.dataEnd < sizeof(RMTileStoreDataHeader)) {
+		fclose(fp);
+		return 0;
+	}
+	for (i = 0; i < header.count; i++) {
+		if (fread(&entry, sizeof(entry), 1, fp) != 1
+			|| entry.offset < sizeof(RMTileStoreDataHeader)
+			|| entry.offset + RecordSize(entry.length) > header.dataEnd
+			|| RMTileStoreSetEntry(store, entry.key, entry.offset, entry.length, entry.access) != 0) {
+			fclose(fp);
+			RMTileStoreClear(store);
+			return 0;
+		}
+		// carry on from the latest clock
+		if ((entry.access & kRMTileStoreClockMask) > store->clock)
+			store->clock = entry.access & kRMTileStoreClockMask;
+	}
+	fclose(fp);
+	store->dataEnd = header.dataEnd;
+	store->dirty = 0;
+	return 1;
+}
+
+// indexes the records of tiles.dat from store->dataEnd on, cutting the file
+// at the first one that is incomplete
+static int
+RMTileStoreScan(RMTileStore *store, uint64_t dataSize)
+{
+	RMTileStoreRecord record;
+	uint64_t offset = store->dataEnd;
+
+	while (offset + sizeof(record) <= dataSize) {
+		if (RMTileStoreReadAll(store->fd, &record, sizeof(record), offset) != 0
+			|| record.magic != kRMTileStoreRecordMagic
+			|| offset + RecordSize(record.length) > dataSize)
+			break;
+		if (RMTileStoreSetEntry(store, record.key, offset, record.length, ++store->clock) != 0)
+			return -1;
+		offset += RecordSize(record.length);
+	}
+	if (offset != dataSize && ftruncate(store->fd, (off_t)offset) != 0)
+		return -1;
+	if (offset != store->dataEnd) {
+		store->dataEnd = offset;
+		store->dirty = 1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////// PUBLIC
+
+RMTileStore *
+RMTileStoreOpen(const char *directory)
+{
+	RMTileStore *store = calloc(1, sizeof(RMTileStore));
+	RMTileStoreDataHeader header;
+	size_t length = strlen(directory);
+	struct stat sb;
+
+	if (!store)
+		return NULL;
+	store->fd = -1;
+	pthread_mutex_init(&store->lock, NULL);
+	store->dataPath = malloc(length + 11);
+	store->indexPath = malloc(length + 11);
+	store->slots = calloc(256, sizeof(uint32_t));
+	store->slotMask = 255;
+	if (!store->dataPath || !store->indexPath || !store->slots)
+		goto fail;
+	RMTileStoreClear(store);
+	sprintf(store->dataPath, "%s/tiles.dat", directory);
+	sprintf(store->indexPath, "%s/tiles.idx", directory);
+
+	if ((store->fd = open(store->dataPath, O_RDWR | O_CREAT, 0644)) < 0
+		|| fstat(store->fd, &sb) != 0)
+		goto fail;
+
+	if ((uint64_t)sb.st_size < sizeof(header)
+		|| RMTileStoreReadAll(store->fd, &header, sizeof(header), 0) != 0
+		|| header.magic != kRMTileStoreDataMagic
+		|| header.version != kRMTileStoreVersion) {
+		// new, or not ours to read
+		if (RMTileStoreResetData(store, store->fd) != 0)
+			goto fail;
+		sb.st_size = store->dataEnd;
+	} else {
+		store->generation = header.generation;
+		store->dataEnd = sizeof(header);
+	}
+
+	// whatever the index does not cover was appended since it was written
+	RMTileStoreReadIndex(store, sb.st_size);
+	if (RMTileStoreScan(store, sb.st_size) != 0)
+		goto fail;
+	return store;
+
+fail:
+	RMTileStoreClose(store);
+	return NULL;
+}
+
+void
+RMTileStoreClose(RMTileStore *store)
+{
+	if (!store)
+		return;
+	if (store->fd >= 0) {
+		if (store->dirty)
+			RMTileStoreWriteIndex(store);
+		close(store->fd);
+	}
+	pthread_mutex_destroy(&store->lock);
+	free(store->dataPath);
+	free(store->indexPath);
+	free(store->entries);
+	free(store->links);
+	free(store->slots);
+	free(store);
+}
+
+void *
+RMTileStoreCopyData(RMTileStore *store, uint64_t key, size_t *length)
+{
+	RMTileStoreEntry *entry;
+	RMTileStoreRecord *record;
+	unsigned slot;
+	char *buf = NULL;
+
+	pthread_mutex_lock(&store->lock);
+	slot = RMTileStoreProbe(store, key);
+	if (store->slots[slot]) {
+		entry = store->entries + store->slots[slot] - 1;
+		// the record is read with the tile and checked, so a damaged file
+		// costs a tile rather than handing back someone else's bytes
+		buf = malloc(RecordSize(entry->length));
+		record = (RMTileStoreRecord *)buf;
+		if (buf && RMTileStoreReadAll(store->fd, buf, RecordSize(entry->length), entry->offset) == 0
+			&& record->magic == kRMTileStoreRecordMagic
+			&& record->key == key
+			&& record->length == entry->length) {
+			*length = entry->length;
+			memmove(buf, buf + sizeof(RMTileStoreRecord), entry->length);
+			RMTileStoreTouch(store, store->slots[slot] - 1);
+		} else {
+			free(buf);
+			buf = NULL;
+			RMTileStoreDeleteSlot(store, slot);
+		}
+	}
+	pthread_mutex_unlock(&store->lock);
+	return buf;
+}
+
+int
+RMTileStoreContains(RMTileStore *store, uint64_t key)
+{
+	int found;
+
+	pthread_mutex_lock(&store->lock);
+	found = store->slots[RMTileStoreProbe(store, key)] != 0;
+	pthread_mutex_unlock(&store->lock);
+	return found;
+}
+
+int
+RMTileStorePut(RMTileStore *store, uint64_t key, const void *data, size_t length)
+{
+	RMTileStoreRecord record = { kRMTileStoreRecordMagic, (uint32_t)length, key };
+	int result = -1;
+
+	if (length > UINT32_MAX) {
+		errno = EFBIG;
+		return -1;
+	}
+	pthread_mutex_lock(&store->lock);
+	if (RMTileStoreWriteAll(store->fd, &record, sizeof(record), store->dataEnd) == 0
+		&& RMTileStoreWriteAll(store->fd, data, length, store->dataEnd + sizeof(record)) == 0
+		&& RMTileStoreSetEntry(store, key, store->dataEnd, (uint32_t)length, ++store->clock) == 0) {
+		store->dataEnd += RecordSize(length);
+		result = 0;
+	} else {
+		// don't leave a partial record for the next open to trip over
+		int saved = errno;
+		(void)ftruncate(store->fd, (off_t)store->dataEnd);
+		errno = saved;
+	}
+	pthread_mutex_unlock(&store->lock);
+	return result;
+}
+
+int
+RMTileStoreRemove(RMTileStore *store, uint64_t key)
+{
+	unsigned slot;
+
+	pthread_mutex_lock(&store->lock);
+	slot = RMTileStoreProbe(store, key);
+	if (store->slots[slot])
+		RMTileStoreDeleteSlot(store, slot);
+	pthread_mutex_unlock(&store->lock);
+	return 0;
+}
+
+// takes the coldest probation tiles, then the coldest protected ones
+unsigned
+RMTileStorePrune(RMTileStore *store, unsigned number)
+{
+	unsigned removed = 0;
+	uint32_t coldest;
+
+	pthread_mutex_lock(&store->lock);
+	for (; removed < number && store->count; removed++) {
+		coldest = store->head[kRMTileStoreProbation];
+		if (coldest == kRMTileStoreNil)
+			coldest = store->head[kRMTileStoreProtected];
+		RMTileStoreDeleteSlot(store, RMTileStoreProbe(store, store->entries[coldest].key));
+	}
+	pthread_mutex_unlock(&store->lock);
+	return removed;
+}
+
+static int
+RMTileStoreCompareOffset(const void *p1, const void *p2)
+{
+	const RMTileStoreEntry *e1 = *(RMTileStoreEntry * const *)p1;
+	const RMTileStoreEntry *e2 = *(RMTileStoreEntry * const *)p2;
+
+	return e1->offset < e2->offset ? -1 : e1->offset > e2->offset;
+}
+
+// copies the live records, in file order, to a new data file that then
+// replaces tiles.dat; a new generation keeps the old index from being
+// applied to it should we stop between the two renames
+static int
+RMTileStoreCompactLocked(RMTileStore *store)
+{
+	size_t length = strlen(store->dataPath);
+	char temp[length + 5];
+	RMTileStoreEntry **order = NULL;
+	uint64_t *offsets = NULL, generation = store->generation, dataEnd = store->dataEnd;
+	char *buf = NULL;
+	size_t bufSize = 0;
+	unsigned i;
+	int fd, saved;
+
+	memcpy(temp, store->dataPath, length);
+	memcpy(temp + length, ".tmp", 5);
+	if ((fd = open(temp, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+		return -1;
+	if (store->count
+		&& (!(order = malloc(store->count * sizeof(RMTileStoreEntry *)))
+			|| !(offsets = malloc(store->count * sizeof(uint64_t)))))
+		goto fail;
+	if (RMTileStoreResetData(store, fd) != 0)
+		goto fail;
+
+	for (i = 0; i < store->count; i++)
+		order[i] = store->entries + i;
+	qsort(order, store->count, sizeof(RMTileStoreEntry *), RMTileStoreCompareOffset);
+
+	for (i = 0; i < store->count; i++) {
+		uint64_t size = RecordSize(order[i]->length);
+		if (size > bufSize) {
+			char *bigger = realloc(buf, size);
+			if (!bigger)
+				goto fail;
+			buf = bigger;
+			bufSize = size;
+		}
+		if (RMTileStoreReadAll(store->fd, buf, size, order[i]->offset) != 0
+			|| RMTileStoreWriteAll(fd, buf, size, store->dataEnd) != 0)
+			goto fail;
+		offsets[i] = store->dataEnd;
+		store->dataEnd += size;
+	}
+	if (fsync(fd) != 0 || rename(temp, store->dataPath) != 0)
+		goto fail;
+
+	close(store->fd);
+	store->fd = fd;
+	for (i = 0; i < store->count; i++)
+		order[i]->offset = offsets[i];
+	free(order);
+	free(offsets);
+	free(buf);
+	return RMTileStoreWriteIndex(store);
+
+fail:
+	saved = errno;
+	store->generation = generation;
+	store->dataEnd = dataEnd;
+	close(fd);
+	unlink(temp);
+	free(order);
+	free(offsets);
+	free(buf);
+	errno = saved;
+	return -1;
+}
+
+int
+RMTileStoreCompact(RMTileStore *store)
+{
+	int result;
+
+	pthread_mutex_lock(&store->lock);
+	result = RMTileStoreCompactLocked(store);
+	pthread_mutex_unlock(&store->lock);
+	return result;
+}
+
+int
+RMTileStoreSync(RMTileStore *store)
+{
+	uint64_t dead;
+	int result = 0;
+
+	pthread_mutex_lock(&store->lock);
+	dead = store->dataEnd - sizeof(RMTileStoreDataHeader) - store->liveBytes;
+	if (dead > store->liveBytes && dead >= kRMTileStoreMinCompactBytes)
+		result = RMTileStoreCompactLocked(store);
+	else if (store->dirty)
+		result = RMTileStoreWriteIndex(store);
+	pthread_mutex_unlock(&store->lock);
+	return result;
+}
+
+int
+RMTileStoreEmpty(RMTileStore *store)
+{
+	int result;
+
+	pthread_mutex_lock(&store->lock);
+	RMTileStoreClear(store);
+	result = RMTileStoreResetData(store, store->fd);
+	if (result == 0)
+		result = RMTileStoreWriteIndex(store);
+	pthread_mutex_unlock(&store->lock);
+	return result;
+}
+
+unsigned
+RMTileStoreCount(RMTileStore *store)
+{
+	unsigned count;
+
+	pthread_mutex_lock(&store->lock);
+	count = store->count;
+	pthread_mutex_unlock(&store->lock);
+	return count;
+}
+
+uint64_t
+RMTileStoreFileSize(RMTileStore *store)
+{
+	uint64_t size;
+
+	pthread_mutex_lock(&store->lock);
+	size = store->dataEnd;
+	pthread_mutex_unlock(&store->lock);
+	return size;
+}
@@ -0,0 +1,103 @@
+//
+//  RMTileStore.h
+//
+// Copyright (c) 2008-2010, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _RM_TILE_STORE_H_
+#define _RM_TILE_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! \file RMTileStore.h
+ \brief Packed single-file storage for cached tiles, used by RMStorage.
+
+ All tiles live in one append-only data file, tiles.dat, and a compact
+ index, tiles.idx, maps each 64 bit key to the offset and length of its
+ tile. A lookup is a probe of an in-memory hash table and a single pread(),
+ instead of a stat, an open and an unarchive per tile.
+
+ The store also keeps the tiles in eviction order, a segmented LRU driven
+ by a logical clock rather than file access times (which many volumes do
+ not keep): tiles read since they were stored outlive those that were
+ only stored. tiles.idx is written in that order, so it survives a
+ relaunch, and RMTileStorePrune() takes tiles off its cold end in time
+ proportional to the number removed.
+
+ Overwritten and removed tiles leave dead bytes behind in the data file;
+ RMTileStoreSync() rewrites the file without them once they make up more
+ than half of it. The index is only written by RMTileStoreSync() and
+ RMTileStoreClose(). Tiles appended after the last sync are found again
+ on the next open by scanning the data file past the point the index
+ covers, so a crash loses recent accesses and removals, never tiles.
+
+ Every record carries its key and length, so a missing or damaged index is
+ rebuilt from the data file alone. Files are in native byte order.
+
+ All functions may be called from any thread; a store serializes its own
+ operations. Functions returning int give 0 on success and -1 with errno
+ set on failure.
+ */
+
+typedef struct RMTileStore RMTileStore;
+
+/// Opens or creates the store in directory, which must exist.
+RMTileStore *RMTileStoreOpen(const char *directory);
+
+/// Writes the index and releases the store.
+void RMTileStoreClose(RMTileStore *store);
+
+/// Writes the index, compacting the data file first if it is mostly dead bytes.
+int RMTileStoreSync(RMTileStore *store);
+
+/// Returns a malloc()ed copy of the tile stored under key and its length,
+/// or NULL if there is none. Counts as an access of the tile.
+void *RMTileStoreCopyData(RMTileStore *store, uint64_t key, size_t *length);
+
+/// Returns 1 if a tile is stored under key, without counting as an access.
+int RMTileStoreContains(RMTileStore *store, uint64_t key);
+
+/// Stores length bytes of data under key, replacing any tile already there.
+int RMTileStorePut(RMTileStore *store, uint64_t key, const void *data, size_t length);
+
+/// Removes the tile stored under key; removing a missing key is not an error.
+int RMTileStoreRemove(RMTileStore *store, uint64_t key);
+
+/// Removes the number coldest tiles in eviction order, returns how many went.
+unsigned RMTileStorePrune(RMTileStore *store, unsigned number);
+
+/// Rewrites the data file with only the live tiles.
+int RMTileStoreCompact(RMTileStore *store);
+
+/// Removes every tile.
+int RMTileStoreEmpty(RMTileStore *store);
+
+/// Number of tiles stored.
+unsigned RMTileStoreCount(RMTileStore *store);
+
+/// Size of the data file in bytes, dead bytes included.
+uint64_t RMTileStoreFileSize(RMTileStore *store);
+
+#endif
@@ -11,6 +11,7 @@
 //  by author Darcy Brockbank May 20, 2010
 
 #import <Foundation/Foundation.h>
+#import "RMTile.h"
 
 ///////////////////////////////////////////////////////////////// DEFAULT KEYS
 
@@ -47,11 +48,74 @@ extern NSString * const kRMKeyStorageLimit;
 
 extern NSString * const kRMKeyPrimaryCacheMemoryLimit;
 
+// Picks the replacement policy of the primary cache: "LRU", "2Q" or 
+// "TinyLFU", see RMPrimaryCache.h. The default is "TinyLFU". The value is
+// a string and is read once, when the cache starts.
+
+extern NSString * const kRMKeyPrimaryCachePolicy;
+
+// The limit in bytes of the primary cache's tier of decoded tiles, which is
+// on top of kRMKeyPrimaryCacheMemoryLimit. Each tile counts its bitmap and
+// the PNG data it keeps: a 256x256 tile takes 256k and its PNG up to 25k,
+// so the default of 3,000,000 holds a screen of tiles and the ring around
+// it. Integer.
+
+extern NSString * const kRMKeyPrimaryCacheDecodedMemoryLimit;
+
 // Controls whether or not secondary cache reads are done in the main
 // thread or offloaded into the worker thread. The default is YES.
 
 extern NSString * const kRMKeySecondaryCacheImmediateRead; 
 
+///////////////////////////////////////////////////////////////// CACHE KEYS
+
+// Cached objects are found by a 64 bit key rather than by their URL. A tile
+// of a source with an id packs into the key without loss:
+//
+//     bit 63      0
+//     bits 53-62  source id, 1 to kRMCacheMaxSourceID
+//     bits 48-52  zoom, up to kRMCacheMaxTileZoom
+//     bits 24-47  x
+//     bits 0-23   y
+//
+// so its tile can be looked up in the caches without ever building the URL,
+// which is only done if it has to come from the network. Anything else is
+// keyed by the 64 bit hash of its URL with bit 63 set, so the two kinds
+// never collide. 0 is not a valid key.
+
+typedef uint64_t RMCacheKey;
+
+#define kRMCacheNoSource		((uint32_t)0xFFFFFFFF)
+#define kRMCacheMaxSourceID		1023
+#define kRMCacheMaxTileZoom		24
+
+// The key for tile in the source with sourceID, or 0 if the tile cannot be
+// packed (no source id, or a zoom beyond kRMCacheMaxTileZoom) and has to be
+// keyed by its URL.
+extern RMCacheKey
+RMCacheKeyForTile(uint32_t sourceID, RMTile tile);
+
+// The key for anything by the URL it is loaded from.
+extern RMCacheKey
+RMCacheKeyForURL(NSString *url);
+
+// A small integer standing for the tile source name, the same on every
+// launch. Returns kRMCacheNoSource for a nil name, once kRMCacheMaxSourceID
+// names have been given out, or if the new id cannot be recorded.
+extern uint32_t
+RMCacheSourceIDForName(NSString *name);
+
+// The file of the secondary storage directory recording the names and ids
+// RMCacheSourceIDForName() has given out. It lives next to the tiles keyed
+// by those ids, so the two are lost together.
+extern NSString * const kRMCacheSourceIDsFile;
+
+// YES if the ids on record started over this launch, the file having been
+// lost or never written. Tiles already in secondary storage may then be
+// keyed by ids about to go to other sources, and have to be dropped.
+extern BOOL
+RMCacheSourceIDsAreNew(void);
+
 ///////////////////////////////////////////////////////////////// ERROR UTILITIES
 
 // Runs an alert panel for the error
@@ -68,12 +132,6 @@ RMAlert(NSString *message);
 extern unsigned 
 RMDirCount(const char *path);
 
-// Prunes the oldest 'number' files from the mainPath, and if the file exists
-// in mirrorPath, it will be deleted from this location as well. Age is based
-// not on creation time, but on access time. Returns the number deleted.
-extern unsigned
-RMPrune(const char *mainPath, unsigned number);
-
 
 //////////////////////////////////////////////////////////////// CATEGORIES
 
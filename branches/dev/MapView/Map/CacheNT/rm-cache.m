@@ -11,6 +11,7 @@
 //  by author Darcy Brockbank May 20, 2010
 
 #import "rm-cache.h"
+#import "RMStorage.h"
 #import <UIKit/UIKit.h>
 #import <unistd.h>
 #import <dirent.h>
@@ -18,6 +19,11 @@
 
 NSString * const kRMKeyStorageLimit = @"RMStorageLimit";
 NSString * const kRMKeyStoragePruneFraction = @"RMStoragePruneFraction";
+NSString * const kRMCacheSourceIDsFile = @"tiles.sources";
+
+// the names and ids on record, read on first use
+static NSMutableDictionary *sourceIDs;
+static BOOL sourceIDsAreNew;
 
 void RMError(NSError *error)
 {
@@ -40,130 +46,114 @@ void RMAlert(NSString *message)
     [alert release];
 }
 
-///////////////////////////////////////////////////////////// FILESYSTEM UTILS
+///////////////////////////////////////////////////////////// CACHE KEYS
 
-// probably the fastest way of getting the count of what is in the directory currently
-// we could hold the count and archive it, but this would bring up the possibility
-// of an error causing a mismatch between filesystem and our count... so it is safer,
-// though slower, to just iterate the cache when we start up and get our count at this
-// point...
-unsigned 
-RMDirCount(const char *path)
+RMCacheKey
+RMCacheKeyForTile(uint32_t sourceID, RMTile tile)
 {
-	unsigned count = 0;
-	struct dirent d,*dp;
-	DIR *dirp = opendir(path);
-	if (dirp) {
-		while ((readdir_r(dirp,&d,&dp)) == 0 && dp){
-			count++;
-		}
-		(void)closedir(dirp);
+	if (sourceID == 0 || sourceID > kRMCacheMaxSourceID 
+		|| tile.zoom < 0 || tile.zoom > kRMCacheMaxTileZoom
+		|| tile.x >> tile.zoom || tile.y >> tile.zoom) {
+		return 0;
 	}
-	// remove the two special files "." and ".."
-	return count-2;
+	return ((RMCacheKey)sourceID << 53) 
+		| ((RMCacheKey)tile.zoom << 48) 
+		| ((RMCacheKey)tile.x << 24) 
+		| (RMCacheKey)tile.y;
 }
 
-typedef struct {
-	char *path;
-	struct stat sb;
-} RMFileEntry;
+RMCacheKey
+RMCacheKeyForURL(NSString *url)
+{
+	return [url hash64] | (1ULL << 63);
+}
 
-static CFComparisonResult 
-RMStatCompare(const void *ptr1, const void *ptr2, void *info)
+static NSString *
+RMCacheSourceIDsPath(void)
 {
-	const RMFileEntry *d1 = ptr1;
-	const RMFileEntry *d2 = ptr2;
-	if (d1->sb.st_atimespec.tv_sec < d2->sb.st_atimespec.tv_sec){
-		return kCFCompareLessThan;
-	} else if (d1->sb.st_atimespec.tv_sec > d2->sb.st_atimespec.tv_sec){
-		return kCFCompareGreaterThan;
-	} else if (d1->sb.st_atimespec.tv_nsec < d2->sb.st_atimespec.tv_nsec){
-		return kCFCompareLessThan;
-	} else if (d1->sb.st_atimespec.tv_nsec > d2->sb.st_atimespec.tv_nsec){
-		return kCFCompareGreaterThan;
-	} else {
-		return kCFCompareEqualTo;
+	return [[RMStorage pathForCache:kRMStorageCache] stringByAppendingPathComponent:kRMCacheSourceIDsFile];
+}
+
+// called with the lock held
+static void
+RMCacheLoadSourceIDs(void)
+{
+	if (!sourceIDs) {
+		NSDictionary *ids = [NSDictionary dictionaryWithContentsOfFile:RMCacheSourceIDsPath()];
+		sourceIDsAreNew = ids == nil;
+		sourceIDs = ids ? [ids mutableCopy] : [NSMutableDictionary new];
 	}
 }
 
-static inline RMFileEntry *
-RMFileEntryCreate(struct dirent *dp, struct stat *sb)
+// ids are given out in order of first use and never taken back, so a source
+// keeps its tiles in secondary storage from one launch to the next
+uint32_t
+RMCacheSourceIDForName(NSString *name)
 {
-	RMFileEntry *fe = malloc(sizeof(RMFileEntry));
-	fe->sb = *sb;
-	fe->path = malloc(dp->d_namlen+1);
-	strcpy(fe->path,dp->d_name);
-	return fe;
+	if (!name) {
+		return kRMCacheNoSource;
+	}
+	uint32_t sourceID;
+	@synchronized(kRMCacheSourceIDsFile) {
+		RMCacheLoadSourceIDs();
+		NSNumber *number = [sourceIDs objectForKey:name];
+		if (number) {
+			sourceID = [number unsignedIntValue];
+		} else if ([sourceIDs count] >= kRMCacheMaxSourceID) {
+			NSLog(@"no cache source id left for %@, its tiles are keyed by URL",name);
+			sourceID = kRMCacheNoSource;
+		} else {
+			NSString *path = RMCacheSourceIDsPath();
+			sourceID = [sourceIDs count] + 1;
+			[sourceIDs setObject:[NSNumber numberWithUnsignedInt:sourceID] forKey:name];
+			// the storage may not have made its directory yet
+			[[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+									  withIntermediateDirectories:YES
+													   attributes:nil
+															error:NULL];
+			if (![sourceIDs writeToFile:path atomically:YES]) {
+				// an id not on record could go to another name next launch
+				NSLog(@"could not write %@, tiles of %@ are keyed by URL",path,name);
+				[sourceIDs removeObjectForKey:name];
+				sourceID = kRMCacheNoSource;
+			}
+		}
+	}
+	return sourceID;
 }
 
-static inline void
-RMFileEntryRelease(RMFileEntry *fe)
+BOOL
+RMCacheSourceIDsAreNew(void)
 {
-	free(fe->path);
-	free(fe);
+	BOOL isNew;
+	@synchronized(kRMCacheSourceIDsFile) {
+		RMCacheLoadSourceIDs();
+		isNew = sourceIDsAreNew;
+	}
+	return isNew;
 }
 
-// Prunes the oldest 'number' files from the mainPath, and if the file exists
-// in mirrorPath, it will be deleted from this location as well. Age is based
-// not on creation time, but on access time. Returns the number deleted.
-
-// What we're trying to do here is make a run through and in minimum space and
-// time select the pruning set. We need to preserve the filenames in order to
-// pass them to unlink() and we need the stat information to get the last access
-// times. This can possibly be done better with getattrlist() and its ilk but
-// the API for them is an utter mess and I'm first worried about correctness.
-// Ideally stat() etc., are implemented on top of the filesystem in the most
-// efficient way possible anyway... I hope.
-unsigned
-RMPrune(const char *mainPath, unsigned number)
+///////////////////////////////////////////////////////////// FILESYSTEM UTILS
+
+// probably the fastest way of getting the count of what is in the directory currently
+// we could hold the count and archive it, but this would bring up the possibility
+// of an error causing a mismatch between filesystem and our count... so it is safer,
+// though slower, to just iterate the cache when we start up and get our count at this
+// point...
+unsigned 
+RMDirCount(const char *path)
 {
-	CFBinaryHeapCallBacks cb = {
-		0,NULL,NULL,NULL,RMStatCompare
-	};
-	CFBinaryHeapRef heap = CFBinaryHeapCreate(0,number,&cb,0);
 	unsigned count = 0;
 	struct dirent d,*dp;
-	struct stat current;
-	RMFileEntry *fe;
-	NSTimeInterval time = [NSDate timeIntervalSinceReferenceDate];
-	NSLog(@"Pruning %u, wish me luck...",number);
-	DIR *dirp = opendir(mainPath);
+	DIR *dirp = opendir(path);
 	if (dirp) {
-		while ((readdir_r(dirp,&d,&dp)) == 0){
-			if (stat(dp->d_name,&current)==0){
-				if (count<number) {
-					fe = RMFileEntryCreate(dp,&current);
-					// we just add it to the heap
-					CFBinaryHeapAddValue(heap,fe);
-				} else {
-					// check current vs. the top
-					fe = (RMFileEntry *)CFBinaryHeapGetMinimum(heap);
-					if (RMStatCompare(fe,&current,0) == kCFCompareLessThan){
-						// pop the top, and insert current
-						CFBinaryHeapRemoveMinimumValue(heap);
-						RMFileEntryRelease(fe);
-						fe = RMFileEntryCreate(dp,&current);
-						CFBinaryHeapAddValue(heap,fe);
-					}
-				}
-			}
+		while ((readdir_r(dirp,&d,&dp)) == 0 && dp){
 			count++;
 		}
 		(void)closedir(dirp);
-		count = 0;
-		// the heap is now populated with the items we have to prune, now we will remove them
-		while ((fe = (RMFileEntry *)CFBinaryHeapGetMinimum(heap))){
-			CFBinaryHeapRemoveMinimumValue(heap);
-			if (unlink(fe->path)!=0){
-				NSLog(@"unlink() = %d, %s",errno,strerror(errno));
-			} else {
-				count++;
-			}
-			RMFileEntryRelease(fe);
-		}
 	}
-	NSLog(@"Prune completed in %.4f seconds.",[NSDate timeIntervalSinceReferenceDate]-time);
-	return count;
+	// remove the two special files "." and ".."
+	return count-2;
 }
 
 
@@ -306,6 +306,10 @@ enum {
 - (RMTilePoint)convertCoordinateToTilePoint:(CLLocationCoordinate2D)aCoordinate withMetersPerPixel:(float)aScale;
 - (CLLocationCoordinate2D)convertPointToCoordinate:(CGPoint)aPoint;
 - (CLLocationCoordinate2D)convertPointToCoordinate:(CGPoint)aPoint withMetersPerPixel:(float)aScale;
+/// #convertCoordinateToPoint: for count coordinates, projected in one batch.
+- (void)convertCoordinates:(const CLLocationCoordinate2D *)coordinates toPoints:(CGPoint *)points count:(NSUInteger)count;
+/// #convertPointToCoordinate: for count points, unprojected in one batch.
+- (void)convertPoints:(const CGPoint *)points toCoordinates:(CLLocationCoordinate2D *)coordinates count:(NSUInteger)count;
 
 - (void)zoomWithLatLngBoundsNorthEast:(CLLocationCoordinate2D)ne SouthWest:(CLLocationCoordinate2D)se;
 - (void)zoomWithRMMercatorRectBounds:(RMProjectedRect)bounds;
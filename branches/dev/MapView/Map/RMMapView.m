@@ -1154,6 +1154,37 @@ BOOL delegateHasRegionUpdate;
 	return [projection coordinateForProjectedPoint:[mercatorToViewProjection convertPointToProjectedPoint:aPoint withMetersPerPixel:aScale]];
 }
 
+- (void)convertCoordinates:(const CLLocationCoordinate2D *)coordinates toPoints:(CGPoint *)points count:(NSUInteger)count
+{
+	RMProjectedPoint *projectedPoints = malloc(count * sizeof(RMProjectedPoint));
+	if (projectedPoints == NULL)
+	{
+		for (NSUInteger i = 0; i < count; i++)
+			points[i] = [self convertCoordinateToPoint:coordinates[i]];
+		return;
+	}
+	
+	[projection projectedPoints:projectedPoints forCoordinates:coordinates count:count];
+	[mercatorToViewProjection convertProjectedPoints:projectedPoints toPoints:points count:count];
+	free(projectedPoints);
+}
+
+- (void)convertPoints:(const CGPoint *)points toCoordinates:(CLLocationCoordinate2D *)coordinates count:(NSUInteger)count
+{
+	RMProjectedPoint *projectedPoints = malloc(count * sizeof(RMProjectedPoint));
+	if (projectedPoints == NULL)
+	{
+		for (NSUInteger i = 0; i < count; i++)
+			coordinates[i] = [self convertPointToCoordinate:points[i]];
+		return;
+	}
+	
+	for (NSUInteger i = 0; i < count; i++)
+		projectedPoints[i] = [mercatorToViewProjection convertPointToProjectedPoint:points[i]];
+	[projection coordinates:coordinates forProjectedPoints:projectedPoints count:count];
+	free(projectedPoints);
+}
+
 - (double)scaleDenominator {
 	double routemeMetersPerPixel = [self metersPerPixel];
 	double iphoneMillimetersPerPixel = kiPhoneMilimeteresPerPixel;
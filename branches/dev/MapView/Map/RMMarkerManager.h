@@ -42,6 +42,8 @@
 - (id)initWithMapView:(RMMapView *)aMapView;
 
 - (void) addMarker: (RMMarker*)marker AtLatLong:(CLLocationCoordinate2D)point;
+/// Adds markers at points[0 ... [markers count] - 1], projecting all the coordinates in one batch.
+- (void) addMarkers: (NSArray*)markers atLatLongs:(const CLLocationCoordinate2D *)points;
 - (void) removeMarkers;
 - (void) hideAllMarkers;
 - (void) unhideAllMarkers;
@@ -56,6 +58,8 @@
 - (BOOL) isMarker:(RMMarker*)marker withinBounds:(CGRect)rect;
 - (BOOL) managingMarker:(RMMarker*)marker;
 - (void) moveMarker:(RMMarker *)marker AtLatLon:(RMLatLong)point;
+/// Moves markers to points[0 ... [markers count] - 1], projecting all the coordinates in one batch.
+- (void) moveMarkers:(NSArray *)markers atLatLongs:(const RMLatLong *)points;
 - (void) moveMarker:(RMMarker *)marker AtXY:(CGPoint)point;
 - (void)setRotation:(float)angle;
 
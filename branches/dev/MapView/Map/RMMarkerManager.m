@@ -61,12 +61,55 @@
 - (void) addMarker: (RMMarker*)marker AtLatLong:(CLLocationCoordinate2D)point
 {
 
+	RMProjectedPoint projectedPoint = [[mapView projection] projectedPointForCoordinate:point];
+
 	[marker setAffineTransform:rotationTransform];
-	[marker setProjectedLocation:[[mapView projection]projectedPointForCoordinate:point]];
-	[marker setPosition:[[mapView mercatorToViewProjection] convertProjectedPointToPoint:[[mapView projection] projectedPointForCoordinate:point]]];
+	[marker setProjectedLocation:projectedPoint];
+	[marker setPosition:[[mapView mercatorToViewProjection] convertProjectedPointToPoint:projectedPoint]];
 	[[mapView overlay] addSublayer:marker];
 }
 
+/// projected and screen locations of each marker in markers from its coordinate in points
+- (void) placeMarkers: (NSArray*)markers atLatLongs:(const CLLocationCoordinate2D *)points
+{
+	NSUInteger count = [markers count];
+	RMProjectedPoint *projectedPoints = malloc(count * sizeof(RMProjectedPoint));
+	CGPoint *screenPoints = malloc(count * sizeof(CGPoint));
+	
+	if (projectedPoints == NULL || screenPoints == NULL)
+	{
+		free(projectedPoints);
+		free(screenPoints);
+		for (NSUInteger i = 0; i < count; i++)
+			[self moveMarker:[markers objectAtIndex:i] AtLatLon:points[i]];
+		return;
+	}
+	
+	[[mapView projection] projectedPoints:projectedPoints forCoordinates:points count:count];
+	[[mapView mercatorToViewProjection] convertProjectedPoints:projectedPoints toPoints:screenPoints count:count];
+	
+	NSUInteger i = 0;
+	for (RMMarker *marker in markers)
+	{
+		[marker setProjectedLocation:projectedPoints[i]];
+		[marker setPosition:screenPoints[i]];
+		i++;
+	}
+	
+	free(projectedPoints);
+	free(screenPoints);
+}
+
+- (void) addMarkers: (NSArray*)markers atLatLongs:(const CLLocationCoordinate2D *)points
+{
+	for (RMMarker *marker in markers)
+		[marker setAffineTransform:rotationTransform];
+	[self placeMarkers:markers atLatLongs:points];
+	
+	for (RMMarker *marker in markers)
+		[[mapView overlay] addSublayer:marker];
+}
+
 /// \bug see http://code.google.com/p/route-me/issues/detail?id=75
 /// (halmueller): I am skeptical about interactions of this code with paths
 - (void) removeMarkers
@@ -166,8 +209,15 @@
 
 - (void) moveMarker:(RMMarker *)marker AtLatLon:(RMLatLong)point
 {
-	[marker setProjectedLocation:[[mapView projection]projectedPointForCoordinate:point]];
-	[marker setPosition:[[mapView mercatorToViewProjection] convertProjectedPointToPoint:[[mapView projection] projectedPointForCoordinate:point]]];
+	RMProjectedPoint projectedPoint = [[mapView projection] projectedPointForCoordinate:point];
+
+	[marker setProjectedLocation:projectedPoint];
+	[marker setPosition:[[mapView mercatorToViewProjection] convertProjectedPointToPoint:projectedPoint]];
+}
+
+- (void) moveMarkers:(NSArray *)markers atLatLongs:(const RMLatLong *)points
+{
+	[self placeMarkers:markers atLatLongs:points];
 }
 
 - (void) moveMarker:(RMMarker *)marker AtXY:(CGPoint)point
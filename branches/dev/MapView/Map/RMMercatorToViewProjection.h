@@ -70,6 +70,10 @@
 - (CGPoint)convertProjectedPointToPoint:(RMProjectedPoint)aPoint withMetersPerPixel:(float)aScale;
 /// Project -> screen coordinates.
 - (CGPoint)convertProjectedPointToPoint:(RMProjectedPoint)aPoint;
+/// Project -> screen coordinates, count points at once.
+- (void)convertProjectedPoints:(const RMProjectedPoint *)projectedPoints toPoints:(CGPoint *)points count:(NSUInteger)count withMetersPerPixel:(float)aScale;
+/// Project -> screen coordinates, count points at once.
+- (void)convertProjectedPoints:(const RMProjectedPoint *)projectedPoints toPoints:(CGPoint *)points count:(NSUInteger)count;
 /// Project -> screen coordinates.
 - (CGRect)convertProjectedRectToRect:(RMProjectedRect)aRect;
 
@@ -142,8 +142,16 @@
  */
 - (CGPoint)convertProjectedPointToPoint:(RMProjectedPoint)aPoint withMetersPerPixel:(float)aScale
 {
-	CGPoint	aPixelPoint = { 0, 0 };
+	CGPoint	aPixelPoint;
 	
+	[self convertProjectedPoints:&aPoint toPoints:&aPixelPoint count:1 withMetersPerPixel:aScale];
+	
+	return aPixelPoint;
+}
+
+/// #convertProjectedPointToPoint:withMetersPerPixel: for count points; the screen bounds and the divider test are worked out once.
+- (void)convertProjectedPoints:(const RMProjectedPoint *)projectedPoints toPoints:(CGPoint *)points count:(NSUInteger)count withMetersPerPixel:(float)aScale
+{
 	RMProjectedRect projectedScreenBounds;
 	projectedScreenBounds.origin = origin;
 	projectedScreenBounds.size.width = viewBounds.size.width * aScale;
@@ -160,32 +168,26 @@
 	normalizedProjectedScreenBounds.origin.northing = projectedScreenBounds.origin.northing + planetEndPoint.northing;
 	normalizedProjectedScreenBounds.size = projectedScreenBounds.size;
 	
-	RMProjectedPoint normalizedProjectedPoint;
-	normalizedProjectedPoint.easting = aPoint.easting + planetEndPoint.easting;
-	normalizedProjectedPoint.northing = aPoint.northing + planetEndPoint.northing;
-	
-	double rightMostViewableEasting;
-	
 	// check if world wrap divider is contained in view
-	if (( normalizedProjectedScreenBounds.origin.easting + normalizedProjectedScreenBounds.size.width ) > planetBounds.size.width ) {
-		rightMostViewableEasting = projectedScreenBounds.size.width - ( planetBounds.size.width - normalizedProjectedScreenBounds.origin.easting );
+	BOOL dividerInView = ( normalizedProjectedScreenBounds.origin.easting + normalizedProjectedScreenBounds.size.width ) > planetBounds.size.width;
+	double rightMostViewableEasting = projectedScreenBounds.size.width - ( planetBounds.size.width - normalizedProjectedScreenBounds.origin.easting );
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		RMProjectedPoint normalizedProjectedPoint;
+		normalizedProjectedPoint.easting = projectedPoints[i].easting + planetEndPoint.easting;
+		normalizedProjectedPoint.northing = projectedPoints[i].northing + planetEndPoint.northing;
+		
 		// Check if Right of divider but on screen still
-		if ( normalizedProjectedPoint.easting <= rightMostViewableEasting ) {
-			aPixelPoint.x = ( planetBounds.size.width + normalizedProjectedPoint.easting - normalizedProjectedScreenBounds.origin.easting ) / aScale;
+		if ( dividerInView && normalizedProjectedPoint.easting <= rightMostViewableEasting ) {
+			points[i].x = ( planetBounds.size.width + normalizedProjectedPoint.easting - normalizedProjectedScreenBounds.origin.easting ) / aScale;
 		} else {
-			// everywhere else is left of divider
-			aPixelPoint.x = ( normalizedProjectedPoint.easting - normalizedProjectedScreenBounds.origin.easting ) / aScale;
+			// everywhere else is left of divider, or the divider is not contained in view
+			points[i].x = ( normalizedProjectedPoint.easting - normalizedProjectedScreenBounds.origin.easting ) / aScale;
 		}
 		
+		points[i].y = viewBounds.size.height - ( normalizedProjectedPoint.northing - normalizedProjectedScreenBounds.origin.northing ) / aScale;
 	}
-	else {
-		// Divider not contained in view
-		aPixelPoint.x = ( normalizedProjectedPoint.easting - normalizedProjectedScreenBounds.origin.easting ) / aScale;
-	}
-	
-	aPixelPoint.y = viewBounds.size.height - ( normalizedProjectedPoint.northing - normalizedProjectedScreenBounds.origin.northing ) / aScale;
-	
-	return aPixelPoint;
 }
 
 /*
@@ -221,6 +223,11 @@
 	return [self convertProjectedPointToPoint:aPoint withMetersPerPixel:metersPerPixel];
 }
 
+- (void)convertProjectedPoints:(const RMProjectedPoint *)projectedPoints toPoints:(CGPoint *)points count:(NSUInteger)count
+{
+	[self convertProjectedPoints:projectedPoints toPoints:points count:count withMetersPerPixel:metersPerPixel];
+}
+
 - (CGRect)convertProjectedRectToRect:(RMProjectedRect)aRect
 {
 	CGRect aPixelRect;
@@ -92,6 +92,10 @@
 - (void) addLineToXY: (RMProjectedPoint) point;
 - (void) addLineToScreenPoint: (CGPoint) point;
 - (void) addLineToLatLong: (RMLatLong) point;
+/// Like #addLineToXY: on each of points in turn, but the layer geometry is recalculated once at the end.
+- (void) addLinesToXY: (const RMProjectedPoint *) points count: (NSUInteger) count;
+/// Like #addLineToLatLong: on each of points in turn; the coordinates are projected in one batch.
+- (void) addLinesToLatLongs: (const RMLatLong *) points count: (NSUInteger) count;
 
 /// This closes the path, connecting the last point to the first.
 /// After this action, no further points can be added to the path.
@@ -148,7 +148,8 @@
 	[self setNeedsDisplay];
 }
 
-- (void) addPointToXY: (RMProjectedPoint) point withDrawing: (BOOL)isDrawing
+/// adds point to path without updating the layer, returns NO for the first point, which only sets projectedLocation
+- (BOOL) appendPointToXY: (RMProjectedPoint) point withDrawing: (BOOL)isDrawing
 {
 	//	RMLog(@"addLineToXY %f %f", point.x, point.y);
 
@@ -161,21 +162,25 @@
 		self.position = [[mapView mercatorToViewProjection] convertProjectedPointToPoint: projectedLocation];
 		//		RMLog(@"screen position set to %f %f", self.position.x, self.position.y);
 		CGPathMoveToPoint(path, NULL, 0.0f, 0.0f);
+		return NO;
 	}
-	else
-	{
-		point.easting = point.easting - projectedLocation.easting;
-		point.northing = point.northing - projectedLocation.northing;
 
-		if (isDrawing)
-		{
-			CGPathAddLineToPoint(path, NULL, point.easting, -point.northing);
-		} else {
-			CGPathMoveToPoint(path, NULL, point.easting, -point.northing);
-		}
+	point.easting = point.easting - projectedLocation.easting;
+	point.northing = point.northing - projectedLocation.northing;
 
-		[self recalculateGeometry];
+	if (isDrawing)
+	{
+		CGPathAddLineToPoint(path, NULL, point.easting, -point.northing);
+	} else {
+		CGPathMoveToPoint(path, NULL, point.easting, -point.northing);
 	}
+	return YES;
+}
+
+- (void) addPointToXY: (RMProjectedPoint) point withDrawing: (BOOL)isDrawing
+{
+	if ([self appendPointToXY:point withDrawing:isDrawing])
+		[self recalculateGeometry];
 	[self setNeedsDisplay];
 }
 
@@ -217,6 +222,35 @@
 	[self addLineToXY:mercator];
 }
 
+- (void) addLinesToXY: (const RMProjectedPoint *) points count: (NSUInteger) count
+{
+	BOOL changed = NO;
+	
+	for (NSUInteger i = 0; i < count; i++)
+		changed |= [self appendPointToXY: points[i] withDrawing: TRUE];
+	
+	// one geometry update for the whole run instead of one per point
+	if (changed)
+		[self recalculateGeometry];
+	[self setNeedsDisplay];
+}
+
+- (void) addLinesToLatLongs: (const RMLatLong *) points count: (NSUInteger) count
+{
+	RMProjectedPoint *mercators = malloc(count * sizeof(RMProjectedPoint));
+	
+	if (mercators == NULL)
+	{
+		for (NSUInteger i = 0; i < count; i++)
+			[self addLineToLatLong: points[i]];
+		return;
+	}
+	
+	[[mapView projection] projectedPoints:mercators forCoordinates:points count:count];
+	[self addLinesToXY: mercators count: count];
+	free(mercators);
+}
+
 - (void)drawInContext:(CGContextRef)theContext
 {
 	renderedScale = [mapView metersPerPixel];
@@ -42,6 +42,10 @@
 	
 	/// hardcoded to YES in #initWithString:InBounds:
 	BOOL		projectionWrapsHorizontally;
+	
+	/// A projSphereMerc (see pj_sphere_merc.h) when the definition is a plain spherical Mercator, like #googleProjection, else NULL.
+	/// Points are then projected inline instead of through pj_fwd/pj_inv, with identical results.
+	void*		sphereMercator;
 }
 
 @property (readonly) void* internalProjection;
@@ -64,4 +68,10 @@
 - (RMLatLong)coordinateForProjectedPoint:(RMProjectedPoint)aPoint;
 - (RMProjectedPoint)projectedPointForCoordinate:(RMLatLong)aLatLong;
 
+/// #projectedPointForCoordinate: for count coordinates at once. The points go through pj_fwd_batch (or the spherical
+/// Mercator batch) instead of one pj_fwd call each, which is what placing hundreds of markers or path vertices wants.
+- (void)projectedPoints:(RMProjectedPoint *)points forCoordinates:(const RMLatLong *)coordinates count:(NSUInteger)count;
+/// #coordinateForProjectedPoint: for count points at once, through pj_inv_batch.
+- (void)coordinates:(RMLatLong *)coordinates forProjectedPoints:(const RMProjectedPoint *)points count:(NSUInteger)count;
+
 @end
@@ -26,6 +26,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #import "RMGlobalConstants.h"
 #import "proj_api.h"
+#import "pj_sphere_merc.h"
 #import "RMProjection.h"
 
 
@@ -46,7 +47,8 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 	if (![super init])
 		return nil;
 	
-	internalProjection = pj_init_plus([projectionArguments UTF8String]);
+	// projections with the same definition share one cached PJ
+	internalProjection = pj_init_plus_cached([projectionArguments UTF8String]);
 	if (internalProjection == NULL)
 	{
 		RMLog(@"Unhandled error creating projection. String is %@", projectionArguments);
@@ -58,6 +60,15 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 
 	projectionWrapsHorizontally = YES;
 	
+	// the Google projection and its like skip pj_fwd/pj_inv for most points
+	projSphereMerc fastPath;
+	if (pj_get_sphere_merc(internalProjection, &fastPath))
+	{
+		sphereMercator = malloc(sizeof(projSphereMerc));
+		if (sphereMercator)
+			*(projSphereMerc *)sphereMercator = fastPath;
+	}
+	
 	return self;
 }
 
@@ -76,7 +87,8 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 - (void)dealloc
 {
 	if (internalProjection)
-		pj_free(internalProjection);
+		pj_free_cached(internalProjection);
+	free(sphereMercator);
 	
 	[super dealloc];
 }
@@ -117,6 +129,11 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 		aCoordinate.latitude * DEG_TO_RAD
 	};
 	
+	RMProjectedPoint fast_point;
+	if (sphereMercator
+		&& pj_sphere_merc_fwd(sphereMercator, uv.u, uv.v, &fast_point.easting, &fast_point.northing) == 0)
+		return fast_point;
+	
 	projUV result = pj_fwd(uv, internalProjection);
 	
 	RMProjectedPoint result_point = {
@@ -134,7 +151,10 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 		aProjectedPoint.northing,
 	};
 	
-	projUV result = pj_inv(uv, internalProjection);
+	projUV result;
+	if (!sphereMercator
+		|| pj_sphere_merc_inv(sphereMercator, uv.u, uv.v, &result.u, &result.v) != 0)
+		result = pj_inv(uv, internalProjection);
 	
 	RMLatLong result_coordinate = {
 		result.v * RAD_TO_DEG,
@@ -144,6 +164,63 @@ NS_INLINE RMLatLong RMPixelPointAsLatLong(RMProjectedPoint xypoint) {
 	return result_coordinate;
 }
 
+/// points per pj_fwd_batch/pj_inv_batch call, so the work arrays can live on the stack
+#define kBatchChunk 256
+
+- (void)projectedPoints:(RMProjectedPoint *)points forCoordinates:(const RMLatLong *)coordinates count:(NSUInteger)count
+{
+	double x[kBatchChunk], y[kBatchChunk];
+	
+	for (NSUInteger start = 0; start < count; start += kBatchChunk)
+	{
+		NSUInteger n = MIN(count - start, (NSUInteger)kBatchChunk);
+		
+		for (NSUInteger i = 0; i < n; i++)
+		{
+			x[i] = coordinates[start + i].longitude * DEG_TO_RAD;
+			y[i] = coordinates[start + i].latitude * DEG_TO_RAD;
+		}
+		
+		if (sphereMercator)
+			pj_sphere_merc_fwd_batch(sphereMercator, n, x, y, NULL);
+		else
+			pj_fwd_batch(internalProjection, n, x, y, NULL);
+		
+		for (NSUInteger i = 0; i < n; i++)
+		{
+			points[start + i].easting = x[i];
+			points[start + i].northing = y[i];
+		}
+	}
+}
+
+- (void)coordinates:(RMLatLong *)coordinates forProjectedPoints:(const RMProjectedPoint *)points count:(NSUInteger)count
+{
+	double x[kBatchChunk], y[kBatchChunk];
+	
+	for (NSUInteger start = 0; start < count; start += kBatchChunk)
+	{
+		NSUInteger n = MIN(count - start, (NSUInteger)kBatchChunk);
+		
+		for (NSUInteger i = 0; i < n; i++)
+		{
+			x[i] = points[start + i].easting;
+			y[i] = points[start + i].northing;
+		}
+		
+		if (sphereMercator)
+			pj_sphere_merc_inv_batch(sphereMercator, n, x, y, NULL);
+		else
+			pj_inv_batch(internalProjection, n, x, y, NULL);
+		
+		for (NSUInteger i = 0; i < n; i++)
+		{
+			coordinates[start + i].latitude = y[i] * RAD_TO_DEG;
+			coordinates[start + i].longitude = x[i] * RAD_TO_DEG;
+		}
+	}
+}
+
 static RMProjection* _google = nil;
 static RMProjection* _latlong = nil;
 static RMProjection* _osgb = nil;
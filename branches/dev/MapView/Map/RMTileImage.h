@@ -52,8 +52,8 @@ typedef NSImage UIImage;
 	// Only used when appropriate
 	CALayer *layer;
 	
-	// this is our URL that maps us to our image
-	NSString *key;
+	// this is the cache key that maps us to our image
+	RMCacheKey cacheKey;
 
 	// loading proxy
 	id proxy;
@@ -77,6 +77,9 @@ typedef NSImage UIImage;
 - (void)draw;
 
 + (RMTileImage*)imageForTile: (RMTile) tile withURL: (NSString*)url;
+/// An image for a tile keyed by RMCacheKeyForTile(), which asks source for
+/// the URL only if the tile is not already cached.
++ (RMTileImage*)imageForTile: (RMTile) tile cacheKey: (RMCacheKey)cacheKey source: (id <RMCacheURLSource>)source;
 + (RMTileImage*)imageForTile: (RMTile) tile withData: (NSData*)data;
 
 - (void)moveBy: (CGSize) delta;
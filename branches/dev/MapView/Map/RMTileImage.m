@@ -88,8 +88,6 @@
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 
 	[layer release]; layer = nil;
-	[key release];
-	key = nil;
 	
 	[super dealloc];
 }
@@ -103,6 +101,11 @@
 	return [[[RMTileImage alloc] initWithTile:_tile withURL:url] autorelease];
 }
 
++ (RMTileImage*)imageForTile:(RMTile) _tile cacheKey: (RMCacheKey)_cacheKey source: (id <RMCacheURLSource>)source
+{
+	return [[[RMTileImage alloc] initWithTile:_tile cacheKey:_cacheKey source:source] autorelease];
+}
+
 
 + (RMTileImage*)imageForTile:(RMTile) tile withData: (NSData*)data
 {
@@ -112,8 +115,8 @@
 }
 - (NSString *)description;
 {
-	return [NSString stringWithFormat:@"((RMTileImage *)%p) %@: [%c%c%c] X=%d Y=%d zoom=%d",self,
-			key,
+	return [NSString stringWithFormat:@"((RMTileImage *)%p) %qx: [%c%c%c] X=%d Y=%d zoom=%d",self,
+			cacheKey,
 			marked?'x':' ',
 			isLoading?'+':' ',
 			isLoaded?'*':' ',
@@ -125,7 +128,7 @@
 -(void) cancelLoading
 {
 	if (isLoading) {
-		[RMTileFactory cancelImage:key forClient:self];
+		[RMTileFactory cancelImageForCacheKey:cacheKey forClient:self];
 	}
 }
 
@@ -255,7 +258,7 @@
 {
         layer.contents = (id)[img CGImage]; 
 }
-- (void)factoryDidLoad:(UIImage *)tileImage forRequest:(NSString *)requestedResource;
+- (void)factoryDidLoad:(UIImage *)tileImage forRequest:(RMCacheKey)requestedResource;
 {
 	isLoading = NO;
 	self.image = tileImage;
@@ -265,8 +268,23 @@
 {
 	if (![self initWithTile:_tile])
 	return nil;
-	key = [urlStr retain];
-	image = [RMTileFactory requestImage:key forClient:self];
+	cacheKey = RMCacheKeyForURL(urlStr);
+	image = [RMTileFactory requestImage:urlStr forClient:self];
+	if (image) {
+		[image retain];
+		isLoaded = YES;
+	} else {
+		isLoading = YES;
+	}
+	return self;
+}
+
+- (id)initWithTile: (RMTile)_tile cacheKey:(RMCacheKey)_cacheKey source:(id <RMCacheURLSource>)source
+{
+	if (![self initWithTile:_tile])
+	return nil;
+	cacheKey = _cacheKey;
+	image = [RMTileFactory requestImageForTile:_tile cacheKey:cacheKey source:source forClient:self];
 	if (image) {
 		[image retain];
 		isLoaded = YES;
@@ -276,7 +294,7 @@
 	return self;
 }
 
-- (void)factoryDidFail:(NSString *)request;
+- (void)factoryDidFail:(RMCacheKey)request;
 {
 	isLoading = NO;
 }
@@ -30,6 +30,7 @@
 #import "RMLatLong.h"
 #import "RMFoundation.h"
 #import "RMFractalTileProjection.h"
+#import "RMCacheEntry.h"
 
 #pragma mark --- begin constants ---
 #define kDefaultTileSize 256
@@ -42,11 +43,13 @@
 @protocol RMMercatorToTileProjection;
 @class RMProjection;
 
-@interface RMTileSource : NSObject
+@interface RMTileSource : NSObject <RMCacheURLSource>
 {
 	RMProjection		*projection;
 	RMFractalTileProjection *tileProjection;
 	BOOL networkOperations;
+	// see cacheSourceID, 0 until it is first asked for
+	uint32_t cacheSourceID;
 }
 
 +(UIImage*) errorTile;
@@ -73,6 +76,11 @@
 
 - (NSString *)uniqueTilecacheKey;
 
+/// The id RMCacheSourceIDForName() gives uniqueTilecacheKey, which goes into
+/// the cache key of every tile, or kRMCacheNoSource if the source has no
+/// uniqueTilecacheKey and its tiles are cached by URL.
+- (uint32_t)cacheSourceID;
+
 - (NSString *)shortName;
 - (NSString *)longDescription;
 - (NSString *)shortAttribution;
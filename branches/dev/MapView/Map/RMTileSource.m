@@ -27,6 +27,7 @@
 
 #import "RMTileSource.h"
 #import "RMNotifications.h"
+#import "RMTileImage.h"
 
 
 @implementation RMTileSource
@@ -148,7 +149,13 @@ static UIImage *_missingTile = nil;
 	
 	if(networkOperations) 
 	{
-		image = [RMTileImage imageForTile:tile withURL:[self tileURL:tile]];     
+		RMCacheKey cacheKey = RMCacheKeyForTile([self cacheSourceID], tile);
+		// the tile URL is left to the caches, which only need it for a
+		// tile they do not have
+		if (cacheKey)
+			image = [RMTileImage imageForTile:tile cacheKey:cacheKey source:self];
+		else
+			image = [RMTileImage imageForTile:tile withURL:[self tileURL:tile]];     
 	}
 	else
 	{
@@ -178,6 +185,22 @@ static UIImage *_missingTile = nil;
 	@throw [NSException exceptionWithName:@"RMAbstractMethodInvocation" reason:@"uniqueTilecacheKey invoked on AbstractMercatorWebSource. Override this method when instantiating abstract class." userInfo:nil];
 }
 
+-(uint32_t)cacheSourceID
+{
+	if (!cacheSourceID)
+	{
+		NSString *name = nil;
+		@try {
+			name = [self uniqueTilecacheKey];
+		}
+		@catch (NSException *exception) {
+			// an abstract uniqueTilecacheKey, keep to URLs
+		}
+		cacheSourceID = RMCacheSourceIDForName(name);
+	}
+	return cacheSourceID;
+}
+
 -(NSString *)shortName
 {
 	@throw [NSException exceptionWithName:@"RMAbstractMethodInvocation" reason:@"shortName invoked on AbstractMercatorWebSource. Override this method when instantiating abstract class." userInfo:nil];
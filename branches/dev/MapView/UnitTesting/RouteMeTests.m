@@ -305,6 +305,32 @@
 					 @"X pixel coordinates should be increasing left to right");
 }
 
+- (void)testBatchScreenCoordinatesMatchSingle
+{
+	[[mapView contents] setZoom: 10];
+	CLLocationCoordinate2D center = {45.5,179.9};
+	[mapView moveToLatLong:center];
+	
+	// straddles the date line, so both sides of the wrap divider are covered
+	CLLocationCoordinate2D coords[8];
+	CGPoint points[8];
+	for (int i = 0; i < 8; i++) {
+		coords[i].latitude = 45.5 + .01 * i;
+		coords[i].longitude = 179.8 + .05 * i;
+		if (coords[i].longitude > 180.0)
+			coords[i].longitude -= 360.0;
+	}
+	[mapView convertCoordinates:coords toPoints:points count:8];
+	
+	for (int i = 0; i < 8; i++) {
+		CGPoint single = [mapView convertCoordinateToPoint:coords[i]];
+		STAssertEqualsWithAccuracy(single.x, points[i].x, kAccuracyThresholdForPixelCoordinates,
+								   @"batch X pixel value differs from single conversion");
+		STAssertEqualsWithAccuracy(single.y, points[i].y, kAccuracyThresholdForPixelCoordinates,
+								   @"batch Y pixel value differs from single conversion");
+	}
+}
+
 - (void)testZoomBounds
 {
 	double contentsMaxZoom, tilesourceMaxZoom, contentsZoom;
@@ -12,6 +12,7 @@ PROJ_HEAD(imw_p, "International Map of the World Polyconic")
 	"\n\tMod. Polyconic, Ell\n\tlat_1= and lat_2= [lon_1=]";
 #define TOL 1e-10
 #define EPS 1e-10
+#define N_ITER 50
 	static int
 phi12(PJ *P, double *del, double *sig) {
 	int err = 0;
@@ -83,14 +84,17 @@ FORWARD(e_forward); /* ellipsoid */
 INVERSE(e_inverse); /* ellipsoid */
 	XY t;
 	double yc;
+	int i, converged = 0;
 
 	lp.phi = P->phi_2;
 	lp.lam = xy.x / cos(lp.phi);
-	do {
+	for (i = N_ITER; i && !converged; --i) {
 		t = loc_for(lp, P, &yc);
 		lp.phi = ((lp.phi - P->phi_1) * (xy.y - yc) / (t.y - yc)) + P->phi_1;
 		lp.lam = lp.lam * xy.x / t.x;
-	} while (fabs(t.x - xy.x) > TOL || fabs(t.y - xy.y) > TOL);
+		converged = fabs(t.x - xy.x) <= TOL && fabs(t.y - xy.y) <= TOL;
+	}
+	if (! converged) I_ERROR;
 	return (lp);
 }
 	static void
@@ -3,8 +3,11 @@ static const char SCCSID[]="@(#)PJ_merc.c	4.1	94/02/15	GIE	REL";
 #endif
 #define PJ_LIB__
 #include	"projects.h"
+#include	"pj_simd.h"
 PROJ_HEAD(merc, "Mercator") "\n\tCyl, Sph&Ell\n\tlat_ts=";
 #define EPS10 1.e-10
+#define TOL 1.0e-10
+#define N_ITER 15
 FORWARD(e_forward); /* ellipsoid */
 	if (fabs(fabs(lp.phi) - HALFPI) <= EPS10) F_ERROR;
 	xy.x = P->k0 * lp.lam;
@@ -27,6 +30,104 @@ INVERSE(s_inverse); /* spheroid */
 	lp.lam = xy.x / P->k0;
 	return (lp);
 }
+#ifdef PJ_HAVE_SIMD
+/* array kernels for pj_fwd_batch()/pj_inv_batch(), the scalar code
+** above handles the tail */
+	static void /* F_ERROR for the lanes at a pole */
+pole_check(pj_vd phi, int *st) {
+	int i, mask;
+
+	mask = pj_vmask(pj_vle(pj_vabs(pj_vsub(pj_vabs(phi), pj_vset1(HALFPI))),
+		pj_vset1(EPS10)));
+	if (mask)
+		for (i = 0; i < PJ_VLEN; ++i)
+			if (mask & (1 << i) && !st[i])
+				st[i] = -20;
+}
+	static long
+e_forward_batch(long n, double *x, double *y, int *st, PJ *P) {
+	pj_vd k0 = pj_vset1(P->k0), e = pj_vset1(P->e), one = pj_vset1(1.);
+	pj_vd phi, s, c, es;
+	long i;
+
+	for (i = 0; i + PJ_VLEN <= n; i += PJ_VLEN) {
+		phi = pj_vload(y + i);
+		pole_check(phi, st + i);
+		pj_vsincos(phi, &s, &c);
+		/* -log(tsfn) == log((1+s)/c) - e/2 log((1+es)/(1-es)) */
+		es = pj_vmul(e, s);
+		phi = pj_vsub(pj_vlog(pj_vdiv(pj_vadd(one, s), c)),
+			pj_vmul(pj_vmul(pj_vset1(.5), e), pj_vlog(pj_vdiv(
+			pj_vadd(one, es), pj_vsub(one, es)))));
+		pj_vstore(y + i, pj_vmul(k0, phi));
+		pj_vstore(x + i, pj_vmul(k0, pj_vload(x + i)));
+	}
+	return i;
+}
+	static long
+s_forward_batch(long n, double *x, double *y, int *st, PJ *P) {
+	pj_vd k0 = pj_vset1(P->k0), phi, s, c;
+	long i;
+
+	for (i = 0; i + PJ_VLEN <= n; i += PJ_VLEN) {
+		phi = pj_vload(y + i);
+		pole_check(phi, st + i);
+		/* log(tan(FORTPI + .5 phi)) == log((1+s)/c) */
+		pj_vsincos(phi, &s, &c);
+		pj_vstore(y + i, pj_vmul(k0, pj_vlog(pj_vdiv(
+			pj_vadd(pj_vset1(1.), s), c))));
+		pj_vstore(x + i, pj_vmul(k0, pj_vload(x + i)));
+	}
+	return i;
+}
+	static long
+e_inverse_batch(long n, double *x, double *y, int *st, PJ *P) {
+	pj_vd k0 = pj_vset1(P->k0), e = pj_vset1(P->e);
+	pj_vd eccnth = pj_vset1(.5 * P->e), one = pj_vset1(1.);
+	pj_vd two = pj_vset1(2.), halfpi = pj_vset1(HALFPI), tol = pj_vset1(TOL);
+	pj_vd ts, Phi, con, dphi, active;
+	long i;
+	int j, k;
+
+	for (i = 0; i + PJ_VLEN <= n; i += PJ_VLEN) {
+		/* pj_phi2() with all lanes iterating in lockstep */
+		ts = pj_vexp(pj_vdiv(pj_vsub(pj_vset1(0.), pj_vload(y + i)), k0));
+		Phi = pj_vsub(halfpi, pj_vmul(two, pj_vatan(ts)));
+		active = PJ_VTRUE;
+		for (j = N_ITER; j && pj_vmask(active); --j) {
+			pj_vsincos(Phi, &con, 0);
+			con = pj_vmul(e, con);
+			dphi = pj_vmul(eccnth, pj_vlog(pj_vdiv(pj_vsub(one, con),
+				pj_vadd(one, con))));
+			dphi = pj_vsub(pj_vsub(halfpi, pj_vmul(two,
+				pj_vatan(pj_vmul(ts, pj_vexp(dphi))))), Phi);
+			Phi = pj_vadd(Phi, pj_vand(active, dphi));
+			active = pj_vand(active, pj_vgt(pj_vabs(dphi), tol));
+		}
+		if ((k = pj_vmask(active)) != 0)
+			for (j = 0; j < PJ_VLEN; ++j)
+				if (k & (1 << j) && !st[i + j])
+					st[i + j] = -18;
+		pj_vstore(y + i, Phi);
+		pj_vstore(x + i, pj_vdiv(pj_vload(x + i), k0));
+	}
+	return i;
+}
+	static long
+s_inverse_batch(long n, double *x, double *y, int *st, PJ *P) {
+	pj_vd k0 = pj_vset1(P->k0), t;
+	long i;
+
+	(void) st; /* the spherical inverse cannot fail */
+	for (i = 0; i + PJ_VLEN <= n; i += PJ_VLEN) {
+		t = pj_vexp(pj_vdiv(pj_vsub(pj_vset1(0.), pj_vload(y + i)), k0));
+		pj_vstore(y + i, pj_vsub(pj_vset1(HALFPI),
+			pj_vmul(pj_vset1(2.), pj_vatan(t))));
+		pj_vstore(x + i, pj_vdiv(pj_vload(x + i), k0));
+	}
+	return i;
+}
+#endif /* PJ_HAVE_SIMD */
 FREEUP; if (P) pj_dalloc(P); }
 ENTRY0(merc)
 	double phits=0.0;
@@ -41,10 +142,18 @@ ENTRY0(merc)
 			P->k0 = pj_msfn(sin(phits), cos(phits), P->es);
 		P->inv = e_inverse;
 		P->fwd = e_forward;
+#ifdef PJ_HAVE_SIMD
+		P->inv_batch = e_inverse_batch;
+		P->fwd_batch = e_forward_batch;
+#endif
 	} else { /* sphere */
 		if (is_phits)
 			P->k0 = cos(phits);
 		P->inv = s_inverse;
 		P->fwd = s_forward;
+#ifdef PJ_HAVE_SIMD
+		P->inv_batch = s_inverse_batch;
+		P->fwd_batch = s_forward_batch;
+#endif
 	}
 ENDENTRY(P)
@@ -3,18 +3,21 @@
 static const char SCCSID[]="@(#)bchgen.c	4.5	94/03/22	GIE	REL";
 #endif
 #include "projects.h"
+	double /* i-th of n Chebyshev nodes over a..b */
+bch_node(double a, double b, int i, int n) {
+	return cos(PI * (i + 0.5) / n) * (0.5 * (b - a)) + 0.5 * (b + a);
+}
 	int
 bchgen(projUV a, projUV b, int nu, int nv, projUV **f, projUV(*func)(projUV)) {
 	int i, j, k;
-	projUV arg, *t, bma, bpa, *c;
+	projUV arg, *t, *c;
 	double d, fac;
 
-	bma.u = 0.5 * (b.u - a.u); bma.v = 0.5 * (b.v - a.v);
-	bpa.u = 0.5 * (b.u + a.u); bpa.v = 0.5 * (b.v + a.v);
-	for ( i = 0; i < nu; ++i) {
-		arg.u = cos(PI * (i + 0.5) / nu) * bma.u + bpa.u;
+	/* func == 0: f already holds the function at the nodes */
+	for ( i = 0; func && i < nu; ++i) {
+		arg.u = bch_node(a.u, b.u, i, nu);
 		for ( j = 0; j < nv; ++j) {
-			arg.v = cos(PI * (j + 0.5) / nv) * bma.v + bpa.v;
+			arg.v = bch_node(a.v, b.v, j, nv);
 			f[i][j] = (*func)(arg);
 			if ((f[i][j]).u == HUGE_VAL)
 				return(1);
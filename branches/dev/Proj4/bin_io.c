@@ -0,0 +1,134 @@
+/* binary record input and output for proj and cs2cs */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "emess.h"
+#include "bin_io.h"
+#if !defined(_WIN32) && !defined(PJ_NO_MMAP)
+#  define BIN_HAVE_MMAP
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#endif
+
+#define WRITE_CHUNK 1024	/* records encoded per fwrite() */
+
+	static int
+host_little_endian(void) {
+	static const int one = 1;
+
+	return *(const char *)&one;
+}
+	static void	/* records at p into the x/y/z arrays */
+decode(const unsigned char *p, int dims, double *x, double *y, double *z,
+	long n) {
+	double *dst[3];
+	unsigned char b[8];
+	long i;
+	int d, k;
+
+	dst[0] = x; dst[1] = y; dst[2] = z;
+	if (host_little_endian()) {
+		for (i = 0; i < n; ++i)
+			for (d = 0; d < dims; ++d, p += 8)
+				memcpy(dst[d] + i, p, 8);
+	} else
+		for (i = 0; i < n; ++i)
+			for (d = 0; d < dims; ++d, p += 8) {
+				for (k = 0; k < 8; ++k)
+					b[k] = p[7 - k];
+				memcpy(dst[d] + i, b, 8);
+			}
+}
+	void	/* start reading records from fid, mapping it if we can */
+bin_open(BIN_INPUT *in, FILE *fid, int dims) {
+	memset(in, 0, sizeof(*in));
+	in->fid = fid;
+	in->dims = dims;
+#ifdef BIN_HAVE_MMAP
+	{
+		struct stat st;
+		long start = ftell(fid);
+		void *map;
+
+		if (start >= 0 && fstat(fileno(fid), &st) == 0
+		    && S_ISREG(st.st_mode) && st.st_size > start
+		    && (off_t)(size_t)st.st_size == st.st_size
+		    && (map = mmap(NULL, (size_t)st.st_size, PROT_READ,
+				MAP_PRIVATE, fileno(fid), 0)) != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+			(void)madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+			in->map = (const unsigned char *)map;
+			in->map_size = (size_t)st.st_size;
+			in->map_pos = (size_t)start;
+			return;
+		}
+	}
+#endif
+	if (!(in->buf = (unsigned char *)malloc(BIN_CHUNK * 8 * dims)))
+		emess(2, "binary input buffer allocation failure");
+}
+	long	/* up to max records into x/y/z, 0 at end of input */
+bin_read(BIN_INPUT *in, double *x, double *y, double *z, long max) {
+	size_t rec = 8 * in->dims, got;
+	long n;
+
+	if (max > BIN_CHUNK)
+		max = BIN_CHUNK;
+	if (in->map) {
+		n = (long)((in->map_size - in->map_pos) / rec);
+		if (n > max)
+			n = max;
+		decode(in->map + in->map_pos, in->dims, x, y, z, n);
+		in->map_pos += n * rec;
+		got = n ? 0 : in->map_size - in->map_pos;
+	} else {
+		got = fread(in->buf, 1, max * rec, in->fid);
+		n = (long)(got / rec);
+		decode(in->buf, in->dims, x, y, z, n);
+		got -= n * rec;
+	}
+	emess_dat.File_line += n;
+	if (got) {	/* only ever at the very end */
+		/* File_line counts records here, which emess would call a line */
+		int records = emess_dat.File_line;
+		emess_dat.File_line = 0;
+		emess(-1, "ignoring %d trailing bytes after record %d, not a whole record",
+			(int)got, records);
+		emess_dat.File_line = records;
+	}
+	return n;
+}
+	void	/* count records from the x/y/z arrays to fid */
+bin_write(FILE *fid, int dims, const double *x, const double *y,
+	const double *z, long count) {
+	unsigned char buf[WRITE_CHUNK * 3 * 8], *p;
+	const double *src[3];
+	long i, j, m;
+	int d, k, le = host_little_endian();
+
+	src[0] = x; src[1] = y; src[2] = z;
+	for (j = 0; j < count; j += m) {
+		m = count - j < WRITE_CHUNK ? count - j : WRITE_CHUNK;
+		for (p = buf, i = j; i < j + m; ++i)
+			for (d = 0; d < dims; ++d, p += 8)
+				if (le)
+					memcpy(p, src[d] + i, 8);
+				else
+					for (k = 0; k < 8; ++k)
+						p[k] = ((const unsigned char *)
+							(src[d] + i))[7 - k];
+		if (fwrite(buf, 8 * dims, m, fid) != (size_t)m)
+			emess(2, "binary output failure");
+	}
+}
+	void
+bin_close(BIN_INPUT *in) {
+#ifdef BIN_HAVE_MMAP
+	if (in->map)
+		(void)munmap((void *)in->map, in->map_size);
+#endif
+	free(in->buf);
+	memset(in, 0, sizeof(*in));
+}
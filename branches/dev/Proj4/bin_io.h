@@ -0,0 +1,38 @@
+/* Binary record streams for the proj and cs2cs programs */
+#ifndef BIN_IO_H
+#define BIN_IO_H
+
+#include <stdio.h>
+
+/* TK 1999-02-13 */
+#if defined(MSDOS) || defined(OS2) || defined(WIN32) || defined(__WIN32__)
+#  include <fcntl.h>
+#  include <io.h>
+#  define SET_BINARY_MODE(file) setmode(fileno(file), O_BINARY)
+#else
+#  define SET_BINARY_MODE(file)
+#endif
+/* ! TK 1999-02-13 */
+
+/*
+ * A record is dims (2 or 3) IEEE doubles, little-endian whatever the
+ * host: x, y and, with three, z.  Angles are in radians.  Failed points
+ * are written as HUGE_VAL.
+ */
+#define BIN_CHUNK 16384		/* records transformed per batch */
+
+typedef struct {
+	FILE		*fid;
+	int		dims;		/* doubles per record */
+	const unsigned char *map;	/* whole file when mapped, else NULL */
+	size_t		map_size, map_pos;
+	unsigned char	*buf;		/* read buffer when not mapped */
+} BIN_INPUT;
+
+void bin_open(BIN_INPUT *, FILE *, int dims);
+long bin_read(BIN_INPUT *, double *x, double *y, double *z, long max);
+void bin_write(FILE *, int dims, const double *x, const double *y,
+	const double *z, long count);
+void bin_close(BIN_INPUT *);
+
+#endif /* end BIN_IO_H */
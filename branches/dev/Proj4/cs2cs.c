@@ -67,6 +67,8 @@
 #include <string.h>
 #include <math.h>
 #include "emess.h"
+#include "bin_io.h"
+#include "par_io.h"
 
 #define MAX_LINE 1000
 #define MAX_PARGS 100
@@ -76,13 +78,16 @@ static projPJ   fromProj, toProj;
 static int
 reversein = 0,	/* != 0 reverse input arguments */
 reverseout = 0,	/* != 0 reverse output arguments */
+bin_in = 0,	/* != 0 then binary input */
+bin_out = 0,	/* != 0 then binary output */
 echoin = 0,	/* echo input data to output line */
+threads = 1,	/* -j threads for text input */
 tag = '#';	/* beginning of line tag character */
 	static char
 *oform = (char *)0,	/* output format for x-y or decimal degrees */
 *oterr = "*\t*",	/* output line for unprojectable input */
 *usage =
-"%s\nusage: %s [ -eEfIlrstvwW [args] ] [ +opts[=arg] ]\n"
+"%s\nusage: %s [ -beEfiIjlorstvwW [args] ] [ +opts[=arg] ]\n"
 "                   [+to [+opts[=arg] [ files ]\n";
 
 static struct FACTORS facs;
@@ -90,6 +95,113 @@ static double (*informat)(const char *,
                           char **); /* input data deformatter function */
 
 
+/************************************************************************/
+/*                             put_point()                              */
+/*                                                                      */
+/*      Write one transformed point as text, without the newline.       */
+/************************************************************************/
+static void put_point(OUT_TEXT *out, projUV data, double z)
+
+{
+    char pline[40];
+
+    if (data.u == HUGE_VAL) /* error output */
+        out_puts(out, oterr);
+
+    else if (pj_is_latlong(toProj) && !oform) {	/*ascii DMS output */
+        if (reverseout) {
+            out_puts(out, rtodms(pline, data.v, 'N', 'S'));
+            out_putc(out, '\t');
+            out_puts(out, rtodms(pline, data.u, 'E', 'W'));
+        } else {
+            out_puts(out, rtodms(pline, data.u, 'E', 'W'));
+            out_putc(out, '\t');
+            out_puts(out, rtodms(pline, data.v, 'N', 'S'));
+        }
+
+    } else {	/* x-y or decimal degree ascii output */
+        if ( pj_is_latlong(toProj) ) {
+            data.v *= RAD_TO_DEG;
+            data.u *= RAD_TO_DEG;
+        }
+        if (reverseout) {
+            out_printf(out, oform,data.v); out_putc(out, '\t');
+            out_printf(out, oform,data.u);
+        } else {
+            out_printf(out, oform,data.u); out_putc(out, '\t');
+            out_printf(out, oform,data.v);
+        }
+    }
+
+    out_putc(out, ' ');
+    if( oform != NULL )
+        out_printf(out, oform, z );
+    else
+        out_printf(out, "%.3f", z );
+}
+
+/************************************************************************/
+/*                           process_line()                             */
+/*                                                                      */
+/*      Transform the point on one input line, which ends in a          */
+/*      newline, and write the result to out.  Safe to run on          */
+/*      several threads at once, each under its own context.            */
+/************************************************************************/
+static void process_line(char *line, OUT_TEXT *out)
+
+{
+    char *s = line;
+    projUV data;
+    double z;
+
+    if (*s == tag) {
+        if (!bin_out)
+            out_puts(out, line);
+        return;
+    }
+
+    if (reversein) {
+        data.v = (*informat)(s, &s);
+        data.u = (*informat)(s, &s);
+    } else {
+        data.u = (*informat)(s, &s);
+        data.v = (*informat)(s, &s);
+    }
+
+    z = strtod( s, &s );
+
+    if (data.v == HUGE_VAL)
+        data.u = HUGE_VAL;
+
+    if (!*s && (s > line)) --s; /* assumed we gobbled \n */
+
+    if (!bin_out && echoin) {
+        int t;
+        t = *s;
+        *s = '\0';
+        out_puts(out, line);
+        *s = t;
+        out_putc(out, '\t');
+    }
+
+    if (data.u != HUGE_VAL) {
+        if( pj_transform( fromProj, toProj, 1, 0, 
+                          &(data.u), &(data.v), &z ) != 0 )
+        {
+            data.u = HUGE_VAL;
+            data.v = HUGE_VAL;
+        }
+    }
+
+    if (bin_out) {
+        bin_write(stdout, 3, &(data.u), &(data.v), &z, 1);
+        return;
+    }
+
+    put_point(out, data, z);
+    out_puts(out, "\n");
+}
+
 /************************************************************************/
 /*                              process()                               */
 /*                                                                      */
@@ -98,12 +210,18 @@ static double (*informat)(const char *,
 static void process(FILE *fid) 
 
 {
-    char line[MAX_LINE+3], *s, pline[40];
-    projUV data;
+    char line[MAX_LINE+3], *s;
+    OUT_TEXT out;
 
-    for (;;) {
-        double z;
+    /* -j: lines in blocks, transformed and formatted on several threads */
+    if (threads > 1 && !bin_out) {
+        par_process(fid, threads, MAX_LINE, process_line);
+        return;
+    }
 
+    memset(&out, 0, sizeof(out));
+    out.fid = stdout;
+    for (;;) {
         ++emess_dat.File_line;
         if (!(s = fgets(line, MAX_LINE, fid)))
             break;
@@ -113,79 +231,63 @@ static void process(FILE *fid)
 				/* gobble up to newline */
             while ((c = fgetc(fid)) != EOF && c != '\n') ;
         }
-        if (*s == tag) {
-            fputs(line, stdout);
-            continue;
-        }
-
-        if (reversein) {
-            data.v = (*informat)(s, &s);
-            data.u = (*informat)(s, &s);
-        } else {
-            data.u = (*informat)(s, &s);
-            data.v = (*informat)(s, &s);
-        }
-
-        z = strtod( s, &s );
-
-        if (data.v == HUGE_VAL)
-            data.u = HUGE_VAL;
-
-        if (!*s && (s > line)) --s; /* assumed we gobbled \n */
+        process_line(line, &out);
+    }
+}
 
-        if ( echoin) {
-            int t;
-            t = *s;
-            *s = '\0';
-            (void)fputs(line, stdout);
-            *s = t;
-            putchar('\t');
-        }
+/************************************************************************/
+/*                          process_binary()                            */
+/*                                                                      */
+/*      File processing for binary input: records are read (or          */
+/*      mapped) and transformed BIN_CHUNK at a time.  A chunk that      */
+/*      pj_transform() gives up on is redone a point at a time, so a    */
+/*      bad point only fails itself, as in process().                   */
+/************************************************************************/
+static void process_binary(FILE *fid)
 
-        if (data.u != HUGE_VAL) {
-            if( pj_transform( fromProj, toProj, 1, 0, 
-                              &(data.u), &(data.v), &z ) != 0 )
-            {
-                data.u = HUGE_VAL;
-                data.v = HUGE_VAL;
+{
+    static double x[BIN_CHUNK], y[BIN_CHUNK], z[BIN_CHUNK];
+    static double sx[BIN_CHUNK], sy[BIN_CHUNK], sz[BIN_CHUNK];
+    BIN_INPUT in;
+    OUT_TEXT out;
+    projUV data;
+    long n, i;
+
+    memset(&out, 0, sizeof(out));
+    out.fid = stdout;
+    bin_open(&in, fid, 3);
+    while ((n = bin_read(&in, x, y, z, BIN_CHUNK)) > 0) {
+        for (i = 0; i < n; i++)
+            if (y[i] == HUGE_VAL)
+                x[i] = HUGE_VAL;
+        memcpy(sx, x, n * sizeof(double));
+        memcpy(sy, y, n * sizeof(double));
+        memcpy(sz, z, n * sizeof(double));
+
+        if (pj_transform(fromProj, toProj, n, 1, x, y, z) != 0) {
+            for (i = 0; i < n; i++) {
+                x[i] = sx[i];
+                y[i] = sy[i];
+                z[i] = sz[i];
+                if (x[i] != HUGE_VAL
+                    && pj_transform(fromProj, toProj, 1, 0,
+                                    x + i, y + i, z + i) != 0)
+                    x[i] = y[i] = HUGE_VAL;
             }
         }
 
-        if (data.u == HUGE_VAL) /* error output */
-            fputs(oterr, stdout);
-
-        else if (pj_is_latlong(toProj) && !oform) {	/*ascii DMS output */
-            if (reverseout) {
-                fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
-                putchar('\t');
-                fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
-            } else {
-                fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
-                putchar('\t');
-                fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
-            }
-
-        } else {	/* x-y or decimal degree ascii output */
-            if ( pj_is_latlong(toProj) ) {
-                data.v *= RAD_TO_DEG;
-                data.u *= RAD_TO_DEG;
-            }
-            if (reverseout) {
-                printf(oform,data.v); putchar('\t');
-                printf(oform,data.u);
-            } else {
-                printf(oform,data.u); putchar('\t');
-                printf(oform,data.v);
-            }
+        if (bin_out) {
+            bin_write(stdout, 3, x, y, z, n);
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            data.u = x[i];
+            data.v = y[i];
+            put_point(&out, data, z[i]);
+            out_puts(&out, "\n");
         }
-
-        putchar(' ');
-        if( oform != NULL )
-            printf( oform, z );
-        else
-            printf( "%.3f", z );
-        fputs("\n", stdout );
     }
+    bin_close(&in);
 }
 
 /************************************************************************/
@@ -215,9 +317,18 @@ int main(int argc, char **argv)
               case '\0': /* position of "stdin" */
                 if (arg[-1] == '-') eargv[eargc++] = "-";
                 break;
+              case 'b': /* binary I/O */
+                bin_in = bin_out = 1;
+                continue;
               case 'v': /* monitor dump of initialization */
                 mon = 1;
                 continue;
+              case 'i': /* input binary */
+                bin_in = 1;
+                continue;
+              case 'o': /* output binary */
+                bin_out = 1;
+                continue;
               case 'I': /* alt. method to spec inverse */
                 inverse = 1;
                 continue;
@@ -306,6 +417,11 @@ int main(int argc, char **argv)
                 if (--argc <= 0) goto noargument;
                 oform = *++argv;
                 continue;
+              case 'j': /* threads for text input */
+                if (--argc <= 0) goto noargument;
+                if ((threads = atoi(*++argv)) < 1 || threads > PAR_MAX_THREADS)
+                    emess(1,"-j needs 1 to %d threads", PAR_MAX_THREADS);
+                continue;
               case 'r': /* reverse input */
                 reversein = 1;
                 continue;
@@ -416,21 +532,34 @@ int main(int argc, char **argv)
     if( !toProj->is_latlong && !oform )
         oform = "%.2f";
 
+    if (bin_out)
+    {
+        SET_BINARY_MODE(stdout);
+    }
+
     /* process input file list */
     for ( ; eargc-- ; ++eargv) {
         if (**eargv == '-') {
             fid = stdin;
             emess_dat.File_name = "<stdin>";
 
+            if (bin_in)
+            {
+                SET_BINARY_MODE(stdin);
+            }
+
         } else {
-            if ((fid = fopen(*eargv, "rt")) == NULL) {
+            if ((fid = fopen(*eargv, bin_in ? "rb" : "rt")) == NULL) {
                 emess(-2, *eargv, "input file");
                 continue;
             }
             emess_dat.File_name = *eargv;
         }
         emess_dat.File_line = 0;
-        process(fid);
+        if (bin_in)
+            process_binary(fid);
+        else
+            process(fid);
         fclose(fid);
         emess_dat.File_name = 0;
     }
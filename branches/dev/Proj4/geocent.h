@@ -172,6 +172,33 @@ void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
  */
 
 
+int pj_geodetic_to_geocentric_batch( GeocentricInfo *gi,
+                                     long point_count, int point_offset,
+                                     double *x, double *y, double *z );
+void pj_geocentric_to_geodetic_batch( GeocentricInfo *gi,
+                                      long point_count, int point_offset,
+                                      double *x, double *y, double *z );
+/*
+ * The conversions above on point_count points of the x, y and z arrays,
+ * point_offset apart, in place (longitude in x, latitude in y), several
+ * points at a time; see geocent_batch.c.  HUGE_VAL points are left alone.
+ * pj_geodetic_to_geocentric_batch() returns 1 if any latitude was out of
+ * range, those points becoming HUGE_VAL.
+ */
+
+
+int pj_geodetic_datum_shift_batch( GeocentricInfo *src, const double *m,
+                                   GeocentricInfo *dst,
+                                   long point_count, int point_offset,
+                                   double *x, double *y, double *z );
+/*
+ * Geodetic on src to geocentric, then the 3x4 row major affine matrix m
+ * (rotation and scale in the first three columns, translation in the
+ * last), then back to geodetic on dst, in one pass.  Returns 1 as
+ * pj_geodetic_to_geocentric_batch() does.
+ */
+
+
 #ifdef __cplusplus
 }
 #endif
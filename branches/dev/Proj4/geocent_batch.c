@@ -0,0 +1,478 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Geodetic <-> geocentric conversion of point arrays, four
+ *           points at a time.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * These do what pj_geodetic_to_geocentric() and pj_geocentric_to_geodetic()
+ * always did point by point through geocent.c, with the same formulas:
+ * the inverse runs the same Hannover iteration, all lanes in lockstep
+ * until the last one has converged.  The differences are the sine,
+ * cosine and arc tangent, which are pj_simd.h's polynomial
+ * approximations good to an ulp or two, so the results agree with the
+ * scalar code to about 1e-8 m and 1e-15 radians; projbench "geocent"
+ * measures both.
+ *
+ * pj_geodetic_datum_shift_batch() chains the two with the datum shift
+ * matrix pj_datum_transform() composes, keeping each group of PJ_VLEN
+ * points in registers from geodetic in to geodetic out.
+ *
+ * Lanes the scalar code treats specially (failed HUGE_VAL points,
+ * latitudes out of range, points on the polar axis) send their group
+ * through geocent.c, as does the tail of the array, and so does all of
+ * it where pj_simd.h has no vector type.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include "geocent.h"
+#include "pj_simd.h"
+#include <math.h>
+
+#define GENAU   1.E-12          /* as in geocent.c */
+#define MAXITER 30
+#define LON_LIMIT 64.0          /* larger longitudes go through libm */
+
+#ifdef PJ_HAVE_SIMD
+
+#define LANES PJ_VLEN
+
+/************************************************************************/
+/*                           to_geocentric()                            */
+/*                                                                      */
+/*      pj_Convert_Geodetic_To_Geocentric() on LANES points, all of     */
+/*      them with valid latitudes: lon/lat/h in x/y/z become X/Y/Z.     */
+/************************************************************************/
+
+static inline void to_geocentric( const GeocentricInfo *gi,
+                                  pj_vd *x, pj_vd *y, pj_vd *z )
+
+{
+    pj_vd lon = *x, sin_lat, cos_lat, sin_lon, cos_lon, rn, r;
+
+    lon = pj_vsub( lon, pj_vand( pj_vgt( lon, pj_vset1( PI ) ),
+                                 pj_vset1( 2 * PI ) ) );
+    pj_vsincos( *y, &sin_lat, &cos_lat );
+    pj_vsincos( lon, &sin_lon, &cos_lon );
+
+    rn = pj_vdiv( pj_vset1( gi->Geocent_a ),
+                  pj_vsqrt( pj_vsub( pj_vset1( 1.0 ),
+                                     pj_vmul( pj_vset1( gi->Geocent_e2 ),
+                                              pj_vmul( sin_lat, sin_lat ) ) ) ) );
+    r = pj_vadd( rn, *z );
+    *x = pj_vmul( pj_vmul( r, cos_lat ), cos_lon );
+    *y = pj_vmul( pj_vmul( r, cos_lat ), sin_lon );
+    *z = pj_vmul( pj_vadd( pj_vmul( rn, pj_vset1( 1 - gi->Geocent_e2 ) ), *z ),
+                  sin_lat );
+}
+
+/************************************************************************/
+/*                            to_geodetic()                             */
+/*                                                                      */
+/*      pj_Convert_Geocentric_To_Geodetic() on LANES points off the     */
+/*      polar axis: X/Y/Z in x/y/z become lon/lat/h.                    */
+/************************************************************************/
+
+static inline void to_geodetic( const GeocentricInfo *gi,
+                                pj_vd *x, pj_vd *y, pj_vd *z )
+
+{
+    pj_vd e2 = pj_vset1( gi->Geocent_e2 ), a = pj_vset1( gi->Geocent_a );
+    pj_vd one = pj_vset1( 1.0 ), two = pj_vset1( 2.0 );
+    pj_vd p, rr, ct, st, rx, cphi0, sphi0, cphi, sphi, rn, h, rk, sdphi;
+    pj_vd lon, more, s2;
+    int   iter = 0;
+
+    p = pj_vsqrt( pj_vadd( pj_vmul( *x, *x ), pj_vmul( *y, *y ) ) );
+    rr = pj_vsqrt( pj_vadd( pj_vadd( pj_vmul( *x, *x ), pj_vmul( *y, *y ) ),
+                            pj_vmul( *z, *z ) ) );
+
+    /* atan2(y, x): add pi with the sign of y where x < 0 */
+    lon = pj_vatan( pj_vdiv( *y, *x ) );
+    lon = pj_vadd( lon, pj_vand( pj_vlt( *x, pj_vset1( 0.0 ) ),
+                                 pj_vor( pj_vset1( PI ),
+                                         pj_vand( *y, PJ_VSIGN ) ) ) );
+
+    ct = pj_vdiv( *z, rr );
+    st = pj_vdiv( p, rr );
+    rx = pj_vdiv( one, pj_vsqrt( pj_vsub( one, pj_vmul( pj_vmul(
+             pj_vmul( e2, pj_vsub( two, e2 ) ), st ), st ) ) ) );
+    cphi0 = pj_vmul( pj_vmul( st, pj_vsub( one, e2 ) ), rx );
+    sphi0 = pj_vmul( ct, rx );
+
+    do
+    {
+        iter++;
+        s2 = pj_vmul( pj_vmul( e2, sphi0 ), sphi0 );
+        rn = pj_vdiv( a, pj_vsqrt( pj_vsub( one, s2 ) ) );
+        h = pj_vsub( pj_vadd( pj_vmul( p, cphi0 ), pj_vmul( *z, sphi0 ) ),
+                     pj_vmul( rn, pj_vsub( one, s2 ) ) );
+
+        rk = pj_vdiv( pj_vmul( e2, rn ), pj_vadd( rn, h ) );
+        rx = pj_vdiv( one, pj_vsqrt( pj_vsub( one, pj_vmul( pj_vmul(
+                 pj_vmul( rk, pj_vsub( two, rk ) ), st ), st ) ) ) );
+        cphi = pj_vmul( pj_vmul( st, pj_vsub( one, rk ) ), rx );
+        sphi = pj_vmul( ct, rx );
+        sdphi = pj_vsub( pj_vmul( sphi, cphi0 ), pj_vmul( cphi, sphi0 ) );
+        cphi0 = cphi;
+        sphi0 = sphi;
+        more = pj_vgt( pj_vmul( sdphi, sdphi ), pj_vset1( GENAU * GENAU ) );
+    }
+    while( pj_vmask( more ) != 0 && iter < MAXITER );
+
+    *x = lon;
+    *y = pj_vatan( pj_vdiv( sphi, pj_vabs( cphi ) ) );
+    *z = h;
+}
+
+/************************************************************************/
+/*                               affine()                               */
+/*                                                                      */
+/*      A 3x4 row major matrix applied to LANES geocentric points.      */
+/************************************************************************/
+
+static inline void affine( const double *m, pj_vd *x, pj_vd *y, pj_vd *z )
+
+{
+    pj_vd x0 = *x, y0 = *y, z0 = *z;
+
+    *x = pj_vadd( pj_vadd( pj_vadd( pj_vmul( pj_vset1( m[0] ), x0 ),
+                                    pj_vmul( pj_vset1( m[1] ), y0 ) ),
+                           pj_vmul( pj_vset1( m[2] ), z0 ) ),
+                  pj_vset1( m[3] ) );
+    *y = pj_vadd( pj_vadd( pj_vadd( pj_vmul( pj_vset1( m[4] ), x0 ),
+                                    pj_vmul( pj_vset1( m[5] ), y0 ) ),
+                           pj_vmul( pj_vset1( m[6] ), z0 ) ),
+                  pj_vset1( m[7] ) );
+    *z = pj_vadd( pj_vadd( pj_vadd( pj_vmul( pj_vset1( m[8] ), x0 ),
+                                    pj_vmul( pj_vset1( m[9] ), y0 ) ),
+                           pj_vmul( pj_vset1( m[10] ), z0 ) ),
+                  pj_vset1( m[11] ) );
+}
+
+/************************************************************************/
+/*                            store_lanes()                             */
+/*                                                                      */
+/*      vx/vy/vz back to points i .. i + LANES - 1 of the arrays.       */
+/************************************************************************/
+
+static inline void store_lanes( pj_vd vx, pj_vd vy, pj_vd vz, long i,
+                                int point_offset,
+                                double *x, double *y, double *z )
+
+{
+    double bx[LANES], by[LANES], bz[LANES];
+    int    k;
+
+    pj_vstore( bx, vx );
+    pj_vstore( by, vy );
+    pj_vstore( bz, vz );
+    for( k = 0; k < LANES; k++ )
+    {
+        x[(i + k) * point_offset] = bx[k];
+        y[(i + k) * point_offset] = by[k];
+        z[(i + k) * point_offset] = bz[k];
+    }
+}
+
+#endif /* def PJ_HAVE_SIMD */
+
+/************************************************************************/
+/*                  to_geocentric1() / to_geodetic1()                   */
+/*                                                                      */
+/*      One point through geocent.c, as the point loops always did.     */
+/*      to_geocentric1() returns 1 if the latitude was out of range.    */
+/************************************************************************/
+
+static int to_geocentric1( GeocentricInfo *gi, double *x, double *y,
+                           double *z )
+
+{
+    if( *x == HUGE_VAL )
+        return 0;
+
+    if( pj_Convert_Geodetic_To_Geocentric( gi, *y, *x, *z, x, y, z ) != 0 )
+    {
+        *x = *y = HUGE_VAL;
+        return 1;
+    }
+    return 0;
+}
+
+static void to_geodetic1( GeocentricInfo *gi, double *x, double *y,
+                          double *z )
+
+{
+    if( *x == HUGE_VAL )
+        return;
+
+    pj_Convert_Geocentric_To_Geodetic( gi, *x, *y, *z, y, x, z );
+}
+
+/************************************************************************/
+/*                               shift1()                               */
+/*                                                                      */
+/*      One point through geocent.c and the matrix, as                  */
+/*      pj_geodetic_datum_shift_batch() does four at a time.            */
+/************************************************************************/
+
+static int shift1( GeocentricInfo *src, const double *m, GeocentricInfo *dst,
+                   double *x, double *y, double *z )
+
+{
+    double x0, y0, z0;
+    int    failed = to_geocentric1( src, x, y, z );
+
+    if( *x == HUGE_VAL )
+        return failed;
+
+    x0 = *x;
+    y0 = *y;
+    z0 = *z;
+    *x = m[0] * x0 + m[1] * y0 + m[2] * z0 + m[3];
+    *y = m[4] * x0 + m[5] * y0 + m[6] * z0 + m[7];
+    *z = m[8] * x0 + m[9] * y0 + m[10] * z0 + m[11];
+
+    to_geodetic1( dst, x, y, z );
+    return failed;
+}
+
+/************************************************************************/
+/*                  pj_geodetic_to_geocentric_batch()                   */
+/*                                                                      */
+/*      Longitude/latitude (radians) and height in x/y/z to geocentric  */
+/*      X/Y/Z in place.  HUGE_VAL points are skipped; points with a     */
+/*      latitude out of range become HUGE_VAL and make the result 1.    */
+/************************************************************************/
+
+int pj_geodetic_to_geocentric_batch( GeocentricInfo *gi, long point_count,
+                                     int point_offset,
+                                     double *x, double *y, double *z )
+
+{
+    long    i = 0;
+    int     failed = 0;
+
+#ifdef PJ_HAVE_SIMD
+    double  bx[LANES], by[LANES], bz[LANES];
+    pj_vd   vx, vy, vz;
+    long    io;
+    int     k, special;
+
+    for( ; i + LANES <= point_count; i += LANES )
+    {
+        special = 0;
+        for( k = 0; k < LANES; k++ )
+        {
+            io = (i + k) * point_offset;
+            bx[k] = x[io];
+            by[k] = y[io];
+            bz[k] = z[io];
+            special |= bx[k] == HUGE_VAL || !(fabs( by[k] ) <= HALFPI)
+                || !(fabs( bx[k] ) <= LON_LIMIT);
+        }
+
+        if( special )
+        {
+            for( k = 0; k < LANES; k++ )
+            {
+                io = (i + k) * point_offset;
+                failed |= to_geocentric1( gi, x + io, y + io, z + io );
+            }
+            continue;
+        }
+
+        vx = pj_vload( bx );
+        vy = pj_vload( by );
+        vz = pj_vload( bz );
+        to_geocentric( gi, &vx, &vy, &vz );
+        store_lanes( vx, vy, vz, i, point_offset, x, y, z );
+    }
+#endif /* def PJ_HAVE_SIMD */
+
+    for( ; i < point_count; i++ )
+    {
+        long io = i * point_offset;
+
+        failed |= to_geocentric1( gi, x + io, y + io, z + io );
+    }
+
+    return failed;
+}
+
+/************************************************************************/
+/*                  pj_geocentric_to_geodetic_batch()                   */
+/*                                                                      */
+/*      Geocentric X/Y/Z to longitude/latitude (radians) and height     */
+/*      in place.  HUGE_VAL points are skipped.                         */
+/************************************************************************/
+
+void pj_geocentric_to_geodetic_batch( GeocentricInfo *gi, long point_count,
+                                      int point_offset,
+                                      double *x, double *y, double *z )
+
+{
+    long    i = 0;
+
+#ifdef PJ_HAVE_SIMD
+    double  min_p2 = (GENAU * gi->Geocent_a) * (GENAU * gi->Geocent_a);
+    double  bx[LANES], by[LANES], bz[LANES];
+    pj_vd   vx, vy, vz;
+    long    io;
+    int     k, special;
+
+    for( ; i + LANES <= point_count; i += LANES )
+    {
+        special = 0;
+        for( k = 0; k < LANES; k++ )
+        {
+            io = (i + k) * point_offset;
+            bx[k] = x[io];
+            by[k] = y[io];
+            bz[k] = z[io];
+
+            /* geocent.c has its own answers near the axis (and NaN
+               fails the compare) */
+            special |= bx[k] == HUGE_VAL
+                || !(bx[k] * bx[k] + by[k] * by[k] >= min_p2)
+                || !(fabs( bz[k] ) < HUGE_VAL);
+        }
+
+        if( special )
+        {
+            for( k = 0; k < LANES; k++ )
+            {
+                io = (i + k) * point_offset;
+                to_geodetic1( gi, x + io, y + io, z + io );
+            }
+            continue;
+        }
+
+        vx = pj_vload( bx );
+        vy = pj_vload( by );
+        vz = pj_vload( bz );
+        to_geodetic( gi, &vx, &vy, &vz );
+        store_lanes( vx, vy, vz, i, point_offset, x, y, z );
+    }
+#endif /* def PJ_HAVE_SIMD */
+
+    for( ; i < point_count; i++ )
+    {
+        long io = i * point_offset;
+
+        to_geodetic1( gi, x + io, y + io, z + io );
+    }
+}
+
+/************************************************************************/
+/*                   pj_geodetic_datum_shift_batch()                    */
+/*                                                                      */
+/*      Longitude/latitude (radians) and height on the src ellipsoid    */
+/*      to the same on dst, through geocentric coordinates and the      */
+/*      3x4 row major matrix m, in one pass over the arrays.  Failures  */
+/*      are as for pj_geodetic_to_geocentric_batch().                   */
+/************************************************************************/
+
+int pj_geodetic_datum_shift_batch( GeocentricInfo *src, const double *m,
+                                   GeocentricInfo *dst, long point_count,
+                                   int point_offset,
+                                   double *x, double *y, double *z )
+
+{
+    long    i = 0;
+    int     failed = 0;
+
+#ifdef PJ_HAVE_SIMD
+    double  min_p2 = (GENAU * dst->Geocent_a) * (GENAU * dst->Geocent_a);
+    double  bx[LANES], by[LANES], bz[LANES];
+    pj_vd   vx, vy, vz;
+    long    io;
+    int     k, special;
+
+    for( ; i + LANES <= point_count; i += LANES )
+    {
+        special = 0;
+        for( k = 0; k < LANES; k++ )
+        {
+            io = (i + k) * point_offset;
+            bx[k] = x[io];
+            by[k] = y[io];
+            bz[k] = z[io];
+            special |= bx[k] == HUGE_VAL || !(fabs( by[k] ) <= HALFPI)
+                || !(fabs( bx[k] ) <= LON_LIMIT);
+        }
+
+        if( special )
+        {
+            for( k = 0; k < LANES; k++ )
+            {
+                io = (i + k) * point_offset;
+                failed |= shift1( src, m, dst, x + io, y + io, z + io );
+            }
+            continue;
+        }
+
+        vx = pj_vload( bx );
+        vy = pj_vload( by );
+        vz = pj_vload( bz );
+        to_geocentric( src, &vx, &vy, &vz );
+        affine( m, &vx, &vy, &vz );
+        pj_vstore( bx, vx );
+        pj_vstore( by, vy );
+        pj_vstore( bz, vz );
+
+        special = 0;
+        for( k = 0; k < LANES; k++ )
+            special |= !(bx[k] * bx[k] + by[k] * by[k] >= min_p2)
+                || !(fabs( bz[k] ) < HUGE_VAL);
+
+        if( special )
+        {
+            for( k = 0; k < LANES; k++ )
+            {
+                io = (i + k) * point_offset;
+                to_geodetic1( dst, bx + k, by + k, bz + k );
+                x[io] = bx[k];
+                y[io] = by[k];
+                z[io] = bz[k];
+            }
+            continue;
+        }
+
+        to_geodetic( dst, &vx, &vy, &vz );
+        store_lanes( vx, vy, vz, i, point_offset, x, y, z );
+    }
+#endif /* def PJ_HAVE_SIMD */
+
+    for( ; i < point_count; i++ )
+    {
+        long io = i * point_offset;
+
+        failed |= shift1( src, m, dst, x + io, y + io, z + io );
+    }
+
+    return failed;
+}
@@ -35,16 +35,8 @@ geod_set(int argc, char **argv) {
 		fr_meter = 1. / (to_meter = atof(unit_list[i].to_meter));
 	} else
 		to_meter = fr_meter = 1.;
-	if (ellipse = es != 0.) {
-		onef = sqrt(1. - es);
-		geod_f = 1 - onef;
-		f2 = geod_f/2;
-		f4 = geod_f/4;
-		f64 = geod_f*geod_f/64;
-	} else {
-		onef = 1.;
-		geod_f = f2 = f4 = f64 = 0.;
-	}
+	if (!(geod_ellps = pj_geod_alloc(geod_a, es)))
+		emess(1,"ellipse setup failure");
 	/* check if line or arc mode */
 	if (pj_param(start, "tlat_1").i) {
 		double del_S;
@@ -17,8 +17,7 @@ GEOD_EXTERN struct geodesic {
 	double	LAM1, PHI1, ALPHA12;
 	double	LAM2, PHI2, ALPHA21;
 	double	DIST;
-	double	ONEF, FLAT, FLAT2, FLAT4, FLAT64;
-	int	ELLIPSE;
+	struct PJ_GEOD *ELLPS;	/* ellipsoid constants, see pj_geod.c */
 } GEODESIC;
 
 # define geod_a	GEODESIC.A
@@ -29,13 +28,7 @@ GEOD_EXTERN struct geodesic {
 # define phi2	GEODESIC.PHI2
 # define al21	GEODESIC.ALPHA21
 # define geod_S	GEODESIC.DIST
-# define geod_f	GEODESIC.FLAT
-# define onef	GEODESIC.ONEF
-# define f2	GEODESIC.FLAT2
-# define f4	GEODESIC.FLAT4
-# define ff2	GEODESIC.FLAT4
-# define f64	GEODESIC.FLAT64
-# define ellipse GEODESIC.ELLIPSE
+# define geod_ellps GEODESIC.ELLPS
 
     
 GEOD_EXTERN int n_alpha, n_S;
@@ -51,11 +51,69 @@
 #include "projects.h"
 #include "org_proj4_Projections.h"
 #include <jni.h>
+#include <string.h>
 
 #define arraysize 300
 
 PJ_CVSID("$Id: jniproj.c,v 1.3 2005/07/05 16:31:48 fwarmerdam Exp $");
 
+/*!
+ * \brief
+ * native state behind the handle returned by createTransform
+ *
+ * The PJs come from the definition cache and the pipeline is prepared
+ * once.  The context keeps the error code and the +nadgrids list of the
+ * handle to itself, so a handle must not be used by two threads at the
+ * same time; give each thread its own.
+ */
+typedef struct {
+	projPJ src, dst;
+	projTransform pipeline;
+	projCtx ctx;
+} jni_transform;
+
+/*!
+ * \brief
+ * raises a Java exception of the given class; the caller must return
+ * to Java without further JNI calls
+*/
+static void throw_exception(JNIEnv * env, const char * classname, const char * message)
+{
+	jclass cls = (*env)->FindClass(env, classname);
+
+	if (cls != NULL)
+		(*env)->ThrowNew(env, cls, message);
+}
+
+/*!
+ * \brief
+ * pj_init_plus_cached() on a Java string, throwing
+ * IllegalArgumentException if the definition is rejected
+*/
+static projPJ init_from_jstring(JNIEnv * env, jstring definition)
+{
+	const char * def;
+	projPJ pj;
+	char message[arraysize];
+
+	if (definition == NULL)
+	{
+		throw_exception(env, "java/lang/NullPointerException", "projection definition");
+		return NULL;
+	}
+	if ((def = (*env)->GetStringUTFChars(env, definition, 0)) == NULL)
+		return NULL;		/* OutOfMemoryError already thrown */
+
+	pj_errno = 0;
+	if (!(pj = pj_init_plus_cached(def)))
+	{
+		sprintf(message, "%.200s: %.90s", pj_strerrno(pj_errno), def);
+		throw_exception(env, "java/lang/IllegalArgumentException", message);
+	}
+	(*env)->ReleaseStringUTFChars(env, definition, def);
+	return pj;
+}
+
 /*!
  * \brief
  * executes reprojection 
@@ -79,28 +137,41 @@ PJ_CVSID("$Id: jniproj.c,v 1.3 2005/07/05 16:31:48 fwarmerdam Exp $");
 JNIEXPORT void JNICALL Java_org_proj4_Projections_transform
   (JNIEnv * env, jobject parent, jdoubleArray firstcoord, jdoubleArray secondcoord, jdoubleArray values, jstring src, jstring dest, jlong pcount, jint poffset)
 {
-	int i;
 	projPJ src_pj, dst_pj;
-	char * srcproj_def = (char *) (*env)->GetStringUTFChars (env, src, 0); 
-	char * destproj_def = (char *) (*env)->GetStringUTFChars (env, dest, 0);
+	double *xcoord, *ycoord, *zcoord = NULL;
+	int err;
+
+	/* the same pair of definitions usually comes in call after call */
+	if (!(src_pj = init_from_jstring(env, src)))
+		return;
+	if (!(dst_pj = init_from_jstring(env, dest)))
+	{
+		pj_free_cached(src_pj);
+		return;
+	}
 
-	if (!(src_pj = pj_init_plus(srcproj_def)))
-		exit(1);
-	if (!(dst_pj = pj_init_plus(destproj_def)))
-		exit(1);
+	xcoord = (* env)-> GetDoubleArrayElements(env, firstcoord, NULL); 
+	ycoord = (* env) -> GetDoubleArrayElements(env, secondcoord, NULL); 
+	if (values != NULL)
+		zcoord = (* env) -> GetDoubleArrayElements(env, values, NULL); 
 
-	double *xcoord = (* env)-> GetDoubleArrayElements(env, firstcoord, NULL); 
-	double *ycoord = (* env) -> GetDoubleArrayElements(env, secondcoord, NULL); 
-	double *zcoord = (* env) -> GetDoubleArrayElements(env, values, NULL); 
+	/* a NULL array leaves an OutOfMemoryError pending */
+	err = 0;
+	if (xcoord != NULL && ycoord != NULL && (values == NULL || zcoord != NULL))
+		err = pj_transform( src_pj, dst_pj, pcount,poffset, xcoord, ycoord, zcoord);
 
-        pj_transform( src_pj, dst_pj, pcount,poffset, xcoord, ycoord, zcoord);
+	if (xcoord != NULL)
+		(* env)->ReleaseDoubleArrayElements(env,firstcoord,(jdouble *) xcoord,0);
+	if (ycoord != NULL)
+		(* env)->ReleaseDoubleArrayElements(env,secondcoord,(jdouble *) ycoord,0);
+	if (zcoord != NULL)
+		(* env)->ReleaseDoubleArrayElements(env,values,(jdouble *) zcoord,0);
 
-	(* env)->ReleaseDoubleArrayElements(env,firstcoord,(jdouble *) xcoord,JNI_COMMIT);
-	(* env)->ReleaseDoubleArrayElements(env,secondcoord,(jdouble *) ycoord,JNI_COMMIT);
-	(* env)->ReleaseDoubleArrayElements(env,values,(jdouble *) zcoord,JNI_COMMIT);
+	pj_free_cached( src_pj );
+	pj_free_cached( dst_pj );
 
-	pj_free( src_pj );
-	pj_free( dst_pj );
+	if (err != 0)
+		throw_exception(env, "java/lang/RuntimeException", pj_strerrno(err));
 }
 
 /*!
@@ -124,15 +195,15 @@ JNIEXPORT jstring JNICALL Java_org_proj4_Projections_getProjInfo
 	char * pjdesc;
 	char info[arraysize];
 	
-	char * proj_def = (char *) (*env)->GetStringUTFChars (env, projdefinition, 0);
-	
-	if (!(pj = pj_init_plus(proj_def)))
-		exit(1);
+	if (!(pj = init_from_jstring(env, projdefinition)))
+		return NULL;
 	
 	// put together all the info of the projection and free the pointer to pjdesc
 	pjdesc = pj_get_def(pj, 0);
-	strcpy(info,pjdesc);
+	strncpy(info,pjdesc,arraysize-1);
+	info[arraysize-1] = '\0';
 	pj_dalloc(pjdesc);
+	pj_free_cached(pj);
 	
 	return (*env)->NewStringUTF(env,info); 
 }
@@ -160,10 +231,8 @@ JNIEXPORT jstring JNICALL Java_org_proj4_Projections_getEllipsInfo
 	char ellipseinfo[arraysize];
 	char temp[50];
 	
-	char * proj_def = (char *) (*env)->GetStringUTFChars (env, projdefinition, 0);
-	
-	if (!(pj = pj_init_plus(proj_def)))
-		exit(1);
+	if (!(pj = init_from_jstring(env, projdefinition)))
+		return NULL;
 	
 	// put together all the info of the ellipsoid 
 /* 	sprintf(temp,"name: %s;", pj->descr); */
@@ -195,8 +264,224 @@ JNIEXPORT jstring JNICALL Java_org_proj4_Projections_getEllipsInfo
 	strcat(ellipseinfo,temp);
 	sprintf(temp,"fr_meter: %lf;", pj->fr_meter);
 	strcat(ellipseinfo,temp);
+	pj_free_cached(pj);
 
 	return (*env)->NewStringUTF(env,ellipseinfo); 
 }
 
+/*!
+ * \brief
+ * creates a native transform handle for repeated use
+ * 
+ * JNI informations:
+ * Class:     org_proj4_Projections
+ * Method:    createTransform
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)J
+ * 
+ *
+ * \param env - parameter used by jni (see JNI specification)
+ * \param parent - parameter used by jni (see JNI specification)
+ * \param src - definition of the source projection
+ * \param dest - definition of the destination projection
+ * \return the handle, to be passed to freeTransform when done; 0 with
+ * an IllegalArgumentException pending if a definition is rejected or the
+ * pair cannot be transformed
+*/
+JNIEXPORT jlong JNICALL Java_org_proj4_Projections_createTransform
+  (JNIEnv * env, jobject parent, jstring src, jstring dest)
+{
+	jni_transform *t;
+
+	if (!(t = (jni_transform *) pj_malloc(sizeof(jni_transform))))
+	{
+		throw_exception(env, "java/lang/OutOfMemoryError", "transform handle");
+		return 0;
+	}
+	memset(t, 0, sizeof(jni_transform));
+
+	if (!(t->src = init_from_jstring(env, src))
+	    || !(t->dst = init_from_jstring(env, dest)))
+	{
+		Java_org_proj4_Projections_freeTransform(env, parent, (jlong) (size_t) t);
+		return 0;
+	}
+
+	if (!(t->pipeline = pj_transform_prepare(t->src, t->dst)))
+	{
+		int err = pj_errno;
+
+		Java_org_proj4_Projections_freeTransform(env, parent, (jlong) (size_t) t);
+		throw_exception(env, "java/lang/IllegalArgumentException", pj_strerrno(err));
+		return 0;
+	}
+	if (!(t->ctx = pj_ctx_alloc()))
+	{
+		Java_org_proj4_Projections_freeTransform(env, parent, (jlong) (size_t) t);
+		throw_exception(env, "java/lang/OutOfMemoryError", "transform handle");
+		return 0;
+	}
+
+	return (jlong) (size_t) t;
+}
+
+/*!
+ * \brief
+ * releases a handle from createTransform; 0 is ignored
+ * 
+ * JNI informations:
+ * Class:     org_proj4_Projections
+ * Method:    freeTransform
+ * Signature: (J)V
+*/
+JNIEXPORT void JNICALL Java_org_proj4_Projections_freeTransform
+  (JNIEnv * env, jobject parent, jlong handle)
+{
+	jni_transform *t = (jni_transform *) (size_t) handle;
+
+	if (t == NULL)
+		return;
+
+	pj_transform_free(t->pipeline);
+	pj_free_cached(t->src);
+	pj_free_cached(t->dst);
+	pj_ctx_free(t->ctx);
+	pj_dalloc(t);
+}
+
+/*!
+ * \brief
+ * runs the handle's transform under its own context
+ * \return 0, or the pj_errno value to report
+*/
+static int run_transform(jni_transform * t, long count, int offset,
+                         double * x, double * y, double * z)
+{
+	projCtx old = pj_set_ctx(t->ctx);
+	int err = pj_transform_run(t->pipeline, count, offset, x, y, z);
+
+	pj_set_ctx(old);
+	return err;
+}
+
+/*!
+ * \brief
+ * transforms Java arrays in place, without copying them
+ * 
+ * JNI informations:
+ * Class:     org_proj4_Projections
+ * Method:    transformArrays
+ * Signature: (J[D[D[DJI)V
+ * 
+ * The arrays are pinned with GetPrimitiveArrayCritical for the duration
+ * of the transform, which may hold up the garbage collector; keep
+ * batches to a reasonable size.
+ *
+ * \param env - parameter used by jni (see JNI specification)
+ * \param parent - parameter used by jni (see JNI specification)
+ * \param handle - from createTransform
+ * \param firstcoord - array of x coordinates
+ * \param secondcoord - array of y coordinates
+ * \param values - array of z coordinates, may be null
+ * \param pcount - number of points
+ * \param poffset - distance between consecutive points in the arrays
+*/
+JNIEXPORT void JNICALL Java_org_proj4_Projections_transformArrays
+  (JNIEnv * env, jobject parent, jlong handle, jdoubleArray firstcoord, jdoubleArray secondcoord, jdoubleArray values, jlong pcount, jint poffset)
+{
+	jni_transform *t = (jni_transform *) (size_t) handle;
+	double *xcoord, *ycoord, *zcoord = NULL;
+	jlong needed;
+	int err = 0;
+
+	if (t == NULL || firstcoord == NULL || secondcoord == NULL)
+	{
+		throw_exception(env, "java/lang/NullPointerException", "transformArrays");
+		return;
+	}
+	if (poffset < 1)
+		poffset = 1;
+	needed = pcount > 0 ? (pcount - 1) * poffset + 1 : 0;
+	if (pcount < 0
+	    || (*env)->GetArrayLength(env, firstcoord) < needed
+	    || (*env)->GetArrayLength(env, secondcoord) < needed
+	    || (values != NULL && (*env)->GetArrayLength(env, values) < needed))
+	{
+		throw_exception(env, "java/lang/IndexOutOfBoundsException", "point count exceeds the arrays");
+		return;
+	}
+
+	xcoord = (*env)->GetPrimitiveArrayCritical(env, firstcoord, NULL);
+	ycoord = (*env)->GetPrimitiveArrayCritical(env, secondcoord, NULL);
+	if (values != NULL)
+		zcoord = (*env)->GetPrimitiveArrayCritical(env, values, NULL);
+
+	/* no other JNI calls until the arrays are released; a NULL array
+	   leaves an OutOfMemoryError pending */
+	if (xcoord != NULL && ycoord != NULL && (values == NULL || zcoord != NULL))
+		err = run_transform(t, pcount, poffset, xcoord, ycoord, zcoord);
+
+	if (zcoord != NULL)
+		(*env)->ReleasePrimitiveArrayCritical(env, values, zcoord, 0);
+	if (ycoord != NULL)
+		(*env)->ReleasePrimitiveArrayCritical(env, secondcoord, ycoord, 0);
+	if (xcoord != NULL)
+		(*env)->ReleasePrimitiveArrayCritical(env, firstcoord, xcoord, 0);
+
+	if (err != 0)
+		throw_exception(env, "java/lang/RuntimeException", pj_strerrno(err));
+}
+
+/*!
+ * \brief
+ * transforms coordinates in a direct ByteBuffer in place
+ * 
+ * JNI informations:
+ * Class:     org_proj4_Projections
+ * Method:    transformBuffer
+ * Signature: (JLjava/nio/ByteBuffer;JI)V
+ * 
+ * The buffer holds pcount points of pdimension (2 or 3) doubles each,
+ * x, y[, z], in native byte order (ByteOrder.nativeOrder()).
+ *
+ * \param env - parameter used by jni (see JNI specification)
+ * \param parent - parameter used by jni (see JNI specification)
+ * \param handle - from createTransform
+ * \param buffer - direct buffer with the coordinates
+ * \param pcount - number of points
+ * \param pdimension - doubles per point
+*/
+JNIEXPORT void JNICALL Java_org_proj4_Projections_transformBuffer
+  (JNIEnv * env, jobject parent, jlong handle, jobject buffer, jlong pcount, jint pdimension)
+{
+	jni_transform *t = (jni_transform *) (size_t) handle;
+	double *coords;
+	int err;
+
+	if (t == NULL || buffer == NULL)
+	{
+		throw_exception(env, "java/lang/NullPointerException", "transformBuffer");
+		return;
+	}
+	if (pdimension != 2 && pdimension != 3)
+	{
+		throw_exception(env, "java/lang/IllegalArgumentException", "dimension must be 2 or 3");
+		return;
+	}
+	if (!(coords = (double *) (*env)->GetDirectBufferAddress(env, buffer)))
+	{
+		throw_exception(env, "java/lang/IllegalArgumentException", "not a direct buffer");
+		return;
+	}
+	if (pcount < 0 || pcount > (*env)->GetDirectBufferCapacity(env, buffer)
+	                            / (jlong) (pdimension * sizeof(double)))
+	{
+		throw_exception(env, "java/lang/IndexOutOfBoundsException", "point count exceeds the buffer");
+		return;
+	}
+
+	if ((err = run_transform(t, pcount, pdimension, coords, coords + 1,
+	                         pdimension == 3 ? coords + 2 : NULL)) != 0)
+		throw_exception(env, "java/lang/RuntimeException", pj_strerrno(err));
+}
+
 #endif
@@ -35,16 +35,14 @@ makeT(int nru, int nrv) {
 	} else
 		return 0;
 }
-	Tseries *
-mk_cheby(projUV a, projUV b, double res, projUV *resid, projUV (*func)(projUV), 
-	int nu, int nv, int power) {
+	static Tseries * /* fit series, func == 0 if w already holds samples */
+fit(projUV a, projUV b, double res, projUV *resid, projUV (*func)(projUV), 
+	projUV **w, int nu, int nv, int power) {
 	int j, i, nru, nrv, *ncu, *ncv;
 	Tseries *Ts = 0;
-	projUV **w;
 	double cutres;
 
-	if (!(w = (projUV **)vector2(nu, nv, sizeof(projUV))) ||
-		!(ncu = (int *)vector1(nu + nv, sizeof(int))))
+	if (!(ncu = (int *)vector1(nu + nv, sizeof(int))))
 		return 0;
 	ncv = ncu + nu;
 	if (!bchgen(a, b, nu, nv, w, func)) {
@@ -158,7 +156,23 @@ error:
 	}
 	Ts = 0;
 gohome:
-	freev2((void **) w, nu);
 	pj_dalloc(ncu);
 	return Ts;
+}
+	Tseries *
+mk_cheby(projUV a, projUV b, double res, projUV *resid, projUV (*func)(projUV), 
+	int nu, int nv, int power) {
+	projUV **w;
+	Tseries *Ts;
+
+	if (!(w = (projUV **)vector2(nu, nv, sizeof(projUV))))
+		return 0;
+	Ts = fit(a, b, res, resid, func, w, nu, nv, power);
+	freev2((void **) w, nu);
+	return Ts;
+}
+	Tseries * /* as mk_cheby, w[i][j] sampled by caller at bch_node(i), (j) */
+mk_cheby_fit(projUV a, projUV b, double res, projUV *resid, projUV **w,
+	int nu, int nv, int power) {
+	return fit(a, b, res, resid, 0, w, nu, nv, power);
 }
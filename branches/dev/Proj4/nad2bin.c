@@ -4,24 +4,64 @@ static const char SCCSID[]="@(#)nad2bin.c	4.2 93/08/25 GIE REL";
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #define PJ_LIB__
 #include "projects.h"
 #define U_SEC_TO_RAD 4.848136811095359935899141023e-12
 	static char
-*usage = "<ASCII_dist_table local_bin_table";
+*usage = "[-f ctable|mapped] local_bin_table <ASCII_dist_table\n"
+"       %s -f mapped -i grid_file local_bin_table";
+	static void
+write_mapped(PJ_GRIDINFO *gi, char *name) {
+	FILE *bin;
+
+	if (!(bin = fopen(name, "wb"))) {
+		perror(name);
+		exit(2);
+	}
+	if (!pj_gridinfo_write_mapped(gi, bin) || fclose(bin)) {
+		fprintf(stderr, "output failure: %s\n", pj_strerrno(pj_errno));
+		exit(2);
+	}
+}
 	void
 main(int argc, char **argv) {
 	struct CTABLE ct;
+	PJ_GRIDINFO gi;
 	FLP *p, t;
 	size_t tsize;
-	int i, j, ichk;
+	int i, j, ichk, mapped = 0;
 	long lam, laml, phi, phil;
+	char *input = 0;
 	FILE *bin;
 
-	if (argc != 2) {
-		fprintf(stderr,"usage: %s %s\n", argv[0], usage);
+	for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+		if (!strcmp(argv[i], "-f") && !strcmp(argv[i+1], "mapped"))
+			mapped = 1;
+		else if (!strcmp(argv[i], "-f") && !strcmp(argv[i+1], "ctable"))
+			mapped = 0;
+		else if (!strcmp(argv[i], "-i"))
+			input = argv[i+1];
+		else
+			break;
+	}
+	if (i != argc - 1 || (input && !mapped)) {
+		fprintf(stderr,"usage: %s ", argv[0]);
+		fprintf(stderr, usage, argv[0]);
+		fprintf(stderr, "\n");
 		exit(1);
 	}
+	/* convert an existing ctable, NTv1 or NTv2 grid */
+	if (input) {
+		PJ_GRIDINFO *grids = pj_gridinfo_init(input);
+
+		if (grids->ct == NULL) {
+			fprintf(stderr, "%s: %s\n", input, pj_strerrno(pj_errno));
+			exit(1);
+		}
+		write_mapped(grids, argv[i]);
+		exit(0);
+	}
 	fgets(ct.id, MAX_TAB_ID, stdin);
 	scanf("%d %d %*d %lf %lf %lf %lf", &ct.lim.lam, &ct.lim.phi,
 		&ct.ll.lam, &ct.del.lam, &ct.ll.phi, &ct.del.phi);
@@ -55,8 +95,18 @@ main(int argc, char **argv) {
 		fprintf(stderr, "premature EOF\n");
 		exit(1);
 	}
-	if (!(bin = freopen(argv[1], "wb", stdout))) {
-		perror(argv[1]);
+	if (mapped) {
+		/* trim the id as nad_ctable_init() would */
+		for (j = strlen(ct.id) - 1; j > 0 &&
+			(ct.id[j] == '\n' || ct.id[j] == ' '); --j)
+			ct.id[j] = '\0';
+		memset(&gi, 0, sizeof(gi));
+		gi.ct = &ct;
+		write_mapped(&gi, argv[argc-1]);
+		exit(0);
+	}
+	if (!(bin = freopen(argv[argc-1], "wb", stdout))) {
+		perror(argv[argc-1]);
 		exit(2);
 	}
 	if (fwrite(&ct, sizeof(ct), 1, stdout) != 1 ||
@@ -39,7 +39,7 @@ nad_cvt(LP in, int inverse, struct CTABLE *ct) {
                            the NTv2 grid shift file from Canada. */
 			if (del.lam == HUGE_VAL) 
                         {
-                            if( getenv( "PROJ_DEBUG" ) != NULL )
+                            if( pj_get_ctx()->debug_level )
                                 fprintf( stderr, 
                                          "Inverse grid shift iteration failed, presumably at grid edge.\n"
                                          "Using first approximation.\n" );
@@ -51,7 +51,7 @@ nad_cvt(LP in, int inverse, struct CTABLE *ct) {
 			t.phi -= dif.phi = t.phi + del.phi - tb.phi;
 		} while (i-- && fabs(dif.lam) > TOL && fabs(dif.phi) > TOL);
 		if (i < 0) {
-                    if( getenv( "PROJ_DEBUG" ) != NULL )
+                    if( pj_get_ctx()->debug_level )
                         fprintf( stderr, 
                                  "Inverse grid shift iterator failed to converge.\n" );
                     t.lam = t.phi = HUGE_VAL;
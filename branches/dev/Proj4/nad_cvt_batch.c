@@ -0,0 +1,289 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  nad_cvt() for several points of one table at a time, with a
+ *           vector bilinear interpolation kernel.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * The results are bit for bit those of nad_cvt() on each point.  The
+ * kernel does the same IEEE operations in the same order as nad_intr(),
+ * PJ_VLEN lanes at a time: the four FLP corners of each lane are read
+ * and widened to double exactly as the scalar code promotes them, and
+ * lanes whose cell touches the table edge (which nad_intr() nudges
+ * inward) are handed to nad_intr() itself.  The inverse iteration steps
+ * each lane as nad_cvt() does, a lane dropping out once it converges,
+ * fails or runs out of tries.
+ *
+ * The vector width is pj_simd.h's, fixed when the library is compiled.
+ * The kernel is left out when the build may contract a*b+c into FMA
+ * instructions (__FMA__), since the scalar results would then depend on
+ * the compiler.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include "pj_simd.h"
+#include <math.h>
+
+#define MAX_TRY 9       /* as in nad_cvt.c */
+#define TOL 1e-12
+
+#if defined(PJ_HAVE_SIMD) && !defined(__FMA__)
+#  define NAD_SIMD
+#endif
+
+#ifdef NAD_SIMD
+
+#define LANES PJ_VLEN
+
+/************************************************************************/
+/*                               intrv()                                */
+/*                                                                      */
+/*      nad_intr() on LANES points.                                     */
+/************************************************************************/
+
+static void intrv( const double *lam, const double *phi,
+                   struct CTABLE *ct, double *vlam, double *vphi )
+
+{
+    double c00_lam[LANES], c10_lam[LANES], c01_lam[LANES], c11_lam[LANES];
+    double c00_phi[LANES], c10_phi[LANES], c01_phi[LANES], c11_phi[LANES];
+    double i_lam[LANES], i_phi[LANES];
+    pj_vd  q_lam, q_phi, fl_lam, fl_phi, ok, one, zero;
+    pj_vd  m00, m10, m01, m11, f_lam, f_phi;
+    int    okmask, k;
+
+    one = pj_vset1( 1.0 );
+    zero = pj_vset1( 0.0 );
+    q_lam = pj_vdiv( pj_vload( lam ), pj_vset1( ct->del.lam ) );
+    q_phi = pj_vdiv( pj_vload( phi ), pj_vset1( ct->del.phi ) );
+
+    /* cells clear of the edges, floor(q) >= 0 and floor(q) + 1 < lim;
+       NaN lanes fail the ordered compares */
+    ok = pj_vand(
+        pj_vand( pj_vge( q_lam, zero ),
+                 pj_vlt( q_lam, pj_vset1( ct->lim.lam - 1.0 ) ) ),
+        pj_vand( pj_vge( q_phi, zero ),
+                 pj_vlt( q_phi, pj_vset1( ct->lim.phi - 1.0 ) ) ) );
+    okmask = pj_vmask( ok );
+
+    if( okmask != 0 )
+    {
+        /* other lanes interpolate cell 0 and are replaced below; adding
+           zero makes floor(-0.0) the +0.0 of nad_intr()'s int index */
+        fl_lam = pj_vadd( pj_vfloor( pj_vand( ok, q_lam ) ), zero );
+        fl_phi = pj_vadd( pj_vfloor( pj_vand( ok, q_phi ) ), zero );
+        pj_vstore( i_lam, fl_lam );
+        pj_vstore( i_phi, fl_phi );
+
+        for( k = 0; k < LANES; k++ )
+        {
+            const FLP *f = ct->cvs + (long) i_phi[k] * ct->lim.lam
+                + (long) i_lam[k];
+
+            c00_lam[k] = f[0].lam;
+            c00_phi[k] = f[0].phi;
+            c10_lam[k] = f[1].lam;
+            c10_phi[k] = f[1].phi;
+            c01_lam[k] = f[ct->lim.lam].lam;
+            c01_phi[k] = f[ct->lim.lam].phi;
+            c11_lam[k] = f[ct->lim.lam + 1].lam;
+            c11_phi[k] = f[ct->lim.lam + 1].phi;
+        }
+
+        q_lam = pj_vsub( q_lam, fl_lam );               /* frct */
+        q_phi = pj_vsub( q_phi, fl_phi );
+        m11 = m10 = q_lam;
+        m00 = m01 = pj_vsub( one, q_lam );
+        m11 = pj_vmul( m11, q_phi );
+        m01 = pj_vmul( m01, q_phi );
+        q_phi = pj_vsub( one, q_phi );
+        m00 = pj_vmul( m00, q_phi );
+        m10 = pj_vmul( m10, q_phi );
+
+        f_lam = pj_vmul( m00, pj_vload( c00_lam ) );
+        f_lam = pj_vadd( f_lam, pj_vmul( m10, pj_vload( c10_lam ) ) );
+        f_lam = pj_vadd( f_lam, pj_vmul( m01, pj_vload( c01_lam ) ) );
+        f_lam = pj_vadd( f_lam, pj_vmul( m11, pj_vload( c11_lam ) ) );
+        f_phi = pj_vmul( m00, pj_vload( c00_phi ) );
+        f_phi = pj_vadd( f_phi, pj_vmul( m10, pj_vload( c10_phi ) ) );
+        f_phi = pj_vadd( f_phi, pj_vmul( m01, pj_vload( c01_phi ) ) );
+        f_phi = pj_vadd( f_phi, pj_vmul( m11, pj_vload( c11_phi ) ) );
+
+        pj_vstore( vlam, f_lam );
+        pj_vstore( vphi, f_phi );
+    }
+
+    for( k = 0; k < LANES; k++ )
+    {
+        if( !(okmask & (1 << k)) )
+        {
+            LP t, val;
+
+            t.lam = lam[k];
+            t.phi = phi[k];
+            val = nad_intr( t, ct );
+            vlam[k] = val.lam;
+            vphi[k] = val.phi;
+        }
+    }
+}
+
+/************************************************************************/
+/*                               cvtv()                                 */
+/*                                                                      */
+/*      nad_cvt() on LANES points, in place.                            */
+/************************************************************************/
+
+static void cvtv( LP *pts, int inverse, struct CTABLE *ct )
+
+{
+    double tb_lam[LANES], tb_phi[LANES], t_lam[LANES], t_phi[LANES];
+    double d_lam[LANES], d_phi[LANES], dif_lam, dif_phi;
+    int    tries[LANES], lanes = 0, active, bit, k;
+    int    debug = pj_get_ctx()->debug_level;
+
+    /* normalize input to ll origin */
+    for( k = 0; k < LANES; k++ )
+    {
+        tb_lam[k] = tb_phi[k] = 0.0;
+        if( pts[k].lam == HUGE_VAL )
+            continue;
+        tb_lam[k] = adjlon( pts[k].lam - ct->ll.lam - PI ) + PI;
+        tb_phi[k] = pts[k].phi - ct->ll.phi;
+        lanes |= 1 << k;
+    }
+
+    intrv( tb_lam, tb_phi, ct, t_lam, t_phi );
+
+    if( !inverse )
+    {
+        for( k = 0; k < LANES; k++ )
+        {
+            if( !(lanes & (1 << k)) )
+                continue;
+            if( t_lam[k] == HUGE_VAL )
+            {
+                pts[k].lam = t_lam[k];
+                pts[k].phi = t_phi[k];
+            }
+            else
+            {
+                pts[k].lam -= t_lam[k];
+                pts[k].phi += t_phi[k];
+            }
+        }
+        return;
+    }
+
+    for( k = 0; k < LANES; k++ )
+    {
+        if( !(lanes & (1 << k)) )
+            continue;
+        if( t_lam[k] == HUGE_VAL )
+        {
+            pts[k].lam = t_lam[k];
+            pts[k].phi = t_phi[k];
+            t_lam[k] = t_phi[k] = 0.0;  /* keep the lane harmless */
+            lanes &= ~(1 << k);
+            continue;
+        }
+        t_lam[k] = tb_lam[k] + t_lam[k];
+        t_phi[k] = tb_phi[k] - t_phi[k];
+        tries[k] = MAX_TRY;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Interpolate all lanes together; a lane leaves the active set    */
+/*      the way nad_cvt() leaves its loop.                              */
+/* -------------------------------------------------------------------- */
+    for( active = lanes; active != 0; )
+    {
+        intrv( t_lam, t_phi, ct, d_lam, d_phi );
+
+        for( k = 0; k < LANES; k++ )
+        {
+            bit = 1 << k;
+            if( !(active & bit) )
+                continue;
+            if( d_lam[k] == HUGE_VAL )
+            {
+                /* first approximation, see nad_cvt() */
+                if( debug )
+                    fprintf( stderr,
+                             "Inverse grid shift iteration failed, presumably at grid edge.\n"
+                             "Using first approximation.\n" );
+                active &= ~bit;
+                continue;
+            }
+
+            t_lam[k] -= dif_lam = t_lam[k] - d_lam[k] - tb_lam[k];
+            t_phi[k] -= dif_phi = t_phi[k] + d_phi[k] - tb_phi[k];
+            if( !(tries[k]-- && fabs( dif_lam ) > TOL
+                  && fabs( dif_phi ) > TOL) )
+                active &= ~bit;
+        }
+    }
+
+    for( k = 0; k < LANES; k++ )
+    {
+        if( !(lanes & (1 << k)) )
+            continue;
+        if( tries[k] < 0 )
+        {
+            if( debug )
+                fprintf( stderr,
+                         "Inverse grid shift iterator failed to converge.\n" );
+            pts[k].lam = pts[k].phi = HUGE_VAL;
+        }
+        else
+        {
+            pts[k].lam = adjlon( t_lam[k] + ct->ll.lam );
+            pts[k].phi = t_phi[k] + ct->ll.phi;
+        }
+    }
+}
+
+#endif /* def NAD_SIMD */
+
+/************************************************************************/
+/*                           nad_cvt_batch()                            */
+/*                                                                      */
+/*      pts[i] = nad_cvt( pts[i], inverse, ct ) for the n points.       */
+/************************************************************************/
+
+void nad_cvt_batch( LP *pts, int n, int inverse, struct CTABLE *ct )
+
+{
+    int i = 0;
+
+#ifdef NAD_SIMD
+    for( ; i + LANES <= n; i += LANES )
+        cvtv( pts + i, inverse, ct );
+#endif
+
+    for( ; i < n; i++ )
+        pts[i] = nad_cvt( pts[i], inverse, ct );
+}
@@ -81,19 +81,20 @@ int nad_ctable_load( struct CTABLE *ct, FILE *fid )
 
 {
     int  a_size;
+    FLP  *cvs;
 
     fseek( fid, sizeof(struct CTABLE), SEEK_SET );
 
-    /* read all the actual shift values */
+    /* read all the actual shift values, ct->cvs is only set once the
+       table is complete as other threads may be testing it */
     a_size = ct->lim.lam * ct->lim.phi;
-    ct->cvs = (FLP *) pj_malloc(sizeof(FLP) * a_size);
-    if( ct->cvs == NULL 
-        || fread(ct->cvs, sizeof(FLP), a_size, fid) != a_size )
+    cvs = (FLP *) pj_malloc(sizeof(FLP) * a_size);
+    if( cvs == NULL 
+        || fread(cvs, sizeof(FLP), a_size, fid) != a_size )
     {
-        pj_dalloc( ct->cvs );
-        ct->cvs = NULL;
+        pj_dalloc( cvs );
 
-        if( getenv("PROJ_DEBUG") != NULL )
+        if( pj_get_ctx()->debug_level )
         {
             fprintf( stderr, 
             "ctable loading failed on fread() - binary incompatible?\n" );
@@ -103,9 +104,56 @@ int nad_ctable_load( struct CTABLE *ct, FILE *fid )
         return 0;
     }
 
+    nad_ctable_publish( ct, cvs );
     return 1;
 } 
 
+/************************************************************************/
+/*                         nad_ctable_publish()                         */
+/*                                                                      */
+/*      Set ct->cvs to a table that has just been filled in.  Other     */
+/*      threads test ct->cvs without holding the grid lock, so the      */
+/*      store has release semantics: whoever sees the pointer sees      */
+/*      the values behind it.                                           */
+/************************************************************************/
+
+void nad_ctable_publish( struct CTABLE *ct, FLP *cvs )
+
+{
+#if defined(__ATOMIC_RELEASE)
+    __atomic_store_n( &ct->cvs, cvs, __ATOMIC_RELEASE );
+#elif defined(__GNUC__)
+    __sync_synchronize();
+    ct->cvs = cvs;
+#else
+    /* MSVC gives volatile stores release semantics */
+    *(FLP * volatile *) &ct->cvs = cvs;
+#endif
+}
+
+/************************************************************************/
+/*                         nad_ctable_loaded()                          */
+/*                                                                      */
+/*      ct->cvs read with acquire semantics, the unlocked counterpart   */
+/*      of nad_ctable_publish().                                        */
+/************************************************************************/
+
+FLP *nad_ctable_loaded( struct CTABLE *ct )
+
+{
+    FLP *cvs;
+
+#if defined(__ATOMIC_ACQUIRE)
+    cvs = __atomic_load_n( &ct->cvs, __ATOMIC_ACQUIRE );
+#elif defined(__GNUC__)
+    cvs = ct->cvs;
+    __sync_synchronize();
+#else
+    cvs = *(FLP * volatile *) &ct->cvs;
+#endif
+    return cvs;
+}
+
 /************************************************************************/
 /*                          nad_ctable_init()                           */
 /*                                                                      */
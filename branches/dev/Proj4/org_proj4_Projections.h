@@ -31,6 +31,38 @@ JNIEXPORT jstring JNICALL Java_org_proj4_Projections_getEllipsInfo
 JNIEXPORT void JNICALL Java_org_proj4_Projections_transform
   (JNIEnv *, jobject, jdoubleArray, jdoubleArray, jdoubleArray, jstring, jstring, jlong, jint);
 
+/*
+ * Class:     org_proj4_Projections
+ * Method:    createTransform
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_proj4_Projections_createTransform
+  (JNIEnv *, jobject, jstring, jstring);
+
+/*
+ * Class:     org_proj4_Projections
+ * Method:    freeTransform
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_proj4_Projections_freeTransform
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     org_proj4_Projections
+ * Method:    transformArrays
+ * Signature: (J[D[D[DJI)V
+ */
+JNIEXPORT void JNICALL Java_org_proj4_Projections_transformArrays
+  (JNIEnv *, jobject, jlong, jdoubleArray, jdoubleArray, jdoubleArray, jlong, jint);
+
+/*
+ * Class:     org_proj4_Projections
+ * Method:    transformBuffer
+ * Signature: (JLjava/nio/ByteBuffer;JI)V
+ */
+JNIEXPORT void JNICALL Java_org_proj4_Projections_transformBuffer
+  (JNIEnv *, jobject, jlong, jobject, jlong, jint);
+
 #ifdef __cplusplus
 }
 #endif
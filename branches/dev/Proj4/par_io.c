@@ -0,0 +1,241 @@
+/* text output buffers and parallel line processing for proj and cs2cs */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "proj_api.h"
+#include "emess.h"
+#include "par_io.h"
+#ifdef _WIN32
+#  include <windows.h>
+#  if defined(_MSC_VER) && _MSC_VER < 1900
+#    define vsnprintf _vsnprintf	/* -1 when short, handled below */
+#  endif
+#else
+#  include <pthread.h>
+#endif
+
+#define CHUNK_BYTES (256 * 1024)	/* input text per thread and round */
+
+typedef struct {	/* a run of whole input lines and their output */
+	char	*text;
+	size_t	len, size;
+	int	max_line;
+	void	(*func)(char *, OUT_TEXT *);
+	OUT_TEXT out;
+} PAR_CHUNK;
+
+typedef struct {	/* the input stream and the partial line read last */
+	FILE	*fid;
+	char	*carry;
+	size_t	len, size;
+} PAR_READER;
+
+	static void	/* room for need more bytes in out->buf */
+out_grow(OUT_TEXT *out, size_t need) {
+	size_t size = out->size ? out->size : 4096;
+
+	while (size < out->len + need)
+		size *= 2;
+	if (size != out->size) {
+		if (!(out->buf = (char *)realloc(out->buf, size)))
+			emess(2, "output buffer allocation failure");
+		out->size = size;
+	}
+}
+	void
+out_puts(OUT_TEXT *out, const char *s) {
+	size_t n;
+
+	if (out->fid) {
+		(void)fputs(s, out->fid);
+		return;
+	}
+	n = strlen(s);
+	out_grow(out, n);
+	memcpy(out->buf + out->len, s, n);
+	out->len += n;
+}
+	void
+out_putc(OUT_TEXT *out, int c) {
+	if (out->fid) {
+		(void)putc(c, out->fid);
+		return;
+	}
+	out_grow(out, 1);
+	out->buf[out->len++] = (char)c;
+}
+	void
+out_printf(OUT_TEXT *out, const char *fmt, ...) {
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	if (out->fid) {
+		(void)vfprintf(out->fid, fmt, args);
+		va_end(args);
+		return;
+	}
+	for (;;) {
+		out_grow(out, 64);
+		n = vsnprintf(out->buf + out->len, out->size - out->len, fmt, args);
+		va_end(args);
+		if (n >= 0 && (size_t)n < out->size - out->len) {
+			out->len += n;
+			return;
+		}
+		out_grow(out, n >= 0 ? (size_t)n + 1 : out->size);
+		va_start(args, fmt);
+	}
+}
+	static void	/* hand each line of c to c->func, as fgets() cuts it */
+run_chunk(PAR_CHUNK *c) {
+	char *line, *p = c->text, *end = c->text + c->len, *nl, *next;
+	size_t n;
+
+	if (!(line = (char *)malloc(c->max_line + 3)))
+		emess(2, "line buffer allocation failure");
+	while (p < end) {
+		nl = (char *)memchr(p, '\n', end - p);
+		next = nl ? nl + 1 : end;
+		n = next - p;
+		if (n > (size_t)c->max_line - 1) /* overlong line */
+			n = c->max_line - 1;
+		memcpy(line, p, n);
+		if (!n || line[n - 1] != '\n')
+			line[n++] = '\n';
+		line[n] = '\0';
+		(*c->func)(line, &c->out);
+		p = next;
+	}
+	free(line);
+}
+	static void	/* run_chunk() under a private context */
+chunk_worker(PAR_CHUNK *c) {
+	projCtx ctx = pj_ctx_alloc(), old;
+
+	if (!ctx)
+		emess(2, "projection context allocation failure");
+	old = pj_set_ctx(ctx);
+	run_chunk(c);
+	(void)pj_set_ctx(old);
+	pj_ctx_free(ctx);
+}
+#ifdef _WIN32
+	static DWORD WINAPI
+chunk_thread(LPVOID arg) {
+	chunk_worker((PAR_CHUNK *)arg);
+	return 0;
+}
+#else
+	static void *
+chunk_thread(void *arg) {
+	chunk_worker((PAR_CHUNK *)arg);
+	return NULL;
+}
+#endif
+	static void	/* double the size of c->text */
+grow_chunk(PAR_CHUNK *c) {
+	c->size *= 2;
+	if (!(c->text = (char *)realloc(c->text, c->size)))
+		emess(2, "input buffer allocation failure");
+}
+	static int	/* fill c with whole lines, 0 at end of input */
+read_chunk(PAR_READER *rd, PAR_CHUNK *c) {
+	size_t got;
+	char *nl;
+
+	while (c->size <= rd->len)
+		grow_chunk(c);
+	memcpy(c->text, rd->carry, rd->len);
+	c->len = rd->len;
+	rd->len = 0;
+	for (;;) {
+		if (c->len == c->size) /* no newline yet, read on */
+			grow_chunk(c);
+		got = fread(c->text + c->len, 1, c->size - c->len, rd->fid);
+		c->len += got;
+		if (!got)	/* the last line may lack its newline */
+			return c->len > 0;
+		for (nl = c->text + c->len; nl > c->text && nl[-1] != '\n'; --nl) ;
+		if (nl > c->text) {
+			rd->len = c->text + c->len - nl;
+			if (rd->len > rd->size) {
+				rd->size = rd->len;
+				if (!(rd->carry = (char *)realloc(rd->carry, rd->size)))
+					emess(2, "input buffer allocation failure");
+			}
+			memcpy(rd->carry, nl, rd->len);
+			c->len = nl - c->text;
+			return 1;
+		}
+	}
+}
+	void
+par_process(FILE *fid, int threads, int max_line,
+	void (*func)(char *line, OUT_TEXT *out)) {
+	PAR_CHUNK chunks[PAR_MAX_THREADS];
+	PAR_READER rd;
+#ifdef _WIN32
+	HANDLE tid[PAR_MAX_THREADS];
+#else
+	pthread_t tid[PAR_MAX_THREADS];
+#endif
+	int started[PAR_MAX_THREADS], i, n;
+
+	if (threads < 1)
+		threads = 1;
+	if (threads > PAR_MAX_THREADS)
+		threads = PAR_MAX_THREADS;
+	memset(&rd, 0, sizeof(rd));
+	rd.fid = fid;
+	memset(chunks, 0, sizeof(chunks));
+	for (i = 0; i < threads; ++i) {
+		chunks[i].size = CHUNK_BYTES;
+		if (!(chunks[i].text = (char *)malloc(CHUNK_BYTES)))
+			emess(2, "input buffer allocation failure");
+		chunks[i].max_line = max_line;
+		chunks[i].func = func;
+	}
+	/* make sure the library is initialized before threads race for it */
+	(void)pj_get_default_ctx();
+
+	/* a round reads a chunk per thread, runs them all and writes the
+	   output in input order */
+	for (;;) {
+		for (n = 0; n < threads && read_chunk(&rd, chunks + n); ++n) ;
+		if (!n)
+			break;
+		for (i = 1; i < n; ++i) {
+#ifdef _WIN32
+			tid[i] = CreateThread(NULL, 0, chunk_thread, chunks + i,
+				0, NULL);
+			started[i] = tid[i] != NULL;
+#else
+			started[i] = !pthread_create(tid + i, NULL, chunk_thread,
+				chunks + i);
+#endif
+		}
+		run_chunk(chunks);
+		for (i = 1; i < n; ++i)
+			if (!started[i])
+				chunk_worker(chunks + i);
+			else {
+#ifdef _WIN32
+				WaitForSingleObject(tid[i], INFINITE);
+				CloseHandle(tid[i]);
+#else
+				pthread_join(tid[i], NULL);
+#endif
+			}
+		for (i = 0; i < n; ++i) {
+			(void)fwrite(chunks[i].out.buf, 1, chunks[i].out.len, stdout);
+			chunks[i].out.len = 0;
+		}
+	}
+	for (i = 0; i < threads; ++i) {
+		free(chunks[i].text);
+		free(chunks[i].out.buf);
+	}
+	free(rd.carry);
+}
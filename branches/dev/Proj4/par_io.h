@@ -0,0 +1,28 @@
+/* Text output buffers and parallel line processing for proj and cs2cs */
+#ifndef PAR_IO_H
+#define PAR_IO_H
+
+#include <stdio.h>
+
+typedef struct {	/* where a line's output goes */
+	FILE	*fid;		/* straight to this stream if not NULL */
+	char	*buf;		/* otherwise appended here */
+	size_t	len, size;
+} OUT_TEXT;
+
+void out_puts(OUT_TEXT *, const char *);
+void out_putc(OUT_TEXT *, int);
+void out_printf(OUT_TEXT *, const char *, ...);
+
+/*
+ * Process all lines of fid with func on up to threads threads (the
+ * calling one included), writing their output to stdout in input
+ * order.  Each line is passed as fgets(line, max_line, fid) would have
+ * read it, always ending in a newline.  Every thread runs under its
+ * own projection context.
+ */
+#define PAR_MAX_THREADS 64
+void par_process(FILE *fid, int threads, int max_line,
+	void (*func)(char *line, OUT_TEXT *out));
+
+#endif /* end PAR_IO_H */
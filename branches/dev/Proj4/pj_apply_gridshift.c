@@ -63,20 +63,166 @@
 #include <string.h>
 #include <math.h>
 
+#define GRID_CONTAINS(ct,lp)                                          \
+    ((ct)->ll.phi <= (lp).phi && (ct)->ll.lam <= (lp).lam            \
+     && PJ_CT_MAX_PHI(ct) >= (lp).phi && PJ_CT_MAX_LAM(ct) >= (lp).lam)
+
+#define GRID_INTERIOR(ct,lp)                                          \
+    ((ct)->ll.phi < (lp).phi && (ct)->ll.lam < (lp).lam              \
+     && PJ_CT_MAX_PHI(ct) > (lp).phi && PJ_CT_MAX_LAM(ct) > (lp).lam)
+
+/* points shifted together by nad_cvt_batch() */
+#define AHEAD_POINTS 16
+
+/* grids pinned in the grid cache by one call */
+typedef struct {
+    PJ_GRIDINFO **grids;
+    int          count, max;
+} grid_pins;
+
 /************************************************************************/
-/*                         pj_apply_gridshift()                         */
+/*                            find_child()                              */
+/*                                                                      */
+/*      First child of gi containing the point, or NULL.  *exclusive    */
+/*      tells whether no earlier child overlaps the one returned.       */
 /************************************************************************/
 
-int pj_apply_gridshift( const char *nadgrids, int inverse, 
-                        long point_count, int point_offset,
-                        double *x, double *y, double *z )
+static PJ_GRIDINFO *find_child( PJ_GRIDINFO *gi, LP input, int *exclusive )
+
+{
+    PJ_GRIDINFO *child;
+
+    if( gi->child_index != NULL )
+    {
+        PJ_GRIDINDEX *index = gi->child_index;
+        const int *cand;
+        int  count, k;
+
+        cand = pj_gridindex_candidates( index, input, &count );
+        for( k = 0; k < count; k++ )
+        {
+            if( GRID_CONTAINS( index->grids[cand[k]]->ct, input ) )
+            {
+                *exclusive = index->exclusive[cand[k]];
+                return index->grids[cand[k]];
+            }
+        }
+        return NULL;
+    }
+
+    *exclusive = 0;
+    for( child = gi->child; child != NULL; child = child->next )
+    {
+        if( GRID_CONTAINS( child->ct, input ) )
+            return child;
+    }
+    return NULL;
+}
+
+/************************************************************************/
+/*                           in_last_grid()                             */
+/*                                                                      */
+/*      Is ct, found in parent for an earlier point, certain to be the  */
+/*      table the search would pick for lp?  Both must be exclusive.    */
+/************************************************************************/
+
+static int in_last_grid( PJ_GRIDINFO *parent, struct CTABLE *ct, LP lp )
+
+{
+    int exclusive;
+
+    if( !GRID_INTERIOR( ct, lp ) || !GRID_INTERIOR( parent->ct, lp ) )
+        return 0;
+
+    /* the parent itself is only right away from all its children */
+    if( ct == parent->ct && parent->child != NULL )
+        return find_child( parent, lp, &exclusive ) == NULL;
+
+    return 1;
+}
+
+/************************************************************************/
+/*                             use_grid()                               */
+/*                                                                      */
+/*      Make sure the data of gi is loaded and, when there is a grid    */
+/*      cache budget (pins != NULL), that it stays loaded until the     */
+/*      end of the call.                                                */
+/************************************************************************/
+
+static int use_grid( PJ_GRIDINFO *gi, grid_pins *pins )
+
+{
+    int i, loaded;
+
+    if( pins == NULL )
+    {
+        if( nad_ctable_loaded( gi->ct ) != NULL )
+            return 1;
+
+        pj_acquire_lock();
+        loaded = gi->ct->cvs != NULL || pj_gridinfo_load( gi );
+        pj_release_lock();
+        return loaded;
+    }
+
+    for( i = 0; i < pins->count; i++ )
+    {
+        if( pins->grids[i] == gi )
+            return 1;
+    }
+
+    if( pins->count == pins->max )
+    {
+        PJ_GRIDINFO **new_grids;
+        int new_max = pins->max + 16;
+
+        new_grids = (PJ_GRIDINFO **) pj_malloc( sizeof(void*) * new_max );
+        if( new_grids == NULL )
+            return 0;
+        if( pins->grids != NULL )
+        {
+            memcpy( new_grids, pins->grids, sizeof(void*) * pins->count );
+            pj_dalloc( pins->grids );
+        }
+        pins->grids = new_grids;
+        pins->max = new_max;
+    }
+
+    pj_acquire_lock();
+    loaded = pj_gridcache_pin( gi );
+    pj_release_lock();
+
+    if( loaded )
+        pins->grids[pins->count++] = gi;
+    return loaded;
+}
+
+/************************************************************************/
+/*                          apply_gridshift()                           */
+/*                                                                      */
+/*      Each point uses the first table in the nadgrids list that       */
+/*      contains it and gives a result, refined to its first child     */
+/*      containing the point if it has any.  Tables are found through   */
+/*      bucket indexes, and the table used for the previous point is    */
+/*      tried first when it is certain to be the one the search would   */
+/*      return.                                                         */
+/************************************************************************/
+
+static int apply_gridshift( const char *nadgrids, int inverse, 
+                            long point_count, int point_offset,
+                            double *x, double *y, grid_pins *pins )
 
 {
     int grid_count = 0;
     PJ_GRIDINFO   **tables;
-    int  i;
-    int debug_flag = getenv( "PROJ_DEBUG" ) != NULL;
-    static int debug_count = 0;
+    PJ_GRIDINDEX  *index;
+    PJ_GRIDINFO   *last_parent = NULL;
+    struct CTABLE *last_ct = NULL;
+    LP   ahead[AHEAD_POINTS];
+    long i, ahead_start = 0, ahead_end = 0;
+    int  n;
+    projCtx ctx = pj_get_ctx();
+    int debug_flag = ctx->debug_level;
 
     pj_errno = 0;
 
@@ -84,56 +230,101 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
     if( tables == NULL || grid_count == 0 )
         return pj_errno;
 
+    if( ctx->last_nadgrids_index == NULL )
+        ctx->last_nadgrids_index = pj_gridindex_build( tables, grid_count );
+    index = ctx->last_nadgrids_index;
+
     for( i = 0; i < point_count; i++ )
     {
         long io = i * point_offset;
         LP   input, output;
-        int  itable;
+        const int *cand = NULL;
+        int  itable, k, count;
 
         input.phi = y[io];
         input.lam = x[io];
         output.phi = HUGE_VAL;
         output.lam = HUGE_VAL;
 
+/* -------------------------------------------------------------------- */
+/*      Points of a batch tend to follow each other through the same    */
+/*      (sub)grid.  The last one used is the first match for points     */
+/*      strictly inside it when no earlier table overlaps it, so the    */
+/*      search can be skipped, and runs of such points can go through   */
+/*      nad_cvt_batch() together.                                       */
+/* -------------------------------------------------------------------- */
+        if( last_ct != NULL && i >= ahead_end && !debug_flag )
+        {
+            /* shift the run of points ahead in this grid in one go */
+            for( n = 0; n < AHEAD_POINTS && i + n < point_count; n++ )
+            {
+                ahead[n].lam = x[(i + n) * point_offset];
+                ahead[n].phi = y[(i + n) * point_offset];
+                if( !in_last_grid( last_parent, last_ct, ahead[n] ) )
+                    break;
+            }
+            nad_cvt_batch( ahead, n, inverse, last_ct );
+            ahead_start = i;
+            ahead_end = i + n;
+        }
+
+        if( i < ahead_end )
+            output = ahead[i - ahead_start];
+        else if( last_ct != NULL
+                 && in_last_grid( last_parent, last_ct, input ) )
+            output = nad_cvt( input, inverse, last_ct );
+
+        if( output.lam != HUGE_VAL )
+        {
+            if( debug_flag && ctx->debug_count++ < 20 )
+                fprintf( stderr,
+                         "pj_apply_gridshift(): used %s\n",
+                         last_ct->id );
+            y[io] = output.phi;
+            x[io] = output.lam;
+            continue;
+        }
+
+        if( index != NULL )
+            cand = pj_gridindex_candidates( index, input, &count );
+        else
+            count = grid_count;
+
         /* keep trying till we find a table that works */
-        for( itable = 0; itable < grid_count; itable++ )
+        for( k = 0; k < count; k++ )
         {
-            PJ_GRIDINFO *gi = tables[itable];
-            struct CTABLE *ct = gi->ct;
+            PJ_GRIDINFO *gi;
+            struct CTABLE *ct;
+            int exclusive;
+
+            itable = cand != NULL ? cand[k] : k;
+            gi = tables[itable];
+            ct = gi->ct;
 
             /* skip tables that don't match our point at all.  */
-            if( ct->ll.phi > input.phi || ct->ll.lam > input.lam
-                || ct->ll.phi + (ct->lim.phi-1) * ct->del.phi < input.phi
-                || ct->ll.lam + (ct->lim.lam-1) * ct->del.lam < input.lam )
+            if( !GRID_CONTAINS( ct, input ) )
                 continue;
 
+            exclusive = index != NULL && index->exclusive[itable];
+
             /* If we have child nodes, check to see if any of them apply. */
             if( gi->child != NULL )
             {
-                PJ_GRIDINFO *child;
-
-                for( child = gi->child; child != NULL; child = child->next )
-                {
-                    struct CTABLE *ct1 = child->ct;
-
-                    if( ct1->ll.phi > input.phi || ct1->ll.lam > input.lam
-                      || ct1->ll.phi+(ct1->lim.phi-1)*ct1->del.phi < input.phi
-                      || ct1->ll.lam+(ct1->lim.lam-1)*ct1->del.lam < input.lam)
-                        continue;
-
-                    break;
-                }
+                int child_exclusive;
+                PJ_GRIDINFO *child = find_child( gi, input, 
+                                                 &child_exclusive );
 
                 /* we found a more refined child node to use */
                 if( child != NULL )
                 {
                     gi = child;
                     ct = child->ct;
+                    exclusive = exclusive && child_exclusive;
                 }
             }
 
             /* load the grid shift info if we don't have it. */
-            if( ct->cvs == NULL && !pj_gridinfo_load( gi ) )
+            if( !use_grid( gi, pins ) )
             {
                 pj_errno = -38;
                 return pj_errno;
@@ -142,10 +333,13 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
             output = nad_cvt( input, inverse, ct );
             if( output.lam != HUGE_VAL )
             {
-                if( debug_flag && debug_count++ < 20 )
+                if( debug_flag && ctx->debug_count++ < 20 )
                     fprintf( stderr,
                              "pj_apply_gridshift(): used %s\n",
                              ct->id );
+
+                last_parent = tables[itable];
+                last_ct = exclusive ? ct : NULL;
                 break;
             }
         }
@@ -176,3 +370,34 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
     return 0;
 }
 
+/************************************************************************/
+/*                         pj_apply_gridshift()                         */
+/************************************************************************/
+
+int pj_apply_gridshift( const char *nadgrids, int inverse, 
+                        long point_count, int point_offset,
+                        double *x, double *y, double *z )
+
+{
+    grid_pins pins;
+    int  result, i;
+
+    if( !pj_gridcache_enabled() )
+        return apply_gridshift( nadgrids, inverse, point_count, point_offset,
+                                x, y, NULL );
+
+    memset( &pins, 0, sizeof(pins) );
+    result = apply_gridshift( nadgrids, inverse, point_count, point_offset,
+                              x, y, &pins );
+
+    if( pins.count > 0 )
+    {
+        pj_acquire_lock();
+        for( i = 0; i < pins.count; i++ )
+            pj_gridcache_unpin( pins.grids[i] );
+        pj_release_lock();
+    }
+    pj_dalloc( pins.grids );
+
+    return result;
+}
@@ -0,0 +1,376 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Approximate transformations over a bounded area using the
+ *           bivariate Chebyshev fitting behind proj -T.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * pj_approx_create() samples the exact src -> dst transformation at the
+ * Chebyshev nodes of a box given in source coordinates, fits a series
+ * with mk_cheby_fit() and checks it against the exact transformation on
+ * a grid finer than the nodes, raising the degree until the requested
+ * tolerance (in destination units) is met.
+ *
+ * pj_approx_transform() then evaluates the series with bcheval() for the
+ * points inside the box and sends the others through the exact prepared
+ * pipeline.  Heights are left untouched inside the box.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+#include <errno.h>
+
+#define CHECK_SIDE      25      /* check grid, nodes fall between */
+#define MAX_DEGREE      40
+
+static const int degrees[] = { 6, 9, 12, 16, 20, 25, 32, MAX_DEGREE, 0 };
+
+struct PJ_APPROX {
+    struct PJ_PIPELINE *exact;
+    Tseries *series;
+    double  west, south, east, north;
+    double  max_error;          /* measured on the check grid */
+};
+
+/************************************************************************/
+/*                            free_series()                             */
+/************************************************************************/
+
+static void free_series( Tseries *T )
+
+{
+    int i;
+
+    if( T == NULL )
+        return;
+    for( i = 0; i <= T->mu; i++ )
+        if( T->cu[i].c )
+            pj_dalloc( T->cu[i].c );
+    for( i = 0; i <= T->mv; i++ )
+        if( T->cv[i].c )
+            pj_dalloc( T->cv[i].c );
+    pj_dalloc( T->cu );
+    pj_dalloc( T->cv );
+    pj_dalloc( T );
+}
+
+/************************************************************************/
+/*                            fit_series()                              */
+/*                                                                      */
+/*      Fit a degree n series and return it with the largest error      */
+/*      found on the check grid, or NULL if the exact transformation    */
+/*      fails somewhere in the box.                                     */
+/************************************************************************/
+
+static Tseries *fit_series( struct PJ_APPROX *A, int n, double tolerance,
+                            double *max_error )
+
+{
+    projUV   low, upp, resid, **w;
+    double   x[CHECK_SIDE * CHECK_SIDE], y[CHECK_SIDE * CHECK_SIDE];
+    double   err, d;
+    Tseries  *T;
+    int      i, j;
+
+    low.u = A->west;
+    low.v = A->south;
+    upp.u = A->east;
+    upp.v = A->north;
+
+/* -------------------------------------------------------------------- */
+/*      Exact values at the nodes, a row at a time.                     */
+/* -------------------------------------------------------------------- */
+    if( !(w = (projUV **) vector2( n, n, sizeof(projUV) )) )
+        return NULL;
+
+    for( i = 0; i < n; i++ )
+    {
+        for( j = 0; j < n; j++ )
+        {
+            x[j] = bch_node( low.u, upp.u, i, n );
+            y[j] = bch_node( low.v, upp.v, j, n );
+        }
+        if( pj_transform_run( A->exact, n, 1, x, y, NULL ) != 0 )
+            break;
+        for( j = 0; j < n; j++ )
+        {
+            if( x[j] == HUGE_VAL )
+                break;
+            w[i][j].u = x[j];
+            w[i][j].v = y[j];
+        }
+        if( j < n )
+            break;
+    }
+
+    T = NULL;
+    if( i == n )
+        T = mk_cheby_fit( low, upp, 0.5 * tolerance, &resid, w, n, n, 0 );
+    freev2( (void **) w, n );
+    if( T == NULL )
+        return NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Compare with the exact transformation between the nodes.        */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < CHECK_SIDE; i++ )
+    {
+        for( j = 0; j < CHECK_SIDE; j++ )
+        {
+            x[i * CHECK_SIDE + j] = low.u + (upp.u - low.u) * i
+                / (CHECK_SIDE - 1);
+            y[i * CHECK_SIDE + j] = low.v + (upp.v - low.v) * j
+                / (CHECK_SIDE - 1);
+        }
+    }
+    if( pj_transform_run( A->exact, CHECK_SIDE * CHECK_SIDE, 1,
+                          x, y, NULL ) != 0 )
+    {
+        free_series( T );
+        return NULL;
+    }
+
+    err = 0.0;
+    for( i = 0; i < CHECK_SIDE; i++ )
+    {
+        for( j = 0; j < CHECK_SIDE; j++ )
+        {
+            projUV in, out;
+
+            in.u = low.u + (upp.u - low.u) * i / (CHECK_SIDE - 1);
+            in.v = low.v + (upp.v - low.v) * j / (CHECK_SIDE - 1);
+            out = bcheval( in, T );
+            if( (d = fabs( out.u - x[i * CHECK_SIDE + j] )) > err )
+                err = d;
+            if( (d = fabs( out.v - y[i * CHECK_SIDE + j] )) > err )
+                err = d;
+        }
+    }
+
+    *max_error = err;
+    return T;
+}
+
+/************************************************************************/
+/*                          pj_approx_create()                          */
+/*                                                                      */
+/*      The box is in source coordinates (radians for lat/long).        */
+/*      Returns NULL with pj_errno set if no series of acceptable       */
+/*      degree meets the tolerance.                                     */
+/************************************************************************/
+
+struct PJ_APPROX *pj_approx_create( PJ *srcdefn, PJ *dstdefn,
+                                    double west, double south,
+                                    double east, double north,
+                                    double tolerance )
+
+{
+    struct PJ_APPROX *A;
+    double err;
+    int    k;
+
+    pj_errno = 0;
+
+    if( west >= east || south >= north || tolerance <= 0.0 )
+    {
+        pj_errno = -47;
+        return NULL;
+    }
+
+    A = (struct PJ_APPROX *) pj_malloc( sizeof(struct PJ_APPROX) );
+    if( A == NULL )
+    {
+        pj_errno = ENOMEM;
+        return NULL;
+    }
+    memset( A, 0, sizeof(struct PJ_APPROX) );
+    A->west = west;
+    A->south = south;
+    A->east = east;
+    A->north = north;
+
+    /* only plane coordinates are approximated */
+    if( srcdefn->is_geocent || dstdefn->is_geocent
+        || (A->exact = pj_transform_prepare( srcdefn, dstdefn )) == NULL )
+    {
+        if( pj_errno == 0 )
+            pj_errno = PJD_ERR_GEOCENTRIC;
+        pj_approx_free( A );
+        return NULL;
+    }
+
+    for( k = 0; degrees[k] != 0; k++ )
+    {
+        Tseries *T = fit_series( A, degrees[k], tolerance, &err );
+
+        if( T == NULL )
+            break;
+        if( err <= tolerance )
+        {
+            A->series = T;
+            A->max_error = err;
+            pj_errno = 0;
+            return A;
+        }
+        free_series( T );
+    }
+
+    pj_approx_free( A );
+    pj_errno = -47;
+    return NULL;
+}
+
+/************************************************************************/
+/*                        pj_approx_transform()                         */
+/*                                                                      */
+/*      Same arguments and results as pj_transform().                   */
+/************************************************************************/
+
+int pj_approx_transform( struct PJ_APPROX *A, long point_count,
+                         int point_offset, double *x, double *y, double *z )
+
+{
+    long   i, io, n_out = 0, *index = NULL;
+    double *ox = NULL, *oy = NULL, *oz = NULL;
+    int    err = 0;
+
+    pj_errno = 0;
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+#define INSIDE(io) (x[io] >= A->west && x[io] <= A->east \
+                    && y[io] >= A->south && y[io] <= A->north)
+
+/* -------------------------------------------------------------------- */
+/*      Gather the points outside the box for the exact path.           */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < point_count; i++ )
+    {
+        io = i * point_offset;
+        if( x[io] != HUGE_VAL && !INSIDE(io) )
+            n_out++;
+    }
+
+    if( n_out == point_count )
+        return pj_transform_run( A->exact, point_count, point_offset,
+                                 x, y, z );
+
+    if( n_out > 0 )
+    {
+        index = (long *) pj_malloc( sizeof(long) * n_out );
+        ox = (double *) pj_malloc( sizeof(double) * n_out * 3 );
+        if( index == NULL || ox == NULL )
+        {
+            pj_dalloc( index );
+            pj_dalloc( ox );
+            pj_errno = ENOMEM;
+            return ENOMEM;
+        }
+        oy = ox + n_out;
+        oz = z != NULL ? oy + n_out : NULL;
+
+        for( i = 0, n_out = 0; i < point_count; i++ )
+        {
+            io = i * point_offset;
+            if( x[io] == HUGE_VAL || INSIDE(io) )
+                continue;
+            index[n_out] = io;
+            ox[n_out] = x[io];
+            oy[n_out] = y[io];
+            if( oz != NULL )
+                oz[n_out] = z[io];
+            n_out++;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Series for the points inside.                                   */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < point_count; i++ )
+    {
+        projUV in, out;
+
+        io = i * point_offset;
+        if( x[io] == HUGE_VAL || !INSIDE(io) )
+            continue;
+        in.u = x[io];
+        in.v = y[io];
+        out = bcheval( in, A->series );
+        x[io] = out.u;
+        y[io] = out.v;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Exact transformation of the rest, written back in place.  The   */
+/*      errors that fail a point rather than the call are those of a    */
+/*      call on all the points, even when only one is outside.          */
+/* -------------------------------------------------------------------- */
+    if( n_out > 0 )
+    {
+        err = pj_transform_run_part( A->exact, n_out, 1, ox, oy, oz,
+                                     point_count );
+        for( i = 0; i < n_out; i++ )
+        {
+            x[index[i]] = ox[i];
+            y[index[i]] = oy[i];
+            if( oz != NULL )
+                z[index[i]] = oz[i];
+        }
+        pj_dalloc( index );
+        pj_dalloc( ox );
+    }
+
+    pj_errno = err;
+    return err;
+}
+
+/************************************************************************/
+/*                          pj_approx_error()                           */
+/*                                                                      */
+/*      Largest difference from the exact transformation measured       */
+/*      while building the approximation.                               */
+/************************************************************************/
+
+double pj_approx_error( struct PJ_APPROX *A )
+
+{
+    return A->max_error;
+}
+
+/************************************************************************/
+/*                           pj_approx_free()                           */
+/************************************************************************/
+
+void pj_approx_free( struct PJ_APPROX *A )
+
+{
+    if( A == NULL )
+        return;
+    free_series( A->series );
+    pj_transform_free( A->exact );
+    pj_dalloc( A );
+}
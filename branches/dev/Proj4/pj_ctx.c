@@ -0,0 +1,274 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Projection contexts: per caller error state, grid list cache
+ *           and debug settings, so projections can run on several threads.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * Every library call runs against the "current" context of the calling
+ * thread.  Threads that never enter a context use the default context,
+ * whose error code is the historical global pj_errno, so single threaded
+ * applications see no difference.  The *_ctx() entry points make the
+ * given context current for the duration of the call.
+ *
+ * The loaded grid shift files themselves are shared by all contexts and
+ * guarded by pj_acquire_lock()/pj_release_lock(); only the parsed
+ * +nadgrids list is kept per context.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
+static struct projCtx_t default_ctx;
+
+static void pj_ctx_init( projCtx ctx );
+
+#ifdef _WIN32
+static CRITICAL_SECTION core_lock;
+static DWORD ctx_key = TLS_OUT_OF_INDEXES;
+
+static void pj_threads_init( void )
+{
+    /* not itself thread safe, the first call should be made before
+       worker threads are started */
+    if( ctx_key == TLS_OUT_OF_INDEXES )
+    {
+        InitializeCriticalSection( &core_lock );
+        pj_ctx_init( &default_ctx );
+        ctx_key = TlsAlloc();
+    }
+}
+#  define GET_THREAD_CTX()      ((projCtx) TlsGetValue( ctx_key ))
+#  define SET_THREAD_CTX(ctx)   TlsSetValue( ctx_key, ctx )
+#  define LOCK()                EnterCriticalSection( &core_lock )
+#  define UNLOCK()              LeaveCriticalSection( &core_lock )
+#else
+static pthread_mutex_t core_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ctx_key;
+static pthread_once_t ctx_key_once = PTHREAD_ONCE_INIT;
+
+static void pj_make_ctx_key( void )
+{
+    pj_ctx_init( &default_ctx );
+    pthread_key_create( &ctx_key, NULL );
+}
+
+static void pj_threads_init( void )
+{
+    pthread_once( &ctx_key_once, pj_make_ctx_key );
+}
+#  if defined(__GNUC__) && !defined(__APPLE__)
+/* native thread locals are much cheaper than pthread_getspecific() and
+   pj_errno is touched several times per point */
+static __thread projCtx thread_ctx = NULL;
+#    define GET_THREAD_CTX()    thread_ctx
+#    define SET_THREAD_CTX(ctx) (thread_ctx = (ctx))
+#  else
+#    define GET_THREAD_CTX()    ((projCtx) pthread_getspecific( ctx_key ))
+#    define SET_THREAD_CTX(ctx) pthread_setspecific( ctx_key, ctx )
+#  endif
+#  define LOCK()                pthread_mutex_lock( &core_lock )
+#  define UNLOCK()              pthread_mutex_unlock( &core_lock )
+#endif
+
+/************************************************************************/
+/*                   pj_acquire_lock()/pj_release_lock()                */
+/*                                                                      */
+/*      Process wide lock around the shared grid shift catalog.         */
+/************************************************************************/
+
+void pj_acquire_lock()
+
+{
+    pj_threads_init();
+    LOCK();
+}
+
+void pj_release_lock()
+
+{
+    UNLOCK();
+}
+
+/************************************************************************/
+/*                            pj_ctx_init()                             */
+/************************************************************************/
+
+static void pj_ctx_init( projCtx ctx )
+
+{
+    memset( ctx, 0, sizeof(struct projCtx_t) );
+    ctx->debug_level = getenv( "PROJ_DEBUG" ) != NULL;
+}
+
+/************************************************************************/
+/*                         pj_get_default_ctx()                         */
+/************************************************************************/
+
+projCtx pj_get_default_ctx()
+
+{
+    pj_threads_init();
+    return &default_ctx;
+}
+
+/************************************************************************/
+/*                             pj_get_ctx()                             */
+/*                                                                      */
+/*      Context of the calling thread.                                  */
+/************************************************************************/
+
+projCtx pj_get_ctx()
+
+{
+    projCtx ctx;
+
+    pj_threads_init();
+    ctx = GET_THREAD_CTX();
+    return ctx != NULL ? ctx : &default_ctx;
+}
+
+/************************************************************************/
+/*                            pj_set_ctx()                              */
+/*                                                                      */
+/*      Make ctx current for the calling thread, returning the          */
+/*      previous one so it can be restored.  NULL selects the default.  */
+/************************************************************************/
+
+projCtx pj_set_ctx( projCtx ctx )
+
+{
+    projCtx old = pj_get_ctx();
+
+    SET_THREAD_CTX( ctx == &default_ctx ? NULL : ctx );
+    return old;
+}
+
+/************************************************************************/
+/*                           pj_ctx_alloc()                             */
+/************************************************************************/
+
+projCtx pj_ctx_alloc()
+
+{
+    projCtx ctx = (projCtx) pj_malloc( sizeof(struct projCtx_t) );
+
+    if( ctx != NULL )
+        pj_ctx_init( ctx );
+    return ctx;
+}
+
+/************************************************************************/
+/*                            pj_ctx_free()                             */
+/************************************************************************/
+
+void pj_ctx_free( projCtx ctx )
+
+{
+    if( ctx == NULL || ctx == &default_ctx )
+        return;
+
+    pj_gridlist_ctx_clear( ctx );
+    pj_dalloc( ctx );
+}
+
+/************************************************************************/
+/*                 pj_ctx_get_debug()/pj_ctx_set_debug()                */
+/************************************************************************/
+
+int pj_ctx_get_debug( projCtx ctx )
+
+{
+    return ctx->debug_level;
+}
+
+void pj_ctx_set_debug( projCtx ctx, int debug_level )
+
+{
+    ctx->debug_level = debug_level;
+}
+
+/************************************************************************/
+/*                 Context taking versions of the API.                  */
+/************************************************************************/
+
+PJ *pj_init_ctx( projCtx ctx, int argc, char **argv )
+
+{
+    projCtx old = pj_set_ctx( ctx );
+    PJ *result = pj_init( argc, argv );
+
+    pj_set_ctx( old );
+    return result;
+}
+
+PJ *pj_init_plus_ctx( projCtx ctx, const char *definition )
+
+{
+    projCtx old = pj_set_ctx( ctx );
+    PJ *result = pj_init_plus( definition );
+
+    pj_set_ctx( old );
+    return result;
+}
+
+XY pj_fwd_ctx( projCtx ctx, LP lp, PJ *P )
+
+{
+    projCtx old = pj_set_ctx( ctx );
+    XY xy = pj_fwd( lp, P );
+
+    pj_set_ctx( old );
+    return xy;
+}
+
+LP pj_inv_ctx( projCtx ctx, XY xy, PJ *P )
+
+{
+    projCtx old = pj_set_ctx( ctx );
+    LP lp = pj_inv( xy, P );
+
+    pj_set_ctx( old );
+    return lp;
+}
+
+int pj_transform_ctx( projCtx ctx, PJ *src, PJ *dst,
+                      long point_count, int point_offset,
+                      double *x, double *y, double *z )
+
+{
+    projCtx old = pj_set_ctx( ctx );
+    int result = pj_transform( src, dst, point_count, point_offset, x, y, z );
+
+    pj_set_ctx( old );
+    return result;
+}
@@ -48,6 +48,56 @@
 /* SEC_TO_RAD = Pi/180/3600 */
 #define SEC_TO_RAD 4.84813681109535993589914102357e-6
 
+/************************************************************************/
+/*                          set_datum_matrices()                        */
+/*                                                                      */
+/*      Precompute datum_params as the affine maps that                 */
+/*      pj_geocentric_to_wgs84() and pj_geocentric_from_wgs84()         */
+/*      apply, so pj_datum_transform() can compose the two into one     */
+/*      without redoing this per call.  Datums without parameters get   */
+/*      the identity.                                                   */
+/************************************************************************/
+
+static void set_datum_matrices( PJ *projdef )
+
+{
+    double *to = projdef->datum_to_wgs84, *from = projdef->datum_from_wgs84;
+    double dx = 0, dy = 0, dz = 0, rx = 0, ry = 0, rz = 0, m = 1;
+    int    i;
+
+    if( projdef->datum_type == PJD_3PARAM
+        || projdef->datum_type == PJD_7PARAM )
+    {
+        dx = projdef->datum_params[0];
+        dy = projdef->datum_params[1];
+        dz = projdef->datum_params[2];
+    }
+    if( projdef->datum_type == PJD_7PARAM )
+    {
+        rx = projdef->datum_params[3];
+        ry = projdef->datum_params[4];
+        rz = projdef->datum_params[5];
+        m = projdef->datum_params[6];
+    }
+
+    /* to WGS84: M * R * p + D */
+    to[0] = m;       to[1] = -m * rz; to[2]  = m * ry;  to[3]  = dx;
+    to[4] = m * rz;  to[5] = m;       to[6]  = -m * rx; to[7]  = dy;
+    to[8] = -m * ry; to[9] = m * rx;  to[10] = m;       to[11] = dz;
+
+    /* from WGS84: transpose(R) * (p - D) / M */
+    from[0] = 1;   from[1] = rz;  from[2]  = -ry;
+    from[4] = -rz; from[5] = 1;   from[6]  = rx;
+    from[8] = ry;  from[9] = -rx; from[10] = 1;
+    for( i = 0; i < 12; i += 4 )
+    {
+        from[i] /= m;
+        from[i+1] /= m;
+        from[i+2] /= m;
+        from[i+3] = -(from[i] * dx + from[i+1] * dy + from[i+2] * dz);
+    }
+}
+
 /************************************************************************/
 /*                            pj_datum_set()                            */
 /************************************************************************/
@@ -150,5 +200,7 @@ int pj_datum_set(paralist *pl, PJ *projdef)
            PJD_WGS84 if shifts are all zero, and ellipsoid is WGS84 or GRS80 */
     }
 
+    set_datum_matrices( projdef );
+
     return 0;
 }
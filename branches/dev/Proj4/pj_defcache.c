@@ -0,0 +1,425 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Shared, reference counted projections keyed by their
+ *           definition string, see pj_init_plus_cached().
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * Callers that build the same projection over and over (one per tile
+ * request, one per JNI call) get it from pj_init_plus_cached() and hand
+ * it back with pj_free_cached() instead of pj_init_plus() / pj_free().  The
+ * cache hands out the same PJ to every holder, so a cached PJ must be
+ * treated as read only and never passed to pj_free().
+ *
+ * Definitions are looked up by the argument list pj_init_plus() would
+ * see: white space and anything outside a "+" argument are dropped, and
+ * unless an +init= file is involved (where argument order decides what
+ * overrides the file) the arguments are put in a stable order by name,
+ * so "+proj=merc +a=1" and "+a=1  +proj=merc" share one entry.
+ *
+ * Unreferenced entries stay in the cache for the next caller; once there
+ * are more than the limit the least recently released ones are freed.
+ * Entries still held are never freed, so the cache can temporarily grow
+ * past the limit.  Everything is done under pj_acquire_lock(), except
+ * pj_init_plus() and pj_free() themselves.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+
+#define HASH_SIZE       128     /* power of two */
+#define DEFAULT_LIMIT   32
+#define MAX_ARG         200
+
+typedef struct DEFCACHE_ENTRY {
+    struct DEFCACHE_ENTRY *hash_next;
+    struct DEFCACHE_ENTRY *lru_prev, *lru_next;
+    PJ          *pj;
+    unsigned    hash;
+    int         refs;
+    char        key[1];
+} DEFCACHE_ENTRY;
+
+static DEFCACHE_ENTRY *buckets[HASH_SIZE];
+static DEFCACHE_ENTRY *lru_head = NULL, *lru_tail = NULL;
+
+static int  limit = DEFAULT_LIMIT;
+static int  entry_count = 0;
+static long hit_count = 0;
+static long miss_count = 0;
+
+/************************************************************************/
+/*                              key_hash()                              */
+/************************************************************************/
+
+static unsigned key_hash( const char *key )
+
+{
+    unsigned h = 2166136261u;
+
+    while( *key )
+        h = (h ^ (unsigned char) *key++) * 16777619u;
+    return h;
+}
+
+/************************************************************************/
+/*                            name_cmp()                                */
+/*                                                                      */
+/*      Compare two arguments by name only, "k=1" and "k=2" are equal.  */
+/************************************************************************/
+
+static int name_cmp( const char *a, const char *b )
+
+{
+    for( ; *a == *b; a++, b++ )
+        if( *a == '\0' || *a == '=' )
+            return 0;
+
+    return (*a == '=' ? 0 : (unsigned char) *a)
+        - (*b == '=' ? 0 : (unsigned char) *b);
+}
+
+/************************************************************************/
+/*                           canonical_key()                            */
+/*                                                                      */
+/*      The normalized form of definition, allocated.  The argument     */
+/*      split follows pj_init_plus().                                   */
+/************************************************************************/
+
+static char *canonical_key( const char *definition )
+
+{
+    char    *copy, *key, *argv[MAX_ARG], *t;
+    int     argc = 0, has_init = 0, i, j;
+    size_t  len = strlen( definition );
+
+    if( (copy = (char *) pj_malloc( len + 1 )) == NULL )
+        return NULL;
+    memcpy( copy, definition, len + 1 );
+
+    for( i = 0; copy[i] != '\0'; i++ )
+    {
+        if( copy[i] == '+' && (i == 0 || copy[i-1] == '\0') )
+        {
+            if( argc == MAX_ARG )
+            {
+                pj_dalloc( copy );
+                return NULL;
+            }
+            argv[argc++] = copy + i + 1;
+        }
+        else if( copy[i] == ' ' || copy[i] == '\t' || copy[i] == '\n' )
+            copy[i] = '\0';
+    }
+
+    for( i = 0; i < argc; i++ )
+        if( strncmp( argv[i], "init=", 5 ) == 0 )
+            has_init = 1;
+
+    /* insertion sort, which keeps repeated names in their order and so
+       keeps the first one the one pj_param() finds */
+    if( !has_init )
+    {
+        for( i = 1; i < argc; i++ )
+        {
+            t = argv[i];
+            for( j = i; j > 0 && name_cmp( argv[j-1], t ) > 0; j-- )
+                argv[j] = argv[j-1];
+            argv[j] = t;
+        }
+    }
+
+    if( (key = (char *) pj_malloc( len + 2 )) != NULL )
+    {
+        key[0] = '\0';
+        for( i = 0, t = key; i < argc; i++ )
+        {
+            if( i > 0 )
+                *t++ = ' ';
+            strcpy( t, argv[i] );
+            t += strlen( t );
+        }
+    }
+
+    pj_dalloc( copy );
+    return key;
+}
+
+/************************************************************************/
+/*                      lru_unlink() / lru_push()                       */
+/************************************************************************/
+
+static void lru_unlink( DEFCACHE_ENTRY *e )
+
+{
+    if( e->lru_prev != NULL )
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        lru_head = e->lru_next;
+    if( e->lru_next != NULL )
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void lru_push( DEFCACHE_ENTRY *e )
+
+{
+    e->lru_prev = NULL;
+    e->lru_next = lru_head;
+    if( lru_head != NULL )
+        lru_head->lru_prev = e;
+    else
+        lru_tail = e;
+    lru_head = e;
+}
+
+/************************************************************************/
+/*                               lookup()                               */
+/************************************************************************/
+
+static DEFCACHE_ENTRY *lookup( const char *key, unsigned hash )
+
+{
+    DEFCACHE_ENTRY *e;
+
+    for( e = buckets[hash & (HASH_SIZE-1)]; e != NULL; e = e->hash_next )
+        if( e->hash == hash && strcmp( e->key, key ) == 0 )
+            return e;
+    return NULL;
+}
+
+/************************************************************************/
+/*                               trim()                                 */
+/*                                                                      */
+/*      Take unreferenced entries, oldest first, out of the cache until */
+/*      it is within the limit.  They are returned chained through      */
+/*      hash_next, for the caller to free once the lock is released.    */
+/************************************************************************/
+
+static DEFCACHE_ENTRY *trim( void )
+
+{
+    DEFCACHE_ENTRY *e, *prev, **link, *victims = NULL;
+
+    for( e = lru_tail; e != NULL && entry_count > limit; e = prev )
+    {
+        prev = e->lru_prev;
+        if( e->refs > 0 )
+            continue;
+
+        for( link = buckets + (e->hash & (HASH_SIZE-1)); *link != e;
+             link = &(*link)->hash_next ) {}
+        *link = e->hash_next;
+        lru_unlink( e );
+        entry_count--;
+
+        e->hash_next = victims;
+        victims = e;
+    }
+    return victims;
+}
+
+/************************************************************************/
+/*                           free_entries()                             */
+/************************************************************************/
+
+static void free_entries( DEFCACHE_ENTRY *e )
+
+{
+    DEFCACHE_ENTRY *next;
+
+    for( ; e != NULL; e = next )
+    {
+        next = e->hash_next;
+        pj_free( e->pj );
+        pj_dalloc( e );
+    }
+}
+
+/************************************************************************/
+/*                        pj_init_plus_cached()                         */
+/*                                                                      */
+/*      Like pj_init_plus(), but returns the cached projection for an   */
+/*      equivalent definition if there is one.  Release the result      */
+/*      with pj_free_cached().                                          */
+/************************************************************************/
+
+PJ *pj_init_plus_cached( const char *definition )
+
+{
+    DEFCACHE_ENTRY *e, *found, *victims;
+    char     *key;
+    unsigned hash;
+    size_t   key_len;
+    PJ       *pj;
+
+    if( (key = canonical_key( definition )) == NULL )
+    {
+        /* out of memory or too many arguments; let pj_init_plus() say
+           which */
+        pj_acquire_lock();
+        miss_count++;
+        pj_release_lock();
+        return pj_init_plus( definition );
+    }
+    hash = key_hash( key );
+
+    pj_acquire_lock();
+    if( (e = lookup( key, hash )) != NULL )
+    {
+        e->refs++;
+        hit_count++;
+        if( e != lru_head )
+        {
+            lru_unlink( e );
+            lru_push( e );
+        }
+        pj_release_lock();
+        pj_dalloc( key );
+        return e->pj;
+    }
+    miss_count++;
+    pj_release_lock();
+
+/* -------------------------------------------------------------------- */
+/*      Build it without the lock, pj_init() can take a while.          */
+/* -------------------------------------------------------------------- */
+    if( (pj = pj_init_plus( definition )) == NULL )
+    {
+        pj_dalloc( key );
+        return NULL;
+    }
+
+    key_len = strlen( key );
+    e = (DEFCACHE_ENTRY *) pj_malloc( sizeof(DEFCACHE_ENTRY) + key_len );
+    if( e == NULL )
+    {
+        /* still usable, pj_free_cached() frees what it does not hold */
+        pj_dalloc( key );
+        return pj;
+    }
+    memcpy( e->key, key, key_len + 1 );
+    pj_dalloc( key );
+    e->pj = pj;
+    e->hash = hash;
+    e->refs = 1;
+
+    pj_acquire_lock();
+
+    /* another thread may have built the same one meanwhile */
+    if( (found = lookup( e->key, hash )) != NULL )
+    {
+        found->refs++;
+        pj_release_lock();
+        pj_free( e->pj );
+        pj_dalloc( e );
+        return found->pj;
+    }
+
+    e->hash_next = buckets[hash & (HASH_SIZE-1)];
+    buckets[hash & (HASH_SIZE-1)] = e;
+    lru_push( e );
+    entry_count++;
+    victims = trim();
+
+    pj_release_lock();
+
+    free_entries( victims );
+    return pj;
+}
+
+/************************************************************************/
+/*                          pj_free_cached()                            */
+/*                                                                      */
+/*      Give back a projection from pj_init_plus_cached().  A PJ the    */
+/*      cache does not hold is simply freed.                            */
+/************************************************************************/
+
+void pj_free_cached( PJ *pj )
+
+{
+    DEFCACHE_ENTRY *e, *victims = NULL;
+
+    if( pj == NULL )
+        return;
+
+    pj_acquire_lock();
+    for( e = lru_head; e != NULL && e->pj != pj; e = e->lru_next ) {}
+    if( e != NULL )
+    {
+        e->refs--;
+        victims = trim();
+    }
+    pj_release_lock();
+
+    if( e == NULL )
+        pj_free( pj );
+    else
+        free_entries( victims );
+}
+
+/************************************************************************/
+/*                       pj_set_def_cache_size()                        */
+/*                                                                      */
+/*      Cache up to max_entries definitions (default 32), 0 to free     */
+/*      every one not currently held and cache nothing more.            */
+/************************************************************************/
+
+void pj_set_def_cache_size( int max_entries )
+
+{
+    DEFCACHE_ENTRY *victims;
+
+    pj_acquire_lock();
+    limit = max_entries > 0 ? max_entries : 0;
+    victims = trim();
+    pj_release_lock();
+
+    free_entries( victims );
+}
+
+/************************************************************************/
+/*                      pj_get_def_cache_stats()                        */
+/*                                                                      */
+/*      Lookups answered from the cache and ones that had to call       */
+/*      pj_init_plus() since startup, and the entries now cached.       */
+/*      Any pointer may be NULL.                                        */
+/************************************************************************/
+
+void pj_get_def_cache_stats( long *hits, long *misses, long *entries )
+
+{
+    pj_acquire_lock();
+    if( hits != NULL )
+        *hits = hit_count;
+    if( misses != NULL )
+        *misses = miss_count;
+    if( entries != NULL )
+        *entries = entry_count;
+    pj_release_lock();
+}
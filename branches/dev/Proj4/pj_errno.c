@@ -3,18 +3,44 @@
 static const char SCCSID[]="@(#)pj_errno.c	4.3	95/06/03	GIE	REL";
 #endif
 
+#define PJ_ERRNO__
 #include "projects.h"
 
+/* error code of the default context, see pj_ctx.c */
 int pj_errno = 0;
 
 /************************************************************************/
 /*                          pj_get_errno_ref()                          */
+/*                                                                      */
+/*      Error code of the calling thread's current context.  Inside     */
+/*      the library pj_errno is a macro around this.                    */
 /************************************************************************/
 
 int *pj_get_errno_ref()
 
 {
-    return &pj_errno;
+    projCtx ctx = pj_get_ctx();
+
+    return ctx == pj_get_default_ctx() ? &pj_errno : &ctx->last_errno;
+}
+
+/************************************************************************/
+/*                 pj_ctx_get_errno()/pj_ctx_set_errno()                */
+/************************************************************************/
+
+int pj_ctx_get_errno( projCtx ctx )
+
+{
+    return ctx == pj_get_default_ctx() ? pj_errno : ctx->last_errno;
+}
+
+void pj_ctx_set_errno( projCtx ctx, int new_errno )
+
+{
+    if( ctx == pj_get_default_ctx() )
+        pj_errno = new_errno;
+    else
+        ctx->last_errno = new_errno;
 }
 
 /* end */
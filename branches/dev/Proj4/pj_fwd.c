@@ -35,3 +35,58 @@ pj_fwd(LP lp, PJ *P) {
 	}
 	return xy;
 }
+
+#define BATCH_CHUNK 256
+	int /* forward projection of x/y arrays in place, lam/phi in -> x/y out */
+pj_fwd_batch(PJ *P, long n, double *x, double *y, int *status) {
+	int st[BATCH_CHUNK], *s, err = 0;
+	long i, j, m;
+	double t;
+
+	for (j = 0; j < n; j += BATCH_CHUNK) {
+		m = n - j < BATCH_CHUNK ? n - j : BATCH_CHUNK;
+		s = status ? status + j : st;
+		/* same range checks and reductions as pj_fwd() */
+		for (i = j; i < j + m; ++i) {
+			if ((t = fabs(y[i])-HALFPI) > EPS || fabs(x[i]) > 10.) {
+				s[i - j] = -14;
+				x[i] = y[i] = 0.;
+				continue;
+			}
+			s[i - j] = 0;
+			if (fabs(t) <= EPS)
+				y[i] = y[i] < 0. ? -HALFPI : HALFPI;
+			else if (P->geoc)
+				y[i] = atan(P->rone_es * tan(y[i]));
+			x[i] -= P->lam0;
+			if (!P->over)
+				x[i] = adjlon(x[i]);
+		}
+		/* projection supplied array kernel, scalar code for the rest */
+		i = j + (P->fwd_batch ? (*P->fwd_batch)(m, x + j, y + j, s, P) : 0);
+		for (; i < j + m; ++i) {
+			LP lp;
+			XY xy;
+
+			if (s[i - j])
+				continue;
+			lp.lam = x[i];
+			lp.phi = y[i];
+			errno = pj_errno = 0;
+			xy = (*P->fwd)(lp, P);
+			if (pj_errno || (pj_errno = errno))
+				s[i - j] = pj_errno;
+			x[i] = xy.x;
+			y[i] = xy.y;
+		}
+		for (i = j; i < j + m; ++i)
+			if (s[i - j]) {
+				x[i] = y[i] = HUGE_VAL;
+				err = s[i - j];
+			} else {
+				x[i] = P->fr_meter * (P->a * x[i] + P->x0);
+				y[i] = P->fr_meter * (P->a * y[i] + P->y0);
+			}
+	}
+	return (pj_errno = err);
+}
@@ -0,0 +1,435 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Reentrant geodesic (direct and inverse) calculations over
+ *           arrays, the library form of the geod program's arithmetic.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * The formulas are those of geod_for.c and geod_inv.c (Andoyer-Lambert
+ * with second order flattening terms), with the GEODESIC globals split
+ * into a PJ_GEOD holding the ellipsoid constants, shared read only, and
+ * a PJ_GEOD_LINE holding what geod_pre() derived from the start point
+ * and azimuth.  The geod program now runs on these functions too, so
+ * both give the same results to the last bit.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+#include <errno.h>
+
+#define MERI_TOL 1e-9
+#define DTOL     1e-12
+
+/************************************************************************/
+/*                           pj_geod_alloc()                            */
+/*                                                                      */
+/*      Ellipsoid of semi-major axis a and eccentricity squared es,     */
+/*      es == 0 for a sphere.  Distances are in the units of a.         */
+/************************************************************************/
+
+struct PJ_GEOD *pj_geod_alloc( double a, double es )
+
+{
+    struct PJ_GEOD *G;
+
+    pj_errno = 0;
+
+    if( a <= 0.0 )
+        pj_errno = -13;
+    else if( es < 0.0 )
+        pj_errno = -12;
+    else if( es >= 1.0 )
+        pj_errno = -6;
+    if( pj_errno != 0 )
+        return NULL;
+
+    G = (struct PJ_GEOD *) pj_malloc( sizeof(struct PJ_GEOD) );
+    if( G == NULL )
+    {
+        pj_errno = ENOMEM;
+        return NULL;
+    }
+
+    G->a = a;
+    if( (G->ellipse = es != 0.0) )
+    {
+        G->onef = sqrt( 1. - es );
+        G->f = 1 - G->onef;
+        G->f2 = G->f / 2;
+        G->f4 = G->f / 4;
+        G->f64 = G->f * G->f / 64;
+    }
+    else
+    {
+        G->onef = 1.;
+        G->f = G->f2 = G->f4 = G->f64 = 0.;
+    }
+
+    return G;
+}
+
+/************************************************************************/
+/*                          pj_geod_from_pj()                           */
+/*                                                                      */
+/*      The ellipsoid of a projection definition, distances in          */
+/*      meters whatever its +units.                                     */
+/************************************************************************/
+
+struct PJ_GEOD *pj_geod_from_pj( PJ *pj )
+
+{
+    if( pj == NULL )
+    {
+        pj_errno = EINVAL;
+        return NULL;
+    }
+    return pj_geod_alloc( pj->a_orig, pj->es_orig );
+}
+
+/************************************************************************/
+/*                           pj_geod_free()                             */
+/************************************************************************/
+
+void pj_geod_free( struct PJ_GEOD *G )
+
+{
+    if( G != NULL )
+        pj_dalloc( G );
+}
+
+/************************************************************************/
+/*                        pj_geod_line_init()                           */
+/*                                                                      */
+/*      geod_pre(): the geodesic leaving (lam1, phi1) at azimuth        */
+/*      al12, which is reduced to +-PI in L->al12.                      */
+/************************************************************************/
+
+void pj_geod_line_init( const struct PJ_GEOD *G, PJ_GEOD_LINE *L,
+                        double lam1, double phi1, double al12 )
+
+{
+    L->lam1 = lam1;
+    L->phi1 = phi1;
+    L->al12 = al12 = adjlon( al12 );
+    L->signS = fabs( al12 ) > HALFPI ? 1 : 0;
+    L->th1 = G->ellipse ? atan( G->onef * tan( phi1 ) ) : phi1;
+    L->costh1 = cos( L->th1 );
+    L->sinth1 = sin( L->th1 );
+    if( (L->merid = fabs( L->sina12 = sin( al12 ) ) < MERI_TOL) )
+    {
+        L->sina12 = 0.;
+        L->cosa12 = fabs( al12 ) < HALFPI ? 1. : -1.;
+        L->M = 0.;
+    }
+    else
+    {
+        L->cosa12 = cos( al12 );
+        L->M = L->costh1 * L->sina12;
+    }
+    L->N = L->costh1 * L->cosa12;
+    if( G->ellipse )
+    {
+        if( L->merid )
+        {
+            L->c1 = 0.;
+            L->c2 = G->f4;
+            L->D = 1. - L->c2;
+            L->D *= L->D;
+            L->P = L->c2 / L->D;
+        }
+        else
+        {
+            L->c1 = G->f * L->M;
+            L->c2 = G->f4 * (1. - L->M * L->M);
+            L->D = (1. - L->c2) * (1. - L->c2 - L->c1 * L->M);
+            L->P = (1. + .5 * L->c1 * L->M) * L->c2 / L->D;
+        }
+    }
+    else
+        L->c1 = L->c2 = L->D = L->P = 0.;
+    if( L->merid )
+        L->s1 = HALFPI - L->th1;
+    else
+    {
+        L->s1 = (fabs( L->M ) >= 1.) ? 0. : acos( L->M );
+        L->s1 = L->sinth1 / sin( L->s1 );
+        L->s1 = (fabs( L->s1 ) >= 1.) ? 0. : acos( L->s1 );
+    }
+}
+
+/************************************************************************/
+/*                       pj_geod_line_position()                        */
+/*                                                                      */
+/*      geod_for(): the point at distance S along the line and the      */
+/*      back azimuth there.                                             */
+/************************************************************************/
+
+void pj_geod_line_position( const struct PJ_GEOD *G, const PJ_GEOD_LINE *L,
+                            double S, double *lam2, double *phi2,
+                            double *al21 )
+
+{
+    double d, sind, u, V, X, ds, cosds, sinds, ss = 0., de, al, phi;
+
+    if( G->ellipse )
+    {
+        d = S / (L->D * G->a);
+        if( L->signS )
+            d = -d;
+        u = 2. * (L->s1 - d);
+        V = cos( u + d );
+        X = L->c2 * L->c2 * (sind = sin( d )) * cos( d ) * (2. * V * V - 1.);
+        ds = d + X - 2. * L->P * V * (1. - 2. * L->P * cos( u )) * sind;
+        ss = L->s1 + L->s1 - ds;
+    }
+    else
+    {
+        ds = S / G->a;
+        if( L->signS )
+            ds = - ds;
+    }
+    cosds = cos( ds );
+    sinds = sin( ds );
+    if( L->signS )
+        sinds = - sinds;
+    al = L->N * cosds - L->sinth1 * sinds;
+    if( L->merid )
+    {
+        phi = atan( tan( HALFPI + L->s1 - ds ) / G->onef );
+        if( al > 0. )
+        {
+            al = PI;
+            if( L->signS )
+                de = PI;
+            else
+            {
+                phi = - phi;
+                de = 0.;
+            }
+        }
+        else
+        {
+            al = 0.;
+            if( L->signS )
+            {
+                phi = - phi;
+                de = 0;
+            }
+            else
+                de = PI;
+        }
+    }
+    else
+    {
+        al = atan( L->M / al );
+        if( al > 0 )
+            al += PI;
+        if( L->al12 < 0. )
+            al -= PI;
+        al = adjlon( al );
+        phi = atan( -(L->sinth1 * cosds + L->N * sinds) * sin( al ) /
+                    (G->ellipse ? G->onef * L->M : L->M) );
+        de = atan2( sinds * L->sina12,
+                    (L->costh1 * cosds - L->sinth1 * sinds * L->cosa12) );
+        if( G->ellipse )
+        {
+            if( L->signS )
+                de += L->c1 * ((1. - L->c2) * ds +
+                               L->c2 * sinds * cos( ss ));
+            else
+                de -= L->c1 * ((1. - L->c2) * ds -
+                               L->c2 * sinds * cos( ss ));
+        }
+    }
+    *lam2 = adjlon( L->lam1 + de );
+    *phi2 = phi;
+    if( al21 != NULL )
+        *al21 = al;
+}
+
+/************************************************************************/
+/*                          pj_geod_inverse1()                          */
+/*                                                                      */
+/*      geod_inv(): distance and azimuths between two points.           */
+/************************************************************************/
+
+void pj_geod_inverse1( const struct PJ_GEOD *G,
+                       double lam1, double phi1, double lam2, double phi2,
+                       double *S, double *al12, double *al21 )
+
+{
+    double th1, th2, thm, dthm, dlamm, dlam, sindlamm, costhm, sinthm,
+        cosdthm, sindthm, L, E, cosd, d, X, Y, T, sind, tandlammp, u, v,
+        D, A, B;
+
+    if( G->ellipse )
+    {
+        th1 = atan( G->onef * tan( phi1 ) );
+        th2 = atan( G->onef * tan( phi2 ) );
+    }
+    else
+    {
+        th1 = phi1;
+        th2 = phi2;
+    }
+    thm = .5 * (th1 + th2);
+    dthm = .5 * (th2 - th1);
+    dlamm = .5 * ( dlam = adjlon( lam2 - lam1 ) );
+    if( fabs( dlam ) < DTOL && fabs( dthm ) < DTOL )
+    {
+        *al12 = *al21 = *S = 0.;
+        return;
+    }
+    sindlamm = sin( dlamm );
+    costhm = cos( thm );
+    sinthm = sin( thm );
+    cosdthm = cos( dthm );
+    sindthm = sin( dthm );
+    L = sindthm * sindthm + (cosdthm * cosdthm - sinthm * sinthm)
+        * sindlamm * sindlamm;
+    d = acos( cosd = 1 - L - L );
+    if( G->ellipse )
+    {
+        E = cosd + cosd;
+        sind = sin( d );
+        Y = sinthm * cosdthm;
+        Y *= (Y + Y) / (1. - L);
+        T = sindthm * costhm;
+        T *= (T + T) / L;
+        X = Y + T;
+        Y -= T;
+        T = d / sind;
+        D = 4. * T * T;
+        A = D * E;
+        B = D + D;
+        *S = G->a * sind * (T - G->f4 * (T * X - Y) +
+                            G->f64 * (X * (A + (T - .5 * (A - E)) * X) -
+                                      Y * (B + E * Y) + D * X * Y));
+        tandlammp = tan( .5 * (dlam - .25 * (Y + Y - E * (4. - X)) *
+                               (G->f2 * T + G->f64 * (32. * T - (20. * T - A)
+                                                      * X - (B + 4.) * Y))
+                               * tan( dlam )) );
+    }
+    else
+    {
+        *S = G->a * d;
+        tandlammp = tan( dlamm );
+    }
+    u = atan2( sindthm, (tandlammp * costhm) );
+    v = atan2( cosdthm, (tandlammp * sinthm) );
+    *al12 = adjlon( TWOPI + v - u );
+    *al21 = adjlon( TWOPI - v - u );
+}
+
+/************************************************************************/
+/*                          pj_geod_direct()                            */
+/*                                                                      */
+/*      For each i, the point reached from (lam1[i], phi1[i]) going     */
+/*      dist[i] at azimuth az12[i].  Angles are in radians.  az21       */
+/*      may be NULL, the outputs may be the input arrays, and a         */
+/*      HUGE_VAL input gives HUGE_VAL outputs.                          */
+/************************************************************************/
+
+int pj_geod_direct( struct PJ_GEOD *G, long point_count,
+                    const double *lam1, const double *phi1,
+                    const double *az12, const double *dist,
+                    double *lam2, double *phi2, double *az21 )
+
+{
+    PJ_GEOD_LINE line;
+    double       S;
+    long         i;
+
+    pj_errno = 0;
+
+    if( G == NULL || point_count < 0 )
+    {
+        pj_errno = EINVAL;
+        return EINVAL;
+    }
+
+    for( i = 0; i < point_count; i++ )
+    {
+        if( lam1[i] == HUGE_VAL || phi1[i] == HUGE_VAL
+            || az12[i] == HUGE_VAL || dist[i] == HUGE_VAL )
+        {
+            lam2[i] = phi2[i] = HUGE_VAL;
+            if( az21 != NULL )
+                az21[i] = HUGE_VAL;
+            continue;
+        }
+        S = dist[i];
+        pj_geod_line_init( G, &line, lam1[i], phi1[i], az12[i] );
+        pj_geod_line_position( G, &line, S, lam2 + i, phi2 + i,
+                               az21 != NULL ? az21 + i : NULL );
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                          pj_geod_inverse()                           */
+/*                                                                      */
+/*      For each i, the distance and azimuths from (lam1[i], phi1[i])   */
+/*      to (lam2[i], phi2[i]).  The legs of a path are given by         */
+/*      passing its vertex arrays as lam1/phi1 and, one vertex on, as   */
+/*      lam2/phi2.  az12 and az21 may be NULL.                          */
+/************************************************************************/
+
+int pj_geod_inverse( struct PJ_GEOD *G, long point_count,
+                     const double *lam1, const double *phi1,
+                     const double *lam2, const double *phi2,
+                     double *dist, double *az12, double *az21 )
+
+{
+    double S, a12, a21;
+    long   i;
+
+    pj_errno = 0;
+
+    if( G == NULL || point_count < 0 )
+    {
+        pj_errno = EINVAL;
+        return EINVAL;
+    }
+
+    for( i = 0; i < point_count; i++ )
+    {
+        if( lam1[i] == HUGE_VAL || phi1[i] == HUGE_VAL
+            || lam2[i] == HUGE_VAL || phi2[i] == HUGE_VAL )
+            S = a12 = a21 = HUGE_VAL;
+        else
+            pj_geod_inverse1( G, lam1[i], phi1[i], lam2[i], phi2[i],
+                              &S, &a12, &a21 );
+        dist[i] = S;
+        if( az12 != NULL )
+            az12[i] = a12;
+        if( az21 != NULL )
+            az21[i] = a21;
+    }
+
+    return 0;
+}
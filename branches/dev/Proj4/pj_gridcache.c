@@ -0,0 +1,242 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Memory budget for loaded grid shift data, with least recently
+ *           used grids unloaded when it is exceeded.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * Every (sub)grid whose shift values pj_gridinfo_load() read into memory
+ * sits on one list, most recently used first.  With a budget set, grids
+ * are unloaded from the tail of the list whenever the loaded data would
+ * exceed it, and loaded again by pj_gridinfo_load() when next needed.
+ *
+ * Readers do not take the lock per point, so with a budget set
+ * pj_apply_gridshift() pins each grid it uses for the length of the call
+ * and pinned grids are never unloaded; this is also when a grid moves to
+ * the front of the list.  Without a budget (the default) nothing is ever
+ * unloaded and nothing is pinned.
+ *
+ * Grids of "mapped" files are not counted: their data belongs to the
+ * file mapping and the system pages it in and out.
+ *
+ * Everything below except the public functions at the end expects the
+ * caller to hold pj_acquire_lock().
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+
+static PJ_GRIDINFO *lru_head = NULL, *lru_tail = NULL;
+
+static long budget = 0;                 /* bytes, 0 for no limit */
+static long resident = 0;               /* bytes of loaded shift data */
+static long load_count = 0;
+static long eviction_count = 0;
+
+#define GRID_BYTES(gi) \
+    ((long) (gi)->ct->lim.lam * (gi)->ct->lim.phi * (long) sizeof(FLP))
+
+/************************************************************************/
+/*                      lru_unlink() / lru_push()                       */
+/************************************************************************/
+
+static void lru_unlink( PJ_GRIDINFO *gi )
+
+{
+    if( gi->lru_prev != NULL )
+        gi->lru_prev->lru_next = gi->lru_next;
+    else
+        lru_head = gi->lru_next;
+    if( gi->lru_next != NULL )
+        gi->lru_next->lru_prev = gi->lru_prev;
+    else
+        lru_tail = gi->lru_prev;
+    gi->lru_prev = gi->lru_next = NULL;
+}
+
+static void lru_push( PJ_GRIDINFO *gi )
+
+{
+    gi->lru_prev = NULL;
+    gi->lru_next = lru_head;
+    if( lru_head != NULL )
+        lru_head->lru_prev = gi;
+    else
+        lru_tail = gi;
+    lru_head = gi;
+}
+
+/************************************************************************/
+/*                               trim()                                 */
+/*                                                                      */
+/*      Unload unpinned grids, oldest first, until the data fits the    */
+/*      budget.  keep is spared even if unpinned.                       */
+/************************************************************************/
+
+static void trim( PJ_GRIDINFO *keep )
+
+{
+    PJ_GRIDINFO *gi, *prev;
+
+    if( budget <= 0 )
+        return;
+
+    for( gi = lru_tail; gi != NULL && resident > budget; gi = prev )
+    {
+        prev = gi->lru_prev;
+        if( gi->pin_count > 0 || gi == keep )
+            continue;
+
+        if( pj_get_ctx()->debug_level )
+            fprintf( stderr, "pj_gridcache: unloading %s\n", gi->ct->id );
+
+        lru_unlink( gi );
+        gi->is_cached = 0;
+        resident -= GRID_BYTES( gi );
+        eviction_count++;
+        pj_dalloc( gi->ct->cvs );
+        gi->ct->cvs = NULL;
+    }
+}
+
+/************************************************************************/
+/*                        pj_gridcache_loaded()                         */
+/*                                                                      */
+/*      pj_gridinfo_load() has just read the data of gi.                */
+/************************************************************************/
+
+void pj_gridcache_loaded( PJ_GRIDINFO *gi )
+
+{
+    load_count++;
+    if( gi->map != NULL || gi->is_cached )
+        return;
+
+    gi->is_cached = 1;
+    resident += GRID_BYTES( gi );
+    lru_push( gi );
+    trim( gi );
+}
+
+/************************************************************************/
+/*                        pj_gridcache_forget()                         */
+/*                                                                      */
+/*      gi is about to be freed.                                        */
+/************************************************************************/
+
+void pj_gridcache_forget( PJ_GRIDINFO *gi )
+
+{
+    if( !gi->is_cached )
+        return;
+
+    lru_unlink( gi );
+    gi->is_cached = 0;
+    resident -= GRID_BYTES( gi );
+}
+
+/************************************************************************/
+/*                         pj_gridcache_pin()                           */
+/*                                                                      */
+/*      Load gi if needed and keep it loaded until unpinned.  Returns   */
+/*      0 if it could not be loaded.                                    */
+/************************************************************************/
+
+int pj_gridcache_pin( PJ_GRIDINFO *gi )
+
+{
+    if( gi->ct->cvs == NULL && !pj_gridinfo_load( gi ) )
+        return 0;
+
+    gi->pin_count++;
+    if( gi->is_cached && gi != lru_head )
+    {
+        lru_unlink( gi );
+        lru_push( gi );
+    }
+    return 1;
+}
+
+/************************************************************************/
+/*                        pj_gridcache_unpin()                          */
+/************************************************************************/
+
+void pj_gridcache_unpin( PJ_GRIDINFO *gi )
+
+{
+    gi->pin_count--;
+    trim( NULL );
+}
+
+/************************************************************************/
+/*                        pj_gridcache_enabled()                        */
+/*                                                                      */
+/*      Whether readers must pin grids.  Taken without the lock: the    */
+/*      budget is only to be changed while no shifts are running.       */
+/************************************************************************/
+
+int pj_gridcache_enabled()
+
+{
+    return budget > 0;
+}
+
+/************************************************************************/
+/*                      pj_set_grid_cache_budget()                      */
+/*                                                                      */
+/*      Limit the memory used by loaded grid shift data to about        */
+/*      bytes, 0 for no limit.  Like pj_deallocate_grids(), not to be   */
+/*      called while other threads are shifting coordinates.            */
+/************************************************************************/
+
+void pj_set_grid_cache_budget( long bytes )
+
+{
+    pj_acquire_lock();
+    budget = bytes > 0 ? bytes : 0;
+    trim( NULL );
+    pj_release_lock();
+}
+
+/************************************************************************/
+/*                      pj_get_grid_cache_stats()                       */
+/*                                                                      */
+/*      Grid data loads and unloads since startup, and the bytes of     */
+/*      grid data now in memory.  Any pointer may be NULL.              */
+/************************************************************************/
+
+void pj_get_grid_cache_stats( long *loads, long *evictions,
+                              long *resident_bytes )
+
+{
+    pj_acquire_lock();
+    if( loads != NULL )
+        *loads = load_count;
+    if( evictions != NULL )
+        *evictions = eviction_count;
+    if( resident_bytes != NULL )
+        *resident_bytes = resident;
+    pj_release_lock();
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Uniform bucket index over grid shift tables, so
+ *           pj_apply_gridshift() only looks at the tables near a point.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * The union of the tables' extents is cut into a grid of equal cells and
+ * each cell lists, in the original order, the tables whose extent touches
+ * it.  A point's cell therefore yields every table that can contain it,
+ * in the order pj_apply_gridshift() has always tried them; the exact
+ * extent test is still done by the caller.
+ *
+ * Cells are assigned with the same arithmetic for extents and points,
+ * which is monotonic, so a point on a table's edge always falls in a cell
+ * listing that table.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+#include <math.h>
+
+#define MAX_SIDE 256
+
+/************************************************************************/
+/*                            cell_of()                                 */
+/************************************************************************/
+
+static int cell_of( double v, double origin, double inv_size, int count )
+
+{
+    double c = (v - origin) * inv_size;
+
+    if( !(c >= 0.0) )           /* NaN from 0 * HUGE_VAL too */
+        return 0;
+    if( c >= count )
+        return count - 1;
+    return (int) c;
+}
+
+/************************************************************************/
+/*                         pj_gridindex_build()                         */
+/*                                                                      */
+/*      Index the count tables in grids, which must stay valid for      */
+/*      the life of the index.                                          */
+/************************************************************************/
+
+PJ_GRIDINDEX *pj_gridindex_build( PJ_GRIDINFO **grids, int count )
+
+{
+    PJ_GRIDINDEX *idx;
+    LP     ur;
+    int    i, j, side, col, row, total;
+    int    *fill;
+
+    if( count < 1 )
+        return NULL;
+
+    idx = (PJ_GRIDINDEX *) pj_malloc( sizeof(PJ_GRIDINDEX) );
+    if( idx == NULL )
+        return NULL;
+    memset( idx, 0, sizeof(PJ_GRIDINDEX) );
+    idx->count = count;
+    idx->grids = (PJ_GRIDINFO **) pj_malloc( sizeof(PJ_GRIDINFO *) * count );
+    idx->exclusive = (char *) pj_malloc( count );
+    if( idx->grids == NULL || idx->exclusive == NULL )
+    {
+        pj_gridindex_free( idx );
+        return NULL;
+    }
+    memcpy( idx->grids, grids, sizeof(PJ_GRIDINFO *) * count );
+
+/* -------------------------------------------------------------------- */
+/*      Overall extent, and which tables no earlier one overlaps.       */
+/* -------------------------------------------------------------------- */
+    idx->ll = grids[0]->ct->ll;
+    ur.lam = PJ_CT_MAX_LAM( grids[0]->ct );
+    ur.phi = PJ_CT_MAX_PHI( grids[0]->ct );
+
+    for( i = 0; i < count; i++ )
+    {
+        struct CTABLE *ct = grids[i]->ct;
+
+        if( ct->ll.lam < idx->ll.lam ) idx->ll.lam = ct->ll.lam;
+        if( ct->ll.phi < idx->ll.phi ) idx->ll.phi = ct->ll.phi;
+        if( PJ_CT_MAX_LAM( ct ) > ur.lam ) ur.lam = PJ_CT_MAX_LAM( ct );
+        if( PJ_CT_MAX_PHI( ct ) > ur.phi ) ur.phi = PJ_CT_MAX_PHI( ct );
+
+        /* touching edges are fine, callers only trust exclusive
+           tables for points strictly inside them */
+        idx->exclusive[i] = 1;
+        for( j = 0; j < i; j++ )
+        {
+            struct CTABLE *ct1 = grids[j]->ct;
+
+            if( ct1->ll.lam < PJ_CT_MAX_LAM( ct )
+                && ct->ll.lam < PJ_CT_MAX_LAM( ct1 )
+                && ct1->ll.phi < PJ_CT_MAX_PHI( ct )
+                && ct->ll.phi < PJ_CT_MAX_PHI( ct1 ) )
+            {
+                idx->exclusive[i] = 0;
+                break;
+            }
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Roughly two cells per table in each direction.                  */
+/* -------------------------------------------------------------------- */
+    side = (int) ceil( sqrt( (double) count ) ) * 2;
+    if( side > MAX_SIDE )
+        side = MAX_SIDE;
+    idx->cols = idx->rows = side;
+    idx->inv_lam = ur.lam > idx->ll.lam ? side / (ur.lam - idx->ll.lam) : 0.0;
+    idx->inv_phi = ur.phi > idx->ll.phi ? side / (ur.phi - idx->ll.phi) : 0.0;
+
+    idx->cell_start = (int *) pj_malloc( sizeof(int) * (side * side + 1) );
+    fill = (int *) pj_malloc( sizeof(int) * side * side );
+    if( idx->cell_start == NULL || fill == NULL )
+    {
+        pj_dalloc( fill );
+        pj_gridindex_free( idx );
+        return NULL;
+    }
+    memset( fill, 0, sizeof(int) * side * side );
+
+/* -------------------------------------------------------------------- */
+/*      Count, then fill the per cell lists in table order.             */
+/* -------------------------------------------------------------------- */
+#define FOR_CELLS_OF(ct)                                                \
+    for( row = cell_of( (ct)->ll.phi, idx->ll.phi, idx->inv_phi, side ); \
+         row <= cell_of( PJ_CT_MAX_PHI(ct), idx->ll.phi, idx->inv_phi,    \
+                         side ); row++ )                                \
+        for( col = cell_of( (ct)->ll.lam, idx->ll.lam, idx->inv_lam,    \
+                            side );                                     \
+             col <= cell_of( PJ_CT_MAX_LAM(ct), idx->ll.lam,            \
+                             idx->inv_lam, side ); col++ )
+
+    total = 0;
+    for( i = 0; i < count; i++ )
+    {
+        FOR_CELLS_OF( grids[i]->ct )
+        {
+            fill[row * side + col]++;
+            total++;
+        }
+    }
+
+    idx->cell_start[0] = 0;
+    for( i = 0; i < side * side; i++ )
+    {
+        idx->cell_start[i+1] = idx->cell_start[i] + fill[i];
+        fill[i] = idx->cell_start[i];
+    }
+
+    idx->entries = (int *) pj_malloc( sizeof(int) * (total > 0 ? total : 1) );
+    if( idx->entries == NULL )
+    {
+        pj_dalloc( fill );
+        pj_gridindex_free( idx );
+        return NULL;
+    }
+
+    for( i = 0; i < count; i++ )
+    {
+        FOR_CELLS_OF( grids[i]->ct )
+            idx->entries[fill[row * side + col]++] = i;
+    }
+
+    pj_dalloc( fill );
+
+    return idx;
+}
+
+/************************************************************************/
+/*                      pj_gridindex_candidates()                       */
+/*                                                                      */
+/*      Positions (into the indexed array) of the tables that may       */
+/*      contain lp, in their original order.                            */
+/************************************************************************/
+
+const int *pj_gridindex_candidates( PJ_GRIDINDEX *idx, LP lp, int *count )
+
+{
+    int cell;
+
+    if( !(lp.lam >= idx->ll.lam && lp.phi >= idx->ll.phi) )
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    cell = cell_of( lp.phi, idx->ll.phi, idx->inv_phi, idx->rows )
+        * idx->cols
+        + cell_of( lp.lam, idx->ll.lam, idx->inv_lam, idx->cols );
+
+    *count = idx->cell_start[cell+1] - idx->cell_start[cell];
+    return idx->entries + idx->cell_start[cell];
+}
+
+/************************************************************************/
+/*                         pj_gridindex_free()                          */
+/************************************************************************/
+
+void pj_gridindex_free( PJ_GRIDINDEX *idx )
+
+{
+    if( idx == NULL )
+        return;
+
+    pj_dalloc( idx->grids );
+    pj_dalloc( idx->exclusive );
+    pj_dalloc( idx->cell_start );
+    pj_dalloc( idx->entries );
+    pj_dalloc( idx );
+}
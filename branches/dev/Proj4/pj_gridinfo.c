@@ -73,6 +73,67 @@
 # include <assert.h>
 #endif /* _WIN32_WCE */
 
+#if !defined(_WIN32) && !defined(PJ_NO_MMAP)
+#  define PJ_HAVE_MMAP
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#endif
+
+/* -------------------------------------------------------------------- */
+/*      The "mapped" format, written by nad2bin -f mapped: a header,    */
+/*      one entry per (sub)grid in parent before child order, then      */
+/*      each grid's FLP array exactly as CTABLE.cvs holds it, in        */
+/*      radians and native byte order, so it can be used straight       */
+/*      from a read-only mapping of the file.                           */
+/* -------------------------------------------------------------------- */
+#define MAPPED_MAGIC      "PJGRIDM1"
+#define MAPPED_BYTE_ORDER 0x01020304
+#define MAPPED_ALIGN      16
+
+typedef struct {
+    char   magic[8];
+    int    byte_order;        /* MAPPED_BYTE_ORDER as written */
+    int    grid_count;
+    int    entry_size;        /* sizeof(MAPPED_ENTRY), layout check */
+    int    reserved;
+} MAPPED_HEADER;
+
+typedef struct {
+    char   id[MAX_TAB_ID];
+    double ll_lam, ll_phi;    /* radians */
+    double del_lam, del_phi;
+    int    lim_lam, lim_phi;
+    int    parent;            /* entry index, -1 for top level grids */
+    unsigned int data_offset; /* from start of file */
+} MAPPED_ENTRY;
+
+struct PJ_GRIDMAP {
+    void   *base;
+    size_t size;
+    int    ref_count;         /* grids pointing into it */
+    int    is_mapped;         /* else base was read into memory */
+};
+
+/************************************************************************/
+/*                         pj_gridmap_release()                         */
+/************************************************************************/
+
+static void pj_gridmap_release( struct PJ_GRIDMAP *map )
+
+{
+    if( --map->ref_count > 0 )
+        return;
+
+#ifdef PJ_HAVE_MMAP
+    if( map->is_mapped )
+        munmap( map->base, map->size );
+    else
+#endif
+        pj_dalloc( map->base );
+    pj_dalloc( map );
+}
+
 /************************************************************************/
 /*                             swap_words()                             */
 /*                                                                      */
@@ -124,6 +185,15 @@ void pj_gridinfo_free( PJ_GRIDINFO *gi )
             pj_gridinfo_free( child );
         }
     }
+    pj_gridindex_free( gi->child_index );
+    pj_gridcache_forget( gi );
+
+    if( gi->map != NULL )
+    {
+        /* the table data belongs to the mapping */
+        gi->ct->cvs = NULL;
+        pj_gridmap_release( gi->map );
+    }
 
     if( gi->ct != NULL )
         nad_free( gi->ct );
@@ -136,19 +206,23 @@ void pj_gridinfo_free( PJ_GRIDINFO *gi )
 }
 
 /************************************************************************/
-/*                          pj_gridinfo_load()                          */
+/*                          pj_gridinfo_read()                          */
 /*                                                                      */
-/*      This function is intended to implement delayed loading of       */
-/*      the data contents of a grid file.  The header and related       */
-/*      stuff are loaded by pj_gridinfo_init().                         */
+/*      Read the shift values of one grid into ct->cvs.                 */
 /************************************************************************/
 
-int pj_gridinfo_load( PJ_GRIDINFO *gi )
+static int pj_gridinfo_read( PJ_GRIDINFO *gi )
 
 {
     if( gi == NULL || gi->ct == NULL )
         return 0;
 
+/* -------------------------------------------------------------------- */
+/*      Mapped grids point into the file mapping from the start.        */
+/* -------------------------------------------------------------------- */
+    if( gi->map != NULL )
+        return 1;
+
 /* -------------------------------------------------------------------- */
 /*      ctable is currently loaded on initialization though there is    */
 /*      no real reason not to support delayed loading for it as well.   */
@@ -183,6 +257,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     else if( strcmp(gi->format,"ntv1") == 0 )
     {
         double	*row_buf;
+        FLP	*cvs_buf;
         int	row;
         FILE *fid;
 
@@ -197,8 +272,8 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
         fseek( fid, gi->grid_offset, SEEK_SET );
 
         row_buf = (double *) pj_malloc(gi->ct->lim.lam * sizeof(double) * 2);
-        gi->ct->cvs = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
-        if( row_buf == NULL || gi->ct->cvs == NULL )
+        cvs_buf = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
+        if( row_buf == NULL || cvs_buf == NULL )
         {
             pj_errno = -38;
             return 0;
@@ -214,7 +289,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
                 != 2 * gi->ct->lim.lam )
             {
                 pj_dalloc( row_buf );
-                pj_dalloc( gi->ct->cvs );
+                pj_dalloc( cvs_buf );
                 pj_errno = -38;
                 return 0;
             }
@@ -227,7 +302,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
             for( i = 0; i < gi->ct->lim.lam; i++ )
             {
-                cvs = gi->ct->cvs + (row) * gi->ct->lim.lam
+                cvs = cvs_buf + (row) * gi->ct->lim.lam
                     + (gi->ct->lim.lam - i - 1);
 
                 cvs->phi = *(diff_seconds++) * ((PI/180.0) / 3600.0);
@@ -239,6 +314,10 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
         fclose( fid );
 
+        /* only publish the table once it is complete, other threads
+           test ct->cvs without holding the lock */
+        nad_ctable_publish( gi->ct, cvs_buf );
+
         return 1;
     }
 
@@ -252,10 +331,11 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     else if( strcmp(gi->format,"ntv2") == 0 )
     {
         float	*row_buf;
+        FLP	*cvs_buf;
         int	row;
         FILE *fid;
 
-        if( getenv("PROJ_DEBUG") != NULL )
+        if( pj_get_ctx()->debug_level )
         {
             fprintf( stderr, "NTv2 - loading grid %s\n", gi->ct->id );
         }
@@ -271,8 +351,8 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
         fseek( fid, gi->grid_offset, SEEK_SET );
 
         row_buf = (float *) pj_malloc(gi->ct->lim.lam * sizeof(float) * 4);
-        gi->ct->cvs = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
-        if( row_buf == NULL || gi->ct->cvs == NULL )
+        cvs_buf = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
+        if( row_buf == NULL || cvs_buf == NULL )
         {
             pj_errno = -38;
             return 0;
@@ -288,8 +368,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
                 != 4 * gi->ct->lim.lam )
             {
                 pj_dalloc( row_buf );
-                pj_dalloc( gi->ct->cvs );
-                gi->ct->cvs = NULL;
+                pj_dalloc( cvs_buf );
                 pj_errno = -38;
                 return 0;
             }
@@ -303,7 +382,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
             for( i = 0; i < gi->ct->lim.lam; i++ )
             {
-                cvs = gi->ct->cvs + (row) * gi->ct->lim.lam
+                cvs = cvs_buf + (row) * gi->ct->lim.lam
                     + (gi->ct->lim.lam - i - 1);
 
                 cvs->phi = *(diff_seconds++) * ((PI/180.0) / 3600.0);
@@ -316,6 +395,10 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
         fclose( fid );
 
+        /* only publish the table once it is complete, other threads
+           test ct->cvs without holding the lock */
+        nad_ctable_publish( gi->ct, cvs_buf );
+
         return 1;
     }
 
@@ -325,6 +408,25 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     }
 }
 
+/************************************************************************/
+/*                          pj_gridinfo_load()                          */
+/*                                                                      */
+/*      This function is intended to implement delayed loading of       */
+/*      the data contents of a grid file.  The header and related       */
+/*      stuff are loaded by pj_gridinfo_init().  The data may be        */
+/*      unloaded again later to keep within the grid cache budget.      */
+/************************************************************************/
+
+int pj_gridinfo_load( PJ_GRIDINFO *gi )
+
+{
+    if( !pj_gridinfo_read( gi ) )
+        return 0;
+
+    pj_gridcache_loaded( gi );
+    return 1;
+}
+
 /************************************************************************/
 /*                       pj_gridinfo_init_ntv2()                        */
 /*                                                                      */
@@ -433,7 +535,7 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
         ct->lim.lam = (int) (fabs(ur.lam-ct->ll.lam)/ct->del.lam + 0.5) + 1;
         ct->lim.phi = (int) (fabs(ur.phi-ct->ll.phi)/ct->del.phi + 0.5) + 1;
 
-        if( getenv("PROJ_DEBUG") != NULL )
+        if( pj_get_ctx()->debug_level )
             fprintf( stderr, 
                      "NTv2 %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
                      ct->id, 
@@ -504,7 +606,7 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 
             if( gp == NULL )
             {
-                if( getenv("PROJ_DEBUG") != NULL )
+                if( pj_get_ctx()->debug_level )
                     fprintf( stderr, "pj_gridinfo_init_ntv2(): "
                              "failed to find parent %8.8s for %s.\n", 
                              (const char *) header+24, gi->ct->id );
@@ -600,7 +702,7 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
     ct->lim.lam = (int) (fabs(ur.lam-ct->ll.lam)/ct->del.lam + 0.5) + 1;
     ct->lim.phi = (int) (fabs(ur.phi-ct->ll.phi)/ct->del.phi + 0.5) + 1;
 
-    if( getenv("PROJ_DEBUG") != NULL )
+    if( pj_get_ctx()->debug_level )
         fprintf( stderr, 
                  "NTv1 %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
                  ct->lim.lam, ct->lim.phi,
@@ -619,6 +721,420 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
     return 1;
 }
 
+/************************************************************************/
+/*                        unmap_partial_grids()                         */
+/*                                                                      */
+/*      Undo the first count grids pj_gridinfo_init_mapped() built,     */
+/*      keeping gilist itself, and release the mapping.                 */
+/************************************************************************/
+
+static void unmap_partial_grids( struct PJ_GRIDMAP *map, PJ_GRIDINFO **gis,
+                                 int count )
+
+{
+    int i;
+
+    for( i = count - 1; i >= 0; i-- )
+    {
+        PJ_GRIDINFO *gi = gis[i];
+
+        gi->ct->cvs = NULL;
+        nad_free( gi->ct );
+        gi->ct = NULL;
+        gi->map = NULL;
+        if( i > 0 )
+        {
+            free( gi->gridname );
+            free( gi->filename );
+            pj_dalloc( gi );
+        }
+    }
+    if( count > 0 )
+    {
+        gis[0]->next = gis[0]->child = NULL;
+        gis[0]->format = "missing";
+        gis[0]->grid_offset = 0;
+    }
+
+    map->ref_count = 1;
+    pj_gridmap_release( map );
+}
+
+/************************************************************************/
+/*                      pj_gridinfo_init_mapped()                       */
+/*                                                                      */
+/*      Map a "mapped" format file and create a PJ_GRIDINFO for each    */
+/*      grid in it, with the table data already in place.               */
+/************************************************************************/
+
+static int pj_gridinfo_init_mapped( FILE *fid, PJ_GRIDINFO *gilist )
+
+{
+    struct PJ_GRIDMAP *map;
+    MAPPED_HEADER *header;
+    MAPPED_ENTRY  *entries;
+    PJ_GRIDINFO   **gis;
+    long          size;
+    int           i;
+
+    fseek( fid, 0, SEEK_END );
+    size = ftell( fid );
+    fseek( fid, 0, SEEK_SET );
+    if( size < (long) sizeof(MAPPED_HEADER) )
+    {
+        pj_errno = -38;
+        return 0;
+    }
+
+    map = (struct PJ_GRIDMAP *) pj_malloc( sizeof(struct PJ_GRIDMAP) );
+    if( map == NULL )
+    {
+        pj_errno = -38;
+        return 0;
+    }
+    map->size = (size_t) size;
+    map->ref_count = 0;
+    map->is_mapped = 0;
+    map->base = NULL;
+
+#ifdef PJ_HAVE_MMAP
+    map->base = mmap( NULL, map->size, PROT_READ, MAP_SHARED, 
+                      fileno( fid ), 0 );
+    if( map->base == MAP_FAILED )
+        map->base = NULL;
+    else
+    {
+        map->is_mapped = 1;
+#  ifdef MADV_RANDOM
+        /* lookups touch scattered cells, don't read ahead */
+        madvise( map->base, map->size, MADV_RANDOM );
+#  endif
+    }
+#endif
+
+    /* no mapping available, fall back to one plain read */
+    if( map->base == NULL )
+    {
+        map->base = pj_malloc( map->size );
+        if( map->base == NULL 
+            || fread( map->base, map->size, 1, fid ) != 1 )
+        {
+            pj_dalloc( map->base );
+            pj_dalloc( map );
+            pj_errno = -38;
+            return 0;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Validate the header, the file is only usable on a machine       */
+/*      with the byte order and structure layout it was written on.     */
+/* -------------------------------------------------------------------- */
+    header = (MAPPED_HEADER *) map->base;
+    entries = (MAPPED_ENTRY *) (header + 1);
+
+    if( header->byte_order != MAPPED_BYTE_ORDER
+        || header->entry_size != sizeof(MAPPED_ENTRY)
+        || header->grid_count < 1
+        || sizeof(MAPPED_HEADER) + header->grid_count * sizeof(MAPPED_ENTRY)
+           > map->size )
+    {
+        if( pj_get_ctx()->debug_level )
+            fprintf( stderr, "pj_gridinfo_init_mapped(): %s was written "
+                     "for another architecture, regenerate it with "
+                     "nad2bin.\n", gilist->filename );
+        map->ref_count = 1;
+        pj_gridmap_release( map );
+        pj_errno = -38;
+        return 0;
+    }
+
+    for( i = 0; i < header->grid_count; i++ )
+    {
+        if( entries[i].lim_lam < 1 || entries[i].lim_phi < 1
+            || entries[i].parent >= i
+            || entries[i].data_offset % sizeof(float) != 0
+            || entries[i].data_offset + (double) entries[i].lim_lam
+               * entries[i].lim_phi * sizeof(FLP) > map->size )
+        {
+            map->ref_count = 1;
+            pj_gridmap_release( map );
+            pj_errno = -38;
+            return 0;
+        }
+    }
+
+/* ==================================================================== */
+/*      Build the grid hierarchy.                                       */
+/* ==================================================================== */
+    gis = (PJ_GRIDINFO **) pj_malloc( sizeof(PJ_GRIDINFO *)
+                                      * header->grid_count );
+    if( gis == NULL )
+    {
+        map->ref_count = 1;
+        pj_gridmap_release( map );
+        pj_errno = -38;
+        return 0;
+    }
+
+    for( i = 0; i < header->grid_count; i++ )
+    {
+        MAPPED_ENTRY  *entry = entries + i;
+        struct CTABLE *ct;
+        PJ_GRIDINFO   *gi, *lnk;
+
+        ct = (struct CTABLE *) pj_malloc(sizeof(struct CTABLE));
+        if( ct == NULL )
+        {
+            unmap_partial_grids( map, gis, i );
+            pj_dalloc( gis );
+            pj_errno = ENOMEM;
+            return 0;
+        }
+        memcpy( ct->id, entry->id, MAX_TAB_ID );
+        ct->id[MAX_TAB_ID-1] = '\0';
+        ct->ll.lam = entry->ll_lam;
+        ct->ll.phi = entry->ll_phi;
+        ct->del.lam = entry->del_lam;
+        ct->del.phi = entry->del_phi;
+        ct->lim.lam = entry->lim_lam;
+        ct->lim.phi = entry->lim_phi;
+        ct->cvs = (FLP *) ((char *) map->base + entry->data_offset);
+
+        if( i == 0 )
+            gi = gilist;
+        else
+        {
+            gi = (PJ_GRIDINFO *) pj_malloc(sizeof(PJ_GRIDINFO));
+            if( gi != NULL )
+            {
+                memset( gi, 0, sizeof(PJ_GRIDINFO) );
+                gi->gridname = strdup( gilist->gridname );
+                gi->filename = strdup( gilist->filename );
+            }
+            if( gi == NULL || gi->gridname == NULL || gi->filename == NULL )
+            {
+                if( gi != NULL )
+                {
+                    free( gi->gridname );
+                    free( gi->filename );
+                    pj_dalloc( gi );
+                }
+                pj_dalloc( ct );
+                unmap_partial_grids( map, gis, i );
+                pj_dalloc( gis );
+                pj_errno = ENOMEM;
+                return 0;
+            }
+        }
+
+        gi->ct = ct;
+        gi->format = "mapped";
+        gi->grid_offset = entry->data_offset;
+        gi->map = map;
+        map->ref_count++;
+        gis[i] = gi;
+
+        if( pj_get_ctx()->debug_level )
+            fprintf( stderr, "Mapped %s %dx%d: LL=(%.9g,%.9g)\n",
+                     ct->id, ct->lim.lam, ct->lim.phi,
+                     ct->ll.lam * RAD_TO_DEG, ct->ll.phi * RAD_TO_DEG );
+
+        if( i == 0 )
+            continue;
+
+        if( entry->parent < 0 )
+        {
+            for( lnk = gilist; lnk->next != NULL; lnk = lnk->next ) {}
+            lnk->next = gi;
+        }
+        else if( gis[entry->parent]->child == NULL )
+            gis[entry->parent]->child = gi;
+        else
+        {
+            for( lnk = gis[entry->parent]->child; lnk->next != NULL; 
+                 lnk = lnk->next ) {}
+            lnk->next = gi;
+        }
+    }
+
+    pj_dalloc( gis );
+
+    return 1;
+}
+
+/************************************************************************/
+/*                      pj_gridinfo_write_mapped()                      */
+/*                                                                      */
+/*      Write a grid list (as from pj_gridinfo_init()) with all its     */
+/*      subgrids in the "mapped" format.  Used by nad2bin.              */
+/************************************************************************/
+
+static int count_grids( PJ_GRIDINFO *gi )
+
+{
+    int count = 0;
+
+    for( ; gi != NULL; gi = gi->next )
+        count += 1 + count_grids( gi->child );
+    return count;
+}
+
+static void collect_grids( PJ_GRIDINFO *gi, int parent,
+                           PJ_GRIDINFO **gis, int *parents, int *count )
+
+{
+    for( ; gi != NULL; gi = gi->next )
+    {
+        int index = (*count)++;
+
+        gis[index] = gi;
+        parents[index] = parent;
+        collect_grids( gi->child, index, gis, parents, count );
+    }
+}
+
+int pj_gridinfo_write_mapped( PJ_GRIDINFO *gilist, FILE *fp )
+
+{
+    MAPPED_HEADER header;
+    MAPPED_ENTRY  entry;
+    PJ_GRIDINFO   **gis;
+    int           *parents, count, i;
+    double        offset;
+    static const char zeros[MAPPED_ALIGN] = { 0 };
+
+    count = count_grids( gilist );
+    gis = (PJ_GRIDINFO **) pj_malloc( sizeof(PJ_GRIDINFO *) * count );
+    parents = (int *) pj_malloc( sizeof(int) * count );
+    if( gis == NULL || parents == NULL )
+    {
+        pj_dalloc( gis );
+        pj_dalloc( parents );
+        pj_errno = ENOMEM;
+        return 0;
+    }
+    i = 0;
+    collect_grids( gilist, -1, gis, parents, &i );
+
+    for( i = 0; i < count; i++ )
+    {
+        if( gis[i]->ct == NULL )
+        {
+            pj_dalloc( gis );
+            pj_dalloc( parents );
+            pj_errno = -38;
+            return 0;
+        }
+    }
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, MAPPED_MAGIC, 8 );
+    header.byte_order = MAPPED_BYTE_ORDER;
+    header.grid_count = count;
+    header.entry_size = sizeof(MAPPED_ENTRY);
+    if( fwrite( &header, sizeof(header), 1, fp ) != 1 )
+    {
+        pj_dalloc( gis );
+        pj_dalloc( parents );
+        pj_errno = errno ? errno : -38;
+        return 0;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Entries, with the data offsets laid out after all of them.      */
+/* -------------------------------------------------------------------- */
+    offset = sizeof(MAPPED_HEADER) + count * sizeof(MAPPED_ENTRY);
+    for( i = 0; i < count; i++ )
+    {
+        struct CTABLE *ct = gis[i]->ct;
+
+        offset = ceil( offset / MAPPED_ALIGN ) * MAPPED_ALIGN;
+        if( offset > 4294967295.0 - 16 )
+        {
+            pj_dalloc( gis );
+            pj_dalloc( parents );
+            pj_errno = -38;
+            return 0;
+        }
+
+        memset( &entry, 0, sizeof(entry) );
+        memcpy( entry.id, ct->id, MAX_TAB_ID - 1 );
+        entry.ll_lam = ct->ll.lam;
+        entry.ll_phi = ct->ll.phi;
+        entry.del_lam = ct->del.lam;
+        entry.del_phi = ct->del.phi;
+        entry.lim_lam = ct->lim.lam;
+        entry.lim_phi = ct->lim.phi;
+        entry.parent = parents[i];
+        entry.data_offset = (unsigned int) offset;
+        if( fwrite( &entry, sizeof(entry), 1, fp ) != 1 )
+        {
+            pj_dalloc( gis );
+            pj_dalloc( parents );
+            pj_errno = errno ? errno : -38;
+            return 0;
+        }
+
+        offset += (double) ct->lim.lam * ct->lim.phi * sizeof(FLP);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Table data, padded to the alignment.  Each grid is loaded and   */
+/*      pinned only while its cells are written: under a grid cache     */
+/*      budget, loading them all first would unload the earlier ones.   */
+/* -------------------------------------------------------------------- */
+    offset = sizeof(MAPPED_HEADER) + count * sizeof(MAPPED_ENTRY);
+    for( i = 0; i < count; i++ )
+    {
+        struct CTABLE *ct = gis[i]->ct;
+        size_t cells = (size_t) ct->lim.lam * ct->lim.phi, written;
+        int    pad = (int) (ceil( offset / MAPPED_ALIGN ) * MAPPED_ALIGN 
+                            - offset);
+        int    loaded;
+
+        pj_acquire_lock();
+        loaded = pj_gridcache_pin( gis[i] );
+        pj_release_lock();
+        if( !loaded )
+        {
+            pj_dalloc( gis );
+            pj_dalloc( parents );
+            if( pj_errno == 0 )
+                pj_errno = -38;
+            return 0;
+        }
+
+        written = 0;
+        if( fwrite( zeros, 1, pad, fp ) == (size_t) pad )
+            written = fwrite( ct->cvs, sizeof(FLP), cells, fp );
+
+        pj_acquire_lock();
+        pj_gridcache_unpin( gis[i] );
+        pj_release_lock();
+
+        if( written != cells )
+        {
+            pj_dalloc( gis );
+            pj_dalloc( parents );
+            pj_errno = errno ? errno : -38;
+            return 0;
+        }
+        offset += pad + cells * sizeof(FLP);
+    }
+
+    pj_dalloc( gis );
+    pj_dalloc( parents );
+
+    if( ferror( fp ) )
+    {
+        pj_errno = errno ? errno : -38;
+        return 0;
+    }
+
+    return 1;
+}
+
 /************************************************************************/
 /*                          pj_gridinfo_init()                          */
 /*                                                                      */
@@ -685,6 +1201,11 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
         pj_gridinfo_init_ntv1( fp, gilist );
     }
     
+    else if( strncmp(header + 0, MAPPED_MAGIC, 8) == 0 )
+    {
+        pj_gridinfo_init_mapped( fp, gilist );
+    }
+
     else if( strncmp(header + 0, "NUM_OREC", 8) == 0 
              && strncmp(header + 48, "GS_TYPE", 7) == 0 )
     {
@@ -698,7 +1219,7 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
         gilist->format = "ctable";
         gilist->ct = ct;
 
-        if( getenv("PROJ_DEBUG") != NULL )
+        if( pj_get_ctx()->debug_level )
             fprintf( stderr, 
                      "Ctable %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
                      ct->id, 
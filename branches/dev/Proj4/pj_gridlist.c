@@ -64,22 +64,46 @@
 
 static PJ_GRIDINFO *grid_list = NULL;
 
-/* used only by pj_load_nadgrids() and pj_deallocate_grids() */
+/* bumped by pj_deallocate_grids() so contexts drop stale nadgrids lists */
+static int grid_generation = 1;
 
-static int           last_nadgrids_max = 0;
-static int           last_nadgrids_count = 0;
-static PJ_GRIDINFO **last_nadgrids_list = NULL;
-static char         *last_nadgrids = NULL;
+/************************************************************************/
+/*                       pj_gridlist_ctx_clear()                        */
+/*                                                                      */
+/*      Forget the nadgrids list cached in a context.                   */
+/************************************************************************/
+
+void pj_gridlist_ctx_clear( projCtx ctx )
+
+{
+    if( ctx->last_nadgrids != NULL )
+    {
+        pj_dalloc( ctx->last_nadgrids );
+        ctx->last_nadgrids = NULL;
+    }
+    if( ctx->last_nadgrids_list != NULL )
+    {
+        pj_dalloc( ctx->last_nadgrids_list );
+        ctx->last_nadgrids_list = NULL;
+    }
+    pj_gridindex_free( ctx->last_nadgrids_index );
+    ctx->last_nadgrids_index = NULL;
+    ctx->last_nadgrids_count = 0;
+    ctx->last_nadgrids_max = 0;
+}
 
 /************************************************************************/
 /*                        pj_deallocate_grids()                         */
 /*                                                                      */
-/*      Deallocate all loaded grids.                                    */
+/*      Deallocate all loaded grids.  No other thread may be using      */
+/*      grid shifts while this runs.                                    */
 /************************************************************************/
 
 void pj_deallocate_grids()
 
 {
+    pj_acquire_lock();
+
     while( grid_list != NULL )
     {
         PJ_GRIDINFO *item = grid_list;
@@ -88,28 +112,21 @@ void pj_deallocate_grids()
 
         pj_gridinfo_free( item );
     }
+    grid_generation++;
 
-    if( last_nadgrids != NULL )
-    {
-        pj_dalloc( last_nadgrids );
-        last_nadgrids = NULL;
+    pj_release_lock();
 
-        pj_dalloc( last_nadgrids_list );
-        last_nadgrids_list = NULL;
-
-        last_nadgrids_count = 0;
-        last_nadgrids_max = 0;
-    }
+    pj_gridlist_ctx_clear( pj_get_ctx() );
 }
 
 /************************************************************************/
 /*                       pj_gridlist_merge_grid()                       */
 /*                                                                      */
 /*      Find/load the named gridfile and merge it into the              */
-/*      last_nadgrids_list.                                             */
+/*      context's last_nadgrids_list.  Called with the lock held.       */
 /************************************************************************/
 
-static int pj_gridlist_merge_gridfile( const char *gridname )
+static int pj_gridlist_merge_gridfile( projCtx ctx, const char *gridname )
 
 {
     int i, got_match=0;
@@ -131,26 +148,26 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
                 return 0;
 
             /* do we need to grow the list? */
-            if( last_nadgrids_count >= last_nadgrids_max - 2 )
+            if( ctx->last_nadgrids_count >= ctx->last_nadgrids_max - 2 )
             {
                 PJ_GRIDINFO **new_list;
-                int new_max = last_nadgrids_max + 20;
+                int new_max = ctx->last_nadgrids_max + 20;
 
                 new_list = (PJ_GRIDINFO **) pj_malloc(sizeof(void*) * new_max);
-                if( last_nadgrids_list != NULL )
+                if( ctx->last_nadgrids_list != NULL )
                 {
-                    memcpy( new_list, last_nadgrids_list, 
-                            sizeof(void*) * last_nadgrids_max );
-                    pj_dalloc( last_nadgrids_list );
+                    memcpy( new_list, ctx->last_nadgrids_list, 
+                            sizeof(void*) * ctx->last_nadgrids_max );
+                    pj_dalloc( ctx->last_nadgrids_list );
                 }
 
-                last_nadgrids_list = new_list;
-                last_nadgrids_max = new_max;
+                ctx->last_nadgrids_list = new_list;
+                ctx->last_nadgrids_max = new_max;
             }
 
             /* add to the list */
-            last_nadgrids_list[last_nadgrids_count++] = this_grid;
-            last_nadgrids_list[last_nadgrids_count] = NULL;
+            ctx->last_nadgrids_list[ctx->last_nadgrids_count++] = this_grid;
+            ctx->last_nadgrids_list[ctx->last_nadgrids_count] = NULL;
         }
 
         tail = this_grid;
@@ -176,10 +193,31 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
     else
         grid_list = this_grid;
 
+    /* index the subgrids of NTv2 style files while we hold the lock */
+    for( ; this_grid != NULL; this_grid = this_grid->next )
+    {
+        PJ_GRIDINFO *child, **children;
+        int          count = 0;
+
+        for( child = this_grid->child; child != NULL; child = child->next )
+            count++;
+        if( count == 0 )
+            continue;
+
+        children = (PJ_GRIDINFO **) pj_malloc( sizeof(void*) * count );
+        if( children == NULL )
+            continue;
+        for( count = 0, child = this_grid->child; child != NULL; 
+             child = child->next )
+            children[count++] = child;
+        this_grid->child_index = pj_gridindex_build( children, count );
+        pj_dalloc( children );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Recurse to add the grid now that it is loaded.                  */
 /* -------------------------------------------------------------------- */
-    return pj_gridlist_merge_gridfile( gridname );
+    return pj_gridlist_merge_gridfile( ctx, gridname );
 }
 
 /************************************************************************/
@@ -189,39 +227,47 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
 /*      particular nadgrids string into a list, and returns it.  The    */
 /*      list is kept around till a request is made with a different     */
 /*      string in order to cut down on the string parsing cost, and     */
-/*      the cost of building the list of tables each time.              */
+/*      the cost of building the list of tables each time.  The list    */
+/*      belongs to the calling thread's context.                        */
 /************************************************************************/
 
 PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
 
 {
     const char *s;
+    projCtx ctx = pj_get_ctx();
 
     pj_errno = 0;
     *grid_count = 0;
 
-    if( last_nadgrids != NULL 
-        && strcmp(nadgrids,last_nadgrids) == 0 )
+    if( ctx->last_nadgrids != NULL 
+        && ctx->last_nadgrids_generation == grid_generation
+        && strcmp(nadgrids,ctx->last_nadgrids) == 0 )
     {
-        *grid_count = last_nadgrids_count;
+        *grid_count = ctx->last_nadgrids_count;
         if( *grid_count == 0 )
             pj_errno = -38;
 
-        return last_nadgrids_list;
+        return ctx->last_nadgrids_list;
     }
 
 /* -------------------------------------------------------------------- */
 /*      Free old one, if any, and make space for new list.              */
 /* -------------------------------------------------------------------- */
-    if( last_nadgrids != NULL )
+    if( ctx->last_nadgrids != NULL )
     {
-        pj_dalloc(last_nadgrids);
+        pj_dalloc(ctx->last_nadgrids);
     }
     
-    last_nadgrids = (char *) pj_malloc(strlen(nadgrids)+1);
-    strcpy( last_nadgrids, nadgrids );
+    ctx->last_nadgrids = (char *) pj_malloc(strlen(nadgrids)+1);
+    strcpy( ctx->last_nadgrids, nadgrids );
 
-    last_nadgrids_count = 0;
+    ctx->last_nadgrids_count = 0;
+    pj_gridindex_free( ctx->last_nadgrids_index );
+    ctx->last_nadgrids_index = NULL;
+
+    pj_acquire_lock();
+    ctx->last_nadgrids_generation = grid_generation;
 
 /* -------------------------------------------------------------------- */
 /*      Loop processing names out of nadgrids one at a time.            */
@@ -244,6 +290,7 @@ PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
 
         if( end_char > sizeof(name) )
         {
+            pj_release_lock();
             pj_errno = -38;
             return NULL;
         }
@@ -255,8 +302,9 @@ PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
         if( *s == ',' )
             s++;
 
-        if( !pj_gridlist_merge_gridfile( name ) && required )
+        if( !pj_gridlist_merge_gridfile( ctx, name ) && required )
         {
+            pj_release_lock();
             pj_errno = -38;
             return NULL;
         }
@@ -264,10 +312,12 @@ PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
             pj_errno = 0;
     }
 
-    if( last_nadgrids_count > 0 )
+    pj_release_lock();
+
+    if( ctx->last_nadgrids_count > 0 )
     {
-        *grid_count = last_nadgrids_count;
-        return last_nadgrids_list;
+        *grid_count = ctx->last_nadgrids_count;
+        return ctx->last_nadgrids_list;
     }
     else
         return NULL;
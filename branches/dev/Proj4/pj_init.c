@@ -182,13 +182,20 @@ pj_init_plus( const char *definition )
 {
 #define MAX_ARG 200
     char	*argv[MAX_ARG];
-    char	*defn_copy;
+    char	*defn_copy, defn_buf[512];
     int		argc = 0, i;
+    size_t	len = strlen(definition);
     PJ	        *result;
     
-    /* make a copy that we can manipulate */
-    defn_copy = (char *) pj_malloc( strlen(definition)+1 );
-    strcpy( defn_copy, definition );
+    /* make a copy that we can manipulate, on the stack if it is short */
+    if( len < sizeof(defn_buf) )
+        defn_copy = defn_buf;
+    else if( (defn_copy = (char *) pj_malloc( len+1 )) == NULL )
+    {
+        pj_errno = ENOMEM;
+        return NULL;
+    }
+    memcpy( defn_copy, definition, len+1 );
 
     /* split into arguments based on '+' and trim white space */
 
@@ -201,6 +208,8 @@ pj_init_plus( const char *definition )
             {
                 if( argc+1 == MAX_ARG )
                 {
+                    if( defn_copy != defn_buf )
+                        pj_dalloc( defn_copy );
                     pj_errno = -44;
                     return NULL;
                 }
@@ -223,7 +232,8 @@ pj_init_plus( const char *definition )
     /* perform actual initialization */
     result = pj_init( argc, argv );
 
-    pj_dalloc( defn_copy );
+    if( defn_copy != defn_buf )
+        pj_dalloc( defn_copy );
 
     return result;
 }
@@ -257,6 +267,7 @@ pj_init(int argc, char **argv) {
 		else
 			start = curr = pj_mkparam(argv[i]);
 	if (pj_errno) goto bum_call;
+	pj_param_index(start);
 
 	/* check if +init present */
 	if (pj_param(start, "tinit").i) {
@@ -270,13 +281,16 @@ pj_init(int argc, char **argv) {
 	/* find projection selection */
 	if (!(name = pj_param(start, "sproj").s))
 		{ pj_errno = -4; goto bum_call; }
-	for (i = 0; (s = pj_list[i].id) && strcmp(name, s) ; ++i) ;
+	/* the first character test skips most of the list cheaply */
+	for (i = 0; (s = pj_list[i].id) && (*s != *name || strcmp(name, s)) ;
+	     ++i) ;
 	if (!s) { pj_errno = -5; goto bum_call; }
 
 	/* set defaults, unless inhibited */
 	if (!pj_param(start, "bno_defs").i)
 		curr = get_defaults(&start, curr, name);
 	proj = (PJ *(*)(PJ *)) pj_list[i].proj;
+	pj_param_index(start);
 
 	/* allocate projection structure */
 	if (!(PIN = (*proj)(0))) goto bum_call;
@@ -287,6 +301,7 @@ pj_init(int argc, char **argv) {
 
         /* set datum parameters */
         if (pj_datum_set(start, PIN)) goto bum_call;
+	pj_param_index(start);
 
 	/* set ellipsoid/sphere parameters */
 	if (pj_ell_set(start, &PIN->a, &PIN->es)) goto bum_call;
@@ -391,7 +406,7 @@ bum_call: /* cleanup error return */
 		if (PIN)
 			pj_free(PIN);
 		else
-			for ( ; start; start = curr) {
+			for (pj_param_unindex(start); start; start = curr) {
 				curr = start->next;
 				pj_dalloc(start);
 			}
@@ -416,6 +431,7 @@ pj_free(PJ *P) {
 		paralist *t = P->params, *n;
 
 		/* free parameter list elements */
+		pj_param_unindex(P->params);
 		for (t = P->params; t; t = n) {
 			n = t->next;
 			pj_dalloc(t);
@@ -30,3 +30,55 @@ pj_inv(XY xy, PJ *P) {
 	}
 	return lp;
 }
+
+#define BATCH_CHUNK 256
+	int /* inverse projection of x/y arrays in place, x/y in -> lam/phi out */
+pj_inv_batch(PJ *P, long n, double *x, double *y, int *status) {
+	int st[BATCH_CHUNK], *s, err = 0;
+	long i, j, m;
+
+	for (j = 0; j < n; j += BATCH_CHUNK) {
+		m = n - j < BATCH_CHUNK ? n - j : BATCH_CHUNK;
+		s = status ? status + j : st;
+		for (i = j; i < j + m; ++i) {
+			if (x[i] == HUGE_VAL || y[i] == HUGE_VAL) {
+				s[i - j] = -15;
+				x[i] = y[i] = 0.;
+				continue;
+			}
+			s[i - j] = 0;
+			x[i] = (x[i] * P->to_meter - P->x0) * P->ra;
+			y[i] = (y[i] * P->to_meter - P->y0) * P->ra;
+		}
+		/* projection supplied array kernel, scalar code for the rest */
+		i = j + (P->inv_batch ? (*P->inv_batch)(m, x + j, y + j, s, P) : 0);
+		for (; i < j + m; ++i) {
+			XY xy;
+			LP lp;
+
+			if (s[i - j])
+				continue;
+			xy.x = x[i];
+			xy.y = y[i];
+			errno = pj_errno = 0;
+			lp = (*P->inv)(xy, P);
+			if (pj_errno || (pj_errno = errno))
+				s[i - j] = pj_errno;
+			x[i] = lp.lam;
+			y[i] = lp.phi;
+		}
+		for (i = j; i < j + m; ++i) {
+			if (s[i - j]) {
+				x[i] = y[i] = HUGE_VAL;
+				err = s[i - j];
+				continue;
+			}
+			x[i] += P->lam0;
+			if (!P->over)
+				x[i] = adjlon(x[i]);
+			if (P->geoc && fabs(fabs(y[i])-HALFPI) > EPS)
+				y[i] = atan(P->one_es * tan(y[i]));
+		}
+	}
+	return (pj_errno = err);
+}
@@ -179,7 +179,7 @@ pj_open_lib(char *name, char *mode) {
             errno = 0;
     }
 
-    if( getenv( "PROJ_DEBUG" ) != NULL )
+    if( pj_get_ctx()->debug_level )
         fprintf( stderr, "pj_open_lib(%s): call fopen(%s) - %s\n",
                  name, sysname,
                  fid == NULL ? "failed" : "succeeded" );
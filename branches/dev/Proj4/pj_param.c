@@ -5,6 +5,17 @@ static const char SCCSID[]="@(#)pj_param.c	4.4	93/06/12	GIE	REL";
 #include "projects.h"
 #include <stdio.h>
 #include <string.h>
+
+/* hash of a parameter name (FNV-1a), up to len characters */
+	static unsigned
+key_hash(const char *key, unsigned len) {
+	unsigned h = 2166136261u;
+
+	while (len--)
+		h = (h ^ (unsigned char)*key++) * 16777619u;
+	return h;
+}
+
 	paralist * /* create parameter list entry */
 pj_mkparam(char *str) {
 	paralist *newitem;
@@ -12,13 +23,102 @@ pj_mkparam(char *str) {
 	if (newitem = (paralist *)pj_malloc(sizeof(paralist) + strlen(str))) {
 		newitem->used = 0;
 		newitem->next = 0;
+		newitem->table = 0;
 		if (*str == '+')
 			++str;
 		(void)strcpy(newitem->param, str);
+		newitem->key_len = strcspn(newitem->param, "=");
+		newitem->hash = key_hash(newitem->param, newitem->key_len);
 	}
 	return newitem;
 }
 
+/************************************************************************/
+/*                           pj_param_index()                           */
+/*                                                                      */
+/*      Build, or extend with the entries appended since, the hash      */
+/*      table pj_param() uses to find names in the list starting at     */
+/*      pl.  Each name maps to its first entry.  Entries appended       */
+/*      later are still found, by a scan after the table.  Not to be    */
+/*      called while entries that will be removed again are on the      */
+/*      list, see pj_ell_set().                                         */
+/************************************************************************/
+
+	void
+pj_param_index(paralist *pl) {
+	PJ_PARAM_TABLE *table = pl->table;
+	paralist *p, *from;
+	unsigned size, slot;
+	int count;
+
+	from = table ? table->tail->next : pl;
+	if (!from)
+		return;
+	for (count = table ? table->count : 0, p = from; p; p = p->next)
+		++count;
+
+	/* keep the table at most half full, rebuilding it if needed */
+	if (!table || (unsigned) count * 2 > table->mask + 1) {
+		for (size = 16; size < (unsigned) count * 2; size <<= 1) ;
+		table = (PJ_PARAM_TABLE *)pj_malloc(sizeof(PJ_PARAM_TABLE)
+			+ (size - 1) * sizeof(paralist *));
+		if (!table)
+			return;	/* lookups fall back to the list */
+		memset(table->slots, 0, size * sizeof(paralist *));
+		table->mask = size - 1;
+		table->count = 0;
+		pj_param_unindex(pl);
+		pl->table = table;
+		from = pl;
+	}
+
+	for (p = from; p; p = p->next) {
+		for (slot = p->hash & table->mask; table->slots[slot];
+				slot = (slot + 1) & table->mask)
+			if (table->slots[slot]->hash == p->hash
+				&& table->slots[slot]->key_len == p->key_len
+				&& !strncmp(table->slots[slot]->param, p->param, p->key_len))
+				break;
+		if (!table->slots[slot])
+			table->slots[slot] = p;
+		table->tail = p;
+		++table->count;
+	}
+}
+
+	void /* drop the table built by pj_param_index() */
+pj_param_unindex(paralist *pl) {
+	if (pl && pl->table) {
+		pj_dalloc(pl->table);
+		pl->table = 0;
+	}
+}
+
+/************************************************************************/
+/*                            param_find()                              */
+/************************************************************************/
+
+#define KEY_MATCH(p, key, len, h) ((p)->hash == (h) && (p)->key_len == (len) \
+	&& !strncmp((p)->param, key, len))
+
+	static paralist *
+param_find(paralist *pl, const char *key, unsigned len) {
+	PJ_PARAM_TABLE *table;
+	unsigned h = key_hash(key, len), slot;
+
+	if (pl && (table = pl->table) != NULL) {
+		for (slot = h & table->mask; table->slots[slot];
+				slot = (slot + 1) & table->mask)
+			if (KEY_MATCH(table->slots[slot], key, len, h))
+				return table->slots[slot];
+		pl = table->tail->next;
+	}
+	for ( ; pl; pl = pl->next)
+		if (KEY_MATCH(pl, key, len, h))
+			return pl;
+	return 0;
+}
+
 /************************************************************************/
 /*                              pj_param()                              */
 /*                                                                      */
@@ -43,11 +143,8 @@ pj_param(paralist *pl, char *opt) {
 	PVALUE value;
 
 	type = *opt++;
-	/* simple linear lookup */
 	l = strlen(opt);
-	while (pl && !(!strncmp(pl->param, opt, l) &&
-	  (!pl->param[l] || pl->param[l] == '=')))
-		pl = pl->next;
+	pl = param_find(pl, opt, l);
 	if (type == 't')
 		value.i = pl != 0;
 	else if (pl) {
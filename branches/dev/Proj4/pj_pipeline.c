@@ -0,0 +1,415 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Prepared transformations: pj_transform() with the decisions
+ *           about which stages are needed taken once per PJ pair.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * pj_transform_prepare() looks at a source and destination definition
+ * and records the stages pj_transform() would run for them as a short
+ * list, leaving out the ones that do nothing:
+ *
+ *  - identical definitions (same PJ, or the same pj_get_def() text)
+ *    reduce to nothing but the +lon_wrap step, if any;
+ *  - unit scaling by 1.0 and prime meridian offsets of 0 are dropped,
+ *    and the source and destination meridian offsets are folded into
+ *    one when no datum shift sits between them;
+ *  - the datum stage is dropped when pj_datum_transform() would return
+ *    without doing anything (unknown datum or pj_compare_datums());
+ *  - geocentric to geocentric on the same ellipsoid becomes a single
+ *    scale.
+ *
+ * Projection stages go through pj_fwd_batch()/pj_inv_batch() when the
+ * points are packed (point_offset 1), so array kernels are used.
+ *
+ * The pipeline only points at the two definitions; they must outlive it.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+#include <errno.h>
+
+#define PJ_STAGE_SCALE          1   /* x, y *= value */
+#define PJ_STAGE_ADD_LON        2   /* x += value */
+#define PJ_STAGE_GEOCENT_SRC    3   /* geocentric to geodetic, source ellps */
+#define PJ_STAGE_INV            4   /* source inverse projection */
+#define PJ_STAGE_DATUM          5   /* pj_datum_transform() */
+#define PJ_STAGE_GEOCENT_DST    6   /* geodetic to geocentric, dest. ellps */
+#define PJ_STAGE_FWD            7   /* destination forward projection */
+#define PJ_STAGE_WRAP           8   /* +lon_wrap of the destination */
+
+#define STATUS_CHUNK 1024
+
+/************************************************************************/
+/*                             add_stage()                              */
+/************************************************************************/
+
+static void add_stage( struct PJ_PIPELINE *pl, int op, double value )
+
+{
+    pl->stages[pl->stage_count].op = op;
+    pl->stages[pl->stage_count].value = value;
+    pl->stage_count++;
+}
+
+/************************************************************************/
+/*                        same_definition()                             */
+/************************************************************************/
+
+static int same_definition( PJ *srcdefn, PJ *dstdefn )
+
+{
+    char *src_def, *dst_def;
+    int  same;
+
+    if( srcdefn == dstdefn )
+        return 1;
+
+    src_def = pj_get_def( srcdefn, 0 );
+    dst_def = pj_get_def( dstdefn, 0 );
+    same = strcmp( src_def, dst_def ) == 0;
+    pj_dalloc( src_def );
+    pj_dalloc( dst_def );
+
+    return same;
+}
+
+/************************************************************************/
+/*                        pj_transform_prepare()                        */
+/************************************************************************/
+
+struct PJ_PIPELINE *pj_transform_prepare( PJ *srcdefn, PJ *dstdefn )
+
+{
+    struct PJ_PIPELINE *pl;
+    int    need_datum;
+
+    pj_errno = 0;
+
+    if( !srcdefn->is_latlong && !srcdefn->is_geocent && srcdefn->inv == NULL )
+    {
+        pj_errno = -17; /* as pj_transform(), no inverse */
+        return NULL;
+    }
+
+    pl = (struct PJ_PIPELINE *) pj_malloc( sizeof(struct PJ_PIPELINE) );
+    if( pl == NULL )
+    {
+        pj_errno = ENOMEM;
+        return NULL;
+    }
+    memset( pl, 0, sizeof(struct PJ_PIPELINE) );
+    pl->srcdefn = srcdefn;
+    pl->dstdefn = dstdefn;
+
+/* -------------------------------------------------------------------- */
+/*      Identical definitions, only the longitude wrap can change       */
+/*      anything.                                                       */
+/* -------------------------------------------------------------------- */
+    if( same_definition( srcdefn, dstdefn ) )
+    {
+        if( dstdefn->is_latlong && dstdefn->long_wrap_center != 0 )
+            add_stage( pl, PJ_STAGE_WRAP, dstdefn->long_wrap_center );
+        return pl;
+    }
+
+    need_datum = srcdefn->datum_type != PJD_UNKNOWN
+        && dstdefn->datum_type != PJD_UNKNOWN
+        && !pj_compare_datums( srcdefn, dstdefn );
+
+/* -------------------------------------------------------------------- */
+/*      Geocentric to geocentric without a change of ellipsoid is       */
+/*      just the unit conversion.                                       */
+/* -------------------------------------------------------------------- */
+    if( srcdefn->is_geocent && dstdefn->is_geocent && !need_datum
+        && srcdefn->a_orig == dstdefn->a_orig
+        && srcdefn->es_orig == dstdefn->es_orig
+        && srcdefn->from_greenwich == dstdefn->from_greenwich )
+    {
+        pl->needs_z = 1;
+        if( srcdefn->to_meter * dstdefn->fr_meter != 1.0 )
+            add_stage( pl, PJ_STAGE_SCALE,
+                       srcdefn->to_meter * dstdefn->fr_meter );
+        return pl;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Source to geodetic.                                             */
+/* -------------------------------------------------------------------- */
+    if( srcdefn->is_geocent )
+    {
+        pl->needs_z = 1;
+        if( srcdefn->to_meter != 1.0 )
+            add_stage( pl, PJ_STAGE_SCALE, srcdefn->to_meter );
+        add_stage( pl, PJ_STAGE_GEOCENT_SRC, 0.0 );
+    }
+    else if( !srcdefn->is_latlong )
+        add_stage( pl, PJ_STAGE_INV, 0.0 );
+
+/* -------------------------------------------------------------------- */
+/*      Prime meridians and datum shift.                                */
+/* -------------------------------------------------------------------- */
+    if( need_datum )
+    {
+        if( srcdefn->from_greenwich != 0.0 )
+            add_stage( pl, PJ_STAGE_ADD_LON, srcdefn->from_greenwich );
+        add_stage( pl, PJ_STAGE_DATUM, 0.0 );
+        if( dstdefn->from_greenwich != 0.0 )
+            add_stage( pl, PJ_STAGE_ADD_LON, -dstdefn->from_greenwich );
+    }
+    else if( srcdefn->from_greenwich != dstdefn->from_greenwich )
+        add_stage( pl, PJ_STAGE_ADD_LON,
+                   srcdefn->from_greenwich - dstdefn->from_greenwich );
+
+/* -------------------------------------------------------------------- */
+/*      Geodetic to destination.                                        */
+/* -------------------------------------------------------------------- */
+    if( dstdefn->is_geocent )
+    {
+        pl->needs_z = 1;
+        add_stage( pl, PJ_STAGE_GEOCENT_DST, 0.0 );
+        if( dstdefn->fr_meter != 1.0 )
+            add_stage( pl, PJ_STAGE_SCALE, dstdefn->fr_meter );
+    }
+    else if( !dstdefn->is_latlong )
+        add_stage( pl, PJ_STAGE_FWD, 0.0 );
+    else if( dstdefn->long_wrap_center != 0 )
+        add_stage( pl, PJ_STAGE_WRAP, dstdefn->long_wrap_center );
+
+    return pl;
+}
+
+/************************************************************************/
+/*                           run_projection()                           */
+/*                                                                      */
+/*      Forward or inverse projection stage.  Packed arrays go          */
+/*      through the batch entry points; errors are classified as in     */
+/*      pj_transform() for a call on request_count points.              */
+/************************************************************************/
+
+static int run_projection( PJ *P, int forward, long point_count,
+                           int point_offset, double *x, double *y,
+                           long request_count )
+
+{
+    long i, j, m;
+
+    if( point_offset == 1 && point_count > 1 )
+    {
+        int status[STATUS_CHUNK];
+
+        for( j = 0; j < point_count; j += STATUS_CHUNK )
+        {
+            m = point_count - j < STATUS_CHUNK ? point_count - j
+                : STATUS_CHUNK;
+            if( forward )
+                pj_fwd_batch( P, m, x + j, y + j, status );
+            else
+                pj_inv_batch( P, m, x + j, y + j, status );
+
+            for( i = 0; i < m; i++ )
+            {
+                if( status[i] != 0
+                    && !pj_transient_error( status[i], request_count ) )
+                    return (pj_errno = status[i]);
+            }
+        }
+        return 0;
+    }
+
+    for( i = 0; i < point_count; i++ )
+    {
+        long io = i * point_offset;
+        XY   xy;
+        LP   lp;
+
+        if( x[io] == HUGE_VAL )
+            continue;
+
+        if( forward )
+        {
+            lp.lam = x[io];
+            lp.phi = y[io];
+            xy = pj_fwd( lp, P );
+        }
+        else
+        {
+            xy.x = x[io];
+            xy.y = y[io];
+            lp = pj_inv( xy, P );
+            xy.x = lp.lam;
+            xy.y = lp.phi;
+        }
+
+        if( pj_errno != 0 )
+        {
+            if( !pj_transient_error( pj_errno, request_count ) )
+                return pj_errno;
+            xy.x = xy.y = HUGE_VAL;
+        }
+        x[io] = xy.x;
+        y[io] = xy.y;
+    }
+    return 0;
+}
+
+/************************************************************************/
+/*                          pj_transform_run()                          */
+/*                                                                      */
+/*      Same arguments and results as pj_transform() for the pair the   */
+/*      pipeline was prepared from.                                     */
+/************************************************************************/
+
+int pj_transform_run( struct PJ_PIPELINE *pl, long point_count,
+                      int point_offset, double *x, double *y, double *z )
+
+{
+    return pj_transform_run_part( pl, point_count, point_offset, x, y, z,
+                                  point_count );
+}
+
+/************************************************************************/
+/*                        pj_transform_run_part()                       */
+/*                                                                      */
+/*      pj_transform_run() on some of the points of a call on           */
+/*      request_count points, whose count decides which errors only     */
+/*      fail their point (see pj_transient_error()).                    */
+/************************************************************************/
+
+int pj_transform_run_part( struct PJ_PIPELINE *pl, long point_count,
+                           int point_offset, double *x, double *y,
+                           double *z, long request_count )
+
+{
+    int  s;
+    long i, io;
+
+    pj_errno = 0;
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+    if( pl->needs_z && z == NULL )
+    {
+        pj_errno = PJD_ERR_GEOCENTRIC;
+        return PJD_ERR_GEOCENTRIC;
+    }
+
+    for( s = 0; s < pl->stage_count; s++ )
+    {
+        PJ_STAGE *stage = pl->stages + s;
+
+        switch( stage->op )
+        {
+          case PJ_STAGE_SCALE:
+            for( i = 0; i < point_count; i++ )
+            {
+                io = i * point_offset;
+                if( x[io] != HUGE_VAL )
+                {
+                    x[io] *= stage->value;
+                    y[io] *= stage->value;
+                }
+            }
+            break;
+
+          case PJ_STAGE_ADD_LON:
+            for( i = 0; i < point_count; i++ )
+            {
+                io = i * point_offset;
+                if( x[io] != HUGE_VAL )
+                    x[io] += stage->value;
+            }
+            break;
+
+          case PJ_STAGE_GEOCENT_SRC:
+            if( pj_geocentric_to_geodetic( pl->srcdefn->a_orig,
+                                           pl->srcdefn->es_orig,
+                                           point_count, point_offset,
+                                           x, y, z ) != 0 )
+                return pj_errno;
+            break;
+
+          case PJ_STAGE_INV:
+          case PJ_STAGE_FWD:
+            if( run_projection( stage->op == PJ_STAGE_FWD ? pl->dstdefn
+                                : pl->srcdefn, stage->op == PJ_STAGE_FWD,
+                                point_count, point_offset, x, y,
+                                request_count ) != 0 )
+                return pj_errno;
+            break;
+
+          case PJ_STAGE_DATUM:
+            if( pj_datum_transform( pl->srcdefn, pl->dstdefn, point_count,
+                                    point_offset, x, y, z ) != 0 )
+                return pj_errno;
+            break;
+
+          case PJ_STAGE_GEOCENT_DST:
+            pj_geodetic_to_geocentric( pl->dstdefn->a_orig,
+                                       pl->dstdefn->es_orig,
+                                       point_count, point_offset, x, y, z );
+            break;
+
+          case PJ_STAGE_WRAP:
+            for( i = 0; i < point_count; i++ )
+            {
+                io = i * point_offset;
+                if( x[io] == HUGE_VAL )
+                    continue;
+
+                while( x[io] < stage->value - HALFPI )
+                    x[io] += PI;
+                while( x[io] > stage->value + HALFPI )
+                    x[io] -= PI;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                      pj_transform_is_identity()                      */
+/************************************************************************/
+
+int pj_transform_is_identity( struct PJ_PIPELINE *pl )
+
+{
+    return pl->stage_count == 0;
+}
+
+/************************************************************************/
+/*                         pj_transform_free()                          */
+/************************************************************************/
+
+void pj_transform_free( struct PJ_PIPELINE *pl )
+
+{
+    if( pl != NULL )
+        pj_dalloc( pl );
+}
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Private SIMD helpers (SSE2/AVX2) and vector versions of the
+ *           few elementary functions needed by the batch kernels.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * The vector width is chosen at compile time: AVX2 gives four doubles per
+ * register, SSE2 two.  On other targets (ie. ARM) PJ_HAVE_SIMD is left
+ * undefined and callers fall back to their scalar loops.
+ *
+ * The elementary functions are the Cephes double precision algorithms
+ * (S. L. Moshier) with branches replaced by lane selects.  They are
+ * accurate to a couple of ulp over the ranges the projection kernels use,
+ * but are not bit identical to the system libm.
+ */
+
+#ifndef PJ_SIMD_H
+#define PJ_SIMD_H
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define PJ_VLEN 4
+typedef __m256d pj_vd;
+typedef __m256i pj_vi;
+#  define pj_vload(p)       _mm256_loadu_pd(p)
+#  define pj_vstore(p,a)    _mm256_storeu_pd(p,a)
+#  define pj_vset1(d)       _mm256_set1_pd(d)
+#  define pj_vadd(a,b)      _mm256_add_pd(a,b)
+#  define pj_vsub(a,b)      _mm256_sub_pd(a,b)
+#  define pj_vmul(a,b)      _mm256_mul_pd(a,b)
+#  define pj_vdiv(a,b)      _mm256_div_pd(a,b)
+#  define pj_vsqrt(a)       _mm256_sqrt_pd(a)
+#  define pj_vmin(a,b)      _mm256_min_pd(a,b)
+#  define pj_vmax(a,b)      _mm256_max_pd(a,b)
+#  define pj_vand(a,b)      _mm256_and_pd(a,b)
+#  define pj_vor(a,b)       _mm256_or_pd(a,b)
+#  define pj_vxor(a,b)      _mm256_xor_pd(a,b)
+#  define pj_vandnot(a,b)   _mm256_andnot_pd(a,b)
+#  define pj_vlt(a,b)       _mm256_cmp_pd(a,b,_CMP_LT_OQ)
+#  define pj_vle(a,b)       _mm256_cmp_pd(a,b,_CMP_LE_OQ)
+#  define pj_vgt(a,b)       _mm256_cmp_pd(a,b,_CMP_GT_OQ)
+#  define pj_vge(a,b)       _mm256_cmp_pd(a,b,_CMP_GE_OQ)
+#  define pj_vmask(a)       _mm256_movemask_pd(a)
+#  define pj_vasi(a)        _mm256_castpd_si256(a)
+#  define pj_viad(a)        _mm256_castsi256_pd(a)
+#  define pj_viset1(i)      _mm256_set1_epi64x(i)
+#  define pj_viadd(a,b)     _mm256_add_epi64(a,b)
+#  define pj_visub(a,b)     _mm256_sub_epi64(a,b)
+#  define pj_viand(a,b)     _mm256_and_si256(a,b)
+#  define pj_vior(a,b)      _mm256_or_si256(a,b)
+#  define pj_vislli(a,n)    _mm256_slli_epi64(a,n)
+#  define pj_visrli(a,n)    _mm256_srli_epi64(a,n)
+#elif defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define PJ_VLEN 2
+typedef __m128d pj_vd;
+typedef __m128i pj_vi;
+#  define pj_vload(p)       _mm_loadu_pd(p)
+#  define pj_vstore(p,a)    _mm_storeu_pd(p,a)
+#  define pj_vset1(d)       _mm_set1_pd(d)
+#  define pj_vadd(a,b)      _mm_add_pd(a,b)
+#  define pj_vsub(a,b)      _mm_sub_pd(a,b)
+#  define pj_vmul(a,b)      _mm_mul_pd(a,b)
+#  define pj_vdiv(a,b)      _mm_div_pd(a,b)
+#  define pj_vsqrt(a)       _mm_sqrt_pd(a)
+#  define pj_vmin(a,b)      _mm_min_pd(a,b)
+#  define pj_vmax(a,b)      _mm_max_pd(a,b)
+#  define pj_vand(a,b)      _mm_and_pd(a,b)
+#  define pj_vor(a,b)       _mm_or_pd(a,b)
+#  define pj_vxor(a,b)      _mm_xor_pd(a,b)
+#  define pj_vandnot(a,b)   _mm_andnot_pd(a,b)
+#  define pj_vlt(a,b)       _mm_cmplt_pd(a,b)
+#  define pj_vle(a,b)       _mm_cmple_pd(a,b)
+#  define pj_vgt(a,b)       _mm_cmpgt_pd(a,b)
+#  define pj_vge(a,b)       _mm_cmpge_pd(a,b)
+#  define pj_vmask(a)       _mm_movemask_pd(a)
+#  define pj_vasi(a)        _mm_castpd_si128(a)
+#  define pj_viad(a)        _mm_castsi128_pd(a)
+#  define pj_viset1(i)      _mm_set1_epi64x(i)
+#  define pj_viadd(a,b)     _mm_add_epi64(a,b)
+#  define pj_visub(a,b)     _mm_sub_epi64(a,b)
+#  define pj_viand(a,b)     _mm_and_si128(a,b)
+#  define pj_vior(a,b)      _mm_or_si128(a,b)
+#  define pj_vislli(a,n)    _mm_slli_epi64(a,n)
+#  define pj_visrli(a,n)    _mm_srli_epi64(a,n)
+#endif
+
+#ifdef PJ_VLEN
+#define PJ_HAVE_SIMD
+
+#define PJ_VTRUE        pj_viad(pj_viset1(-1))
+#define PJ_VSIGN        pj_viad(pj_viset1((long long) 0x8000000000000000ULL))
+/* 1.5 * 2^52: adding this rounds to an integer held in the low mantissa */
+#define PJ_VMAGIC       6755399441055744.0
+
+/* mask ? a : b */
+static inline pj_vd pj_vsel(pj_vd mask, pj_vd a, pj_vd b)
+{
+    return pj_vor(pj_vand(mask, a), pj_vandnot(mask, b));
+}
+
+static inline pj_vd pj_vabs(pj_vd a)
+{
+    return pj_vandnot(PJ_VSIGN, a);
+}
+
+/************************************************************************/
+/*                             pj_vround()                              */
+/*                                                                      */
+/*      Round to nearest, also returning the integer in the low bits    */
+/*      of each 64 bit lane.  Only valid for |a| < 2^51.                */
+/************************************************************************/
+
+static inline pj_vd pj_vround(pj_vd a, pj_vi *n)
+{
+    pj_vd t = pj_vadd(a, pj_vset1(PJ_VMAGIC));
+    if (n)
+        *n = pj_vasi(t);
+    return pj_vsub(t, pj_vset1(PJ_VMAGIC));
+}
+
+/************************************************************************/
+/*                             pj_vfloor()                              */
+/*                                                                      */
+/*      floor(), also only valid for |a| < 2^51 without AVX.            */
+/************************************************************************/
+
+static inline pj_vd pj_vfloor(pj_vd a)
+{
+#if PJ_VLEN == 4
+    return _mm256_floor_pd(a);
+#else
+    pj_vd r = pj_vround(a, NULL);
+    return pj_vsub(r, pj_vand(pj_vgt(r, a), pj_vset1(1.0)));
+#endif
+}
+
+/************************************************************************/
+/*                              pj_vlog()                               */
+/*                                                                      */
+/*      Natural logarithm for positive, finite, normal arguments.       */
+/************************************************************************/
+
+static inline pj_vd pj_vlog(pj_vd x)
+{
+    pj_vi bits = pj_vasi(x);
+    pj_vd e, m, z, y, num, den, small;
+
+    /* frexp(): exponent to double through the 2^52 trick */
+    e = pj_viad(pj_vior(pj_visrli(bits, 52),
+                        pj_viset1(0x4330000000000000LL)));
+    e = pj_vsub(e, pj_vset1(4503599627370496.0 + 1022.0));
+    m = pj_viad(pj_vior(pj_viand(bits, pj_viset1(0x000FFFFFFFFFFFFFLL)),
+                        pj_viset1(0x3FE0000000000000LL)));
+
+    small = pj_vlt(m, pj_vset1(0.70710678118654752440));
+    e = pj_vsub(e, pj_vand(small, pj_vset1(1.0)));
+    m = pj_vsub(pj_vadd(m, pj_vand(small, m)), pj_vset1(1.0));
+
+    z = pj_vmul(m, m);
+    num = pj_vset1(1.01875663804580931796E-4);
+    num = pj_vadd(pj_vmul(num, m), pj_vset1(4.97494994976747001425E-1));
+    num = pj_vadd(pj_vmul(num, m), pj_vset1(4.70579119878881725854E0));
+    num = pj_vadd(pj_vmul(num, m), pj_vset1(1.44989225341610930846E1));
+    num = pj_vadd(pj_vmul(num, m), pj_vset1(1.79368678507819816313E1));
+    num = pj_vadd(pj_vmul(num, m), pj_vset1(7.70838733755885391666E0));
+    den = pj_vadd(m, pj_vset1(1.12873587189167450590E1));
+    den = pj_vadd(pj_vmul(den, m), pj_vset1(4.52279145837532221105E1));
+    den = pj_vadd(pj_vmul(den, m), pj_vset1(8.29875266912776603211E1));
+    den = pj_vadd(pj_vmul(den, m), pj_vset1(7.11544750618563894466E1));
+    den = pj_vadd(pj_vmul(den, m), pj_vset1(2.31251620126765340583E1));
+
+    y = pj_vmul(m, pj_vdiv(pj_vmul(z, num), den));
+    y = pj_vsub(y, pj_vmul(e, pj_vset1(2.121944400546905827679e-4)));
+    y = pj_vsub(y, pj_vmul(z, pj_vset1(0.5)));
+    return pj_vadd(pj_vadd(m, y), pj_vmul(e, pj_vset1(0.693359375)));
+}
+
+/************************************************************************/
+/*                              pj_vexp()                               */
+/*                                                                      */
+/*      Exponential, arguments are clamped to [-708, 709].              */
+/************************************************************************/
+
+static inline pj_vd pj_vexp(pj_vd x)
+{
+    pj_vd px, xx, p, q;
+    pj_vi n;
+
+    x = pj_vmin(pj_vmax(x, pj_vset1(-708.0)), pj_vset1(709.0));
+    px = pj_vround(pj_vmul(x, pj_vset1(1.4426950408889634073599)), &n);
+    x = pj_vsub(x, pj_vmul(px, pj_vset1(6.93145751953125E-1)));
+    x = pj_vsub(x, pj_vmul(px, pj_vset1(1.42860682030941723212E-6)));
+
+    xx = pj_vmul(x, x);
+    p = pj_vset1(1.26177193074810590878E-4);
+    p = pj_vadd(pj_vmul(p, xx), pj_vset1(3.02994407707441961300E-2));
+    p = pj_vadd(pj_vmul(p, xx), pj_vset1(9.99999999999999999910E-1));
+    p = pj_vmul(p, x);
+    q = pj_vset1(3.00198505138664455042E-6);
+    q = pj_vadd(pj_vmul(q, xx), pj_vset1(2.52448340349684104192E-3));
+    q = pj_vadd(pj_vmul(q, xx), pj_vset1(2.27265548208155028766E-1));
+    q = pj_vadd(pj_vmul(q, xx), pj_vset1(2.00000000000000000009E0));
+    x = pj_vdiv(p, pj_vsub(q, p));
+    x = pj_vadd(pj_vset1(1.0), pj_vadd(x, x));
+
+    /* ldexp(x, n) */
+    n = pj_vislli(pj_viadd(n, pj_viset1(1023)), 52);
+    return pj_vmul(x, pj_viad(n));
+}
+
+/************************************************************************/
+/*                            pj_vsincos()                              */
+/*                                                                      */
+/*      Sine and cosine, reduced by multiples of pi/2.  Intended for    */
+/*      angles of at most a few turns.                                  */
+/************************************************************************/
+
+static inline void pj_vsincos(pj_vd x, pj_vd *sinx, pj_vd *cosx)
+{
+    pj_vd q, r, zz, s, c, swap, ssign, csign;
+    pj_vi n;
+
+    q = pj_vround(pj_vmul(x, pj_vset1(0.63661977236758134308)), &n);
+    r = pj_vsub(x, pj_vmul(q, pj_vset1(1.57079625129699707031E0)));
+    r = pj_vsub(r, pj_vmul(q, pj_vset1(7.54978941586159635336E-8)));
+    r = pj_vsub(r, pj_vmul(q, pj_vset1(5.39030285815811905290E-15)));
+    zz = pj_vmul(r, r);
+
+    s = pj_vset1(1.58962301576546568060E-10);
+    s = pj_vadd(pj_vmul(s, zz), pj_vset1(-2.50507477628578072866E-8));
+    s = pj_vadd(pj_vmul(s, zz), pj_vset1(2.75573136213857245213E-6));
+    s = pj_vadd(pj_vmul(s, zz), pj_vset1(-1.98412698295895385996E-4));
+    s = pj_vadd(pj_vmul(s, zz), pj_vset1(8.33333333332211858878E-3));
+    s = pj_vadd(pj_vmul(s, zz), pj_vset1(-1.66666666666666307295E-1));
+    s = pj_vadd(r, pj_vmul(pj_vmul(r, zz), s));
+
+    c = pj_vset1(-1.13585365213876817300E-11);
+    c = pj_vadd(pj_vmul(c, zz), pj_vset1(2.08757008419747316778E-9));
+    c = pj_vadd(pj_vmul(c, zz), pj_vset1(-2.75573141792967388112E-7));
+    c = pj_vadd(pj_vmul(c, zz), pj_vset1(2.48015872888517045348E-5));
+    c = pj_vadd(pj_vmul(c, zz), pj_vset1(-1.38888888888730564116E-3));
+    c = pj_vadd(pj_vmul(c, zz), pj_vset1(4.16666666666665929218E-2));
+    c = pj_vadd(pj_vsub(pj_vset1(1.0), pj_vmul(zz, pj_vset1(0.5))),
+                pj_vmul(pj_vmul(zz, zz), c));
+
+    /* quadrant: odd swaps sin/cos, bit 1 (of n, n+1) flips the sign */
+    swap = pj_viad(pj_visub(pj_viset1(0), pj_viand(n, pj_viset1(1))));
+    ssign = pj_viad(pj_vislli(pj_viand(n, pj_viset1(2)), 62));
+    csign = pj_viad(pj_vislli(pj_viand(pj_viadd(n, pj_viset1(1)),
+                                       pj_viset1(2)), 62));
+    if (sinx)
+        *sinx = pj_vxor(pj_vsel(swap, c, s), ssign);
+    if (cosx)
+        *cosx = pj_vxor(pj_vsel(swap, s, c), csign);
+}
+
+/************************************************************************/
+/*                             pj_vatan()                               */
+/************************************************************************/
+
+static inline pj_vd pj_vatan(pj_vd x)
+{
+    pj_vd sign, a, big, mid, xr, y, more, z, num, den;
+
+    sign = pj_vand(x, PJ_VSIGN);
+    a = pj_vabs(x);
+    big = pj_vgt(a, pj_vset1(2.41421356237309504880));
+    mid = pj_vandnot(big, pj_vgt(a, pj_vset1(0.66)));
+
+    xr = pj_vsel(mid, pj_vdiv(pj_vsub(a, pj_vset1(1.0)),
+                              pj_vadd(a, pj_vset1(1.0))), a);
+    xr = pj_vsel(big, pj_vdiv(pj_vset1(-1.0), pj_vmax(a, pj_vset1(1.0))), xr);
+    y = pj_vor(pj_vand(big, pj_vset1(1.57079632679489661923)),
+               pj_vand(mid, pj_vset1(0.78539816339744830962)));
+    more = pj_vor(pj_vand(big, pj_vset1(6.123233995736765886130E-17)),
+                  pj_vand(mid, pj_vset1(3.061616997868382943065E-17)));
+
+    z = pj_vmul(xr, xr);
+    num = pj_vset1(-8.750608600031904122785E-1);
+    num = pj_vadd(pj_vmul(num, z), pj_vset1(-1.615753718733365076637E1));
+    num = pj_vadd(pj_vmul(num, z), pj_vset1(-7.500855792314704667340E1));
+    num = pj_vadd(pj_vmul(num, z), pj_vset1(-1.228866684490136173410E2));
+    num = pj_vadd(pj_vmul(num, z), pj_vset1(-6.485021904942025371773E1));
+    den = pj_vadd(z, pj_vset1(2.485846490142306297962E1));
+    den = pj_vadd(pj_vmul(den, z), pj_vset1(1.650270098316988542046E2));
+    den = pj_vadd(pj_vmul(den, z), pj_vset1(4.328810604912902668951E2));
+    den = pj_vadd(pj_vmul(den, z), pj_vset1(4.853903996359136964868E2));
+    den = pj_vadd(pj_vmul(den, z), pj_vset1(1.945506571482613964425E2));
+    z = pj_vdiv(pj_vmul(z, num), den);
+    z = pj_vadd(pj_vadd(pj_vmul(xr, z), xr), more);
+
+    return pj_vxor(pj_vadd(y, z), sign);
+}
+
+#endif /* PJ_VLEN */
+
+#endif /* ndef PJ_SIMD_H */
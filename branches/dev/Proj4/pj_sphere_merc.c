@@ -0,0 +1,245 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Detection and array versions of the spherical Mercator fast
+ *           path, see pj_sphere_merc.h.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * Unlike pj_fwd_batch(), which makes one pass for the range checks, one
+ * for the projection kernel and one for the scaling, the batch functions
+ * here do all of it in a single pass over the arrays.  A vector of points
+ * that holds anything the plain formula cannot take (a longitude to wrap,
+ * a pole, HUGE_VAL) is done by the scalar code, which follows pj_fwd() and
+ * pj_inv() step by step and sets the same error codes.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include "pj_sphere_merc.h"
+#include "pj_simd.h"
+#include <string.h>
+
+#define EPS     1.0e-12         /* pj_fwd() */
+#define EPS10   1.e-10          /* PJ_merc.c */
+#define SPI     3.14159265359   /* adjlon() */
+
+/************************************************************************/
+/*                         pj_get_sphere_merc()                         */
+/*                                                                      */
+/*      Returns 1 and fills M if the definition is a spherical          */
+/*      Mercator the fast path reproduces exactly, 0 otherwise.         */
+/************************************************************************/
+
+int pj_get_sphere_merc( PJ *P, projSphereMerc *M )
+
+{
+    const char *proj;
+
+    if( P == NULL
+        || (proj = pj_param( P->params, "sproj" ).s) == NULL
+        || strcmp( proj, "merc" ) != 0 )
+        return 0;
+
+    if( P->es != 0.0 || P->k0 != 1.0 || P->lam0 != 0.0
+        || P->x0 != 0.0 || P->y0 != 0.0
+        || P->to_meter != 1.0 || P->fr_meter != 1.0
+        || P->over || P->geoc || P->a <= 0.0 )
+        return 0;
+
+    if( M != NULL )
+    {
+        M->a = P->a;
+        M->ra = P->ra;
+    }
+    return 1;
+}
+
+/************************************************************************/
+/*                             fwd_point()                              */
+/*                                                                      */
+/*      pj_fwd() for one point, returns its error code.                 */
+/************************************************************************/
+
+static int fwd_point( const projSphereMerc *M, double *x, double *y )
+
+{
+    double lam = *x, phi = *y, t;
+
+    if( (t = fabs(phi) - HALFPI) > EPS || fabs(lam) > 10. )
+    {
+        *x = *y = HUGE_VAL;
+        return -14;
+    }
+    if( fabs(t) <= EPS10 )          /* s_forward() F_ERROR */
+    {
+        *x = *y = HUGE_VAL;
+        return -20;
+    }
+    lam = adjlon( lam );
+    *x = M->a * lam;
+    *y = M->a * log( tan( FORTPI + .5 * phi ) );
+    return 0;
+}
+
+/************************************************************************/
+/*                             inv_point()                              */
+/************************************************************************/
+
+static int inv_point( const projSphereMerc *M, double *x, double *y )
+
+{
+    double lam;
+
+    if( *x == HUGE_VAL || *y == HUGE_VAL )
+    {
+        *x = *y = HUGE_VAL;
+        return -15;
+    }
+    lam = *x * M->ra;
+    *y = HALFPI - 2. * atan( exp( -(*y * M->ra) ) );
+    *x = adjlon( lam );
+    return 0;
+}
+
+/************************************************************************/
+/*                      pj_sphere_merc_fwd_batch()                      */
+/*                                                                      */
+/*      Same arguments and results as pj_fwd_batch(): lam/phi in        */
+/*      radians in, x/y out, in place.  status may be NULL.             */
+/************************************************************************/
+
+int pj_sphere_merc_fwd_batch( const projSphereMerc *M, long n,
+                              double *x, double *y, int *status )
+
+{
+    long i = 0;
+    int  st, err = 0;
+
+#ifdef PJ_HAVE_SIMD
+    pj_vd a = pj_vset1( M->a ), one = pj_vset1( 1. );
+    pj_vd lim_phi = pj_vset1( HALFPI - EPS10 ), lim_lam = pj_vset1( SPI );
+    pj_vd lam, phi, s, c;
+    int   j;
+
+    for( ; i + PJ_VLEN <= n; i += PJ_VLEN )
+    {
+        lam = pj_vload( x + i );
+        phi = pj_vload( y + i );
+
+        /* all lanes inside the plain formula's domain, NaN is not */
+        if( pj_vmask( pj_vand( pj_vlt( pj_vabs( phi ), lim_phi ),
+                               pj_vle( pj_vabs( lam ), lim_lam ) ) )
+            != (1 << PJ_VLEN) - 1 )
+        {
+            for( j = 0; j < PJ_VLEN; j++ )
+            {
+                if( (st = fwd_point( M, x + i + j, y + i + j )) != 0 )
+                    err = st;
+                if( status != NULL )
+                    status[i + j] = st;
+            }
+            continue;
+        }
+
+        /* log(tan(FORTPI + .5 phi)) == log((1+s)/c) */
+        pj_vsincos( phi, &s, &c );
+        pj_vstore( y + i, pj_vmul( a, pj_vlog( pj_vdiv( pj_vadd( one, s ),
+                                                         c ) ) ) );
+        pj_vstore( x + i, pj_vmul( a, lam ) );
+        if( status != NULL )
+            for( j = 0; j < PJ_VLEN; j++ )
+                status[i + j] = 0;
+    }
+#endif
+
+    for( ; i < n; i++ )
+    {
+        if( (st = fwd_point( M, x + i, y + i )) != 0 )
+            err = st;
+        if( status != NULL )
+            status[i] = st;
+    }
+
+    return (pj_errno = err);
+}
+
+/************************************************************************/
+/*                      pj_sphere_merc_inv_batch()                      */
+/*                                                                      */
+/*      Same arguments and results as pj_inv_batch().                   */
+/************************************************************************/
+
+int pj_sphere_merc_inv_batch( const projSphereMerc *M, long n,
+                              double *x, double *y, int *status )
+
+{
+    long i = 0;
+    int  st, err = 0;
+
+#ifdef PJ_HAVE_SIMD
+    pj_vd ra = pj_vset1( M->ra ), lim_lam = pj_vset1( SPI );
+    pj_vd halfpi = pj_vset1( HALFPI ), two = pj_vset1( 2. );
+    pj_vd huge = pj_vset1( HUGE_VAL ), lam, t;
+    int   j;
+
+    for( ; i + PJ_VLEN <= n; i += PJ_VLEN )
+    {
+        lam = pj_vmul( pj_vload( x + i ), ra );
+        t = pj_vload( y + i );
+
+        /* HUGE_VAL x is caught by the longitude test */
+        if( pj_vmask( pj_vand( pj_vle( pj_vabs( lam ), lim_lam ),
+                               pj_vlt( t, huge ) ) )
+            != (1 << PJ_VLEN) - 1 )
+        {
+            for( j = 0; j < PJ_VLEN; j++ )
+            {
+                if( (st = inv_point( M, x + i + j, y + i + j )) != 0 )
+                    err = st;
+                if( status != NULL )
+                    status[i + j] = st;
+            }
+            continue;
+        }
+
+        t = pj_vexp( pj_vsub( pj_vset1( 0. ), pj_vmul( t, ra ) ) );
+        pj_vstore( y + i, pj_vsub( halfpi, pj_vmul( two, pj_vatan( t ) ) ) );
+        pj_vstore( x + i, lam );
+        if( status != NULL )
+            for( j = 0; j < PJ_VLEN; j++ )
+                status[i + j] = 0;
+    }
+#endif
+
+    for( ; i < n; i++ )
+    {
+        if( (st = inv_point( M, x + i, y + i )) != 0 )
+            err = st;
+        if( status != NULL )
+            status[i] = st;
+    }
+
+    return (pj_errno = err);
+}
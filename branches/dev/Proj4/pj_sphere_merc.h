@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Spherical Mercator (the web map "Google" projection) without
+ *           the generic pj_fwd()/pj_inv() overhead.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * pj_get_sphere_merc() recognizes a definition that is a plain Mercator
+ * on a sphere: no scale factor, central meridian, false easting or
+ * northing and meters for units, like
+ *
+ *     +proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0
+ *     +y_0=0 +k=1.0 +units=m +nadgrids=@null +no_defs
+ *
+ * For such a definition the inline functions below give the results of
+ * pj_fwd()/pj_inv() bit for bit.  They return -1 instead for the points
+ * that need more than the formula (longitudes to wrap, latitudes at or
+ * beyond the poles, HUGE_VAL), which the caller passes to pj_fwd() or
+ * pj_inv().
+ *
+ * The batch functions take the arrays of pj_fwd_batch()/pj_inv_batch()
+ * and handle every point themselves.  Their SSE2/AVX2 lanes use the
+ * pj_simd.h log/exp/atan, a few ulp from the system libm.
+ */
+
+#ifndef PJ_SPHERE_MERC_H
+#define PJ_SPHERE_MERC_H
+
+#include "proj_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER)
+#  define PJ_INLINE static __inline
+#else
+#  define PJ_INLINE static inline
+#endif
+
+typedef struct {
+    double a;       /* sphere radius, meters */
+    double ra;      /* 1 / a */
+} projSphereMerc;
+
+int pj_get_sphere_merc( projPJ, projSphereMerc * );
+int pj_sphere_merc_fwd_batch( const projSphereMerc *, long point_count,
+                              double *x, double *y, int *status );
+int pj_sphere_merc_inv_batch( const projSphereMerc *, long point_count,
+                              double *x, double *y, int *status );
+
+/* lam/phi in radians to x/y in meters, -1 to leave the point to pj_fwd() */
+PJ_INLINE int pj_sphere_merc_fwd( const projSphereMerc *M,
+                                  double lam, double phi,
+                                  double *x, double *y )
+{
+    if( !(fabs(phi) - 1.5707963267948966 < -1.e-10)
+        || !(fabs(lam) <= 3.14159265359) )
+        return -1;
+    *x = M->a * lam;
+    *y = M->a * log(tan(0.78539816339744833 + .5 * phi));
+    return 0;
+}
+
+/* x/y in meters to lam/phi in radians, -1 to leave the point to pj_inv() */
+PJ_INLINE int pj_sphere_merc_inv( const projSphereMerc *M,
+                                  double x, double y,
+                                  double *lam, double *phi )
+{
+    double l = x * M->ra;
+
+    if( !(fabs(l) <= 3.14159265359) || y == HUGE_VAL )
+        return -1;
+    *lam = l;
+    *phi = 1.5707963267948966 - 2. * atan(exp(-(y * M->ra)));
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ndef PJ_SPHERE_MERC_H */
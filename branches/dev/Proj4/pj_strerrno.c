@@ -55,6 +55,7 @@ pj_err_list[] = {
 	"unparseable coordinate system definition",	/* -44 */
 	"geocentric transformation missing z or ellps",	/* -45 */
 	"unknown prime meridian conversion id",		/* -46 */
+	"no approximation within tolerance for area",	/* -47 */
 };
 	char *
 pj_strerrno(int err) 
@@ -165,6 +165,24 @@ static const int transient_error[45] = {
     /* 30 to 39 */ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 
     /* 40 to 44 */ 0, 0, 0, 0, 0 };
 
+/************************************************************************/
+/*                         pj_transient_error()                         */
+/*                                                                      */
+/*      Returns TRUE if err only concerns the point being transformed   */
+/*      (which is then set to HUGE_VAL) rather than the whole request.  */
+/*      As in pj_transform(), errors are never transient for a single   */
+/*      point.                                                          */
+/************************************************************************/
+
+int pj_transient_error( int err, long point_count )
+
+{
+    if( err == 33 /*EDOM*/ || err == 34 /*ERANGE*/ )
+        return 1;
+    return err <= 0 && err >= -44 && point_count != 1
+        && transient_error[-err] != 0;
+}
+
 /************************************************************************/
 /*                            pj_transform()                            */
 /*                                                                      */
@@ -224,7 +242,7 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
         if( srcdefn->inv == NULL )
         {
             pj_errno = -17; /* this isn't correct, we need a no inverse err */
-            if( getenv( "PROJ_DEBUG" ) != NULL )
+            if( pj_get_ctx()->debug_level )
             {
                 fprintf( stderr, 
                        "pj_transform(): source projection not invertable\n" );
@@ -246,9 +264,7 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
             geodetic_loc = pj_inv( projected_loc, srcdefn );
             if( pj_errno != 0 )
             {
-                if( (pj_errno != 33 /*EDOM*/ && pj_errno != 34 /*ERANGE*/ )
-                    && (pj_errno > 0 || pj_errno < -44 || point_count == 1
-                        || transient_error[-pj_errno] == 0 ) )
+                if( !pj_transient_error( pj_errno, point_count ) )
                     return pj_errno;
                 else
                 {
@@ -342,9 +358,7 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
             projected_loc = pj_fwd( geodetic_loc, dstdefn );
             if( pj_errno != 0 )
             {
-                if( (pj_errno != 33 /*EDOM*/ && pj_errno != 34 /*ERANGE*/ )
-                    && (pj_errno > 0 || pj_errno < -44 || point_count == 1
-                        || transient_error[-pj_errno] == 0 ) )
+                if( !pj_transient_error( pj_errno, point_count ) )
                     return pj_errno;
                 else
                 {
@@ -389,7 +403,6 @@ int pj_geodetic_to_geocentric( double a, double es,
 
 {
     double b;
-    int    i;
     GeocentricInfo gi;
 
     pj_errno = 0;
@@ -405,21 +418,10 @@ int pj_geodetic_to_geocentric( double a, double es,
         return pj_errno;
     }
 
-    for( i = 0; i < point_count; i++ )
-    {
-        long io = i * point_offset;
-
-        if( x[io] == HUGE_VAL  )
-            continue;
-
-        if( pj_Convert_Geodetic_To_Geocentric( &gi, y[io], x[io], z[io], 
-                                               x+io, y+io, z+io ) != 0 )
-        {
-            pj_errno = -14;
-            x[io] = y[io] = HUGE_VAL;
-            /* but keep processing points! */
-        }
-    }
+    /* failed points become HUGE_VAL, the others are still converted */
+    if( pj_geodetic_to_geocentric_batch( &gi, point_count, point_offset,
+                                         x, y, z ) != 0 )
+        pj_errno = -14;
 
     return pj_errno;
 }
@@ -434,7 +436,6 @@ int pj_geocentric_to_geodetic( double a, double es,
 
 {
     double b;
-    int    i;
     GeocentricInfo gi;
 
     if( es == 0.0 )
@@ -448,16 +449,8 @@ int pj_geocentric_to_geodetic( double a, double es,
         return pj_errno;
     }
 
-    for( i = 0; i < point_count; i++ )
-    {
-        long io = i * point_offset;
-
-        if( x[io] == HUGE_VAL )
-            continue;
-
-        pj_Convert_Geocentric_To_Geodetic( &gi, x[io], y[io], z[io], 
-                                           y+io, x+io, z+io );
-    }
+    pj_geocentric_to_geodetic_batch( &gi, point_count, point_offset,
+                                     x, y, z );
 
     return 0;
 }
@@ -608,6 +601,28 @@ int pj_geocentric_from_wgs84( PJ *defn,
     return 0;
 }
 
+/************************************************************************/
+/*                        compose_datum_shift()                         */
+/*                                                                      */
+/*      The geocentric matrix taking srcdefn's datum through WGS84 to   */
+/*      dstdefn's, from the matrices pj_datum_set() left on each.       */
+/************************************************************************/
+
+static void compose_datum_shift( PJ *srcdefn, PJ *dstdefn, double *m )
+
+{
+    const double *t = srcdefn->datum_to_wgs84;
+    const double *f = dstdefn->datum_from_wgs84;
+    int r, c;
+
+    for( r = 0; r < 12; r += 4 )
+    {
+        for( c = 0; c < 4; c++ )
+            m[r+c] = f[r] * t[c] + f[r+1] * t[4+c] + f[r+2] * t[8+c];
+        m[r+3] += f[r+3];
+    }
+}
+
 /************************************************************************/
 /*                         pj_datum_transform()                         */
 /*                                                                      */
@@ -659,7 +674,9 @@ int pj_datum_transform( PJ *srcdefn, PJ *dstdefn,
         z_is_temp = TRUE;
     }
 
-#define CHECK_RETURN {if( pj_errno != 0 && (pj_errno > 0 || transient_error[-pj_errno] == 0) ) { if( z_is_temp ) pj_dalloc(z); return pj_errno; }}
+/* a positive (system) errno from the datum steps is always fatal; of the
+   proj codes only the per-point ones are tolerated, even for one point */
+#define CHECK_RETURN {if( pj_errno != 0 && (pj_errno > 0 || !pj_transient_error( pj_errno, 0 )) ) { if( z_is_temp ) pj_dalloc(z); return pj_errno; }}
 
 /* -------------------------------------------------------------------- */
 /*	If this datum requires grid shifts, then apply it to geodetic   */
@@ -690,35 +707,31 @@ int pj_datum_transform( PJ *srcdefn, PJ *dstdefn,
         || dstdefn->datum_type == PJD_3PARAM 
         || dstdefn->datum_type == PJD_7PARAM)
     {
-/* -------------------------------------------------------------------- */
-/*      Convert to geocentric coordinates.                              */
-/* -------------------------------------------------------------------- */
-        pj_geodetic_to_geocentric( src_a, src_es,
-                                   point_count, point_offset, x, y, z );
-        CHECK_RETURN;
-
-/* -------------------------------------------------------------------- */
-/*      Convert between datums.                                         */
-/* -------------------------------------------------------------------- */
-        if( srcdefn->datum_type == PJD_3PARAM 
-            || srcdefn->datum_type == PJD_7PARAM )
-        {
-            pj_geocentric_to_wgs84( srcdefn, point_count, point_offset,x,y,z);
-            CHECK_RETURN;
-        }
+        GeocentricInfo src_gi, dst_gi;
+        double         shift[12];
 
-        if( dstdefn->datum_type == PJD_3PARAM 
-            || dstdefn->datum_type == PJD_7PARAM )
+        if( pj_Set_Geocentric_Parameters( &src_gi, src_a,
+                                          src_a * sqrt(1-src_es) ) != 0
+            || pj_Set_Geocentric_Parameters( &dst_gi, dst_a,
+                                             dst_a * sqrt(1-dst_es) ) != 0 )
         {
-            pj_geocentric_from_wgs84( dstdefn, point_count,point_offset,x,y,z);
-            CHECK_RETURN;
+            if( z_is_temp )
+                pj_dalloc( z );
+            pj_errno = PJD_ERR_GEOCENTRIC;
+            return pj_errno;
         }
 
 /* -------------------------------------------------------------------- */
-/*      Convert back to geodetic coordinates.                           */
+/*      To geocentric, through both datum shifts composed into one      */
+/*      matrix, and back to geodetic in a single pass.  Points          */
+/*      with a bad latitude become HUGE_VAL, a transient error.         */
 /* -------------------------------------------------------------------- */
-        pj_geocentric_to_geodetic( dst_a, dst_es,
-                                   point_count, point_offset, x, y, z );
+        compose_datum_shift( srcdefn, dstdefn, shift );
+
+        if( pj_geodetic_datum_shift_batch( &src_gi, shift, &dst_gi,
+                                           point_count, point_offset,
+                                           x, y, z ) != 0 )
+            pj_errno = -14;
         CHECK_RETURN;
     }
 
@@ -0,0 +1,273 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  pj_transform_mt(), pj_transform() spread over worker threads
+ *           for large point arrays.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * The point arrays are cut into chunks of CHUNK_POINTS points which the
+ * workers claim one at a time, so grid shifted areas that are slower than
+ * the rest do not leave threads idle.  Each worker runs pj_transform() on
+ * its chunks under a private context; failed points come back as HUGE_VAL
+ * exactly as with pj_transform(), and only the first fatal error (in
+ * point order) is stored in the caller's context.
+ */
+
+#define PJ_LIB__
+
+#include "projects.h"
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+#define CHUNK_POINTS  16384
+#define MAX_THREADS   64
+
+typedef struct {
+    PJ        *srcdefn;
+    PJ        *dstdefn;
+    long      point_count;
+    int       point_offset;
+    long      chunk_count;
+    int       debug_level;
+    double    *x, *y, *z;
+
+    long      next_chunk;       /* protected by lock */
+    long      error_chunk;      /* first chunk with a fatal error */
+    int       error;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t  lock;
+#endif
+} transform_job;
+
+#ifdef _WIN32
+#  define JOB_LOCK(job)    EnterCriticalSection( &(job)->lock )
+#  define JOB_UNLOCK(job)  LeaveCriticalSection( &(job)->lock )
+#else
+#  define JOB_LOCK(job)    pthread_mutex_lock( &(job)->lock )
+#  define JOB_UNLOCK(job)  pthread_mutex_unlock( &(job)->lock )
+#endif
+
+/************************************************************************/
+/*                          transform_worker()                          */
+/************************************************************************/
+
+static void transform_worker( transform_job *job )
+
+{
+    projCtx   ctx = pj_ctx_alloc();
+    long      chunk, first, count, offset;
+    int       err;
+
+    if( ctx == NULL )
+    {
+        JOB_LOCK( job );
+        if( job->error == 0 )
+        {
+            job->error = -2;    /* out of memory */
+            job->error_chunk = 0;
+        }
+        JOB_UNLOCK( job );
+        return;
+    }
+
+    pj_ctx_set_debug( ctx, job->debug_level );
+
+    for( ;; )
+    {
+        JOB_LOCK( job );
+        chunk = job->next_chunk++;
+        /* stop early once a fatal error is known before this chunk */
+        if( job->error != 0 && job->error_chunk < chunk )
+            chunk = -1;
+        JOB_UNLOCK( job );
+
+        if( chunk < 0 || chunk >= job->chunk_count )
+            break;
+
+        /* the last chunk takes the remainder, so no chunk is a lone
+           point (for which pj_transform() treats every error as fatal) */
+        first = chunk * CHUNK_POINTS;
+        if( chunk == job->chunk_count - 1 )
+            count = job->point_count - first;
+        else
+            count = CHUNK_POINTS;
+        offset = first * job->point_offset;
+
+        err = pj_transform_ctx( ctx, job->srcdefn, job->dstdefn,
+                                count, job->point_offset,
+                                job->x + offset, job->y + offset,
+                                job->z != NULL ? job->z + offset : NULL );
+        if( err != 0 )
+        {
+            JOB_LOCK( job );
+            if( job->error == 0 || chunk < job->error_chunk )
+            {
+                job->error = err;
+                job->error_chunk = chunk;
+            }
+            JOB_UNLOCK( job );
+        }
+    }
+
+    pj_ctx_free( ctx );
+}
+
+#ifdef _WIN32
+static DWORD WINAPI transform_thread( LPVOID arg )
+{
+    transform_worker( (transform_job *) arg );
+    return 0;
+}
+#else
+static void *transform_thread( void *arg )
+{
+    transform_worker( (transform_job *) arg );
+    return NULL;
+}
+#endif
+
+/************************************************************************/
+/*                          pj_cpu_count()                              */
+/************************************************************************/
+
+static int pj_cpu_count()
+
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo( &info );
+    return (int) info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+    return n > 0 ? (int) n : 1;
+#else
+    return 1;
+#endif
+}
+
+/************************************************************************/
+/*                          pj_transform_mt()                           */
+/*                                                                      */
+/*      Same contract as pj_transform(), using up to thread_count       */
+/*      threads (the calling thread included).  A thread_count of 0     */
+/*      uses one thread per online processor.                           */
+/************************************************************************/
+
+int pj_transform_mt( PJ *srcdefn, PJ *dstdefn,
+                     long point_count, int point_offset,
+                     double *x, double *y, double *z, int thread_count )
+
+{
+    transform_job job;
+    long          chunks, i;
+#ifdef _WIN32
+    HANDLE        threads[MAX_THREADS];
+#else
+    pthread_t     threads[MAX_THREADS];
+#endif
+    int           started = 0;
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+    if( thread_count <= 0 )
+        thread_count = pj_cpu_count();
+    if( thread_count > MAX_THREADS )
+        thread_count = MAX_THREADS;
+
+    chunks = point_count / CHUNK_POINTS;
+    if( thread_count > chunks )
+        thread_count = (int) chunks;
+
+/* -------------------------------------------------------------------- */
+/*      Small requests are not worth a thread.  This also keeps the     */
+/*      single point case, where transient errors are fatal, exactly    */
+/*      as pj_transform() has it.                                       */
+/* -------------------------------------------------------------------- */
+    if( thread_count <= 1 )
+        return pj_transform( srcdefn, dstdefn, point_count, point_offset,
+                             x, y, z );
+
+    memset( &job, 0, sizeof(job) );
+    job.srcdefn = srcdefn;
+    job.dstdefn = dstdefn;
+    job.point_count = point_count;
+    job.point_offset = point_offset;
+    job.x = x;
+    job.y = y;
+    job.z = z;
+    job.chunk_count = chunks;
+    job.debug_level = pj_get_ctx()->debug_level;
+
+    /* make sure the library is initialized before threads race for it */
+    pj_get_default_ctx();
+
+#ifdef _WIN32
+    InitializeCriticalSection( &job.lock );
+    for( i = 1; i < thread_count; i++ )
+    {
+        threads[started] = CreateThread( NULL, 0, transform_thread, &job,
+                                         0, NULL );
+        if( threads[started] != NULL )
+            started++;
+    }
+#else
+    pthread_mutex_init( &job.lock, NULL );
+    for( i = 1; i < thread_count; i++ )
+    {
+        if( pthread_create( threads + started, NULL, transform_thread,
+                            &job ) == 0 )
+            started++;
+    }
+#endif
+
+    /* the calling thread works too */
+    transform_worker( &job );
+
+#ifdef _WIN32
+    for( i = 0; i < started; i++ )
+    {
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+    }
+    DeleteCriticalSection( &job.lock );
+#else
+    for( i = 0; i < started; i++ )
+        pthread_join( threads[i], NULL );
+    pthread_mutex_destroy( &job.lock );
+#endif
+
+    pj_errno = job.error;
+    return job.error;
+}
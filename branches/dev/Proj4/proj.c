@@ -9,16 +9,8 @@ static const char SCCSID[]="@(#)proj.c	4.12	95/09/23	GIE	REL";
 #include <string.h>
 #include <math.h>
 #include "emess.h"
-
-/* TK 1999-02-13 */
-#if defined(MSDOS) || defined(OS2) || defined(WIN32) || defined(__WIN32__)
-#  include <fcntl.h>
-#  include <io.h>
-#  define SET_BINARY_MODE(file) setmode(fileno(file), O_BINARY)
-#else
-#  define SET_BINARY_MODE(file)
-#endif
-/* ! TK 1999-02-13 */
+#include "bin_io.h"
+#include "par_io.h"
 
 #define MAX_LINE 1000
 #define MAX_PARGS 100
@@ -28,16 +20,18 @@ static const char SCCSID[]="@(#)proj.c	4.12	95/09/23	GIE	REL";
 	static projUV
 (*proj)(projUV, PJ *);
 	static int
+(*proj_batch)(projPJ, long, double *, double *, int *);
+	static int
 reversein = 0,	/* != 0 reverse input arguments */
 reverseout = 0,	/* != 0 reverse output arguments */
 bin_in = 0,	/* != 0 then binary input */
 bin_out = 0,	/* != 0 then binary output */
 echoin = 0,	/* echo input data to output line */
+threads = 1,	/* -j threads for text input */
 tag = '#',	/* beginning of line tag character */
 inverse = 0,	/* != 0 then inverse projection */
 prescale = 0,	/* != 0 apply cartesian scale factor */
 dofactors = 0,	/* determine scale factors */
-facs_bad = 0,	/* return condition from pj_factors */
 very_verby = 0, /* very verbose mode */
 postscale = 0;
 	static char
@@ -45,7 +39,7 @@ postscale = 0;
 *oform = (char *)0,	/* output format for x-y or decimal degrees */
 *oterr = "*\t*",	/* output line for unprojectable input */
 *usage =
-"%s\nusage: %s [ -beEfiIlormsStTvVwW [args] ] [ +opts[=arg] ] [ files ]\n";
+"%s\nusage: %s [ -beEfiIjlormsStTvVwW [args] ] [ +opts[=arg] ] [ files ]\n";
 	static struct FACTORS
 facs;
 	static double
@@ -58,97 +52,168 @@ int_proj(projUV data) {
 	if (postscale && data.u != HUGE_VAL)
 		{ data.u *= fscale; data.v *= fscale; }
 	return(data);
+}
+	static void	/* one projected point as text, no newline */
+put_point(OUT_TEXT *out, projUV data, struct FACTORS *fac, int fac_bad) {
+	char pline[40];
+
+	if (data.u == HUGE_VAL) /* error output */
+		out_puts(out, oterr);
+	else if (inverse && !oform) {	/*ascii DMS output */
+		if (reverseout) {
+			out_puts(out, rtodms(pline, data.v, 'N', 'S'));
+			out_putc(out, '\t');
+			out_puts(out, rtodms(pline, data.u, 'E', 'W'));
+		} else {
+			out_puts(out, rtodms(pline, data.u, 'E', 'W'));
+			out_putc(out, '\t');
+			out_puts(out, rtodms(pline, data.v, 'N', 'S'));
+		}
+	} else {	/* x-y or decimal degree ascii output */
+		if (inverse) {
+			data.v *= RAD_TO_DEG;
+			data.u *= RAD_TO_DEG;
+		}
+		if (reverseout) {
+			out_printf(out, oform,data.v); out_putc(out, '\t');
+			out_printf(out, oform,data.u);
+		} else {
+			out_printf(out, oform,data.u); out_putc(out, '\t');
+			out_printf(out, oform,data.v);
+		}
+	}
+	if (dofactors) /* print scale factor data */
+		if (!fac_bad)
+			out_printf(out, "\t<%g %g %g %g %g %g>",
+				fac->h, fac->k, fac->s,
+				fac->omega * RAD_TO_DEG, fac->a, fac->b);
+		else
+			out_puts(out, "\t<* * * * * *>");
+}
+	static void	/* one input line, ending in a newline, to out */
+process_line(char *line, OUT_TEXT *out) {
+	char *s = line;
+	projUV data;
+	struct FACTORS fac;
+	int fac_bad = 1;
+
+	if (*s == tag) {
+		if (!bin_out)
+			out_puts(out, line);
+		return;
+	}
+	if (reversein) {
+		data.v = (*informat)(s, &s);
+		data.u = (*informat)(s, &s);
+	} else {
+		data.u = (*informat)(s, &s);
+		data.v = (*informat)(s, &s);
+	}
+	if (data.v == HUGE_VAL)
+		data.u = HUGE_VAL;
+	if (!*s && (s > line)) --s; /* assumed we gobbled \n */
+	if (!bin_out && echoin) {
+		int t;
+		t = *s;
+		*s = '\0';
+		out_puts(out, line);
+		*s = t;
+		out_putc(out, '\t');
+	}
+	memset(&fac, 0, sizeof(fac));
+	if (data.u != HUGE_VAL) {
+		if (prescale) { data.u *= fscale; data.v *= fscale; }
+		if (dofactors && !inverse)
+			fac_bad = pj_factors(data, Proj, 0., &fac);
+		data = (*proj)(data, Proj);
+		if (dofactors && inverse)
+			fac_bad = pj_factors(data, Proj, 0., &fac);
+		if (postscale && data.u != HUGE_VAL)
+			{ data.u *= fscale; data.v *= fscale; }
+	}
+	if (bin_out) { /* binary output */
+		bin_write(stdout, 2, &data.u, &data.v, NULL, 1);
+		return;
+	}
+	put_point(out, data, &fac, fac_bad);
+	out_puts(out, s);
 }
 	static void	/* file processing function */
 process(FILE *fid) {
-	char line[MAX_LINE+3], *s, pline[40];
-	projUV data;
+	char line[MAX_LINE+3], *s;
+	OUT_TEXT out;
 
+	/* -j: lines in blocks, projected and formatted on several threads */
+	if (threads > 1 && !bin_out) {
+		par_process(fid, threads, MAX_LINE, process_line);
+		return;
+	}
+	memset(&out, 0, sizeof(out));
+	out.fid = stdout;
 	for (;;) {
 		++emess_dat.File_line;
-		if (bin_in) {	/* binary input */
-			if (fread(&data, sizeof(projUV), 1, fid) != 1)
-				break;
-		} else {	/* ascii input */
-			if (!(s = fgets(line, MAX_LINE, fid)))
-				break;
-			if (!strchr(s, '\n')) { /* overlong line */
-				int c;
-				(void)strcat(s, "\n");
-				/* gobble up to newline */
-				while ((c = fgetc(fid)) != EOF && c != '\n') ;
-			}
-			if (*s == tag) {
-				if (!bin_out)
-					(void)fputs(line, stdout);
-				continue;
-			}
-			if (reversein) {
-				data.v = (*informat)(s, &s);
-				data.u = (*informat)(s, &s);
-			} else {
-				data.u = (*informat)(s, &s);
-				data.v = (*informat)(s, &s);
-			}
-			if (data.v == HUGE_VAL)
-				data.u = HUGE_VAL;
-			if (!*s && (s > line)) --s; /* assumed we gobbled \n */
-			if (!bin_out && echoin) {
-				int t;
-				t = *s;
-				*s = '\0';
-				(void)fputs(line, stdout);
-				*s = t;
-				putchar('\t');
-			}
+		if (!(s = fgets(line, MAX_LINE, fid)))
+			break;
+		if (!strchr(s, '\n')) { /* overlong line */
+			int c;
+			(void)strcat(s, "\n");
+			/* gobble up to newline */
+			while ((c = fgetc(fid)) != EOF && c != '\n') ;
 		}
-		if (data.u != HUGE_VAL) {
-			if (prescale) { data.u *= fscale; data.v *= fscale; }
-			if (dofactors && !inverse)
-				facs_bad = pj_factors(data, Proj, 0., &facs);
-			data = (*proj)(data, Proj);
-			if (dofactors && inverse)
-				facs_bad = pj_factors(data, Proj, 0., &facs);
-			if (postscale && data.u != HUGE_VAL)
-				{ data.u *= fscale; data.v *= fscale; }
+		process_line(line, &out);
+	}
+}
+	static void	/* file processing function --- binary input */
+process_binary(FILE *fid) {
+	static double x[BIN_CHUNK], y[BIN_CHUNK], lam[BIN_CHUNK], phi[BIN_CHUNK];
+	BIN_INPUT in;
+	OUT_TEXT out;
+	struct FACTORS fac;
+	projUV data;
+	long n, i;
+	int fac_bad = 1;
+
+	memset(&out, 0, sizeof(out));
+	out.fid = stdout;
+	bin_open(&in, fid, 2);
+	while ((n = bin_read(&in, x, y, NULL, BIN_CHUNK)) > 0) {
+		if (prescale)
+			for (i = 0; i < n; ++i)
+				if (x[i] != HUGE_VAL)
+					{ x[i] *= fscale; y[i] *= fscale; }
+		if (dofactors && !bin_out && !inverse) {
+			memcpy(lam, x, n * sizeof(double));
+			memcpy(phi, y, n * sizeof(double));
+		}
+		/* failed points come back as HUGE_VAL */
+		(void)(*proj_batch)(Proj, n, x, y, NULL);
+		if (dofactors && !bin_out && inverse) {
+			memcpy(lam, x, n * sizeof(double));
+			memcpy(phi, y, n * sizeof(double));
 		}
+		if (postscale)
+			for (i = 0; i < n; ++i)
+				if (x[i] != HUGE_VAL)
+					{ x[i] *= fscale; y[i] *= fscale; }
 		if (bin_out) { /* binary output */
-			(void)fwrite(&data, sizeof(projUV), 1, stdout);
+			bin_write(stdout, 2, x, y, NULL, n);
 			continue;
-		} else if (data.u == HUGE_VAL) /* error output */
-			(void)fputs(oterr, stdout);
-		else if (inverse && !oform) {	/*ascii DMS output */
-			if (reverseout) {
-				(void)fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
-				putchar('\t');
-				(void)fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
-			} else {
-				(void)fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
-				putchar('\t');
-				(void)fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
-			}
-		} else {	/* x-y or decimal degree ascii output */
-			if (inverse) {
-				data.v *= RAD_TO_DEG;
-				data.u *= RAD_TO_DEG;
-			}
-			if (reverseout) {
-				(void)printf(oform,data.v); putchar('\t');
-				(void)printf(oform,data.u);
-			} else {
-				(void)printf(oform,data.u); putchar('\t');
-				(void)printf(oform,data.v);
+		}
+		for (i = 0; i < n; ++i) {
+			if (dofactors) {
+				memset(&fac, 0, sizeof(fac));
+				data.u = lam[i];
+				data.v = phi[i];
+				fac_bad = data.u == HUGE_VAL
+					|| pj_factors(data, Proj, 0., &fac);
 			}
+			data.u = x[i];
+			data.v = y[i];
+			put_point(&out, data, &fac, fac_bad);
+			out_putc(&out, '\n');
 		}
-		if (dofactors) /* print scale factor data */
-			if (!facs_bad)
-				(void)printf("\t<%g %g %g %g %g %g>",
-					facs.h, facs.k, facs.s,
-					facs.omega * RAD_TO_DEG, facs.a, facs.b);
-			else
-				(void)fputs("\t<* * * * * *>", stdout);
-		(void)fputs(bin_in ? "\n" : s, stdout);
 	}
+	bin_close(&in);
 }
 	static void	/* file processing function --- verbosely */
 vprocess(FILE *fid) {
@@ -388,6 +453,11 @@ int main(int argc, char **argv) {
                 if (--argc <= 0) goto noargument;
                 oform = *++argv;
                 continue;
+              case 'j': /* threads for text input */
+                if (--argc <= 0) goto noargument;
+                if ((threads = atoi(*++argv)) < 1 || threads > PAR_MAX_THREADS)
+                    emess(1,"-j needs 1 to %d threads", PAR_MAX_THREADS);
+                continue;
               case 'r': /* reverse input */
                 reversein = 1;
                 continue;
@@ -431,8 +501,11 @@ int main(int argc, char **argv) {
         if (!Proj->inv)
             emess(3,"inverse projection not available");
         proj = pj_inv;
-    } else
+        proj_batch = pj_inv_batch;
+    } else {
         proj = pj_fwd;
+        proj_batch = pj_fwd_batch;
+    }
     if (cheby_str) {
         extern void gen_cheb(int, projUV(*)(projUV), char *, PJ *, int, char **);
 
@@ -491,6 +564,8 @@ int main(int argc, char **argv) {
         emess_dat.File_line = 0;
         if (very_verby)
             vprocess(fid);
+        else if (bin_in)
+            process_binary(fid);
         else
             process(fid);
         (void)fclose(fid);
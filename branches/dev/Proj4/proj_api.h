@@ -105,10 +105,18 @@ extern int pj_errno;	/* global error return code */
 #if !defined(PROJECTS_H)
     typedef struct { double u, v; } projUV;
     typedef void *projPJ;
+    typedef void *projCtx;
+    typedef void *projTransform;
+    typedef void *projApprox;
+    typedef void *projGeod;
     #define projXY projUV
     #define projLP projUV
 #else
     typedef PJ *projPJ;
+    typedef struct projCtx_t *projCtx;
+    typedef struct PJ_PIPELINE *projTransform;
+    typedef struct PJ_APPROX *projApprox;
+    typedef struct PJ_GEOD *projGeod;
 #   define projXY	XY
 #   define projLP       LP
 #endif
@@ -117,9 +125,25 @@ extern int pj_errno;	/* global error return code */
 
 projXY pj_fwd(projLP, projPJ);
 projLP pj_inv(projXY, projPJ);
+int pj_fwd_batch(projPJ, long point_count, double *x, double *y, int *status);
+int pj_inv_batch(projPJ, long point_count, double *x, double *y, int *status);
 
 int pj_transform( projPJ src, projPJ dst, long point_count, int point_offset,
                   double *x, double *y, double *z );
+int pj_transform_mt( projPJ src, projPJ dst, long point_count, int point_offset,
+                     double *x, double *y, double *z, int thread_count );
+projTransform pj_transform_prepare( projPJ src, projPJ dst );
+int pj_transform_run( projTransform, long point_count, int point_offset,
+                      double *x, double *y, double *z );
+int pj_transform_is_identity( projTransform );
+void pj_transform_free( projTransform );
+projApprox pj_approx_create( projPJ src, projPJ dst,
+                             double west, double south,
+                             double east, double north, double tolerance );
+int pj_approx_transform( projApprox, long point_count, int point_offset,
+                         double *x, double *y, double *z );
+double pj_approx_error( projApprox );
+void pj_approx_free( projApprox );
 int pj_datum_transform( projPJ src, projPJ dst, long point_count, int point_offset,
                         double *x, double *y, double *z );
 int pj_geocentric_to_geodetic( double a, double es,
@@ -133,6 +157,24 @@ int pj_apply_gridshift( const char *, int,
                         long point_count, int point_offset,
                         double *x, double *y, double *z );
 void pj_deallocate_grids(void);
+void pj_set_grid_cache_budget( long bytes );
+void pj_get_grid_cache_stats( long *loads, long *evictions,
+                              long *resident_bytes );
+projPJ pj_init_plus_cached(const char *);
+void pj_free_cached(projPJ);
+void pj_set_def_cache_size( int max_entries );
+void pj_get_def_cache_stats( long *hits, long *misses, long *entries );
+projGeod pj_geod_alloc( double a, double es );
+projGeod pj_geod_from_pj( projPJ );
+void pj_geod_free( projGeod );
+int pj_geod_direct( projGeod, long point_count,
+                    const double *lam1, const double *phi1,
+                    const double *az12, const double *dist,
+                    double *lam2, double *phi2, double *az21 );
+int pj_geod_inverse( projGeod, long point_count,
+                     const double *lam1, const double *phi1,
+                     const double *lam2, const double *phi2,
+                     double *dist, double *az12, double *az21 );
 int pj_is_latlong(projPJ);
 int pj_is_geocent(projPJ);
 void pj_pr_list(projPJ);
@@ -149,6 +191,25 @@ char *pj_strerrno(int);
 int *pj_get_errno_ref(void);
 const char *pj_get_release(void);
 
+/* contexts, for using the library from several threads */
+projCtx pj_ctx_alloc(void);
+void pj_ctx_free(projCtx);
+projCtx pj_get_default_ctx(void);
+projCtx pj_get_ctx(void);
+projCtx pj_set_ctx(projCtx);
+int pj_ctx_get_errno(projCtx);
+void pj_ctx_set_errno(projCtx, int);
+int pj_ctx_get_debug(projCtx);
+void pj_ctx_set_debug(projCtx, int);
+
+projPJ pj_init_ctx(projCtx, int, char **);
+projPJ pj_init_plus_ctx(projCtx, const char *);
+projXY pj_fwd_ctx(projCtx, projLP, projPJ);
+projLP pj_inv_ctx(projCtx, projXY, projPJ);
+int pj_transform_ctx( projCtx ctx, projPJ src, projPJ dst,
+                      long point_count, int point_offset,
+                      double *x, double *y, double *z );
+
 #ifdef __cplusplus
 }
 #endif
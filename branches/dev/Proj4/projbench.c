@@ -0,0 +1,2051 @@
+/******************************************************************************
+ * Project:  PROJ.4
+ * Purpose:  Micro benchmarks for the projection library.
+ * Author:   Route-Me Contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2009, Route-Me Contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ *
+ * Usage: projbench [-n points] [-r repeats] [-t threads]
+ *                  [-g grid[,grid...] [-B west,south,east,north]] [test ...]
+ *
+ * Every result is printed as one tab separated line:
+ *
+ *     test  case  ns/point  points/sec  [extra]
+ *
+ * so runs from different builds can be diffed or loaded into a sheet.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "projects.h"
+#include "pj_sphere_merc.h"
+
+static long npoints = 100000;
+static int repeats = 5;
+static int nthreads = 8;
+static int failures = 0;
+static const char *grids = NULL;     /* -g, +nadgrids value */
+static double grid_box[4] = { -180.0, -90.0, 180.0, 90.0 };
+
+static double *src_x, *src_y, *x, *y;
+static int *status;
+
+/************************************************************************/
+/*                              now_ns()                                */
+/************************************************************************/
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/************************************************************************/
+/*                              report()                                */
+/*                                                                      */
+/*      Print one result line, best of the repeats is passed in.        */
+/************************************************************************/
+
+static void report(const char *test, const char *name, double ns, long count,
+                   const char *extra)
+{
+    printf("%s\t%s\t%.2f\t%.0f%s%s\n", test, name, ns / count,
+           count / (ns * 1e-9), extra ? "\t" : "", extra ? extra : "");
+}
+
+/************************************************************************/
+/*                            lonlat_grid()                             */
+/*                                                                      */
+/*      Fill src_x/src_y (radians) with a regular grid over the         */
+/*      given box.                                                      */
+/************************************************************************/
+
+static void lonlat_grid(double west, double south, double east, double north)
+{
+    long i, side = (long) sqrt((double) npoints);
+
+    if (side < 1)
+        side = 1;
+    for (i = 0; i < npoints; i++)
+    {
+        src_x[i] = (west + (east - west) * (i % side) / side) * DEG_TO_RAD;
+        src_y[i] = (south + (north - south) * ((i / side) % side) / side)
+            * DEG_TO_RAD;
+    }
+}
+
+static void reset_points(void)
+{
+    memcpy(x, src_x, npoints * sizeof(double));
+    memcpy(y, src_y, npoints * sizeof(double));
+}
+
+/************************************************************************/
+/*                             max_error()                              */
+/*                                                                      */
+/*      Largest difference between the batch results (x/y) and the      */
+/*      scalar results in ex/ey, ignoring failed points.                */
+/************************************************************************/
+
+static double max_error(const double *ex, const double *ey)
+{
+    double err = 0.0, d;
+    long i;
+
+    for (i = 0; i < npoints; i++)
+    {
+        if (ex[i] == HUGE_VAL || x[i] == HUGE_VAL)
+        {
+            if (ex[i] != x[i])
+                return HUGE_VAL;
+            continue;
+        }
+        if ((d = fabs(ex[i] - x[i])) > err)
+            err = d;
+        if ((d = fabs(ey[i] - y[i])) > err)
+            err = d;
+    }
+    return err;
+}
+
+/************************************************************************/
+/*                            bench_batch()                             */
+/*                                                                      */
+/*      pj_fwd()/pj_inv() point loops against pj_fwd_batch() and        */
+/*      pj_inv_batch() for the Mercator definitions we use.             */
+/************************************************************************/
+
+static void bench_batch(void)
+{
+    static const char *defs[][2] = {
+        { "merc_sphere", "+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 "
+          "+lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +no_defs" },
+        { "merc_wgs84", "+proj=merc +ellps=WGS84 +no_defs" },
+        { "tmerc_osgb", "+proj=tmerc +lat_0=49 +lon_0=-2 +k=0.999601 "
+          "+x_0=400000 +y_0=-100000 +ellps=airy +units=m +no_defs" },
+    };
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    double t, best, err;
+    char name[64], extra[64];
+    size_t d;
+    long i;
+    int r;
+
+    lonlat_grid(-179.0, -84.0, 179.0, 84.0);
+    for (d = 0; d < sizeof(defs) / sizeof(defs[0]); d++)
+    {
+        projPJ pj = pj_init_plus(defs[d][1]);
+        projUV uv;
+
+        if (!pj)
+        {
+            fprintf(stderr, "%s: %s\n", defs[d][0], pj_strerrno(pj_errno));
+            continue;
+        }
+
+        /* forward */
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            t = now_ns();
+            for (i = 0; i < npoints; i++)
+            {
+                uv.u = src_x[i];
+                uv.v = src_y[i];
+                uv = pj_fwd(uv, pj);
+                ex[i] = uv.u;
+                ey[i] = uv.v;
+            }
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        sprintf(name, "%s_fwd_scalar", defs[d][0]);
+        report("batch", name, best, npoints, NULL);
+
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            t = now_ns();
+            pj_fwd_batch(pj, npoints, x, y, status);
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        err = max_error(ex, ey);
+        sprintf(name, "%s_fwd_batch", defs[d][0]);
+        sprintf(extra, "maxerr_m=%g", err);
+        report("batch", name, best, npoints, extra);
+
+        /* inverse, starting from the scalar forward results */
+        memcpy(src_x, ex, npoints * sizeof(double));
+        memcpy(src_y, ey, npoints * sizeof(double));
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            t = now_ns();
+            for (i = 0; i < npoints; i++)
+            {
+                uv.u = src_x[i];
+                uv.v = src_y[i];
+                uv = pj_inv(uv, pj);
+                ex[i] = uv.u;
+                ey[i] = uv.v;
+            }
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        sprintf(name, "%s_inv_scalar", defs[d][0]);
+        report("batch", name, best, npoints, NULL);
+
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            t = now_ns();
+            pj_inv_batch(pj, npoints, x, y, status);
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        err = max_error(ex, ey);
+        sprintf(name, "%s_inv_batch", defs[d][0]);
+        sprintf(extra, "maxerr_rad=%g", err);
+        report("batch", name, best, npoints, extra);
+
+        lonlat_grid(-179.0, -84.0, 179.0, 84.0);
+        pj_free(pj);
+    }
+    free(ex);
+    free(ey);
+}
+
+/************************************************************************/
+/*                           bench_threads()                            */
+/*                                                                      */
+/*      Stress test for projection contexts: every thread creates its   */
+/*      own context and definitions, shares one projection with the     */
+/*      others, provokes errors and checks that neither the results     */
+/*      nor the error codes leak between threads.                       */
+/************************************************************************/
+
+#define THREAD_DEFN "+proj=merc +ellps=WGS84 +no_defs"
+#define THREAD_LATLONG "+proj=latlong +ellps=WGS84 +towgs84=0,0,0 +no_defs"
+
+static projPJ shared_pj;
+static double *ref_x, *ref_y;
+
+typedef struct {
+    int index;
+    long mismatches;
+    double ns;
+} thread_job;
+
+static void *thread_main(void *arg)
+{
+    thread_job *job = (thread_job *) arg;
+    projCtx ctx = pj_ctx_alloc();
+    projPJ own, latlong;
+    double *tx, *ty, t;
+    projUV uv, bad;
+    long i;
+    int r;
+
+    own = pj_init_plus_ctx(ctx, THREAD_DEFN);
+    latlong = pj_init_plus_ctx(ctx, THREAD_LATLONG);
+    if (!own || !latlong)
+    {
+        job->mismatches++;
+        return NULL;
+    }
+    tx = malloc(npoints * sizeof(double));
+    ty = malloc(npoints * sizeof(double));
+    bad.u = 0.0;
+    bad.v = 2.0;                 /* beyond the pole, fails with -14 */
+
+    t = now_ns();
+    for (r = 0; r < repeats; r++)
+    {
+        /* private definition through pj_transform_ctx() */
+        memcpy(tx, src_x, npoints * sizeof(double));
+        memcpy(ty, src_y, npoints * sizeof(double));
+        if (pj_transform_ctx(ctx, latlong, own, npoints, 1, tx, ty, NULL))
+            job->mismatches++;
+        for (i = 0; i < npoints; i++)
+            if (tx[i] != ref_x[i] || ty[i] != ref_y[i])
+                job->mismatches++;
+
+        /* shared definition, alternating failing and good points */
+        for (i = job->index; i < npoints; i += nthreads)
+        {
+            pj_fwd_ctx(ctx, bad, shared_pj);
+            if (pj_ctx_get_errno(ctx) != -14)
+                job->mismatches++;
+
+            uv.u = src_x[i];
+            uv.v = src_y[i];
+            uv = pj_fwd_ctx(ctx, uv, shared_pj);
+            if (pj_ctx_get_errno(ctx) != 0
+                || uv.u != ref_x[i] || uv.v != ref_y[i])
+                job->mismatches++;
+
+            uv = pj_inv_ctx(ctx, uv, shared_pj);
+            if (pj_ctx_get_errno(ctx) != 0
+                || fabs(uv.u - src_x[i]) > 1e-12
+                || fabs(uv.v - src_y[i]) > 1e-12)
+                job->mismatches++;
+        }
+    }
+    job->ns = now_ns() - t;
+
+    free(tx);
+    free(ty);
+    pj_free(own);
+    pj_free(latlong);
+    pj_ctx_free(ctx);
+    return NULL;
+}
+
+static void bench_threads(void)
+{
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    thread_job *jobs = calloc(nthreads, sizeof(thread_job));
+    long i, mismatches = 0;
+    double t;
+    char name[64], extra[64];
+
+    lonlat_grid(-179.0, -84.0, 179.0, 84.0);
+    shared_pj = pj_init_plus(THREAD_DEFN);
+    ref_x = malloc(npoints * sizeof(double));
+    ref_y = malloc(npoints * sizeof(double));
+    for (i = 0; i < npoints; i++)
+    {
+        projUV uv;
+
+        uv.u = src_x[i];
+        uv.v = src_y[i];
+        uv = pj_fwd(uv, shared_pj);
+        ref_x[i] = uv.u;
+        ref_y[i] = uv.v;
+    }
+
+    t = now_ns();
+    for (i = 0; i < nthreads; i++)
+    {
+        jobs[i].index = i;
+        pthread_create(threads + i, NULL, thread_main, jobs + i);
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+        mismatches += jobs[i].mismatches;
+    }
+    t = now_ns() - t;
+
+    /* the default context must not have seen any of the errors */
+    if (pj_errno != 0)
+        mismatches++;
+
+    sprintf(name, "ctx_%d_threads", nthreads);
+    sprintf(extra, "mismatches=%ld", mismatches);
+    report("threads", name, t, (long) repeats * npoints * (nthreads + 1),
+           extra);
+    if (mismatches)
+        failures++;
+
+    pj_free(shared_pj);
+    free(ref_x);
+    free(ref_y);
+    free(threads);
+    free(jobs);
+}
+
+/************************************************************************/
+/*                          bench_transform()                           */
+/*                                                                      */
+/*      pj_transform_mt() scaling from one thread up to -t threads,     */
+/*      for a plain reprojection and one with a 7 parameter datum       */
+/*      shift.  Every run must match serial pj_transform() exactly.     */
+/************************************************************************/
+
+static void bench_transform(void)
+{
+    static const struct {
+        const char *name, *src, *dst;
+    } cases[] = {
+        { "latlong_merc",
+          "+proj=latlong +ellps=WGS84 +no_defs",
+          "+proj=merc +ellps=WGS84 +no_defs" },
+        { "osgb_merc",
+          "+proj=tmerc +lat_0=49 +lon_0=-2 +k=0.9996012717 +x_0=400000 "
+          "+y_0=-100000 +ellps=airy +datum=OSGB36 +units=m +no_defs",
+          "+proj=merc +ellps=WGS84 +datum=WGS84 +no_defs" },
+    };
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    double *z = malloc(npoints * sizeof(double));
+    char name[64], extra[64];
+    int c, r, t;
+
+    for (c = 0; c < (int) (sizeof(cases) / sizeof(cases[0])); c++)
+    {
+        projPJ src = pj_init_plus(cases[c].src);
+        projPJ dst = pj_init_plus(cases[c].dst);
+        double best = HUGE_VAL, one = 0.0, d;
+        long i;
+
+        if (!src || !dst)
+        {
+            fprintf(stderr, "transform: %s: %s\n", cases[c].name,
+                    pj_strerrno(pj_errno));
+            failures++;
+            continue;
+        }
+
+        /* projected sources are fed the forward projection of the grid */
+        lonlat_grid(-8.0, 49.5, 2.0, 61.0);
+        reset_points();
+        if (!pj_is_latlong(src))
+            pj_transform(dst, src, npoints, 1, x, y, NULL);
+        memcpy(src_x, x, npoints * sizeof(double));
+        memcpy(src_y, y, npoints * sizeof(double));
+
+        reset_points();
+        memset(z, 0, npoints * sizeof(double));
+        pj_transform(src, dst, npoints, 1, x, y, z);
+        memcpy(ex, x, npoints * sizeof(double));
+        memcpy(ey, y, npoints * sizeof(double));
+
+        for (t = 1; t <= nthreads; t = (t == nthreads || t * 2 < nthreads)
+                 ? t * 2 : nthreads)
+        {
+            best = HUGE_VAL;
+            for (r = 0; r < repeats; r++)
+            {
+                reset_points();
+                memset(z, 0, npoints * sizeof(double));
+                d = now_ns();
+                if (pj_transform_mt(src, dst, npoints, 1, x, y, z, t) != 0)
+                    failures++;
+                d = now_ns() - d;
+                if (d < best)
+                    best = d;
+            }
+            if (t == 1)
+                one = best;
+            for (i = 0; i < npoints; i++)
+                if (x[i] != ex[i] || y[i] != ey[i])
+                    break;
+
+            sprintf(name, "%s_%d_threads", cases[c].name, t);
+            sprintf(extra, "speedup=%.2f%s", one / best,
+                    i < npoints ? " MISMATCH" : "");
+            report("transform", name, best, npoints, extra);
+            if (i < npoints)
+                failures++;
+        }
+
+        pj_free(src);
+        pj_free(dst);
+    }
+
+    free(ex);
+    free(ey);
+    free(z);
+}
+
+/************************************************************************/
+/*                           bench_pipeline()                           */
+/*                                                                      */
+/*      pj_transform() against a pipeline from pj_transform_prepare()   */
+/*      for the same pair, with the largest difference between them.    */
+/************************************************************************/
+
+#define GOOGLE_DEFN "+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 " \
+    "+x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +no_defs"
+
+static void bench_pipeline(void)
+{
+    static const struct {
+        const char *name, *src, *dst;
+    } cases[] = {
+        { "google_google", GOOGLE_DEFN, GOOGLE_DEFN },
+        { "latlong_google",
+          "+proj=latlong +ellps=WGS84 +datum=WGS84 +no_defs", GOOGLE_DEFN },
+        { "latlong_merc",
+          "+proj=latlong +ellps=WGS84 +no_defs",
+          "+proj=merc +ellps=WGS84 +no_defs" },
+        { "osgb_merc",
+          "+proj=tmerc +lat_0=49 +lon_0=-2 +k=0.9996012717 +x_0=400000 "
+          "+y_0=-100000 +ellps=airy +datum=OSGB36 +units=m +no_defs",
+          "+proj=merc +ellps=WGS84 +datum=WGS84 +no_defs" },
+    };
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    char name[64], extra[64];
+    int c, r;
+
+    for (c = 0; c < (int) (sizeof(cases) / sizeof(cases[0])); c++)
+    {
+        projPJ src = pj_init_plus(cases[c].src);
+        projPJ dst = pj_init_plus(cases[c].dst);
+        projTransform pipeline;
+        double exact = HUGE_VAL, fast = HUGE_VAL, d, err;
+
+        if (!src || !dst || !(pipeline = pj_transform_prepare(src, dst)))
+        {
+            fprintf(stderr, "pipeline: %s: %s\n", cases[c].name,
+                    pj_strerrno(pj_errno));
+            failures++;
+            continue;
+        }
+
+        lonlat_grid(-8.0, 49.5, 2.0, 61.0);
+        if (!pj_is_latlong(src))
+        {
+            projPJ latlong = pj_latlong_from_proj(src);
+
+            reset_points();
+            pj_transform(latlong, src, npoints, 1, x, y, NULL);
+            memcpy(src_x, x, npoints * sizeof(double));
+            memcpy(src_y, y, npoints * sizeof(double));
+            pj_free(latlong);
+        }
+
+        for (r = 0; r < repeats; r++)
+        {
+            reset_points();
+            d = now_ns();
+            pj_transform(src, dst, npoints, 1, x, y, NULL);
+            d = now_ns() - d;
+            if (d < exact)
+                exact = d;
+        }
+        memcpy(ex, x, npoints * sizeof(double));
+        memcpy(ey, y, npoints * sizeof(double));
+
+        for (r = 0; r < repeats; r++)
+        {
+            reset_points();
+            d = now_ns();
+            if (pj_transform_run(pipeline, npoints, 1, x, y, NULL) != 0)
+                failures++;
+            d = now_ns() - d;
+            if (d < fast)
+                fast = d;
+        }
+        err = max_error(ex, ey);
+
+        sprintf(name, "%s_transform", cases[c].name);
+        report("pipeline", name, exact, npoints, NULL);
+        sprintf(name, "%s_prepared", cases[c].name);
+        sprintf(extra, "speedup=%.2f maxerr=%.3g%s", exact / fast, err,
+                pj_transform_is_identity(pipeline) ? " identity" : "");
+        report("pipeline", name, fast, npoints, extra);
+        /* identity skips the round trip, the rest is batch rounding */
+        if (err > 1e-6)
+            failures++;
+
+        pj_transform_free(pipeline);
+        pj_free(src);
+        pj_free(dst);
+    }
+
+    free(ex);
+    free(ey);
+}
+
+/************************************************************************/
+/*                         approx_edge_check()                          */
+/*                                                                      */
+/*      pj_approx_transform() must give the results and return value    */
+/*      of pj_transform() for points outside its box, including one     */
+/*      that fails on its own among points inside.  Returns the number  */
+/*      of differences.                                                 */
+/************************************************************************/
+
+static int approx_edge_check(projPJ src, projPJ dst, projApprox approx,
+                             double tolerance)
+{
+    /* two points in the google_city box, then the pole */
+    static const double lon[3] = { -0.1, 0.1, 20.0 };
+    static const double lat[3] = { 51.5, 51.4, 90.0 };
+    double ax[3], ay[3], ex[3], ey[3];
+    int n, i, bad = 0, aerr, eerr;
+
+    /* all three, then the pole alone, where the error is fatal */
+    for (n = 3; n >= 1; n -= 2)
+    {
+        for (i = 0; i < n; i++)
+        {
+            ax[i] = ex[i] = lon[3 - n + i] * DEG_TO_RAD;
+            ay[i] = ey[i] = lat[3 - n + i] * DEG_TO_RAD;
+        }
+        eerr = pj_transform(src, dst, n, 1, ex, ey, NULL);
+        aerr = pj_approx_transform(approx, n, 1, ax, ay, NULL);
+        if (aerr != eerr)
+            bad++;
+        for (i = 0; eerr == 0 && i < n; i++)
+        {
+            if (ex[i] == HUGE_VAL
+                ? ax[i] != HUGE_VAL || ay[i] != HUGE_VAL
+                : fabs(ax[i] - ex[i]) > 2.0 * tolerance
+                  || fabs(ay[i] - ey[i]) > 2.0 * tolerance)
+                bad++;
+        }
+    }
+    return bad;
+}
+
+/************************************************************************/
+/*                            bench_approx()                            */
+/*                                                                      */
+/*      Speed and accuracy of pj_approx_transform() for viewport sized  */
+/*      boxes at a few tolerances, against exact pj_transform().        */
+/************************************************************************/
+
+static void bench_approx(void)
+{
+    static const struct {
+        const char *name, *src, *dst;
+        double west, south, east, north;
+    } cases[] = {
+        { "google_city", "+proj=latlong +ellps=WGS84 +datum=WGS84 +no_defs",
+          GOOGLE_DEFN, -0.5, 51.2, 0.3, 51.7 },
+        { "google_region", "+proj=latlong +ellps=WGS84 +datum=WGS84 +no_defs",
+          GOOGLE_DEFN, -8.0, 49.5, 2.0, 61.0 },
+        { "osgb36_merc", "+proj=latlong +ellps=airy +datum=OSGB36 +no_defs",
+          "+proj=merc +ellps=WGS84 +datum=WGS84 +no_defs",
+          -3.0, 52.0, 0.0, 54.0 },
+    };
+    static const double tolerances[] = { 1.0, 1e-3, 1e-6 };
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    char name[64], extra[128];
+    int c, t, r;
+
+    for (c = 0; c < (int) (sizeof(cases) / sizeof(cases[0])); c++)
+    {
+        projPJ src = pj_init_plus(cases[c].src);
+        projPJ dst = pj_init_plus(cases[c].dst);
+        double exact = HUGE_VAL, d;
+
+        if (!src || !dst)
+        {
+            failures++;
+            continue;
+        }
+
+        /* inner grid, so the check points differ from the fit's */
+        lonlat_grid(cases[c].west + 1e-3, cases[c].south + 1e-3,
+                    cases[c].east - 1e-3, cases[c].north - 1e-3);
+        for (r = 0; r < repeats; r++)
+        {
+            reset_points();
+            d = now_ns();
+            pj_transform(src, dst, npoints, 1, x, y, NULL);
+            d = now_ns() - d;
+            if (d < exact)
+                exact = d;
+        }
+        memcpy(ex, x, npoints * sizeof(double));
+        memcpy(ey, y, npoints * sizeof(double));
+        sprintf(name, "%s_exact", cases[c].name);
+        report("approx", name, exact, npoints, NULL);
+
+        for (t = 0; t < (int) (sizeof(tolerances) / sizeof(tolerances[0]));
+             t++)
+        {
+            projApprox approx;
+            double fast = HUGE_VAL, build, err;
+
+            build = now_ns();
+            approx = pj_approx_create(src, dst,
+                                      cases[c].west * DEG_TO_RAD,
+                                      cases[c].south * DEG_TO_RAD,
+                                      cases[c].east * DEG_TO_RAD,
+                                      cases[c].north * DEG_TO_RAD,
+                                      tolerances[t]);
+            build = now_ns() - build;
+            if (!approx)
+            {
+                sprintf(name, "%s_tol_%g", cases[c].name, tolerances[t]);
+                printf("approx\t%s\t-\t-\t%s\n", name,
+                       pj_strerrno(pj_errno));
+                continue;
+            }
+
+            for (r = 0; r < repeats; r++)
+            {
+                reset_points();
+                d = now_ns();
+                if (pj_approx_transform(approx, npoints, 1, x, y, NULL) != 0)
+                    failures++;
+                d = now_ns() - d;
+                if (d < fast)
+                    fast = d;
+            }
+            err = max_error(ex, ey);
+
+            if (c == 0 && t == 0)
+            {
+                int bad = approx_edge_check(src, dst, approx, tolerances[t]);
+
+                printf("approx\t%s_outside\t-\t-\tmismatches=%d\n",
+                       cases[c].name, bad);
+                if (bad)
+                    failures++;
+            }
+
+            sprintf(name, "%s_tol_%g", cases[c].name, tolerances[t]);
+            sprintf(extra, "speedup=%.2f maxerr=%.3g build_us=%.0f",
+                    exact / fast, err, build * 1e-3);
+            report("approx", name, fast, npoints, extra);
+            /* the check grid is finite, allow some slack */
+            if (err > 2.0 * tolerances[t])
+                failures++;
+
+            pj_approx_free(approx);
+        }
+
+        pj_free(src);
+        pj_free(dst);
+    }
+
+    free(ex);
+    free(ey);
+}
+
+/************************************************************************/
+/*                         batch_mismatches()                           */
+/*                                                                      */
+/*      Points of a batch pj_transform() from src_x/src_y whose result  */
+/*      differs in any bit from transforming them one at a time, which  */
+/*      never takes the batched grid shift path.  Leaves the batch      */
+/*      results in x/y.                                                 */
+/************************************************************************/
+
+static long batch_mismatches(projPJ from, projPJ to)
+{
+    double px, py;
+    long i, bad = 0;
+
+    reset_points();
+    pj_transform(from, to, npoints, 1, x, y, NULL);
+    for (i = 0; i < npoints; i++)
+    {
+        px = src_x[i];
+        py = src_y[i];
+        if (pj_transform(from, to, 1, 1, &px, &py, NULL) != 0)
+            px = py = HUGE_VAL;
+        if (memcmp(&px, x + i, sizeof(double)) != 0
+            || memcmp(&py, y + i, sizeof(double)) != 0)
+            bad++;
+    }
+    return bad;
+}
+
+/************************************************************************/
+/*                            bench_grids()                             */
+/*                                                                      */
+/*      Grid shifting through the -g grids over the -B box (degrees):   */
+/*      the cost of the first transformation, which opens and loads     */
+/*      the grids, and the steady per point cost after that, both       */
+/*      ways.  When every point is inside the grids the batch results   */
+/*      are also checked bit for bit against single point calls.        */
+/************************************************************************/
+
+static void bench_grids(void)
+{
+    projPJ src, dst, from, to;
+    double first = HUGE_VAL, steady, d, px, py;
+    char defn[1024], name[64], extra[64];
+    const char *base;
+    long i, failed, bad;
+    int r, inverse;
+
+    if (grids == NULL)
+    {
+        printf("# grids: skipped, no -g grid given\n");
+        return;
+    }
+
+    sprintf(defn, "+proj=latlong +ellps=WGS84 +nadgrids=%.900s", grids);
+    src = pj_init_plus(defn);
+    dst = pj_init_plus("+proj=latlong +datum=WGS84");
+    if (!src || !dst)
+    {
+        fprintf(stderr, "grids: %s\n", pj_strerrno(pj_errno));
+        failures++;
+        return;
+    }
+    base = strrchr(grids, '/') ? strrchr(grids, '/') + 1 : grids;
+
+    lonlat_grid(grid_box[0], grid_box[1], grid_box[2], grid_box[3]);
+    for (r = 0; r < repeats; r++)
+    {
+        pj_deallocate_grids();
+        px = src_x[npoints / 2];
+        py = src_y[npoints / 2];
+        d = now_ns();
+        pj_transform(src, dst, 1, 1, &px, &py, NULL);
+        d = now_ns() - d;
+        if (d < first)
+            first = d;
+    }
+    sprintf(name, "%s_first_point", base);
+    report("grids", name, first, 1, NULL);
+
+    for (inverse = 0; inverse < 2; inverse++)
+    {
+        from = inverse ? dst : src;
+        to = inverse ? src : dst;
+
+        steady = HUGE_VAL;
+        for (r = 0; r < repeats; r++)
+        {
+            reset_points();
+            d = now_ns();
+            pj_transform(from, to, npoints, 1, x, y, NULL);
+            d = now_ns() - d;
+            if (d < steady)
+                steady = d;
+        }
+        for (i = 0, failed = 0; i < npoints; i++)
+            if (x[i] == HUGE_VAL)
+                failed++;
+
+        /* a point outside the grids ends the batch early */
+        if (failed == 0)
+        {
+            bad = batch_mismatches(from, to);
+            sprintf(extra, "outside=0 mismatches=%ld", bad);
+            if (bad != 0)
+            {
+                fprintf(stderr, "grids: %ld batch results differ from "
+                        "single point results\n", bad);
+                failures++;
+            }
+        }
+        else
+            sprintf(extra, "outside=%ld", failed);
+        sprintf(name, "%s_%s", base, inverse ? "inverse" : "shift");
+        report("grids", name, steady, npoints, extra);
+    }
+
+    pj_free(src);
+    pj_free(dst);
+}
+
+/************************************************************************/
+/*                        check_mapped_budget()                         */
+/*                                                                      */
+/*      pj_gridinfo_write_mapped() of two ctable grids with a cache     */
+/*      budget of one of them, which unloads each as the other loads,   */
+/*      must write the cells of both.  Returns the number of cells      */
+/*      that do not read back, -1 if the test files cannot be made.     */
+/************************************************************************/
+
+#define MAPPED_TEST_SIDE 40
+
+static long check_mapped_budget(void)
+{
+    const char *tmp = getenv("TMPDIR");
+    char names[3][1024];
+    PJ_GRIDINFO *gis[2], *mapped, *gi;
+    struct CTABLE ct;
+    FLP cell;
+    FILE *fp;
+    long bad = 0, i;
+    int g;
+
+    for (g = 0; g < 3; g++)
+        sprintf(names[g], "%.900s/projbench_grid%d.%d", tmp ? tmp : "/tmp",
+                g, (int) getpid());
+
+    /* side by side, cell i of grid g holds (i + g, -i) */
+    for (g = 0; g < 2; g++)
+    {
+        memset(&ct, 0, sizeof(ct));
+        sprintf(ct.id, "projbench %d", g);
+        ct.ll.u = (g * 5.0) * DEG_TO_RAD;
+        ct.ll.v = 0.0;
+        ct.del.u = ct.del.v = 0.1 * DEG_TO_RAD;
+        ct.lim.lam = ct.lim.phi = MAPPED_TEST_SIDE;
+        if (!(fp = fopen(names[g], "wb")))
+            return -1;
+        fwrite(&ct, sizeof(ct), 1, fp);
+        for (i = 0; i < MAPPED_TEST_SIDE * MAPPED_TEST_SIDE; i++)
+        {
+            cell.lam = (float) (i + g);
+            cell.phi = (float) -i;
+            fwrite(&cell, sizeof(cell), 1, fp);
+        }
+        if (fclose(fp) != 0)
+            return -1;
+        gis[g] = pj_gridinfo_init(names[g]);
+    }
+
+    bad = -1;
+    if (gis[0]->ct != NULL && gis[1]->ct != NULL
+        && (fp = fopen(names[2], "wb")) != NULL)
+    {
+        gis[0]->next = gis[1];
+        pj_set_grid_cache_budget((long) (MAPPED_TEST_SIDE * MAPPED_TEST_SIDE
+                                         * sizeof(FLP)));
+        if (pj_gridinfo_write_mapped(gis[0], fp) && fclose(fp) == 0)
+        {
+            bad = 0;
+            mapped = pj_gridinfo_init(names[2]);
+            for (g = 0, gi = mapped; g < 2; g++, gi = gi->next)
+            {
+                if (gi == NULL || gi->ct == NULL || gi->ct->cvs == NULL)
+                {
+                    bad += MAPPED_TEST_SIDE * MAPPED_TEST_SIDE;
+                    break;
+                }
+                for (i = 0; i < MAPPED_TEST_SIDE * MAPPED_TEST_SIDE; i++)
+                    if (gi->ct->cvs[i].lam != (float) (i + g)
+                        || gi->ct->cvs[i].phi != (float) -i)
+                        bad++;
+            }
+            while (mapped != NULL)
+            {
+                gi = mapped->next;
+                pj_gridinfo_free(mapped);
+                mapped = gi;
+            }
+        }
+        else
+            fclose(fp);
+        pj_set_grid_cache_budget(0);
+        gis[0]->next = NULL;
+    }
+
+    for (g = 0; g < 2; g++)
+        pj_gridinfo_free(gis[g]);
+    for (g = 0; g < 3; g++)
+        remove(names[g]);
+    return bad;
+}
+
+/************************************************************************/
+/*                          bench_gridcache()                           */
+/*                                                                      */
+/*      The -g grids shifted 1024 points per call with a grid cache     */
+/*      budget of a quarter of their data, so subgrids get unloaded     */
+/*      and loaded again; the results must match those without a        */
+/*      budget bit for bit.                                             */
+/************************************************************************/
+
+#define CACHE_CALL_POINTS 1024
+
+static void shift_in_calls(projPJ src, projPJ dst)
+{
+    long i, n;
+
+    for (i = 0; i < npoints; i += CACHE_CALL_POINTS)
+    {
+        n = npoints - i < CACHE_CALL_POINTS ? npoints - i : CACHE_CALL_POINTS;
+        pj_transform(src, dst, n, 1, x + i, y + i, NULL);
+    }
+}
+
+static void bench_gridcache(void)
+{
+    projPJ src, dst;
+    double *ex, *ey, best = HUGE_VAL, d;
+    long all, budget, loads, evictions, resident, loads0, evictions0, i, bad;
+    char defn[1024], extra[160];
+    int r;
+
+    bad = check_mapped_budget();
+    printf("gridcache\twrite_mapped_budget\t-\t-\tmismatches=%ld\n", bad);
+    if (bad != 0)
+        failures++;
+
+    if (grids == NULL)
+    {
+        printf("# gridcache: skipped, no -g grid given\n");
+        return;
+    }
+
+    sprintf(defn, "+proj=latlong +ellps=WGS84 +nadgrids=%.900s", grids);
+    src = pj_init_plus(defn);
+    dst = pj_init_plus("+proj=latlong +datum=WGS84");
+    if (!src || !dst)
+    {
+        fprintf(stderr, "gridcache: %s\n", pj_strerrno(pj_errno));
+        failures++;
+        return;
+    }
+    ex = malloc(npoints * sizeof(double));
+    ey = malloc(npoints * sizeof(double));
+
+    lonlat_grid(grid_box[0], grid_box[1], grid_box[2], grid_box[3]);
+    pj_set_grid_cache_budget(0);
+    pj_deallocate_grids();
+    reset_points();
+    shift_in_calls(src, dst);
+    memcpy(ex, x, npoints * sizeof(double));
+    memcpy(ey, y, npoints * sizeof(double));
+    pj_get_grid_cache_stats(NULL, NULL, &all);
+
+    budget = all / 4 > 0 ? all / 4 : 1;
+    pj_set_grid_cache_budget(budget);
+    pj_get_grid_cache_stats(&loads0, &evictions0, NULL);
+    for (r = 0; r < repeats; r++)
+    {
+        reset_points();
+        d = now_ns();
+        shift_in_calls(src, dst);
+        d = now_ns() - d;
+        if (d < best)
+            best = d;
+    }
+    pj_get_grid_cache_stats(&loads, &evictions, &resident);
+
+    for (i = 0, bad = 0; i < npoints; i++)
+        if (memcmp(ex + i, x + i, sizeof(double)) != 0
+            || memcmp(ey + i, y + i, sizeof(double)) != 0)
+            bad++;
+    if (bad != 0)
+    {
+        fprintf(stderr, "gridcache: %ld results differ under a budget\n",
+                bad);
+        failures++;
+    }
+
+    sprintf(extra, "all=%ld budget=%ld resident=%ld loads=%ld "
+            "evictions=%ld mismatches=%ld", all, budget, resident,
+            (loads - loads0) / repeats, (evictions - evictions0) / repeats,
+            bad);
+    report("gridcache", "budget_quarter", best, npoints, extra);
+
+    pj_set_grid_cache_budget(0);
+    free(ex);
+    free(ey);
+    pj_free(src);
+    pj_free(dst);
+}
+
+/************************************************************************/
+/*                            bench_init()                              */
+/*                                                                      */
+/*      pj_init_plus() + pj_free() throughput, as a tile server that    */
+/*      builds its projections per request sees it.  Each definition    */
+/*      is created -n / 10 times.                                       */
+/************************************************************************/
+
+static void bench_init(void)
+{
+    static const char *defs[][2] = {
+        { "google", GOOGLE_DEFN },
+        { "utm_datum", "+proj=utm +zone=33 +datum=WGS84 +units=m +no_defs" },
+        { "osgb_towgs84", "+proj=tmerc +lat_0=49 +lon_0=-2 +k=0.9996012717 "
+          "+x_0=400000 +y_0=-100000 +ellps=airy "
+          "+towgs84=446.448,-125.157,542.06,0.15,0.247,0.842,-20.489 "
+          "+units=m +no_defs" },
+        { "latlong", "+proj=latlong +datum=WGS84 +no_defs" },
+        { "lcc_defaults", "+proj=lcc +lat_1=33 +lat_2=45 +lon_0=-96 +ellps=GRS80" },
+    };
+    long count = npoints / 10 > 0 ? npoints / 10 : 1, i;
+    double best, d;
+    size_t k;
+    int r;
+
+    for (k = 0; k < sizeof(defs) / sizeof(defs[0]); k++)
+    {
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            d = now_ns();
+            for (i = 0; i < count; i++)
+            {
+                projPJ pj = pj_init_plus(defs[k][1]);
+
+                if (!pj)
+                {
+                    fprintf(stderr, "init %s: %s\n", defs[k][0],
+                            pj_strerrno(pj_errno));
+                    failures++;
+                    return;
+                }
+                pj_free(pj);
+            }
+            if ((d = now_ns() - d) < best)
+                best = d;
+        }
+        report("init", defs[k][0], best, count, NULL);
+    }
+}
+
+/************************************************************************/
+/*                          bench_defcache()                            */
+/*                                                                      */
+/*      pj_init_plus_cached() + pj_free_cached() for the same mix as    */
+/*      bench_init(), plus checks that reordered definitions share an   */
+/*      entry and that a cached PJ projects like a fresh one.           */
+/************************************************************************/
+
+static void bench_defcache(void)
+{
+    static const char *defs[][2] = {
+        { "google", GOOGLE_DEFN },
+        { "utm_datum", "+proj=utm +zone=33 +datum=WGS84 +units=m +no_defs" },
+        { "latlong", "+proj=latlong +datum=WGS84 +no_defs" },
+    };
+    long count = npoints / 10 > 0 ? npoints / 10 : 1, i;
+    long hits0, misses0, hits, misses;
+    double best, d;
+    projPJ fresh, a, b;
+    projUV uv = { 0.25, 0.75 }, xy1, xy2;
+    char extra[64];
+    size_t k;
+    int r;
+
+    a = pj_init_plus_cached("+proj=merc +a=6378137 +b=6378137 +units=m");
+    b = pj_init_plus_cached(" +units=m\t+b=6378137  +proj=merc +a=6378137 ");
+    fresh = pj_init_plus("+proj=merc +a=6378137 +b=6378137 +units=m");
+    if (!a || a != b || !fresh)
+    {
+        fprintf(stderr, "defcache: equivalent definitions not shared\n");
+        failures++;
+    }
+    else
+    {
+        xy1 = pj_fwd(uv, a);
+        xy2 = pj_fwd(uv, fresh);
+        if (memcmp(&xy1, &xy2, sizeof(xy1)) != 0)
+        {
+            fprintf(stderr, "defcache: cached projection differs\n");
+            failures++;
+        }
+    }
+    pj_free_cached(a);
+    pj_free_cached(b);
+    pj_free(fresh);
+
+    for (k = 0; k < sizeof(defs) / sizeof(defs[0]); k++)
+    {
+        pj_get_def_cache_stats(&hits0, &misses0, NULL);
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            d = now_ns();
+            for (i = 0; i < count; i++)
+            {
+                projPJ pj = pj_init_plus_cached(defs[k][1]);
+
+                if (!pj)
+                {
+                    fprintf(stderr, "defcache %s: %s\n", defs[k][0],
+                            pj_strerrno(pj_errno));
+                    failures++;
+                    return;
+                }
+                pj_free_cached(pj);
+            }
+            if ((d = now_ns() - d) < best)
+                best = d;
+        }
+        pj_get_def_cache_stats(&hits, &misses, NULL);
+        sprintf(extra, "hits=%ld misses=%ld", hits - hits0, misses - misses0);
+        report("defcache", defs[k][0], best, count, extra);
+    }
+}
+
+/************************************************************************/
+/*                           bench_geocent()                            */
+/*                                                                      */
+/*      pj_geodetic_to_geocentric() and pj_geocentric_to_geodetic() on  */
+/*      arrays, which take the vector kernels, against one point per    */
+/*      call, which goes through geocent.c as before.  The whole globe  */
+/*      at heights from -500 m to 9 km, and a tenth of the points at    */
+/*      GPS orbit heights.  Fails beyond 2e-8 m (a few ulp at those    */
+/*      radii) or 1e-14 radians.                                        */
+/************************************************************************/
+
+#define GEOCENT_A  6378137.0
+#define GEOCENT_ES 0.00669437999014
+
+static void bench_geocent(void)
+{
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    double *ez = malloc(npoints * sizeof(double));
+    double *src_z = malloc(npoints * sizeof(double));
+    double *z = malloc(npoints * sizeof(double));
+    double one, batch, err_xy, err_z, d;
+    char extra[128];
+    long i;
+    int r;
+
+    lonlat_grid(-180.0, -90.0, 180.0, 90.0);
+    for (i = 0; i < npoints; i++)
+        src_z[i] = i % 10 == 9 ? 20200e3 * (i % 7) / 6.0
+            : -500.0 + 9500.0 * (i % 13) / 12.0;
+
+    /* forward */
+    for (one = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        reset_points();
+        memcpy(z, src_z, npoints * sizeof(double));
+        d = now_ns();
+        for (i = 0; i < npoints; i++)
+            pj_geodetic_to_geocentric(GEOCENT_A, GEOCENT_ES, 1, 1,
+                                      x + i, y + i, z + i);
+        if ((d = now_ns() - d) < one)
+            one = d;
+    }
+    memcpy(ex, x, npoints * sizeof(double));
+    memcpy(ey, y, npoints * sizeof(double));
+    memcpy(ez, z, npoints * sizeof(double));
+    report("geocent", "to_geocentric_point", one, npoints, NULL);
+
+    for (batch = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        reset_points();
+        memcpy(z, src_z, npoints * sizeof(double));
+        d = now_ns();
+        pj_geodetic_to_geocentric(GEOCENT_A, GEOCENT_ES, npoints, 1, x, y, z);
+        if ((d = now_ns() - d) < batch)
+            batch = d;
+    }
+    for (err_xy = err_z = 0.0, i = 0; i < npoints; i++)
+    {
+        if ((d = fabs(x[i] - ex[i])) > err_xy || d != d)
+            err_xy = d;
+        if ((d = fabs(y[i] - ey[i])) > err_xy || d != d)
+            err_xy = d;
+        if ((d = fabs(z[i] - ez[i])) > err_xy || d != d)
+            err_xy = d;
+    }
+    sprintf(extra, "speedup=%.2f maxerr_m=%.3g", one / batch, err_xy);
+    report("geocent", "to_geocentric_batch", batch, npoints, extra);
+    if (!(err_xy <= 2e-8))
+        failures++;
+
+    /* inverse, from the exact geocentric coordinates */
+    memcpy(src_x, ex, npoints * sizeof(double));
+    memcpy(src_y, ey, npoints * sizeof(double));
+    memcpy(src_z, ez, npoints * sizeof(double));
+
+    for (one = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        reset_points();
+        memcpy(z, src_z, npoints * sizeof(double));
+        d = now_ns();
+        for (i = 0; i < npoints; i++)
+            pj_geocentric_to_geodetic(GEOCENT_A, GEOCENT_ES, 1, 1,
+                                      x + i, y + i, z + i);
+        if ((d = now_ns() - d) < one)
+            one = d;
+    }
+    memcpy(ex, x, npoints * sizeof(double));
+    memcpy(ey, y, npoints * sizeof(double));
+    memcpy(ez, z, npoints * sizeof(double));
+    report("geocent", "to_geodetic_point", one, npoints, NULL);
+
+    for (batch = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        reset_points();
+        memcpy(z, src_z, npoints * sizeof(double));
+        d = now_ns();
+        pj_geocentric_to_geodetic(GEOCENT_A, GEOCENT_ES, npoints, 1, x, y, z);
+        if ((d = now_ns() - d) < batch)
+            batch = d;
+    }
+    for (err_xy = err_z = 0.0, i = 0; i < npoints; i++)
+    {
+        /* -pi and pi are the same longitude */
+        d = fabs(x[i] - ex[i]);
+        if (fabs(d - 2 * M_PI) < d)
+            d = fabs(d - 2 * M_PI);
+        if (d > err_xy || d != d)
+            err_xy = d;
+        if ((d = fabs(y[i] - ey[i])) > err_xy || d != d)
+            err_xy = d;
+        if ((d = fabs(z[i] - ez[i])) > err_z || d != d)
+            err_z = d;
+    }
+    sprintf(extra, "speedup=%.2f maxerr_rad=%.3g maxerr_h_m=%.3g",
+            one / batch, err_xy, err_z);
+    report("geocent", "to_geodetic_batch", batch, npoints, extra);
+    if (!(err_xy <= 1e-14 && err_z <= 2e-8))
+        failures++;
+
+    free(ex);
+    free(ey);
+    free(ez);
+    free(src_z);
+    free(z);
+}
+
+/************************************************************************/
+/*                           bench_helmert()                            */
+/*                                                                      */
+/*      pj_transform() between latlong datums with towgs84 shifts,      */
+/*      which composes both Helmert transforms into one matrix and      */
+/*      runs geodetic to geodetic in one pass, against the old route:   */
+/*      to geocentric, each shift in turn as pj_geocentric_to_wgs84()   */
+/*      and pj_geocentric_from_wgs84() apply it, and back.  Fails       */
+/*      beyond 1e-14 radians or 2e-8 m of height.                       */
+/************************************************************************/
+
+#define ARCSEC 4.84813681109535993589914102357e-6
+
+typedef struct {
+    double a, es;
+    double p[7];        /* towgs84, rotations in radians, scale factor */
+} HELMERT_DATUM;
+
+static void helmert_datum(HELMERT_DATUM *d, double a, double rf,
+                          double dx, double dy, double dz, double rx,
+                          double ry, double rz, double ppm)
+{
+    double f = 1.0 / rf;
+
+    d->a = a;
+    d->es = 2 * f - f * f;
+    d->p[0] = dx;
+    d->p[1] = dy;
+    d->p[2] = dz;
+    d->p[3] = rx * ARCSEC;
+    d->p[4] = ry * ARCSEC;
+    d->p[5] = rz * ARCSEC;
+    d->p[6] = ppm / 1000000.0 + 1;
+}
+
+static void helmert_two_pass(const HELMERT_DATUM *src,
+                             const HELMERT_DATUM *dst, double *z)
+{
+    const double *s = src->p, *t = dst->p;
+    double xt, yt, zt;
+    long i;
+
+    pj_geodetic_to_geocentric(src->a, src->es, npoints, 1, x, y, z);
+    for (i = 0; i < npoints; i++)
+    {
+        if (x[i] == HUGE_VAL)
+            continue;
+        xt = s[6] * (x[i] - s[5] * y[i] + s[4] * z[i]) + s[0];
+        yt = s[6] * (s[5] * x[i] + y[i] - s[3] * z[i]) + s[1];
+        zt = s[6] * (-s[4] * x[i] + s[3] * y[i] + z[i]) + s[2];
+        x[i] = xt;
+        y[i] = yt;
+        z[i] = zt;
+    }
+    for (i = 0; i < npoints; i++)
+    {
+        if (x[i] == HUGE_VAL)
+            continue;
+        xt = (x[i] - t[0]) / t[6];
+        yt = (y[i] - t[1]) / t[6];
+        zt = (z[i] - t[2]) / t[6];
+        x[i] = xt + t[5] * yt - t[4] * zt;
+        y[i] = -t[5] * xt + yt + t[3] * zt;
+        z[i] = t[4] * xt - t[3] * yt + zt;
+    }
+    pj_geocentric_to_geodetic(dst->a, dst->es, npoints, 1, x, y, z);
+}
+
+static void bench_helmert(void)
+{
+    static const char *osgb36 = "+proj=latlong +a=6377563.396 "
+        "+rf=299.3249646 +towgs84=446.448,-125.157,542.060,"
+        "0.1502,0.2470,0.8421,-20.4894 +no_defs";
+    static const char *dhdn = "+proj=latlong +a=6377397.155 "
+        "+rf=299.1528128 +towgs84=598.1,73.7,418.2,"
+        "0.202,0.045,-2.455,6.7 +no_defs";
+    static const char *ed50 = "+proj=latlong +a=6378388 +rf=297 "
+        "+towgs84=-87,-98,-121 +no_defs";
+    static const char *wgs84 = "+proj=latlong +datum=WGS84 +no_defs";
+    HELMERT_DATUM d_osgb36, d_dhdn, d_ed50, d_wgs84;
+    struct {
+        const char *name, *src, *dst;
+        const HELMERT_DATUM *sd, *dd;
+    } cases[4];
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    double *ez = malloc(npoints * sizeof(double));
+    double *src_z = malloc(npoints * sizeof(double));
+    double *z = malloc(npoints * sizeof(double));
+    double two, fused, err_xy, err_z, d;
+    char name[64], extra[128];
+    long i;
+    int c, r;
+
+    helmert_datum(&d_osgb36, 6377563.396, 299.3249646, 446.448, -125.157,
+                  542.060, 0.1502, 0.2470, 0.8421, -20.4894);
+    helmert_datum(&d_dhdn, 6377397.155, 299.1528128, 598.1, 73.7, 418.2,
+                  0.202, 0.045, -2.455, 6.7);
+    helmert_datum(&d_ed50, 6378388.0, 297.0, -87, -98, -121, 0, 0, 0, 0);
+    d_ed50.p[6] = 1.0;
+    helmert_datum(&d_wgs84, 6378137.0, 298.257223563, 0, 0, 0, 0, 0, 0, 0);
+
+    cases[0].name = "osgb36_wgs84";
+    cases[0].src = osgb36; cases[0].sd = &d_osgb36;
+    cases[0].dst = wgs84;  cases[0].dd = &d_wgs84;
+    cases[1].name = "osgb36_dhdn";
+    cases[1].src = osgb36; cases[1].sd = &d_osgb36;
+    cases[1].dst = dhdn;   cases[1].dd = &d_dhdn;
+    cases[2].name = "ed50_osgb36";
+    cases[2].src = ed50;   cases[2].sd = &d_ed50;
+    cases[2].dst = osgb36; cases[2].dd = &d_osgb36;
+    cases[3].name = "dhdn_ed50";
+    cases[3].src = dhdn;   cases[3].sd = &d_dhdn;
+    cases[3].dst = ed50;   cases[3].dd = &d_ed50;
+
+    lonlat_grid(-180.0, -89.0, 180.0, 89.0);
+    for (i = 0; i < npoints; i++)
+        src_z[i] = -500.0 + 9500.0 * (i % 13) / 12.0;
+
+    for (c = 0; c < 4; c++)
+    {
+        projPJ src = pj_init_plus(cases[c].src);
+        projPJ dst = pj_init_plus(cases[c].dst);
+
+        if (!src || !dst)
+        {
+            fprintf(stderr, "helmert: %s: %s\n", cases[c].name,
+                    pj_strerrno(pj_errno));
+            failures++;
+            continue;
+        }
+
+        for (two = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            memcpy(z, src_z, npoints * sizeof(double));
+            d = now_ns();
+            helmert_two_pass(cases[c].sd, cases[c].dd, z);
+            if ((d = now_ns() - d) < two)
+                two = d;
+        }
+        memcpy(ex, x, npoints * sizeof(double));
+        memcpy(ey, y, npoints * sizeof(double));
+        memcpy(ez, z, npoints * sizeof(double));
+        sprintf(name, "%s_two_pass", cases[c].name);
+        report("helmert", name, two, npoints, NULL);
+
+        for (fused = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            memcpy(z, src_z, npoints * sizeof(double));
+            d = now_ns();
+            if (pj_transform(src, dst, npoints, 1, x, y, z) != 0)
+                failures++;
+            if ((d = now_ns() - d) < fused)
+                fused = d;
+        }
+        for (err_xy = err_z = 0.0, i = 0; i < npoints; i++)
+        {
+            /* -pi and pi are the same longitude */
+            d = fabs(x[i] - ex[i]);
+            if (fabs(d - 2 * M_PI) < d)
+                d = fabs(d - 2 * M_PI);
+            if (d > err_xy || d != d)
+                err_xy = d;
+            if ((d = fabs(y[i] - ey[i])) > err_xy || d != d)
+                err_xy = d;
+            if ((d = fabs(z[i] - ez[i])) > err_z || d != d)
+                err_z = d;
+        }
+        sprintf(name, "%s_fused", cases[c].name);
+        sprintf(extra, "speedup=%.2f maxerr_rad=%.3g maxerr_h_m=%.3g",
+                two / fused, err_xy, err_z);
+        report("helmert", name, fused, npoints, extra);
+        if (!(err_xy <= 1e-14 && err_z <= 2e-8))
+            failures++;
+
+        pj_free(src);
+        pj_free(dst);
+    }
+
+    free(ex);
+    free(ey);
+    free(ez);
+    free(src_z);
+    free(z);
+}
+
+/************************************************************************/
+/*                         bench_projections()                          */
+/*                                                                      */
+/*      pj_init_plus(), pj_fwd() and pj_inv() for every projection in   */
+/*      pj_list.h on the WGS84 ellipsoid, over a grid around the        */
+/*      standard parallels given to them.  Each definition carries the  */
+/*      parameters any of them requires, the rest ignore what they do   */
+/*      not use; one that still fails to initialize is listed as        */
+/*      skipped.  Points a projection cannot reach are counted and      */
+/*      left out of the inverse.                                        */
+/************************************************************************/
+
+#define PROJ_COMMON_PARMS "+ellps=WGS84 +lat_1=30 +lat_2=60 +lat_0=0 " \
+    "+lon_0=0 +lon_1=-30 +lon_2=30 +lat_3=10 +lon_3=0 +h=35785831 " \
+    "+lsat=5 +path=120 +o_proj=merc +o_lat_p=45 +o_lon_p=0 +n=0.5 " \
+    "+m=1 +W=2 +M=2 +q=3 +zone=31 +no_defs"
+
+static void bench_projections(void)
+{
+    struct PJ_LIST *lp;
+    double *fx = malloc(npoints * sizeof(double));
+    double *fy = malloc(npoints * sizeof(double));
+    long count = npoints / 100 > 0 ? npoints / 100 : 1, i, n;
+    char defn[256], name[64], extra[64];
+    double best, d;
+    projUV uv;
+    int r, done = 0, skipped = 0;
+
+    lonlat_grid(-20.0, 25.0, 20.0, 65.0);
+    for (lp = pj_list; lp->id; lp++)
+    {
+        projPJ pj;
+
+        sprintf(defn, "+proj=%.32s " PROJ_COMMON_PARMS, lp->id);
+        if (!(pj = pj_init_plus(defn)))
+        {
+            printf("# projections: %s skipped, %s\n", lp->id,
+                   pj_strerrno(pj_errno));
+            skipped++;
+            continue;
+        }
+        pj_free(pj);
+
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            d = now_ns();
+            for (i = 0; i < count; i++)
+                pj_free(pj_init_plus(defn));
+            if ((d = now_ns() - d) < best)
+                best = d;
+        }
+        sprintf(name, "%s_init", lp->id);
+        report("projections", name, best, count, NULL);
+
+        pj = pj_init_plus(defn);
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            d = now_ns();
+            for (i = 0; i < npoints; i++)
+            {
+                uv.u = src_x[i];
+                uv.v = src_y[i];
+                uv = pj_fwd(uv, pj);
+                x[i] = uv.u;
+                y[i] = uv.v;
+            }
+            if ((d = now_ns() - d) < best)
+                best = d;
+        }
+        for (i = n = 0; i < npoints; i++)
+            if (x[i] != HUGE_VAL)
+            {
+                fx[n] = x[i];
+                fy[n++] = y[i];
+            }
+        sprintf(name, "%s_fwd", lp->id);
+        sprintf(extra, "failed=%ld", npoints - n);
+        report("projections", name, best, npoints, extra);
+
+        if (pj->inv && n > 0)
+        {
+            for (best = HUGE_VAL, r = 0; r < repeats; r++)
+            {
+                d = now_ns();
+                for (i = 0; i < n; i++)
+                {
+                    uv.u = fx[i];
+                    uv.v = fy[i];
+                    uv = pj_inv(uv, pj);
+                    x[i] = uv.u;
+                    y[i] = uv.v;
+                }
+                if ((d = now_ns() - d) < best)
+                    best = d;
+            }
+            sprintf(name, "%s_inv", lp->id);
+            report("projections", name, best, n, NULL);
+        }
+        pj_free(pj);
+        done++;
+    }
+    printf("# projections: %d timed, %d skipped\n", done, skipped);
+
+    free(fx);
+    free(fy);
+}
+
+/************************************************************************/
+/*                           bench_datums()                             */
+/*                                                                      */
+/*      pj_transform() from WGS84 geographic to a transverse Mercator   */
+/*      on each kind of datum path: none, 3 and 7 parameter shifts      */
+/*      and a grid shift, the -g grids or @null without them.           */
+/************************************************************************/
+
+static void bench_datums(void)
+{
+    static const char *tmerc = "+proj=tmerc +lat_0=49 +lon_0=-2 "
+        "+k=0.9996012717 +x_0=400000 +y_0=-100000 ";
+    static const char *paths[][2] = {
+        { "none", "+ellps=WGS84" },
+        { "3param", "+ellps=intl +towgs84=-87,-98,-121" },
+        { "7param", "+ellps=airy +towgs84=446.448,-125.157,542.06,"
+          "0.15,0.247,0.842,-20.489" },
+        { "gridshift", NULL },
+    };
+    projPJ src = pj_init_plus("+proj=latlong +datum=WGS84 +no_defs");
+    double *z = malloc(npoints * sizeof(double));
+    char defn[1024], extra[64];
+    double best, d;
+    long i, failed;
+    size_t k;
+    int r;
+
+    if (grids)
+        lonlat_grid(grid_box[0], grid_box[1], grid_box[2], grid_box[3]);
+    else
+        lonlat_grid(-8.0, 49.5, 2.0, 61.0);
+    for (k = 0; k < sizeof(paths) / sizeof(paths[0]); k++)
+    {
+        projPJ dst;
+
+        if (paths[k][1])
+            sprintf(defn, "%s%s +units=m +no_defs", tmerc, paths[k][1]);
+        else
+            sprintf(defn, "%s+ellps=WGS84 +nadgrids=%.900s +units=m +no_defs",
+                    tmerc, grids ? grids : "@null");
+        if (!src || !(dst = pj_init_plus(defn)))
+        {
+            fprintf(stderr, "datums: %s: %s\n", paths[k][0],
+                    pj_strerrno(pj_errno));
+            failures++;
+            continue;
+        }
+
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            memset(z, 0, npoints * sizeof(double));
+            d = now_ns();
+            pj_transform(src, dst, npoints, 1, x, y, z);
+            if ((d = now_ns() - d) < best)
+                best = d;
+        }
+        for (i = 0, failed = 0; i < npoints; i++)
+            if (x[i] == HUGE_VAL)
+                failed++;
+        sprintf(extra, "failed=%ld", failed);
+        report("datums", paths[k][0], best, npoints, extra);
+        pj_free(dst);
+    }
+
+    pj_free(src);
+    free(z);
+}
+
+/************************************************************************/
+/*                          bench_geodesic()                            */
+/*                                                                      */
+/*      pj_geod_inverse() over the legs of a path of -n vertices and    */
+/*      pj_geod_direct() back along them, on WGS84.  The direct         */
+/*      results must land on the next vertex within 1e-9 radians, and   */
+/*      -t threads sharing one projGeod must match the serial run       */
+/*      exactly.                                                        */
+/************************************************************************/
+
+typedef struct {
+    projGeod geod;
+    long first, count;
+    double *dist, *az12;
+} geod_job;
+
+static void *geod_thread(void *arg)
+{
+    geod_job *job = (geod_job *) arg;
+
+    pj_geod_inverse(job->geod, job->count, src_x + job->first,
+                    src_y + job->first, src_x + job->first + 1,
+                    src_y + job->first + 1, job->dist + job->first,
+                    job->az12 + job->first, NULL);
+    return NULL;
+}
+
+static void bench_geodesic(void)
+{
+    projGeod geod = pj_geod_alloc(6378137.0, 0.0066943799901413165);
+    long legs = npoints - 1, i, mismatches = 0;
+    double *dist = malloc(npoints * sizeof(double));
+    double *az12 = malloc(npoints * sizeof(double));
+    double *tdist = malloc(npoints * sizeof(double));
+    double *taz12 = malloc(npoints * sizeof(double));
+    double best, d, err = 0.0;
+    geod_job *jobs = malloc(nthreads * sizeof(geod_job));
+    pthread_t *tids = malloc(nthreads * sizeof(pthread_t));
+    char extra[64];
+    int r, t;
+
+    if (!geod || legs < 1)
+    {
+        fprintf(stderr, "geodesic: %s\n", legs < 1 ? "needs -n 2 or more"
+                : pj_strerrno(pj_errno));
+        failures++;
+        goto done;
+    }
+
+    /* a random walk of up to 50 km steps, as a route would be */
+    srand(1);
+    src_x[0] = -100.0 * DEG_TO_RAD;
+    src_y[0] = 40.0 * DEG_TO_RAD;
+    for (i = 1; i < npoints; i++)
+    {
+        src_x[i] = src_x[i - 1] + (rand() / (double) RAND_MAX - 0.5) * 0.01;
+        src_y[i] = src_y[i - 1] + (rand() / (double) RAND_MAX - 0.5) * 0.01;
+        if (fabs(src_y[i]) > 80.0 * DEG_TO_RAD)
+            src_y[i] = src_y[i - 1];
+    }
+
+    for (best = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        d = now_ns();
+        pj_geod_inverse(geod, legs, src_x, src_y, src_x + 1, src_y + 1,
+                        dist, az12, NULL);
+        if ((d = now_ns() - d) < best)
+            best = d;
+    }
+    report("geodesic", "inverse", best, legs, NULL);
+
+    for (best = HUGE_VAL, r = 0; r < repeats; r++)
+    {
+        d = now_ns();
+        pj_geod_direct(geod, legs, src_x, src_y, az12, dist, x, y, NULL);
+        if ((d = now_ns() - d) < best)
+            best = d;
+    }
+    for (i = 0; i < legs; i++)
+    {
+        if ((d = fabs(adjlon(x[i] - src_x[i + 1]))) > err)
+            err = d;
+        if ((d = fabs(y[i] - src_y[i + 1])) > err)
+            err = d;
+    }
+    sprintf(extra, "max_error=%.3g", err);
+    report("geodesic", "direct", best, legs, extra);
+    if (err > 1e-9)
+    {
+        fprintf(stderr, "geodesic: direct misses the next vertex by %g\n",
+                err);
+        failures++;
+    }
+
+    /* shared projGeod, one slice of the legs per thread */
+    for (t = 0; t < nthreads; t++)
+    {
+        jobs[t].geod = geod;
+        jobs[t].first = legs * t / nthreads;
+        jobs[t].count = legs * (t + 1) / nthreads - jobs[t].first;
+        jobs[t].dist = tdist;
+        jobs[t].az12 = taz12;
+    }
+    d = now_ns();
+    for (t = 0; t < nthreads; t++)
+        pthread_create(tids + t, NULL, geod_thread, jobs + t);
+    for (t = 0; t < nthreads; t++)
+        pthread_join(tids[t], NULL);
+    d = now_ns() - d;
+    for (i = 0; i < legs; i++)
+        if (tdist[i] != dist[i] || taz12[i] != az12[i])
+            mismatches++;
+    sprintf(extra, "threads=%d mismatches=%ld", nthreads, mismatches);
+    report("geodesic", "inverse_shared", d, legs, extra);
+    if (mismatches)
+        failures++;
+
+done:
+    pj_geod_free(geod);
+    free(dist);
+    free(az12);
+    free(tdist);
+    free(taz12);
+    free(jobs);
+    free(tids);
+}
+
+/************************************************************************/
+/*                         bench_spheremerc()                           */
+/*                                                                      */
+/*      The spherical Mercator fast path against pj_fwd()/pj_inv() on   */
+/*      the Google definition: detection, the inline functions (bit     */
+/*      for bit, or -1 for the points they leave to the library) and    */
+/*      the batch functions (same status, error reported).  The grid    */
+/*      is salted with poles, wrapping longitudes and HUGE_VAL.         */
+/************************************************************************/
+
+static void bench_spheremerc(void)
+{
+    static const char *others[] = {
+        "+proj=merc +ellps=WGS84 +no_defs",
+        "+proj=merc +a=6378137 +b=6378137 +x_0=100 +no_defs",
+        "+proj=merc +a=6378137 +b=6378137 +lat_ts=30 +no_defs",
+        "+proj=merc +a=6378137 +b=6378137 +units=km +no_defs",
+        "+proj=latlong +a=6378137 +b=6378137 +no_defs",
+    };
+    projPJ pj = pj_init_plus(GOOGLE_DEFN);
+    projSphereMerc M;
+    double *ex = malloc(npoints * sizeof(double));
+    double *ey = malloc(npoints * sizeof(double));
+    int *estatus = malloc(npoints * sizeof(int));
+    long i, mismatches, left = 0;
+    double t, best, err;
+    char extra[64];
+    projUV uv;
+    size_t k;
+    int r, inverse;
+
+    if (!pj || !pj_get_sphere_merc(pj, &M))
+    {
+        fprintf(stderr, "spheremerc: Google definition not detected\n");
+        failures++;
+        goto done;
+    }
+    for (k = 0; k < sizeof(others) / sizeof(others[0]); k++)
+    {
+        projPJ other = pj_init_plus(others[k]);
+
+        if (other && pj_get_sphere_merc(other, NULL))
+        {
+            fprintf(stderr, "spheremerc: detected %s\n", others[k]);
+            failures++;
+        }
+        pj_free(other);
+    }
+
+    lonlat_grid(-179.0, -84.0, 179.0, 84.0);
+    for (i = 0; i < npoints; i += 97)
+    {
+        switch ((i / 97) % 5)
+        {
+          case 0: src_y[i] = HALFPI; break;
+          case 1: src_y[i] = -HALFPI + 1e-11; break;
+          case 2: src_x[i] = 3.5; break;
+          case 3: src_x[i] = -9.0; break;
+          case 4: src_x[i] = 11.0; break;
+        }
+    }
+
+    for (inverse = 0; inverse < 2; inverse++)
+    {
+        const char *dir = inverse ? "inv" : "fwd";
+        char name[64];
+
+        /* the library, one point at a time */
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            t = now_ns();
+            for (i = 0; i < npoints; i++)
+            {
+                uv.u = src_x[i];
+                uv.v = src_y[i];
+                uv = inverse ? pj_inv(uv, pj) : pj_fwd(uv, pj);
+                ex[i] = uv.u;
+                ey[i] = uv.v;
+            }
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        sprintf(name, "%s_pj", dir);
+        report("spheremerc", name, best, npoints, NULL);
+
+        /* inline, the library for what it leaves */
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            t = now_ns();
+            for (i = 0, left = 0; i < npoints; i++)
+            {
+                if ((inverse ? pj_sphere_merc_inv(&M, src_x[i], src_y[i],
+                                                  x + i, y + i)
+                     : pj_sphere_merc_fwd(&M, src_x[i], src_y[i],
+                                          x + i, y + i)) == 0)
+                    continue;
+                uv.u = src_x[i];
+                uv.v = src_y[i];
+                uv = inverse ? pj_inv(uv, pj) : pj_fwd(uv, pj);
+                x[i] = uv.u;
+                y[i] = uv.v;
+                left++;
+            }
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        /* bitwise, pj_inv() makes NaNs of HUGE_VAL input */
+        for (i = 0, mismatches = 0; i < npoints; i++)
+            if (memcmp(x + i, ex + i, sizeof(double))
+                || memcmp(y + i, ey + i, sizeof(double)))
+                mismatches++;
+        sprintf(name, "%s_inline", dir);
+        sprintf(extra, "left=%ld mismatches=%ld", left, mismatches);
+        report("spheremerc", name, best, npoints, extra);
+        if (mismatches)
+            failures++;
+
+        /* generic and dedicated batches */
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            t = now_ns();
+            if (inverse)
+                pj_inv_batch(pj, npoints, x, y, estatus);
+            else
+                pj_fwd_batch(pj, npoints, x, y, estatus);
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        sprintf(name, "%s_pj_batch", dir);
+        report("spheremerc", name, best, npoints, NULL);
+
+        for (best = HUGE_VAL, r = 0; r < repeats; r++)
+        {
+            reset_points();
+            t = now_ns();
+            if (inverse)
+                pj_sphere_merc_inv_batch(&M, npoints, x, y, status);
+            else
+                pj_sphere_merc_fwd_batch(&M, npoints, x, y, status);
+            if ((t = now_ns() - t) < best)
+                best = t;
+        }
+        for (i = 0, mismatches = 0, err = 0.0; i < npoints; i++)
+        {
+            if (status[i] != estatus[i])
+                mismatches++;
+            else if (status[i] == 0)
+            {
+                if ((t = fabs(x[i] - ex[i])) > err)
+                    err = t;
+                if ((t = fabs(y[i] - ey[i])) > err)
+                    err = t;
+            }
+        }
+        sprintf(name, "%s_batch", dir);
+        sprintf(extra, "maxerr=%g status_mismatches=%ld", err, mismatches);
+        report("spheremerc", name, best, npoints, extra);
+        if (mismatches || err > (inverse ? 1e-14 : 1e-7))
+            failures++;
+
+        /* the inverse starts from the library's forward results */
+        memcpy(src_x, ex, npoints * sizeof(double));
+        memcpy(src_y, ey, npoints * sizeof(double));
+    }
+
+done:
+    pj_free(pj);
+    free(ex);
+    free(ey);
+    free(estatus);
+}
+
+static struct {
+    const char *name;
+    void (*run)(void);
+} tests[] = {
+    { "batch", bench_batch },
+    { "threads", bench_threads },
+    { "transform", bench_transform },
+    { "pipeline", bench_pipeline },
+    { "approx", bench_approx },
+    { "grids", bench_grids },
+    { "gridcache", bench_gridcache },
+    { "init", bench_init },
+    { "defcache", bench_defcache },
+    { "geocent", bench_geocent },
+    { "helmert", bench_helmert },
+    { "projections", bench_projections },
+    { "datums", bench_datums },
+    { "geodesic", bench_geodesic },
+    { "spheremerc", bench_spheremerc },
+    { NULL, NULL }
+};
+
+int main(int argc, char **argv)
+{
+    int i, j, k;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            npoints = atol(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeats = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            nthreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+            grids = argv[++i];
+        else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc
+                 && sscanf(argv[i + 1], "%lf,%lf,%lf,%lf", grid_box,
+                           grid_box + 1, grid_box + 2, grid_box + 3) == 4)
+            i++;
+        else
+        {
+            fprintf(stderr, "usage: %s [-n points] [-r repeats] "
+                    "[-t threads]\n       [-g grid[,grid...] "
+                    "[-B west,south,east,north]] [test ...]\n"
+                    "tests:", argv[0]);
+            for (j = 0; tests[j].name; j++)
+                fprintf(stderr, " %s", tests[j].name);
+            fprintf(stderr, "\n");
+            exit(1);
+        }
+    }
+    if (npoints < 1 || repeats < 1 || nthreads < 1)
+    {
+        fprintf(stderr, "%s: points, repeats and threads must be positive\n",
+                argv[0]);
+        exit(1);
+    }
+
+    src_x = malloc(npoints * sizeof(double));
+    src_y = malloc(npoints * sizeof(double));
+    x = malloc(npoints * sizeof(double));
+    y = malloc(npoints * sizeof(double));
+    status = malloc(npoints * sizeof(int));
+
+    printf("#test\tcase\tns/point\tpoints/sec\textra\n");
+    for (j = 0; tests[j].name; j++)
+    {
+        int wanted = (i == argc);
+
+        for (k = i; k < argc && !wanted; k++)
+            wanted = strcmp(argv[k], tests[j].name) == 0;
+        if (wanted)
+            tests[j].run();
+    }
+
+    free(src_x);
+    free(src_y);
+    free(x);
+    free(y);
+    free(status);
+    return failures ? 1 : 0;
+}
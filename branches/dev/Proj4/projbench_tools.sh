@@ -0,0 +1,67 @@
+#!/bin/bash
+#
+# Throughput of the proj and cs2cs programs on synthetic input: text
+# input with -j 1, 2, 4 ... threads, and binary records (-b), one tab
+# separated line per run like projbench:
+#
+#     tool  case  seconds  points/sec
+#
+# usage: projbench_tools.sh [-n points] [-j max_threads] [bindir]
+#
+# bindir defaults to the directory of this script, where the programs
+# are built.
+
+points=1000000
+max_threads=4
+
+while getopts n:j: opt; do
+    case $opt in
+        n) points=$OPTARG ;;
+        j) max_threads=$OPTARG ;;
+        *) echo "usage: $0 [-n points] [-j max_threads] [bindir]" >&2
+           exit 1 ;;
+    esac
+done
+shift `expr $OPTIND - 1`
+bindir=${1:-`dirname $0`}
+
+tmp=${TMPDIR:-/tmp}/projbench_tools.$$
+mkdir -p $tmp || exit 1
+trap 'rm -rf $tmp' 0 1 2 15
+
+OSGB="+proj=tmerc +lat_0=49 +lon_0=-2 +k=0.9996012717 +x_0=400000
+      +y_0=-100000 +ellps=airy +datum=OSGB36 +units=m"
+WGS84="+proj=latlong +datum=WGS84"
+
+# points over Great Britain in decimal degrees with a height, the same
+# projected, and both as binary records written by the programs
+awk -v n=$points 'BEGIN {
+    srand(1);
+    for (i = 0; i < n; i++)
+        printf "%.7f %.7f %.2f\n", -8 + 10 * rand(), 50 + 10 * rand(),
+            500 * rand();
+}' > $tmp/lonlat.txt
+$bindir/cs2cs -o $WGS84 +to $WGS84 $tmp/lonlat.txt > $tmp/lonlat.bin
+$bindir/cs2cs -f %.3f $WGS84 +to $OSGB $tmp/lonlat.txt > $tmp/xy.txt
+$bindir/proj -I -o $OSGB $tmp/xy.txt > $tmp/lonlat2.bin
+
+# run <tool> <case> <command...>: time the command, output discarded
+TIMEFORMAT=%R
+run() {
+    tool=$1 name=$2
+    shift 2
+    secs=`{ time "$@" > /dev/null; } 2>&1`
+    awk -v t=$tool -v c=$name -v s=$secs -v n=$points 'BEGIN {
+        printf "%s\t%s\t%.3f\t%.0f\n", t, c, s, (s > 0 ? n / s : 0) }'
+}
+
+echo "#tool	case	seconds	points/sec"
+j=1
+while [ $j -le $max_threads ]; do
+    run cs2cs text_j$j $bindir/cs2cs -j $j $WGS84 +to $OSGB $tmp/lonlat.txt
+    run proj fwd_text_j$j $bindir/proj -j $j $OSGB $tmp/lonlat.txt
+    run proj inv_text_j$j $bindir/proj -I -j $j $OSGB $tmp/xy.txt
+    j=`expr $j \* 2`
+done
+run cs2cs binary $bindir/cs2cs -b $WGS84 +to $OSGB $tmp/lonlat.bin
+run proj fwd_binary $bindir/proj -b $OSGB $tmp/lonlat2.bin
@@ -280,14 +280,27 @@ struct FACTORS {
     /* parameter list struct */
 typedef struct ARG_list {
 	struct ARG_list *next;
+	struct PJ_PARAM_TABLE *table; /* on the first entry, see pj_param.c */
+	unsigned hash;		/* of the name */
+	unsigned key_len;	/* length of the name, before any '=' */
 	char used;
 	char param[1]; } paralist;
+	/* name lookup table built by pj_param_index() */
+typedef struct PJ_PARAM_TABLE {
+	paralist *tail;		/* last entry indexed */
+	int count;		/* entries indexed */
+	unsigned mask;		/* slots - 1 */
+	paralist *slots[1];
+} PJ_PARAM_TABLE;
 	/* base projection data structure */
 
 
 typedef struct PJconsts {
 	XY  (*fwd)(LP, struct PJconsts *);
 	LP  (*inv)(XY, struct PJconsts *);
+	/* optional array kernels, see pj_fwd_batch() / pj_inv_batch() */
+	long (*fwd_batch)(long, double *, double *, int *, struct PJconsts *);
+	long (*inv_batch)(long, double *, double *, int *, struct PJconsts *);
 	void (*spc)(LP, struct PJconsts *, struct FACTORS *);
 	void (*pfree)(struct PJconsts *);
 	const char *descr;
@@ -312,6 +325,8 @@ typedef struct PJconsts {
     
         int     datum_type; /* PJD_UNKNOWN/3PARAM/7PARAM/GRIDSHIFT/WGS84 */
         double  datum_params[7];
+        double  datum_to_wgs84[12];   /* datum_params as 3x4 affine maps */
+        double  datum_from_wgs84[12]; /* on geocentric X/Y/Z, row major */
         double  from_greenwich; /* prime meridian offset (in radians) */
         double  long_wrap_center; /* 0.0 for -180 to 180, actually in radians*/
         
@@ -323,6 +338,12 @@ PROJ_PARMS__
 /* public API */
 #include "proj_api.h"
 
+/* inside the library the error code is the one of the calling thread's
+   context, see pj_ctx.c */
+#ifndef PJ_ERRNO__
+#define pj_errno (*pj_get_errno_ref())
+#endif
+
 /* Generate pj_list external or make list from include file */
 #ifndef PJ_LIST_H
 extern struct PJ_LIST pj_list[];
@@ -368,6 +389,7 @@ extern struct PJ_PRIME_MERIDIANS pj_prime_meridians[];
 	C_NAMESPACE PJ *pj_##name(PJ *P) { if (!P) { \
 	if( (P = (PJ*) pj_malloc(sizeof(PJ))) != NULL) { \
 	P->pfree = freeup; P->fwd = 0; P->inv = 0; \
+	P->fwd_batch = 0; P->inv_batch = 0; \
 	P->spc = 0; P->descr = des_##name;
 #define ENTRYX } return P; } else {
 #define ENTRY0(name) ENTRYA(name) ENTRYX
@@ -400,16 +422,87 @@ typedef struct _pj_gi {
     char *filename;   /* full path to filename */
     
     const char *format; /* format of this grid, ie "ctable", "ntv1", 
-                           "ntv2" or "missing". */
+                           "ntv2", "mapped" or "missing". */
 
     int   grid_offset; /* offset in file, for delayed loading */
 
     struct CTABLE *ct;
 
+    struct PJ_GRIDMAP *map; /* shared mapping of a "mapped" format file,
+                               ct->cvs points into it */
+
     struct _pj_gi *next;
     struct _pj_gi *child;
+
+    struct PJ_GRIDINDEX *child_index; /* over child, see pj_gridindex.c */
+
+    /* loaded data bookkeeping, see pj_gridcache.c */
+    struct _pj_gi *lru_prev, *lru_next;
+    int   is_cached;
+    int   pin_count;
 } PJ_GRIDINFO;
 
+/* upper right corner of a grid shift table */
+#define PJ_CT_MAX_LAM(ct)  ((ct)->ll.lam + ((ct)->lim.lam-1) * (ct)->del.lam)
+#define PJ_CT_MAX_PHI(ct)  ((ct)->ll.phi + ((ct)->lim.phi-1) * (ct)->del.phi)
+
+/* bucket index over an array of grids, see pj_gridindex.c */
+typedef struct PJ_GRIDINDEX {
+    int          count;
+    PJ_GRIDINFO **grids;        /* indexed grids, in search order */
+    char         *exclusive;    /* no earlier grid overlaps this one */
+    LP           ll;            /* lower left of the union */
+    double       inv_lam, inv_phi; /* cells per radian */
+    int          cols, rows;
+    int          *cell_start;   /* cols*rows+1 offsets into entries */
+    int          *entries;      /* grid positions, per cell */
+} PJ_GRIDINDEX;
+
+/* per caller state, see pj_ctx.c */
+struct projCtx_t {
+    int     last_errno;     /* unused for the default context (pj_errno) */
+    int     debug_level;    /* initialized from PROJ_DEBUG */
+    int     debug_count;    /* pj_apply_gridshift() messages issued */
+
+    /* last +nadgrids list, see pj_gridlist_from_nadgrids() */
+    char         *last_nadgrids;
+    int           last_nadgrids_generation;
+    int           last_nadgrids_count;
+    int           last_nadgrids_max;
+    PJ_GRIDINFO **last_nadgrids_list;
+    PJ_GRIDINDEX *last_nadgrids_index; /* built on first use */
+};
+
+/* transform prepared by pj_transform_prepare(), see pj_pipeline.c */
+#define PJ_PIPELINE_MAX_STAGES 8
+
+typedef struct {
+    int     op;             /* PJ_STAGE_* in pj_pipeline.c */
+    double  value;          /* scale factor or longitude offset */
+} PJ_STAGE;
+
+struct PJ_PIPELINE {
+    PJ       *srcdefn;      /* not owned */
+    PJ       *dstdefn;
+    int      needs_z;       /* a geocentric stage requires the z array */
+    int      stage_count;
+    PJ_STAGE stages[PJ_PIPELINE_MAX_STAGES];
+};
+
+/* ellipsoid for pj_geod_direct()/pj_geod_inverse(), see pj_geod.c */
+struct PJ_GEOD {
+    double  a;              /* semi-major axis, distance units */
+    double  onef, f, f2, f4, f64;
+    int     ellipse;        /* 0 for a sphere */
+};
+
+/* a geodesic from a point and azimuth, what geod_pre() derives */
+typedef struct {
+    double  lam1, phi1, al12;
+    double  th1, costh1, sinth1, sina12, cosa12, M, N, c1, c2, D, P, s1;
+    int     merid, signS;
+} PJ_GEOD_LINE;
+
 /* procedure prototypes */
 double dmstor(const char *, char **);
 void set_rtodms(int, int);
@@ -418,6 +511,8 @@ double adjlon(double);
 double aacos(double), aasin(double), asqrt(double), aatan2(double, double);
 PVALUE pj_param(paralist *, char *);
 paralist *pj_mkparam(char *);
+void pj_param_index(paralist *);
+void pj_param_unindex(paralist *);
 int pj_ell_set(paralist *, double *, double *);
 int pj_datum_set(paralist *, PJ *);
 int pj_prime_meridian_set(paralist *, PJ *);
@@ -436,6 +531,15 @@ COMPLEX pj_zpoly1(COMPLEX, COMPLEX *, int);
 COMPLEX pj_zpolyd1(COMPLEX, COMPLEX *, int, COMPLEX *);
 FILE *pj_open_lib(char *, char *);
 
+void pj_geod_line_init(const struct PJ_GEOD *, PJ_GEOD_LINE *,
+                       double lam1, double phi1, double al12);
+void pj_geod_line_position(const struct PJ_GEOD *, const PJ_GEOD_LINE *,
+                           double S, double *lam2, double *phi2,
+                           double *al21);
+void pj_geod_inverse1(const struct PJ_GEOD *, double lam1, double phi1,
+                      double lam2, double phi2,
+                      double *S, double *al12, double *al21);
+
 int pj_deriv(LP, double, PJ *, struct DERIVS *);
 int pj_factors(LP, PJ *, double, struct FACTORS *);
 
@@ -453,30 +557,52 @@ typedef struct {	/* Chebyshev or Power series structure */
 	int power;		/* != 0 if power series, else Chebyshev */
 } Tseries;
 Tseries *mk_cheby(projUV, projUV, double, projUV *, projUV (*)(projUV), int, int, int);
+Tseries *mk_cheby_fit(projUV, projUV, double, projUV *, projUV **, int, int, int);
 projUV bpseval(projUV, Tseries *);
 projUV bcheval(projUV, Tseries *);
 projUV biveval(projUV, Tseries *);
 void *vector1(int, int);
 void **vector2(int, int, int);
 void freev2(void **v, int nrows);
+double bch_node(double, double, int, int);
 int bchgen(projUV, projUV, int, int, projUV **, projUV(*)(projUV));
 int bch2bps(projUV, projUV, projUV **, int, int);
 /* nadcon related protos */
 LP nad_intr(LP, struct CTABLE *);
 LP nad_cvt(LP, int, struct CTABLE *);
+void nad_cvt_batch(LP *, int, int, struct CTABLE *);
 struct CTABLE *nad_init(char *);
 struct CTABLE *nad_ctable_init( FILE * fid );
 int nad_ctable_load( struct CTABLE *, FILE * fid );
+void nad_ctable_publish( struct CTABLE *, FLP * );
+FLP *nad_ctable_loaded( struct CTABLE * );
 void nad_free(struct CTABLE *);
 
 /* higher level handling of datum grid shift files */
 
 PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *, int * );
+void pj_gridlist_ctx_clear( projCtx );
 void pj_deallocate_grids();
+void pj_acquire_lock(void);
+void pj_release_lock(void);
+int pj_transient_error( int, long );
+int pj_transform_run_part( struct PJ_PIPELINE *, long, int,
+                           double *, double *, double *, long );
 
 PJ_GRIDINFO *pj_gridinfo_init( const char * );
 int pj_gridinfo_load( PJ_GRIDINFO * );
 void pj_gridinfo_free( PJ_GRIDINFO * );
+int pj_gridinfo_write_mapped( PJ_GRIDINFO *, FILE * );
+
+void pj_gridcache_loaded( PJ_GRIDINFO * );
+void pj_gridcache_forget( PJ_GRIDINFO * );
+int pj_gridcache_pin( PJ_GRIDINFO * );
+void pj_gridcache_unpin( PJ_GRIDINFO * );
+int pj_gridcache_enabled( void );
+
+PJ_GRIDINDEX *pj_gridindex_build( PJ_GRIDINFO **, int );
+const int *pj_gridindex_candidates( PJ_GRIDINDEX *, LP, int * );
+void pj_gridindex_free( PJ_GRIDINDEX * );
 
 void *proj_mdist_ini(double);
 double proj_mdist(double, double, double, const void *);